@@ -0,0 +1,76 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdint.h>
+
+#include "game.h"
+#include "solver.h"
+
+typedef struct
+{
+    const char* name;
+    const char* description;
+    void (*run)(void);
+} Benchmark;
+
+double GetBenchmarkSeconds(void);
+
+bool GenerateBenchmarkBoard(
+    _Out_ Minefield* field,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t seed);
+
+bool RevealFirstOpening(_Inout_ Minefield* field);
+
+void PlayUntilStuck(_Inout_ Minefield* field, _Inout_opt_ SolverCache* cache, _Inout_ SolverResult* result);
+
+void BuildLongFrontierBoard(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t seed);
+
+void RunSolverBenchmark(void);
+
+void RunSamplerBenchmark(void);
+
+void RunSolverCacheBenchmark(void);
+
+void RunNoGuessBenchmark(void);
+
+void RunBoardPoolBenchmark(void);
+
+void RunMetricsBenchmark(void);
+
+void RunRevealBenchmark(void);
+
+void RunLargeFieldBenchmark(void);
+
+void RunLayoutBenchmark(void);
+
+void RunLazyCountBenchmark(void);
+
+void RunHashFieldBenchmark(void);
+
+void RunChunkFieldBenchmark(void);
+
+void RunBatchBenchmark(void);
+
+void RunObservationBenchmark(void);
+
+void RunSelfPlayBenchmark(void);
+
+void RunReplayBenchmark(void);
+
+void RunCorpusBenchmark(void);
+
+void RunFormatsBenchmark(void);
+
+void RunArchiveBenchmark(void);
+
+void RunSaveGameBenchmark(void);
+
+void RunJournalBenchmark(void);
+
+void RunStatsBenchmark(void);
+
+void RunQuantileSketchBenchmark(void);
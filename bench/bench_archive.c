@@ -0,0 +1,241 @@
+#include "pch.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "bench.h"
+#include "boardarchive.h"
+#include "parallel.h"
+#include "random.h"
+
+#define ARCHIVE_BENCH_RANDOM_READS 100000
+#define ARCHIVE_BENCH_DECODE_BOARDS 256
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t boards;
+} ArchiveConfiguration;
+
+typedef struct
+{
+    const BoardArchive* archive;
+    bool* mines;
+    ArchivedBoard* boards;
+    volatile LONG nextBatch;
+    volatile LONG failed;
+} ArchiveDecode;
+
+static void
+GenerateArchiveBoards(
+    _In_ const ArchiveConfiguration* configuration,
+    _In_ uint32_t first,
+    _In_ uint32_t count,
+    _Out_ bool* mines,
+    _Out_writes_(count) uint32_t* firstClicks)
+{
+    uint32_t cellCount = configuration->width * configuration->height;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t seed = mix64(first + i);
+
+        firstClicks[i] = (uint32_t)(seed >> 32) % cellCount;
+        PlaceSeededMines(
+            configuration->width,
+            configuration->height,
+            configuration->mines,
+            seed,
+            firstClicks[i] % configuration->width,
+            firstClicks[i] / configuration->width,
+            mines + (size_t)i * cellCount);
+    }
+}
+
+static void
+DecodeArchiveBatches(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    ArchiveDecode* decode = (ArchiveDecode*)context;
+    const BoardArchive* archive = decode->archive;
+    size_t cellCount = (size_t)archive->width * archive->height;
+    bool* mines = decode->mines + (size_t)index * ARCHIVE_BENCH_DECODE_BOARDS * cellCount;
+    ArchivedBoard* boards = decode->boards + (size_t)index * ARCHIVE_BENCH_DECODE_BOARDS;
+
+    for (;;)
+    {
+        uint64_t first = (uint64_t)(InterlockedIncrement(&decode->nextBatch) - 1) * ARCHIVE_BENCH_DECODE_BOARDS;
+
+        if (first >= archive->count)
+            break;
+
+        uint32_t count = (uint32_t)min(archive->count - first, (uint64_t)ARCHIVE_BENCH_DECODE_BOARDS);
+
+        if (!ReadArchiveBoards(archive, first, count, mines, boards))
+            InterlockedExchange(&decode->failed, 1);
+    }
+}
+
+static double
+TimeArchiveDecode(
+    _In_ const BoardArchive* archive,
+    _In_ uint32_t threads,
+    _Inout_ bool* mines,
+    _Inout_ ArchivedBoard* boards)
+{
+    ArchiveDecode decode = {
+        .archive = archive,
+        .mines = mines,
+        .boards = boards,
+    };
+
+    double start = GetBenchmarkSeconds();
+
+    ParallelFor(threads, threads, DecodeArchiveBatches, &decode);
+
+    return decode.failed != 0 ? 0.0 : GetBenchmarkSeconds() - start;
+}
+
+static void
+BenchmarkArchive(
+    _In_ const ArchiveConfiguration* configuration,
+    _In_z_ const char* path,
+    _Inout_ bool* mines,
+    _Inout_ bool* decoded,
+    _Inout_ uint32_t* firstClicks,
+    _Inout_ ArchivedBoard* boards)
+{
+    uint32_t cellCount = configuration->width * configuration->height;
+    uint32_t threads = GetParallelThreadCount();
+    BoardArchiveWriter writer;
+    double encodeSeconds = 0.0;
+
+    if (!CreateBoardArchiveWriter(&writer, path, configuration->width, configuration->height, configuration->mines))
+    {
+        printf("Cannot create the archive (error %lu)\n", GetLastError());
+        return;
+    }
+
+    bool success = true;
+
+    for (uint32_t first = 0; success && first < configuration->boards; first += BOARD_ARCHIVE_BATCH_BOARDS)
+    {
+        uint32_t count = min(configuration->boards - first, (uint32_t)BOARD_ARCHIVE_BATCH_BOARDS);
+
+        GenerateArchiveBoards(configuration, first, count, mines, firstClicks);
+
+        double start = GetBenchmarkSeconds();
+
+        success = AppendArchiveBoards(&writer, count, mines, firstClicks, threads);
+        encodeSeconds += GetBenchmarkSeconds() - start;
+    }
+
+    uint64_t codeBits = writer.codeBits;
+
+    success = CloseBoardArchiveWriter(&writer) && success;
+
+    BoardArchive archive;
+
+    if (!success || !OpenBoardArchive(&archive, path))
+    {
+        printf("Cannot write the archive (error %lu)\n", GetLastError());
+        return;
+    }
+
+    uint64_t mismatches = 0;
+
+    for (uint32_t first = 0; first < configuration->boards; first += BOARD_ARCHIVE_BATCH_BOARDS)
+    {
+        uint32_t count = min(configuration->boards - first, (uint32_t)BOARD_ARCHIVE_BATCH_BOARDS);
+
+        GenerateArchiveBoards(configuration, first, count, mines, firstClicks);
+
+        if (!ReadArchiveBoards(&archive, first, count, decoded, boards))
+        {
+            mismatches += count;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            bool same = boards[i].firstClick == firstClicks[i] &&
+                        memcmp(decoded + (size_t)i * cellCount, mines + (size_t)i * cellCount, cellCount) == 0;
+
+            mismatches += same ? 0 : 1;
+        }
+    }
+
+    double serial = TimeArchiveDecode(&archive, 1, decoded, boards);
+    double parallel = TimeArchiveDecode(&archive, threads, decoded, boards);
+
+    struct splitmix64_state random = {
+        .s = configuration->boards,
+    };
+
+    double start = GetBenchmarkSeconds();
+
+    for (uint32_t i = 0; i < ARCHIVE_BENCH_RANDOM_READS; i++)
+        ReadArchiveBoards(&archive, splitmix64(&random) % archive.count, 1, decoded, boards);
+
+    double randomSeconds = GetBenchmarkSeconds() - start;
+    double bound = (lgamma(cellCount + 1.0) - lgamma(configuration->mines + 1.0) -
+                    lgamma(cellCount - configuration->mines + 1.0)) / log(2.0);
+
+    printf("%s, %u boards, %u decoded differently\n", configuration->name, configuration->boards, (uint32_t)mismatches);
+    printf("  %8.1f bits per board stored, %8.1f coded, log2(C(cells, mines)) = %8.1f, Cell array %u bits\n",
+           (double)archive.size * 8.0 / (double)archive.count,
+           (double)codeBits / (double)archive.count,
+           bound,
+           (uint32_t)(sizeof(Cell) * cellCount * 8));
+    printf("  encode with 3BV %10.0f boards/s on %u threads\n", configuration->boards / encodeSeconds, threads);
+    printf("  decode          %10.0f boards/s on 1 thread, %10.0f on %u threads\n",
+           configuration->boards / serial,
+           configuration->boards / parallel,
+           threads);
+    printf("  random access   %10.0f boards/s\n", ARCHIVE_BENCH_RANDOM_READS / randomSeconds);
+
+    CloseBoardArchive(&archive);
+}
+
+void
+RunArchiveBenchmark(void)
+{
+    static const ArchiveConfiguration configurations[] = {
+        {"Beginner", 9, 9, 10, 1 << 20},
+        {"Intermediate", 16, 16, 40, 1 << 19},
+        {"Expert", 30, 16, 99, 1 << 19},
+        {"100x100", 100, 100, 2000, 1 << 14},
+    };
+
+    char directory[MAX_PATH];
+    char path[MAX_PATH];
+
+    if (GetTempPathA(ARRAYSIZE(directory), directory) == 0 || GetTempFileNameA(directory, "msa", 0, path) == 0)
+    {
+        printf("Cannot create a temporary file\n");
+        return;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t threads = GetParallelThreadCount();
+    size_t batchCells = (size_t)BOARD_ARCHIVE_BATCH_BOARDS * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY;
+    bool* mines = HeapAlloc(hHeap, 0, sizeof(bool) * batchCells);
+    size_t decodeBoards = max((size_t)ARCHIVE_BENCH_DECODE_BOARDS * threads, (size_t)BOARD_ARCHIVE_BATCH_BOARDS);
+    bool* decoded = HeapAlloc(hHeap, 0, sizeof(bool) * decodeBoards * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+    uint32_t* firstClicks = HeapAlloc(hHeap, 0, sizeof(uint32_t) * BOARD_ARCHIVE_BATCH_BOARDS);
+    ArchivedBoard* boards = HeapAlloc(hHeap, 0, sizeof(ArchivedBoard) * decodeBoards);
+
+    if (mines != NULL && decoded != NULL && firstClicks != NULL && boards != NULL)
+    {
+        for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+            BenchmarkArchive(&configurations[i], path, mines, decoded, firstClicks, boards);
+    }
+
+    HeapFree(hHeap, 0, boards);
+    HeapFree(hHeap, 0, firstClicks);
+    HeapFree(hHeap, 0, decoded);
+    HeapFree(hHeap, 0, mines);
+    DeleteFileA(path);
+}
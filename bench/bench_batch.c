@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include "batchfield.h"
+#include "bench.h"
+#include "parallel.h"
+#include "random.h"
+
+#define BATCH_BENCH_MAX_BOARDS 65536
+#define BATCH_BENCH_MAX_MINEFIELDS 1024
+#define BATCH_BENCH_STEPS (1u << 21)
+#define BATCH_BENCH_MIN_CALLS 16
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+} BatchConfiguration;
+
+// A random player: finished games are reset and every other board reveals a uniformly drawn cell.
+static BatchAction
+ChooseAction(_Inout_ struct splitmix64_state* random, _In_ bool playing, _In_ uint32_t cellCount)
+{
+    BatchAction action = {
+        .cell = (uint16_t)(splitmix64(random) % cellCount),
+        .kind = playing ? BATCH_ACTION_REVEAL : BATCH_ACTION_RESET,
+    };
+
+    return action;
+}
+
+static double
+BenchmarkBatch(
+    _In_ const BatchConfiguration* configuration,
+    _In_ uint32_t boardCount,
+    _In_ uint32_t threads,
+    _Inout_ BatchAction* actions)
+{
+    BatchField batch;
+    uint32_t calls = max(BATCH_BENCH_STEPS / boardCount, (uint32_t)BATCH_BENCH_MIN_CALLS);
+    uint32_t cellCount = configuration->width * configuration->height;
+    double elapsed = 0.0;
+
+    if (!CreateBatchField(&batch, configuration->width, configuration->height, configuration->mines, boardCount, 1))
+    {
+        return 0.0;
+    }
+
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    for (uint32_t call = 0; call < calls; call++)
+    {
+        for (uint32_t board = 0; board < boardCount; board++)
+            actions[board] = ChooseAction(&random, batch.gameStates[board] == GAME_PLAYING, cellCount);
+
+        double start = GetBenchmarkSeconds();
+        StepBatchField(&batch, actions, threads);
+        elapsed += GetBenchmarkSeconds() - start;
+    }
+
+    DestroyBatchField(&batch);
+
+    return (double)calls * boardCount / elapsed;
+}
+
+static void
+ResetMinefield(_Out_ Minefield* field, _In_ const BatchConfiguration* configuration, _In_ uint64_t seed)
+{
+    CreateCustomMinefield(field, configuration->width, configuration->height, configuration->mines);
+    field->seed = seed;
+}
+
+// The same player stepping separate Minefield structs one RevealCell at a time.
+static double
+BenchmarkMinefields(
+    _In_ const BatchConfiguration* configuration,
+    _In_ uint32_t boardCount,
+    _Inout_ BatchAction* actions)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* fields = HeapAlloc(hHeap, 0, sizeof(Minefield) * boardCount);
+    uint32_t calls = max(BATCH_BENCH_STEPS / boardCount, (uint32_t)BATCH_BENCH_MIN_CALLS);
+    uint32_t cellCount = configuration->width * configuration->height;
+    double elapsed = 0.0;
+
+    if (fields == NULL)
+        return 0.0;
+
+    struct splitmix64_state seeds = {
+        .s = 1,
+    };
+
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    for (uint32_t board = 0; board < boardCount; board++)
+        ResetMinefield(&fields[board], configuration, splitmix64(&seeds));
+
+    for (uint32_t call = 0; call < calls; call++)
+    {
+        for (uint32_t board = 0; board < boardCount; board++)
+            actions[board] = ChooseAction(&random, fields[board].state == GAME_PLAYING, cellCount);
+
+        double start = GetBenchmarkSeconds();
+
+        for (uint32_t board = 0; board < boardCount; board++)
+        {
+            Minefield* field = &fields[board];
+
+            if (actions[board].kind == BATCH_ACTION_RESET)
+            {
+                struct splitmix64_state next = {
+                    .s = field->seed,
+                };
+
+                ResetMinefield(field, configuration, splitmix64(&next));
+            }
+            else
+            {
+                uint32_t cell = actions[board].cell;
+
+                RevealCell(field, cell % configuration->width, cell / configuration->width);
+            }
+        }
+
+        elapsed += GetBenchmarkSeconds() - start;
+    }
+
+    HeapFree(hHeap, 0, fields);
+
+    return (double)calls * boardCount / elapsed;
+}
+
+void
+RunBatchBenchmark(void)
+{
+    static const BatchConfiguration configurations[] = {
+        {"Beginner", 9, 9, 10},
+        {"Expert", 30, 16, 99},
+    };
+
+    uint32_t cores = GetParallelThreadCount();
+    BatchAction* actions = HeapAlloc(GetProcessHeap(), 0, sizeof(BatchAction) * BATCH_BENCH_MAX_BOARDS);
+
+    if (actions == NULL)
+        return;
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+    {
+        const BatchConfiguration* configuration = &configurations[i];
+
+        printf("%s, random player, M steps/s\n", configuration->name);
+        printf("  %6s %10s %10s %10s\n", "boards", "Minefield", "1 thread", "all cores");
+
+        for (uint32_t boardCount = 1; boardCount <= BATCH_BENCH_MAX_BOARDS; boardCount *= 4)
+        {
+            double serial = BenchmarkBatch(configuration, boardCount, 1, actions);
+            double parallel = cores > 1 ? BenchmarkBatch(configuration, boardCount, cores, actions) : serial;
+
+            if (boardCount <= BATCH_BENCH_MAX_MINEFIELDS)
+            {
+                double minefields = BenchmarkMinefields(configuration, boardCount, actions);
+
+                printf("  %6u %10.2f %10.2f %10.2f\n", boardCount, minefields / 1e6, serial / 1e6, parallel / 1e6);
+            }
+            else
+            {
+                printf("  %6u %10s %10.2f %10.2f\n", boardCount, "-", serial / 1e6, parallel / 1e6);
+            }
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, actions);
+}
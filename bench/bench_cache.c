@@ -0,0 +1,94 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "solver.h"
+#include "solvercache.h"
+
+#define CACHE_GAMES 200
+
+typedef struct
+{
+    double seconds;
+    LONG64 lookups;
+    LONG64 hits;
+    LONG64 candidatesSaved;
+    uint32_t games;
+    uint32_t hashMismatches;
+} CacheRun;
+
+static void
+PlayGames(_Inout_ Minefield* field, _Inout_opt_ SolverCache* cache, _Inout_ SolverResult* result, _Out_ CacheRun* run)
+{
+    run->seconds = 0.0;
+    run->games = 0;
+    run->hashMismatches = 0;
+
+    if (cache != NULL)
+    {
+        cache->lookups = 0;
+        cache->hits = 0;
+        cache->candidatesSaved = 0;
+    }
+
+    for (uint32_t seed = 1; run->games < CACHE_GAMES; seed++)
+    {
+        if (!GenerateBenchmarkBoard(field, 30, 16, 99, seed) || !RevealFirstOpening(field))
+            continue;
+
+        double start = GetBenchmarkSeconds();
+        PlayUntilStuck(field, cache, result);
+        run->seconds += GetBenchmarkSeconds() - start;
+
+        if (field->hash != ComputeMinefieldHash(field))
+            run->hashMismatches++;
+
+        run->games++;
+    }
+
+    run->lookups = cache != NULL ? cache->lookups : 0;
+    run->hits = cache != NULL ? cache->hits : 0;
+    run->candidatesSaved = cache != NULL ? cache->candidatesSaved : 0;
+}
+
+static void
+PrintCachedRun(_In_z_ const char* label, _In_ const CacheRun* run, _In_ const CacheRun* baseline)
+{
+    printf("  %-12s %8.1f ms, %5.1f%% hit rate, %.1f%% time saved, %.2fM candidates skipped\n",
+           label,
+           run->seconds * 1e3,
+           run->lookups > 0 ? 100.0 * (double)run->hits / (double)run->lookups : 0.0,
+           100.0 * (1.0 - run->seconds / baseline->seconds),
+           (double)run->candidatesSaved / 1e6);
+}
+
+void
+RunSolverCacheBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    SolverResult* result = HeapAlloc(hHeap, 0, sizeof(SolverResult));
+    SolverCache cache;
+
+    if (field != NULL && result != NULL && CreateSolverCache(&cache, SOLVER_CACHE_DEFAULT_ENTRIES))
+    {
+        CacheRun uncached;
+        CacheRun cold;
+        CacheRun warm;
+
+        PlayGames(field, NULL, result, &uncached);
+        PlayGames(field, &cache, result, &cold);
+        PlayGames(field, &cache, result, &warm);
+
+        printf("Expert games played until stuck: %u games, %u hash mismatches\n",
+               uncached.games,
+               uncached.hashMismatches + cold.hashMismatches + warm.hashMismatches);
+        printf("  %-12s %8.1f ms\n", "uncached", uncached.seconds * 1e3);
+        PrintCachedRun("cold cache", &cold, &uncached);
+        PrintCachedRun("replayed", &warm, &uncached);
+
+        DestroySolverCache(&cache);
+    }
+
+    HeapFree(hHeap, 0, field);
+    HeapFree(hHeap, 0, result);
+}
@@ -0,0 +1,67 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "chunkfield.h"
+
+#define CHUNK_BENCH_DENSITY 0.12
+#define CHUNK_BENCH_RESIDENT 1024
+#define CHUNK_BENCH_SPACING 37
+#define CHUNK_BENCH_CLICKS_PER_ROW 1024
+#define CHUNK_BENCH_TARGET 100000000ull
+
+void
+RunChunkFieldBenchmark(void)
+{
+    ChunkField field;
+    uint64_t milestone = 100000;
+    uint64_t clicks = 0;
+
+    if (!CreateChunkField(&field, 1, CHUNK_BENCH_DENSITY, CHUNK_BENCH_RESIDENT))
+    {
+        printf("Could not create the board\n");
+        return;
+    }
+
+    printf("Unbounded, 12%% mines, %u resident chunks of %ux%u\n", CHUNK_BENCH_RESIDENT, CHUNK_SIDE, CHUNK_SIDE);
+
+    double start = GetBenchmarkSeconds();
+
+    // Clicks a spread-out grid of openings, row after row, skipping mines and numbers so the game never ends.
+    for (uint64_t i = 0; field.revealedCells < CHUNK_BENCH_TARGET; i++)
+    {
+        int32_t x = (int32_t)(i % CHUNK_BENCH_CLICKS_PER_ROW) * CHUNK_BENCH_SPACING;
+        int32_t y = (int32_t)(i / CHUNK_BENCH_CLICKS_PER_ROW) * CHUNK_BENCH_SPACING;
+
+        if (GetChunkCell(&field, x, y) != 0 || GetChunkCellState(&field, x, y) != 0)
+            continue;
+
+        if (!RevealChunkCell(&field, x, y))
+        {
+            printf("  out of memory after %llu cells\n", (unsigned long long)field.revealedCells);
+            break;
+        }
+
+        clicks++;
+
+        if (field.revealedCells >= milestone)
+        {
+            uint64_t memory = GetChunkFieldMemory(&field);
+            double elapsed = GetBenchmarkSeconds() - start;
+
+            printf("  %10llu cells revealed: %7.1f MB resident, %6.3f bytes per cell, %6u deltas, "
+                   "%8llu chunks built, %8llu evicted, %5.1f M cells/s\n",
+                   (unsigned long long)field.revealedCells,
+                   (double)memory / (1024.0 * 1024.0),
+                   (double)memory / (double)field.revealedCells,
+                   field.deltaCount,
+                   (unsigned long long)field.builtChunks,
+                   (unsigned long long)field.evictedChunks,
+                   (double)field.revealedCells / elapsed / 1e6);
+
+            milestone *= 10;
+        }
+    }
+
+    printf("  %llu clicks\n", (unsigned long long)clicks);
+    DestroyChunkField(&field);
+}
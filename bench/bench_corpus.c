@@ -0,0 +1,162 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "corpus.h"
+#include "corpusstats.h"
+#include "parallel.h"
+#include "random.h"
+#include "replay.h"
+
+#define CORPUS_BENCH_REPLAYS 1000000
+#define CORPUS_BENCH_DISTINCT_GAMES 65536
+#define CORPUS_BENCH_DISTINCT_BYTES (64 << 20)
+
+// Every fourth game is won by a player that reveals only safe cells; the rest reveal at random until they hit a mine.
+static void
+PlayCorpusGame(_Inout_ Minefield* field, _Inout_ ReplayLog* log, _In_ uint32_t game)
+{
+    static const Difficulty difficulties[] = {DIFFICULTY_BEGINNER, DIFFICULTY_INTERMEDIATE, DIFFICULTY_EXPERT};
+
+    struct splitmix64_state random = {
+        .s = mix64(game),
+    };
+
+    CreateMinefield(field, difficulties[game % ARRAYSIZE(difficulties)]);
+    AttachReplayLog(field, log);
+    field->seed = mix64(~(uint64_t)game);
+
+    uint32_t cellCount = field->width * field->height;
+    bool safeOnly = game % 4 == 0;
+
+    RevealCell(field, field->width / 2, field->height / 2);
+
+    while (field->state == GAME_PLAYING)
+    {
+        uint32_t cell = (uint32_t)(splitmix64(&random) % cellCount);
+
+        if (field->cells[cell].state != CELL_HIDDEN || (safeOnly && field->cells[cell].hasMine))
+            continue;
+
+        RevealCell(field, cell % field->width, cell / field->width);
+    }
+}
+
+// Packs a million replays into a temporary corpus file. Distinct games are cycled through so the corpus can be built
+// in seconds, but every replay is stored and scanned on its own.
+static bool
+WriteBenchmarkCorpus(_In_z_ const char* path, _Out_ uint64_t* bytes)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    ReplayLog* log = HeapAlloc(hHeap, 0, sizeof(ReplayLog));
+    uint8_t* files = HeapAlloc(hHeap, 0, CORPUS_BENCH_DISTINCT_BYTES);
+    uint32_t* offsets = HeapAlloc(hHeap, 0, sizeof(uint32_t) * (CORPUS_BENCH_DISTINCT_GAMES + 1));
+    uint8_t* file = HeapAlloc(hHeap, 0, REPLAY_FILE_MAX_SIZE);
+    CorpusWriter writer;
+    bool success = field != NULL && log != NULL && files != NULL && offsets != NULL && file != NULL;
+
+    *bytes = 0;
+
+    if (success)
+        offsets[0] = 0;
+
+    for (uint32_t game = 0; success && game < CORPUS_BENCH_DISTINCT_GAMES; game++)
+    {
+        PlayCorpusGame(field, log, game);
+
+        uint32_t size = EncodeReplayFile(field, file);
+
+        success = offsets[game] + size <= CORPUS_BENCH_DISTINCT_BYTES;
+
+        if (success)
+        {
+            CopyMemory(files + offsets[game], file, size);
+            offsets[game + 1] = offsets[game] + size;
+        }
+    }
+
+    if (success && CreateCorpusWriter(&writer, path))
+    {
+        for (uint32_t i = 0; success && i < CORPUS_BENCH_REPLAYS; i++)
+        {
+            uint32_t game = i % CORPUS_BENCH_DISTINCT_GAMES;
+
+            success = AppendCorpusReplay(&writer, files + offsets[game], offsets[game + 1] - offsets[game]);
+        }
+
+        *bytes = writer.offset;
+        success = CloseCorpusWriter(&writer) && success;
+    }
+    else
+    {
+        success = false;
+    }
+
+    HeapFree(hHeap, 0, file);
+    HeapFree(hHeap, 0, offsets);
+    HeapFree(hHeap, 0, files);
+    HeapFree(hHeap, 0, log);
+    HeapFree(hHeap, 0, field);
+
+    return success;
+}
+
+void
+RunCorpusBenchmark(void)
+{
+    char directory[MAX_PATH];
+    char path[MAX_PATH];
+    uint64_t bytes;
+
+    if (GetTempPathA(ARRAYSIZE(directory), directory) == 0 || GetTempFileNameA(directory, "msc", 0, path) == 0)
+    {
+        printf("Cannot create a temporary file\n");
+        return;
+    }
+
+    double start = GetBenchmarkSeconds();
+
+    if (!WriteBenchmarkCorpus(path, &bytes))
+    {
+        printf("Cannot write the corpus (error %lu)\n", GetLastError());
+        DeleteFileA(path);
+        return;
+    }
+
+    printf("%u replays of %u distinct games packed in %.2f s, %.1f MB\n",
+           CORPUS_BENCH_REPLAYS,
+           CORPUS_BENCH_DISTINCT_GAMES,
+           GetBenchmarkSeconds() - start,
+           (double)bytes / (1024.0 * 1024.0));
+
+    HANDLE hHeap = GetProcessHeap();
+    CorpusStats* stats = HeapAlloc(hHeap, 0, sizeof(CorpusStats));
+    ReplayCorpus corpus;
+
+    if (stats != NULL && OpenReplayCorpus(&corpus, path))
+    {
+        uint32_t maxThreads = GetParallelThreadCount();
+
+        for (uint32_t threads = 1;; threads = min(threads * 2, maxThreads))
+        {
+            if (!AnalyzeReplayCorpus(&corpus, threads, stats))
+                break;
+
+            const DifficultyStats* expert = &stats->difficulties[DIFFICULTY_EXPERT];
+
+            printf("  %2u threads: %10.0f replays/s, Expert win rate %.1f%%, mean 3BV %.1f\n",
+                   threads,
+                   (double)stats->replays / stats->seconds,
+                   expert->wins * 100.0 / (double)expert->games,
+                   (double)expert->bbbv / (double)expert->wins);
+
+            if (threads == maxThreads)
+                break;
+        }
+
+        CloseReplayCorpus(&corpus);
+    }
+
+    HeapFree(hHeap, 0, stats);
+    DeleteFileA(path);
+}
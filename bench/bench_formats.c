@@ -0,0 +1,336 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "mbf.h"
+#include "random.h"
+#include "rawvf.h"
+
+#define FORMATS_BENCH_GAMES 768
+#define FORMATS_BENCH_REPEATS 3
+#define FORMATS_BENCH_CHUNK_SIZE 4096
+#define FORMATS_BENCH_MUTANTS 20000
+#define FORMATS_BENCH_MAX_FUZZ_CHUNK 97
+#define FORMATS_BENCH_MAX_INSERT 32
+
+typedef struct
+{
+    Minefield* field;
+    ReplayLog* log;
+    Minefield* imported;
+    Minefield* chunked;
+    RawvfParser* parser;
+    char* videos;
+    uint32_t* offsets;
+    uint8_t* boards;
+    char* mutant;
+} FormatsWorkspace;
+
+typedef struct
+{
+    uint64_t mutants;
+    uint64_t rejected;
+    uint64_t mismatches;
+    uint64_t boards;
+    uint64_t boardsRejected;
+} FuzzTotals;
+
+// A player that knows the mines flags, reveals and chords every cell in a random order, so each game is a long
+// video of all three actions.
+static void
+PlayFormatsGame(_Inout_ Minefield* field, _Inout_ ReplayLog* log, _In_ uint32_t game)
+{
+    static const Difficulty difficulties[] = {DIFFICULTY_BEGINNER, DIFFICULTY_INTERMEDIATE, DIFFICULTY_EXPERT};
+
+    struct splitmix64_state random = {
+        .s = mix64(game),
+    };
+
+    CreateMinefield(field, difficulties[game % ARRAYSIZE(difficulties)]);
+    AttachReplayLog(field, log);
+    field->seed = mix64(~(uint64_t)game);
+
+    uint32_t cellCount = field->width * field->height;
+
+    RevealCell(field, field->width / 2, field->height / 2);
+
+    while (field->state == GAME_PLAYING)
+    {
+        uint32_t cell = (uint32_t)(splitmix64(&random) % cellCount);
+        uint32_t x = cell % field->width;
+        uint32_t y = cell / field->width;
+
+        if (field->cells[cell].state == CELL_REVEALED)
+            ChordCell(field, x, y);
+        else if (field->cells[cell].hasMine && field->cells[cell].state == CELL_HIDDEN)
+            ToggleFlag(field, x, y);
+        else if (!field->cells[cell].hasMine)
+            RevealCell(field, x, y);
+    }
+}
+
+static bool
+ImportRawvf(
+    _Inout_ RawvfParser* parser,
+    _Inout_ Minefield* field,
+    _In_reads_bytes_(size) const char* text,
+    _In_ uint32_t size,
+    _In_ uint32_t chunkSize)
+{
+    bool success = true;
+
+    BeginRawvfParse(parser, field);
+
+    for (uint32_t offset = 0; success && offset < size; offset += chunkSize)
+        success = ParseRawvfChunk(parser, text + offset, min(chunkSize, size - offset));
+
+    return EndRawvfParse(parser) && success;
+}
+
+// Imports a video whole and then split into chunks of random size; both must agree on the outcome, to the line that
+// failed or to the hash of the board that was played.
+static bool
+CompareImports(
+    _Inout_ FormatsWorkspace* workspace,
+    _In_reads_bytes_(size) const char* text,
+    _In_ uint32_t size,
+    _Inout_ struct splitmix64_state* random,
+    _Out_ bool* accepted)
+{
+    RawvfParser* parser = workspace->parser;
+
+    *accepted = ImportRawvf(parser, workspace->imported, text, size, max(size, 1));
+
+    uint32_t line = parser->line;
+    uint32_t actions = parser->actions;
+
+    BeginRawvfParse(parser, workspace->chunked);
+
+    bool success = true;
+
+    for (uint32_t offset = 0; success && offset < size;)
+    {
+        uint32_t chunk = (uint32_t)(splitmix64(random) % FORMATS_BENCH_MAX_FUZZ_CHUNK) + 1;
+
+        chunk = min(chunk, size - offset);
+
+        success = ParseRawvfChunk(parser, text + offset, chunk);
+        offset += chunk;
+    }
+
+    success = EndRawvfParse(parser) && success;
+
+    if (success != *accepted || parser->line != line)
+        return false;
+
+    return !success || (parser->actions == actions && workspace->chunked->hash == workspace->imported->hash &&
+                        workspace->chunked->state == workspace->imported->state);
+}
+
+static uint32_t
+MutateInput(
+    _Out_writes_bytes_to_(size + FORMATS_BENCH_MAX_INSERT, return) char* mutant,
+    _In_reads_bytes_(size) const char* input,
+    _In_ uint32_t size,
+    _Inout_ struct splitmix64_state* random)
+{
+    static const char alphabet[] = "0123456789 .-*:\r\nlrmc()";
+
+    uint32_t position = (uint32_t)(splitmix64(random) % size);
+    uint32_t length = (uint32_t)(splitmix64(random) % FORMATS_BENCH_MAX_INSERT) + 1;
+
+    switch (splitmix64(random) % 4)
+    {
+        case 0:
+            CopyMemory(mutant, input, size);
+            mutant[position] = (char)splitmix64(random);
+            return size;
+        case 1:
+            CopyMemory(mutant, input, position);
+            return position;
+        case 2:
+            length = min(length, size - position);
+            CopyMemory(mutant, input, position);
+            CopyMemory(mutant + position, input + position + length, size - position - length);
+            return size - length;
+        default:
+            CopyMemory(mutant, input, position);
+
+            for (uint32_t i = 0; i < length; i++)
+                mutant[position + i] = alphabet[splitmix64(random) % (ARRAYSIZE(alphabet) - 1)];
+
+            CopyMemory(mutant + position + length, input + position, size - position);
+            return size + length;
+    }
+}
+
+static void
+FuzzFormats(_Inout_ FormatsWorkspace* workspace, _Out_ FuzzTotals* totals)
+{
+    struct splitmix64_state random = {
+        .s = 0x6d696e65ULL,
+    };
+
+    ZeroMemory(totals, sizeof(FuzzTotals));
+
+    for (uint32_t i = 0; i < FORMATS_BENCH_MUTANTS; i++)
+    {
+        uint32_t game = (uint32_t)(splitmix64(&random) % FORMATS_BENCH_GAMES);
+        const char* video = workspace->videos + workspace->offsets[game];
+        uint32_t size = workspace->offsets[game + 1] - workspace->offsets[game];
+        uint32_t mutantSize = MutateInput(workspace->mutant, video, size, &random);
+        bool accepted;
+
+        totals->mutants++;
+        totals->mismatches += CompareImports(workspace, workspace->mutant, mutantSize, &random, &accepted) ? 0 : 1;
+        totals->rejected += accepted ? 0 : 1;
+
+        const uint8_t* board = workspace->boards + (size_t)game * MBF_MAX_SIZE;
+        uint32_t boardSize = MBF_HEADER_SIZE + ((uint32_t)board[2] << 8 | board[3]) * 2;
+
+        mutantSize = MutateInput(workspace->mutant, (const char*)board, boardSize, &random);
+        totals->boards++;
+        totals->boardsRejected += LoadMbfBoard(workspace->imported, (uint8_t*)workspace->mutant, mutantSize) ? 0 : 1;
+    }
+}
+
+static bool
+WriteFormatsInputs(_Inout_ FormatsWorkspace* workspace, _Out_ uint64_t* mismatches)
+{
+    char* video = workspace->videos;
+
+    *mismatches = 0;
+    workspace->offsets[0] = 0;
+
+    for (uint32_t game = 0; game < FORMATS_BENCH_GAMES; game++)
+    {
+        PlayFormatsGame(workspace->field, workspace->log, game);
+
+        uint32_t size = ExportRawvf(workspace->field, workspace->log, video);
+
+        if (size == 0 || SaveMbfBoard(workspace->field, workspace->boards + (size_t)game * MBF_MAX_SIZE) == 0)
+            return false;
+
+        // The imported video has to replay to the very board the game ended on.
+        if (!ImportRawvf(workspace->parser, workspace->imported, video, size, size) ||
+            workspace->imported->hash != workspace->field->hash ||
+            workspace->imported->state != workspace->field->state)
+        {
+            (*mismatches)++;
+        }
+
+        workspace->offsets[game + 1] = workspace->offsets[game] + size;
+        video += size;
+    }
+
+    return true;
+}
+
+void
+RunFormatsBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    FormatsWorkspace workspace = {
+        .field = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .log = HeapAlloc(hHeap, 0, sizeof(ReplayLog)),
+        .imported = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .chunked = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .parser = HeapAlloc(hHeap, 0, sizeof(RawvfParser)),
+        .offsets = HeapAlloc(hHeap, 0, sizeof(uint32_t) * (FORMATS_BENCH_GAMES + 1)),
+        .boards = HeapAlloc(hHeap, 0, (size_t)MBF_MAX_SIZE * FORMATS_BENCH_GAMES),
+        .mutant = HeapAlloc(hHeap, 0, RAWVF_MAX_SIZE + FORMATS_BENCH_MAX_INSERT),
+    };
+
+    // Videos are written back to back. Each stays well under 64 KB, so only the last needs room for the longest.
+    size_t videoBytes = (size_t)FORMATS_BENCH_GAMES * (RAWVF_MAX_HEADER_SIZE + 64 * 1024) + RAWVF_MAX_SIZE;
+
+    workspace.videos = HeapAlloc(hHeap, 0, videoBytes);
+
+    uint64_t mismatches;
+
+    if (workspace.field == NULL || workspace.log == NULL || workspace.imported == NULL || workspace.chunked == NULL ||
+        workspace.parser == NULL || workspace.offsets == NULL || workspace.boards == NULL ||
+        workspace.mutant == NULL || workspace.videos == NULL || !WriteFormatsInputs(&workspace, &mismatches))
+    {
+        printf("Cannot prepare the inputs\n");
+    }
+    else
+    {
+        uint32_t bytes = workspace.offsets[FORMATS_BENCH_GAMES];
+        double whole = 0.0, chunked = 0.0, boards = 0.0;
+
+        printf("%u games exported: %.1f MB of RAWVF, %u imports that do not replay to the same board\n",
+               FORMATS_BENCH_GAMES,
+               bytes / (1024.0 * 1024.0),
+               (uint32_t)mismatches);
+
+        for (uint32_t repeat = 0; repeat < FORMATS_BENCH_REPEATS; repeat++)
+        {
+            double start = GetBenchmarkSeconds();
+
+            for (uint32_t game = 0; game < FORMATS_BENCH_GAMES; game++)
+            {
+                const char* video = workspace.videos + workspace.offsets[game];
+                uint32_t size = workspace.offsets[game + 1] - workspace.offsets[game];
+
+                ImportRawvf(workspace.parser, workspace.imported, video, size, size);
+            }
+
+            double middle = GetBenchmarkSeconds();
+
+            for (uint32_t game = 0; game < FORMATS_BENCH_GAMES; game++)
+            {
+                ImportRawvf(workspace.parser,
+                            workspace.imported,
+                            workspace.videos + workspace.offsets[game],
+                            workspace.offsets[game + 1] - workspace.offsets[game],
+                            FORMATS_BENCH_CHUNK_SIZE);
+            }
+
+            double end = GetBenchmarkSeconds();
+
+            for (uint32_t game = 0; game < FORMATS_BENCH_GAMES; game++)
+            {
+                const uint8_t* board = workspace.boards + (size_t)game * MBF_MAX_SIZE;
+
+                LoadMbfBoard(workspace.imported, board, MBF_HEADER_SIZE + ((uint32_t)board[2] << 8 | board[3]) * 2);
+            }
+
+            double last = GetBenchmarkSeconds();
+
+            whole = repeat == 0 ? middle - start : min(whole, middle - start);
+            chunked = repeat == 0 ? end - middle : min(chunked, end - middle);
+            boards = repeat == 0 ? last - end : min(boards, last - end);
+        }
+
+        printf("  RAWVF in one buffer:      %8.1f MB/s, %9.0f videos/s\n",
+               bytes / (1024.0 * 1024.0) / whole,
+               FORMATS_BENCH_GAMES / whole);
+        printf("  RAWVF in %u-byte chunks: %8.1f MB/s, %9.0f videos/s\n",
+               FORMATS_BENCH_CHUNK_SIZE,
+               bytes / (1024.0 * 1024.0) / chunked,
+               FORMATS_BENCH_GAMES / chunked);
+        printf("  MBF boards:               %8.0f boards/s\n", FORMATS_BENCH_GAMES / boards);
+
+        FuzzTotals fuzz;
+
+        FuzzFormats(&workspace, &fuzz);
+
+        printf("  fuzzed %llu RAWVF mutants (%llu rejected, %llu whole and chunked imports disagree) and %llu MBF "
+               "mutants (%llu rejected)\n",
+               (unsigned long long)fuzz.mutants,
+               (unsigned long long)fuzz.rejected,
+               (unsigned long long)fuzz.mismatches,
+               (unsigned long long)fuzz.boards,
+               (unsigned long long)fuzz.boardsRejected);
+    }
+
+    HeapFree(hHeap, 0, workspace.videos);
+    HeapFree(hHeap, 0, workspace.mutant);
+    HeapFree(hHeap, 0, workspace.boards);
+    HeapFree(hHeap, 0, workspace.offsets);
+    HeapFree(hHeap, 0, workspace.parser);
+    HeapFree(hHeap, 0, workspace.chunked);
+    HeapFree(hHeap, 0, workspace.imported);
+    HeapFree(hHeap, 0, workspace.log);
+    HeapFree(hHeap, 0, workspace.field);
+}
@@ -0,0 +1,101 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "hashfield.h"
+
+#define HASH_QUERY_SIDE 4096
+#define HASH_CLICK_SPACING 37
+#define HASH_CLICKS_PER_ROW 1024
+
+typedef struct
+{
+    const char* name;
+    double density;
+    uint64_t revealTarget;
+} HashFieldConfiguration;
+
+static void
+BenchmarkQueries(_In_ const HashField* field)
+{
+    uint64_t mines = 0;
+    uint64_t counts = 0;
+
+    double start = GetBenchmarkSeconds();
+
+    for (int32_t y = 0; y < HASH_QUERY_SIDE; y++)
+    {
+        for (int32_t x = 0; x < HASH_QUERY_SIDE; x++)
+            mines += IsHashMine(field, x, y);
+    }
+
+    double queried = GetBenchmarkSeconds();
+
+    for (int32_t y = 0; y < HASH_QUERY_SIDE / 4; y++)
+    {
+        for (int32_t x = 0; x < HASH_QUERY_SIDE; x++)
+            counts += GetHashNeighborCount(field, x, y);
+    }
+
+    double counted = GetBenchmarkSeconds();
+    double cells = (double)HASH_QUERY_SIDE * HASH_QUERY_SIDE;
+
+    printf("  mine queries   %7.1f M/s (%.2f%% mines)\n", cells / (queried - start) / 1e6, mines * 100.0 / cells);
+    printf("  count queries  %7.1f M/s (mean %.2f)\n", cells / 4 / (counted - queried) / 1e6, counts * 4.0 / cells);
+}
+
+// Clicks a spread-out grid of openings, skipping mines and numbers so the game never ends, until enough is revealed.
+static void
+BenchmarkExploration(_Inout_ HashField* field, _In_ uint64_t target)
+{
+    uint64_t clicks = 0;
+    double start = GetBenchmarkSeconds();
+
+    for (uint64_t i = 0; field->revealedCells < target; i++)
+    {
+        int32_t x = (int32_t)(i % HASH_CLICKS_PER_ROW) * HASH_CLICK_SPACING;
+        int32_t y = (int32_t)(i / HASH_CLICKS_PER_ROW) * HASH_CLICK_SPACING;
+
+        if (IsHashMine(field, x, y) || GetHashNeighborCount(field, x, y) != 0 || GetHashCellState(field, x, y) != 0)
+            continue;
+
+        if (!RevealHashCell(field, x, y))
+        {
+            printf("  out of memory after %llu cells\n", (unsigned long long)field->revealedCells);
+            return;
+        }
+
+        clicks++;
+    }
+
+    double elapsed = GetBenchmarkSeconds() - start;
+    uint64_t memory = GetHashFieldMemory(field);
+
+    printf("  exploration    %7.1f M cells/s, %llu clicks, %llu cells revealed, %.1f MB, %.1f bytes per cell\n",
+           (double)field->revealedCells / elapsed / 1e6,
+           (unsigned long long)clicks,
+           (unsigned long long)field->revealedCells,
+           (double)memory / (1024.0 * 1024.0),
+           (double)memory / (double)field->revealedCells);
+}
+
+void
+RunHashFieldBenchmark(void)
+{
+    static const HashFieldConfiguration configurations[] = {
+        {"20.6%", 0.206, 1000000},
+        {"12%", 0.12, 10000000},
+    };
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+    {
+        HashField field;
+
+        if (!CreateHashField(&field, 1, configurations[i].density))
+            continue;
+
+        printf("Unbounded, %s mines\n", configurations[i].name);
+        BenchmarkQueries(&field);
+        BenchmarkExploration(&field, configurations[i].revealTarget);
+        DestroyHashField(&field);
+    }
+}
@@ -0,0 +1,278 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "journal.h"
+#include "random.h"
+
+#define JOURNAL_BENCH_COPIES 10000
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t games;
+} JournalConfiguration;
+
+typedef struct
+{
+    double playSeconds;
+    double journaledSeconds;
+    double undoSeconds;
+    double redoSeconds;
+    uint64_t moves;
+    uint64_t cells;
+    uint64_t bytes;
+    uint64_t mismatches;
+} JournalTotals;
+
+// Visits every cell in a random order, flagging mines, revealing safe cells and chording numbers, as a player that
+// knows where the mines are would.
+static void
+PlayKnownMoves(_Inout_ Minefield* field, _Inout_ uint16_t* order, _In_ uint64_t seed)
+{
+    uint32_t cellCount = field->width * field->height;
+
+    struct splitmix64_state random = {
+        .s = seed,
+    };
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        order[i] = (uint16_t)i;
+
+    for (uint32_t i = cellCount - 1; i > 0; i--)
+    {
+        uint32_t j = (uint32_t)(splitmix64(&random) % (i + 1));
+        uint16_t swap = order[i];
+
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    RevealCell(field, field->width / 2, field->height / 2);
+
+    for (uint32_t i = 0; i < cellCount && field->state == GAME_PLAYING; i++)
+    {
+        uint32_t x = order[i] % field->width;
+        uint32_t y = order[i] / field->width;
+        const Cell* cell = &field->cells[order[i]];
+
+        if (cell->state == CELL_REVEALED)
+            ChordCell(field, x, y);
+        else if (cell->hasMine)
+            ToggleFlag(field, x, y);
+        else
+            RevealCell(field, x, y);
+    }
+}
+
+// A copy of a position with an opening index of its own, so that the copies can be compared.
+static void
+CopyPosition(_Out_ Minefield* copy, _Out_ OpeningIndex* openings, _In_ const Minefield* field)
+{
+    CopyMemory(copy, field, sizeof(Minefield));
+    copy->openings = openings;
+    openings->indexed = false;
+
+    if (field->openings != NULL && field->openings->indexed)
+        CopyMemory(openings, field->openings, sizeof(OpeningIndex));
+}
+
+static bool
+IsSamePosition(_In_ const Minefield* a, _In_ const Minefield* b)
+{
+    if (a->hash != b->hash || a->state != b->state || a->revealedCells != b->revealedCells ||
+        a->flaggedCells != b->flaggedCells || a->firstClick != b->firstClick)
+    {
+        return false;
+    }
+
+    if (a->openings->indexed != b->openings->indexed)
+        return false;
+
+    for (uint32_t i = 0; a->openings->indexed && i < a->openings->count; i++)
+    {
+        if (a->openings->opened[i] != b->openings->opened[i] || a->openings->flagged[i] != b->openings->flagged[i])
+            return false;
+    }
+
+    return true;
+}
+
+// Plays each game twice from the same seed, once plain and once journaled, then undoes every move back to the
+// start and redoes them all, checking the position at both ends against the plain game.
+static void
+BenchmarkGames(
+    _In_ const JournalConfiguration* configuration,
+    _Inout_ MoveJournal* journal,
+    _Inout_ Minefield* field,
+    _Inout_ Minefield* start,
+    _Inout_ Minefield* finish,
+    _Inout_updates_(3) OpeningIndex* openings,
+    _Inout_ uint16_t* order,
+    _Inout_ JournalTotals* totals)
+{
+    for (uint32_t game = 0; game < configuration->games; game++)
+    {
+        CreateCustomMinefield(finish, configuration->width, configuration->height, configuration->mines);
+        finish->seed = mix64(game + 1);
+        AttachOpeningIndex(finish, &openings[2]);
+        CopyPosition(start, &openings[1], finish);
+
+        double begin = GetBenchmarkSeconds();
+
+        PlayKnownMoves(finish, order, mix64(~(uint64_t)game));
+        totals->playSeconds += GetBenchmarkSeconds() - begin;
+
+        CopyPosition(field, &openings[0], start);
+        AttachMoveJournal(field, journal);
+        begin = GetBenchmarkSeconds();
+        PlayKnownMoves(field, order, mix64(~(uint64_t)game));
+        totals->journaledSeconds += GetBenchmarkSeconds() - begin;
+
+        totals->moves += journal->moveCount;
+        totals->cells += journal->cellCount;
+        totals->bytes += GetMoveJournalSize(journal);
+        totals->mismatches += IsSamePosition(field, finish) ? 0 : 1;
+
+        begin = GetBenchmarkSeconds();
+
+        while (UndoMove(field))
+            ;
+
+        totals->undoSeconds += GetBenchmarkSeconds() - begin;
+        totals->mismatches += IsSamePosition(field, start) ? 0 : 1;
+        begin = GetBenchmarkSeconds();
+
+        while (RedoMove(field))
+            ;
+
+        totals->redoSeconds += GetBenchmarkSeconds() - begin;
+        totals->mismatches += IsSamePosition(field, finish) ? 0 : 1;
+    }
+}
+
+// A sparse 100x100 board, where the first click floods most of the board, undone and redone in turn.
+static void
+BenchmarkFloodFill(
+    _Inout_ MoveJournal* journal,
+    _Inout_ Minefield* field,
+    _Inout_ Minefield* start,
+    _Inout_ Minefield* finish,
+    _Inout_updates_(3) OpeningIndex* openings,
+    _In_ uint32_t mines,
+    _In_ uint32_t boards)
+{
+    JournalTotals totals = {0};
+
+    for (uint32_t board = 0; board < boards; board++)
+    {
+        CreateCustomMinefield(field, MAX_CELLS_HORIZONTALLY, MAX_CELLS_VERTICALLY, mines);
+        field->seed = mix64(board + 1);
+        AttachOpeningIndex(field, &openings[0]);
+        CopyPosition(start, &openings[1], field);
+        AttachMoveJournal(field, journal);
+        RevealCell(field, field->width / 2, field->height / 2);
+        CopyPosition(finish, &openings[2], field);
+
+        totals.cells += journal->cellCount;
+        totals.bytes += GetMoveJournalSize(journal);
+
+        double begin = GetBenchmarkSeconds();
+
+        UndoMove(field);
+        totals.undoSeconds += GetBenchmarkSeconds() - begin;
+        totals.mismatches += IsSamePosition(field, start) ? 0 : 1;
+
+        begin = GetBenchmarkSeconds();
+        RedoMove(field);
+        totals.redoSeconds += GetBenchmarkSeconds() - begin;
+        totals.mismatches += IsSamePosition(field, finish) ? 0 : 1;
+    }
+
+    printf("First click on 100x100 with %u mines, %u boards, %u positions differ\n",
+           mines,
+           boards,
+           (uint32_t)totals.mismatches);
+    printf("  %.0f cells revealed, %.0f journal bytes, undo %.2f us, redo %.2f us\n",
+           (double)totals.cells / boards,
+           (double)totals.bytes / boards,
+           totals.undoSeconds * 1e6 / boards,
+           totals.redoSeconds * 1e6 / boards);
+}
+
+// What the journal replaces: a copy of the whole field before every move.
+static double
+TimeMinefieldCopy(_In_ const Minefield* field, _Out_ Minefield* copy)
+{
+    double begin = GetBenchmarkSeconds();
+
+    for (uint32_t i = 0; i < JOURNAL_BENCH_COPIES; i++)
+    {
+        CopyMemory(copy, field, sizeof(Minefield));
+        ((volatile Minefield*)copy)->hash ^= i;
+    }
+
+    return (GetBenchmarkSeconds() - begin) / JOURNAL_BENCH_COPIES;
+}
+
+void
+RunJournalBenchmark(void)
+{
+    static const JournalConfiguration configurations[] = {
+        {"Expert", 30, 16, 99, 20000},
+        {"100x100", 100, 100, 2000, 200},
+    };
+
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    Minefield* start = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    Minefield* finish = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    OpeningIndex* openings = HeapAlloc(hHeap, 0, sizeof(OpeningIndex) * 3);
+    uint16_t* order = HeapAlloc(hHeap, 0, sizeof(uint16_t) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+    MoveJournal journal;
+
+    if (field != NULL && start != NULL && finish != NULL && openings != NULL && order != NULL &&
+        CreateMoveJournal(&journal))
+    {
+        CreateMinefield(field, DIFFICULTY_EXPERT);
+        printf("Copying a Minefield of %u bytes takes %.2f us\n",
+               (uint32_t)sizeof(Minefield),
+               TimeMinefieldCopy(field, start) * 1e6);
+
+        BenchmarkFloodFill(&journal, field, start, finish, openings, 500, 2000);
+        BenchmarkFloodFill(&journal, field, start, finish, openings, 1000, 2000);
+
+        for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+        {
+            JournalTotals totals = {0};
+
+            BenchmarkGames(&configurations[i], &journal, field, start, finish, openings, order, &totals);
+
+            printf("%s, %u games, %.0f moves per game, %u positions differ\n",
+                   configurations[i].name,
+                   configurations[i].games,
+                   (double)totals.moves / configurations[i].games,
+                   (uint32_t)totals.mismatches);
+            printf("  play %7.1f ns per move, journaled %7.1f ns (%+.1f ns)\n",
+                   totals.playSeconds * 1e9 / (double)totals.moves,
+                   totals.journaledSeconds * 1e9 / (double)totals.moves,
+                   (totals.journaledSeconds - totals.playSeconds) * 1e9 / (double)totals.moves);
+            printf("  undo %7.1f ns per move, redo %7.1f ns\n",
+                   totals.undoSeconds * 1e9 / (double)totals.moves,
+                   totals.redoSeconds * 1e9 / (double)totals.moves);
+            printf("  %.2f journal bytes per move, %.2f cells changed\n",
+                   (double)totals.bytes / (double)totals.moves,
+                   (double)totals.cells / (double)totals.moves);
+        }
+
+        DestroyMoveJournal(&journal);
+    }
+
+    HeapFree(hHeap, 0, order);
+    HeapFree(hHeap, 0, openings);
+    HeapFree(hHeap, 0, finish);
+    HeapFree(hHeap, 0, start);
+    HeapFree(hHeap, 0, field);
+}
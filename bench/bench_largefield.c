@@ -0,0 +1,85 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "largefield.h"
+#include "parallel.h"
+#include "random.h"
+
+#define LARGE_FIELD_SIDE 16384
+
+// Every cell's byte and opening label, so that a label differing anywhere changes the hash.
+static uint64_t
+HashLargeField(_In_ const LargeField* field)
+{
+    size_t cellCount = (size_t)field->width * field->height;
+    uint64_t hash = field->openingCount;
+
+    for (size_t i = 0; i < cellCount; i++)
+        hash = mix64(hash ^ ((uint64_t)field->openings[i] << 8 | field->cells[i]));
+
+    return hash;
+}
+
+void
+RunLargeFieldBenchmark(void)
+{
+    // Same density as Expert.
+    uint32_t mines = (uint32_t)((uint64_t)LARGE_FIELD_SIDE * LARGE_FIELD_SIDE * 99 / 480);
+    uint32_t cores = GetParallelThreadCount();
+    uint64_t expected = 0;
+    double baseline = 0.0;
+    LargeField field;
+
+    if (!CreateLargeField(&field, LARGE_FIELD_SIDE, LARGE_FIELD_SIDE, mines, 1, LARGE_LAYOUT_ROWS))
+    {
+        printf("Could not allocate a %ux%u board\n", LARGE_FIELD_SIDE, LARGE_FIELD_SIDE);
+        return;
+    }
+
+    printf("Custom %ux%u, %u mines, %u tiles of %ux%u\n",
+           LARGE_FIELD_SIDE,
+           LARGE_FIELD_SIDE,
+           mines,
+           field.tilesX * field.tilesY,
+           LARGE_FIELD_TILE_SIDE,
+           LARGE_FIELD_TILE_SIDE);
+
+    // The first pass only faults the pages in, which would otherwise be charged to the single-thread run.
+    GenerateLargeField(&field, cores);
+
+    for (uint32_t threads = 1; threads <= cores; threads = threads < cores && threads * 2 > cores ? cores : threads * 2)
+    {
+        double start = GetBenchmarkSeconds();
+        PlaceLargeFieldMines(&field, threads);
+        double placed = GetBenchmarkSeconds();
+        CountLargeFieldNeighbors(&field, threads);
+        double counted = GetBenchmarkSeconds();
+        LabelLargeFieldOpenings(&field, threads);
+        double labeled = GetBenchmarkSeconds();
+
+        uint64_t hash = HashLargeField(&field);
+        double total = labeled - start;
+
+        if (threads == 1)
+        {
+            expected = hash;
+            baseline = total;
+        }
+
+        printf("  %2u threads: place %8.1f ms, count %8.1f ms, label %8.1f ms, total %8.1f ms, %5.2fx, "
+               "%llu openings%s\n",
+               threads,
+               (placed - start) * 1e3,
+               (counted - placed) * 1e3,
+               (labeled - counted) * 1e3,
+               total * 1e3,
+               baseline / total,
+               (unsigned long long)field.openingCount,
+               hash == expected ? "" : " (board differs!)");
+
+        if (threads == cores)
+            break;
+    }
+
+    DestroyLargeField(&field);
+}
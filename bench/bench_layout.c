@@ -0,0 +1,107 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "largefield.h"
+
+typedef struct
+{
+    uint32_t side;
+    uint32_t rounds;
+} LayoutConfiguration;
+
+static const char*
+GetLayoutName(_In_ LargeFieldLayout layout)
+{
+    return layout == LARGE_LAYOUT_BLOCKS ? "8x8 blocks" : "rows";
+}
+
+// The first zero cell to the right of the centre, or of a later row, so the click opens a region.
+static void
+FindZeroCell(_In_ const LargeField* field, _Out_ uint32_t* x, _Out_ uint32_t* y)
+{
+    for (uint64_t i = (uint64_t)field->height / 2 * field->width + field->width / 2;
+         i < (uint64_t)field->width * field->height;
+         i++)
+    {
+        *x = (uint32_t)(i % field->width);
+        *y = (uint32_t)(i / field->width);
+
+        if ((field->cells[GetLargeCellIndex(field, *x, *y)] & (LARGE_CELL_MINE | LARGE_CELL_COUNT_MASK)) == 0)
+            return;
+    }
+
+    *x = field->width / 2;
+    *y = field->height / 2;
+}
+
+static void
+BenchmarkLayout(_In_ const LayoutConfiguration* configuration, _In_ LargeFieldLayout layout)
+{
+    // Sparse enough that the click floods most of the board.
+    uint32_t side = configuration->side;
+    uint32_t mines = (uint32_t)((uint64_t)side * side / 64);
+    double countSeconds = 0.0;
+    double revealSeconds = 0.0;
+    uint64_t revealed = 0;
+    LargeField field;
+
+    if (!CreateLargeField(&field, side, side, mines, 1, layout))
+    {
+        printf("Could not allocate a %ux%u board\n", side, side);
+        return;
+    }
+
+    // Placing the mines once first faults the pages in outside the timed rounds.
+    PlaceLargeFieldMines(&field, 1);
+
+    for (uint32_t round = 0; round < configuration->rounds; round++)
+    {
+        uint32_t x, y;
+
+        PlaceLargeFieldMines(&field, 1);
+
+        double start = GetBenchmarkSeconds();
+        CountLargeFieldNeighbors(&field, 1);
+        double counted = GetBenchmarkSeconds();
+
+        FindZeroCell(&field, &x, &y);
+
+        double clicked = GetBenchmarkSeconds();
+        RevealLargeCell(&field, x, y);
+        double finished = GetBenchmarkSeconds();
+
+        countSeconds += counted - start;
+        revealSeconds += finished - clicked;
+        revealed += field.revealedCells;
+    }
+
+    double cells = (double)side * side * configuration->rounds;
+
+    printf("Custom %5ux%-5u %-10s count %9.2f ms (%5.2f ns/cell), reveal %9.2f ms (%5.2f ns/cell, %3.0f%% of board)\n",
+           side,
+           side,
+           GetLayoutName(layout),
+           countSeconds * 1e3 / configuration->rounds,
+           countSeconds * 1e9 / cells,
+           revealSeconds * 1e3 / configuration->rounds,
+           revealed > 0 ? revealSeconds * 1e9 / (double)revealed : 0.0,
+           (double)revealed * 100.0 / cells);
+
+    DestroyLargeField(&field);
+}
+
+void
+RunLayoutBenchmark(void)
+{
+    static const LayoutConfiguration configurations[] = {
+        {1024, 16},
+        {4096, 4},
+        {16384, 1},
+    };
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+    {
+        BenchmarkLayout(&configurations[i], LARGE_LAYOUT_ROWS);
+        BenchmarkLayout(&configurations[i], LARGE_LAYOUT_BLOCKS);
+    }
+}
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "largefield.h"
+
+#define LAZY_COUNT_SIDE 10000
+#define LAZY_COUNT_ROUNDS 3
+
+typedef struct
+{
+    const char* name;
+    uint32_t minesPerThousand;
+} LazyCountConfiguration;
+
+// The first zero cell to the right of the centre, or of a later row. Needs the counts.
+static void
+FindOpeningCell(_In_ const LargeField* field, _Out_ uint32_t* x, _Out_ uint32_t* y)
+{
+    for (uint64_t i = (uint64_t)field->height / 2 * field->width + field->width / 2;
+         i < (uint64_t)field->width * field->height;
+         i++)
+    {
+        *x = (uint32_t)(i % field->width);
+        *y = (uint32_t)(i / field->width);
+
+        if ((field->cells[GetLargeCellIndex(field, *x, *y)] & (LARGE_CELL_MINE | LARGE_CELL_COUNT_MASK)) == 0)
+            return;
+    }
+
+    *x = field->width / 2;
+    *y = field->height / 2;
+}
+
+static void
+BenchmarkConfiguration(_In_ const LazyCountConfiguration* configuration, _Inout_ LargeField* field)
+{
+    double placeSeconds = 0.0;
+    double eagerSeconds = 0.0;
+    double lazySeconds = 0.0;
+    uint64_t revealed = 0;
+
+    field->mines = (uint32_t)((uint64_t)field->width * field->height * configuration->minesPerThousand / 1000);
+
+    for (uint32_t round = 0; round < LAZY_COUNT_ROUNDS; round++)
+    {
+        uint32_t x, y;
+
+        field->seed = round + 1;
+
+        double start = GetBenchmarkSeconds();
+        PlaceLargeFieldMines(field, 1);
+        placeSeconds += GetBenchmarkSeconds() - start;
+
+        // Every count up front, then the click.
+        start = GetBenchmarkSeconds();
+        CountLargeFieldNeighbors(field, 1);
+        double counted = GetBenchmarkSeconds();
+
+        FindOpeningCell(field, &x, &y);
+
+        double clicked = GetBenchmarkSeconds();
+        RevealLargeCell(field, x, y);
+        eagerSeconds += GetBenchmarkSeconds() - clicked + counted - start;
+
+        uint64_t eagerRevealed = field->revealedCells;
+
+        // The same board and click, counting only what the reveal touches.
+        PlaceLargeFieldMines(field, 1);
+
+        start = GetBenchmarkSeconds();
+        RevealLargeCell(field, x, y);
+        lazySeconds += GetBenchmarkSeconds() - start;
+
+        revealed += field->revealedCells;
+
+        if (field->revealedCells != eagerRevealed)
+            printf("  round %u reveals differ: %llu eager, %llu lazy\n",
+                   round,
+                   (unsigned long long)eagerRevealed,
+                   (unsigned long long)field->revealedCells);
+    }
+
+    double cells = (double)field->width * field->height;
+
+    printf("%-10s %8.0f cells revealed (%.5f%%), place %7.1f ms, first click eager %9.3f ms, lazy %9.3f ms\n",
+           configuration->name,
+           (double)revealed / LAZY_COUNT_ROUNDS,
+           (double)revealed * 100.0 / (cells * LAZY_COUNT_ROUNDS),
+           placeSeconds * 1e3 / LAZY_COUNT_ROUNDS,
+           eagerSeconds * 1e3 / LAZY_COUNT_ROUNDS,
+           lazySeconds * 1e3 / LAZY_COUNT_ROUNDS);
+}
+
+void
+RunLazyCountBenchmark(void)
+{
+    static const LazyCountConfiguration configurations[] = {
+        {"20.6%", 206},
+        {"15%", 150},
+        {"12%", 120},
+    };
+
+    LargeField field;
+
+    if (!CreateLargeField(&field, LAZY_COUNT_SIDE, LAZY_COUNT_SIDE, 0, 1, LARGE_LAYOUT_ROWS))
+    {
+        printf("Could not allocate a %ux%u board\n", LAZY_COUNT_SIDE, LAZY_COUNT_SIDE);
+        return;
+    }
+
+    printf("Custom %ux%u, first click on an opening near the centre\n", LAZY_COUNT_SIDE, LAZY_COUNT_SIDE);
+
+    // Placing the mines once first faults the pages in outside the timed rounds.
+    PlaceLargeFieldMines(&field, 1);
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+        BenchmarkConfiguration(&configurations[i], &field);
+
+    DestroyLargeField(&field);
+}
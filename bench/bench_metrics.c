@@ -0,0 +1,172 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "metrics.h"
+#include "parallel.h"
+#include "random.h"
+
+#define METRICS_EXPERT_LAYOUTS 1024
+#define METRICS_EXPERT_ROUNDS 16
+#define METRICS_LARGE_SIDE 1024
+#define METRICS_LARGE_BOARDS 4
+
+typedef struct
+{
+    const bool* layouts;
+    uint32_t width;
+    uint32_t height;
+    uint32_t layoutCount;
+    uint32_t rounds;
+    uint32_t threads;
+    bool estimateZini;
+    volatile LONG64 bbbvTotal;
+    volatile LONG64 ziniTotal;
+} MetricsJob;
+
+static void
+GenerateLayout(
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _Inout_ struct splitmix64_state* random,
+    _Out_writes_(width* height) bool* layout)
+{
+    uint32_t cellCount = width * height;
+    uint32_t placed = 0;
+
+    ZeroMemory(layout, sizeof(bool) * cellCount);
+
+    while (placed < mines)
+    {
+        uint32_t index = (uint32_t)(((splitmix64(random) >> 32) * cellCount) >> 32);
+
+        if (!layout[index])
+        {
+            layout[index] = true;
+            placed++;
+        }
+    }
+}
+
+static void
+ScoreLayouts(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    MetricsJob* job = (MetricsJob*)context;
+    MetricsWorkspace workspace;
+    uint64_t bbbv = 0;
+    uint64_t zini = 0;
+
+    if (!CreateMetricsWorkspace(&workspace, job->width, job->height))
+        return;
+
+    // Each thread scores its own share of the rounds over the whole set of layouts.
+    for (uint32_t round = index; round < job->rounds; round += job->threads)
+    {
+        for (uint32_t i = 0; i < job->layoutCount; i++)
+        {
+            BoardMetrics metrics;
+            const bool* layout = job->layouts + (size_t)i * job->width * job->height;
+
+            ComputeBoardMetrics(&workspace, job->width, job->height, layout, job->estimateZini, &metrics);
+            bbbv += metrics.bbbv;
+            zini += metrics.zini;
+        }
+    }
+
+    InterlockedExchangeAdd64(&job->bbbvTotal, (LONG64)bbbv);
+    InterlockedExchangeAdd64(&job->ziniTotal, (LONG64)zini);
+    DestroyMetricsWorkspace(&workspace);
+}
+
+static void
+BenchmarkLayouts(
+    _In_z_ const char* name,
+    _In_reads_(layoutCount* width* height) const bool* layouts,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t layoutCount,
+    _In_ uint32_t rounds,
+    _In_ uint32_t threads)
+{
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        MetricsJob job = {
+            .layouts = layouts,
+            .width = width,
+            .height = height,
+            .layoutCount = layoutCount,
+            .rounds = rounds,
+            .threads = threads,
+            .estimateZini = pass == 1,
+        };
+
+        double start = GetBenchmarkSeconds();
+        ParallelFor(threads, threads, ScoreLayouts, &job);
+        double elapsed = GetBenchmarkSeconds() - start;
+
+        double boards = (double)layoutCount * rounds;
+
+        printf("%-26s %-10s %2u threads: %12.0f boards/min, %9.3f ms per board, mean 3BV %.1f",
+               name,
+               pass == 1 ? "3BV+ZiNi" : "3BV",
+               threads,
+               boards * 60.0 / elapsed,
+               elapsed * 1e3 * threads / boards,
+               (double)job.bbbvTotal / boards);
+
+        if (pass == 1)
+            printf(", mean ZiNi %.1f", (double)job.ziniTotal / boards);
+
+        printf("\n");
+    }
+}
+
+void
+RunMetricsBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    bool* expert = HeapAlloc(hHeap, 0, sizeof(bool) * 30 * 16 * METRICS_EXPERT_LAYOUTS);
+    bool* large = HeapAlloc(hHeap, 0, sizeof(bool) * METRICS_LARGE_SIDE * METRICS_LARGE_SIDE * METRICS_LARGE_BOARDS);
+
+    if (expert != NULL && large != NULL)
+    {
+        for (uint32_t i = 0; i < METRICS_EXPERT_LAYOUTS; i++)
+            GenerateLayout(30, 16, 99, &random, expert + (size_t)i * 30 * 16);
+
+        // Same density as Expert.
+        uint32_t largeMines = (uint32_t)((uint64_t)METRICS_LARGE_SIDE * METRICS_LARGE_SIDE * 99 / 480);
+
+        for (uint32_t i = 0; i < METRICS_LARGE_BOARDS; i++)
+        {
+            bool* layout = large + (size_t)i * METRICS_LARGE_SIDE * METRICS_LARGE_SIDE;
+            GenerateLayout(METRICS_LARGE_SIDE, METRICS_LARGE_SIDE, largeMines, &random, layout);
+        }
+
+        BenchmarkLayouts("Expert 30x16, 99", expert, 30, 16, METRICS_EXPERT_LAYOUTS, METRICS_EXPERT_ROUNDS, 1);
+        BenchmarkLayouts("Custom 1024x1024, 20.6%",
+                         large,
+                         METRICS_LARGE_SIDE,
+                         METRICS_LARGE_SIDE,
+                         METRICS_LARGE_BOARDS,
+                         1,
+                         1);
+
+        if (GetParallelThreadCount() > 1)
+        {
+            BenchmarkLayouts("Expert 30x16, 99",
+                             expert,
+                             30,
+                             16,
+                             METRICS_EXPERT_LAYOUTS,
+                             METRICS_EXPERT_ROUNDS * GetParallelThreadCount(),
+                             GetParallelThreadCount());
+        }
+    }
+
+    HeapFree(hHeap, 0, expert);
+    HeapFree(hHeap, 0, large);
+}
@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include <stdlib.h>
+
+#include "bench.h"
+#include "noguess.h"
+#include "parallel.h"
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t boards;
+} NoGuessConfiguration;
+
+static int
+CompareSeconds(_In_ const void* a, _In_ const void* b)
+{
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+
+    return (left > right) - (left < right);
+}
+
+static void
+BenchmarkConfiguration(_In_ const NoGuessConfiguration* configuration, _In_ uint32_t threads, _Inout_ bool* layout)
+{
+    double latencies[64];
+    uint64_t candidates = 0;
+    uint64_t repairs = 0;
+    uint32_t generated = 0;
+    uint32_t failed = 0;
+    double total = 0.0;
+
+    for (uint32_t seed = 1; seed <= configuration->boards; seed++)
+    {
+        NoGuessStats stats;
+        double start = GetBenchmarkSeconds();
+        bool success = GenerateNoGuessLayout(configuration->width,
+                                             configuration->height,
+                                             configuration->mines,
+                                             configuration->width / 2,
+                                             configuration->height / 2,
+                                             seed,
+                                             threads,
+                                             layout,
+                                             &stats);
+        double elapsed = GetBenchmarkSeconds() - start;
+
+        total += elapsed;
+        candidates += stats.candidates;
+        repairs += stats.repairs;
+
+        if (success)
+            latencies[generated++] = elapsed;
+        else
+            failed++;
+    }
+
+    qsort(latencies, generated, sizeof(double), CompareSeconds);
+
+    printf("%-24s %2u threads: %6.2f boards/s", configuration->name, threads, configuration->boards / total);
+
+    if (generated > 0)
+    {
+        printf(", latency p50 %.1f ms, p90 %.1f ms, max %.1f ms",
+               latencies[generated / 2] * 1e3,
+               latencies[generated * 9 / 10] * 1e3,
+               latencies[generated - 1] * 1e3);
+    }
+
+    printf(", %.1f candidates and %.1f repairs per board, %u failed\n",
+           (double)candidates / configuration->boards,
+           (double)repairs / configuration->boards,
+           failed);
+}
+
+void
+RunNoGuessBenchmark(void)
+{
+    static const NoGuessConfiguration configurations[] = {
+        {"Expert 30x16, 99", 30, 16, 99, 64},
+        {"Custom 50x50, 400", 50, 50, 400, 16},
+        {"Custom 100x100, 1600", 100, 100, 1600, 4},
+    };
+
+    bool* layout = HeapAlloc(GetProcessHeap(), 0, sizeof(bool) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+
+    if (layout == NULL)
+        return;
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+    {
+        BenchmarkConfiguration(&configurations[i], 1, layout);
+
+        if (GetParallelThreadCount() > 1)
+            BenchmarkConfiguration(&configurations[i], GetParallelThreadCount(), layout);
+    }
+
+    HeapFree(GetProcessHeap(), 0, layout);
+}
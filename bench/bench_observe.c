@@ -0,0 +1,130 @@
+#include "pch.h"
+
+#include "batchfield.h"
+#include "bench.h"
+#include "random.h"
+
+#define OBSERVE_BENCH_BOARDS 4096
+#define OBSERVE_BENCH_CALLS 256
+#define OBSERVE_BENCH_REPEATS 3
+
+typedef enum
+{
+    OBSERVE_NONE,
+    OBSERVE_IN_PLACE,
+    OBSERVE_REENCODE,
+} ObserveMode;
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+} ObserveConfiguration;
+
+// Microseconds per step of a random player that resets finished games and otherwise reveals a random cell.
+static double
+TimeObservation(
+    _In_ const ObserveConfiguration* configuration,
+    _In_ BatchObservationFormat format,
+    _In_ ObserveMode mode,
+    _Inout_ BatchAction* actions,
+    _Out_ void* buffer)
+{
+    BatchField batch;
+    uint32_t cellCount = configuration->width * configuration->height;
+    double elapsed = 0.0;
+
+    if (!CreateBatchField(
+            &batch, configuration->width, configuration->height, configuration->mines, OBSERVE_BENCH_BOARDS, 1))
+    {
+        return 0.0;
+    }
+
+    if (mode == OBSERVE_IN_PLACE)
+        AttachBatchObservation(&batch, format, buffer);
+
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    for (uint32_t call = 0; call < OBSERVE_BENCH_CALLS; call++)
+    {
+        for (uint32_t board = 0; board < OBSERVE_BENCH_BOARDS; board++)
+        {
+            actions[board].cell = (uint16_t)(splitmix64(&random) % cellCount);
+            actions[board].kind = batch.gameStates[board] == GAME_PLAYING ? BATCH_ACTION_REVEAL : BATCH_ACTION_RESET;
+        }
+
+        double start = GetBenchmarkSeconds();
+        StepBatchField(&batch, actions, 1);
+
+        if (mode == OBSERVE_REENCODE)
+            EncodeBatchObservation(&batch, format, buffer);
+
+        elapsed += GetBenchmarkSeconds() - start;
+    }
+
+    DestroyBatchField(&batch);
+
+    return elapsed / OBSERVE_BENCH_CALLS * 1e6;
+}
+
+// The fastest of a few runs, since the differences measured are small next to the step itself.
+static double
+BenchmarkObservation(
+    _In_ const ObserveConfiguration* configuration,
+    _In_ BatchObservationFormat format,
+    _In_ ObserveMode mode,
+    _Inout_ BatchAction* actions,
+    _Out_ void* buffer)
+{
+    double fastest = TimeObservation(configuration, format, mode, actions, buffer);
+
+    for (uint32_t i = 1; i < OBSERVE_BENCH_REPEATS; i++)
+        fastest = min(fastest, TimeObservation(configuration, format, mode, actions, buffer));
+
+    return fastest;
+}
+
+void
+RunObservationBenchmark(void)
+{
+    static const ObserveConfiguration configurations[] = {
+        {"Beginner", 9, 9, 10},
+        {"Expert", 30, 16, 99},
+    };
+
+    static const char* formatNames[] = {"codes", "one-hot"};
+
+    SIZE_T bufferSize = (SIZE_T)OBSERVE_BENCH_BOARDS * 30 * 16 * BATCH_OBSERVATION_CHANNELS;
+    BatchAction* actions = HeapAlloc(GetProcessHeap(), 0, sizeof(BatchAction) * OBSERVE_BENCH_BOARDS);
+    void* buffer = VirtualAlloc(NULL, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+    if (actions != NULL && buffer != NULL)
+    {
+        for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+        {
+            const ObserveConfiguration* configuration = &configurations[i];
+
+            printf("%s, %u boards, one thread, per step\n", configuration->name, OBSERVE_BENCH_BOARDS);
+
+            for (BatchObservationFormat format = BATCH_OBSERVATION_CODES; format <= BATCH_OBSERVATION_ONE_HOT; format++)
+            {
+                double plain = BenchmarkObservation(configuration, format, OBSERVE_NONE, actions, buffer);
+                double inPlace = BenchmarkObservation(configuration, format, OBSERVE_IN_PLACE, actions, buffer);
+                double reencode = BenchmarkObservation(configuration, format, OBSERVE_REENCODE, actions, buffer);
+
+                printf("  %-8s step %8.1f us, updated in place %+8.1f us, re-encoded %+8.1f us\n",
+                       formatNames[format],
+                       plain,
+                       inPlace - plain,
+                       reencode - plain);
+            }
+        }
+    }
+
+    VirtualFree(buffer, 0, MEM_RELEASE);
+    HeapFree(GetProcessHeap(), 0, actions);
+}
@@ -0,0 +1,172 @@
+#include "pch.h"
+
+#include <stdlib.h>
+
+#include "bench.h"
+#include "boardpool.h"
+#include "noguess.h"
+#include "parallel.h"
+#include "random.h"
+
+#define POOL_BENCHMARK_GAMES 32
+#define POOL_BENCHMARK_PLAY_MS 250
+#define POOL_BENCHMARK_FILL_MS 30000
+
+typedef struct
+{
+    const char* name;
+    BoardSettings settings;
+    bool centerClick;
+} PoolConfiguration;
+
+static int
+CompareSeconds(_In_ const void* a, _In_ const void* b)
+{
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+
+    return (left > right) - (left < right);
+}
+
+static void
+PrintLatencies(_In_z_ const char* label, _Inout_updates_(count) double* latencies, _In_ uint32_t count)
+{
+    qsort(latencies, count, sizeof(double), CompareSeconds);
+
+    printf("  %-8s first click p50 %7.2f ms, p90 %7.2f ms, max %7.2f ms\n",
+           label,
+           latencies[count / 2] * 1e3,
+           latencies[count * 9 / 10] * 1e3,
+           latencies[count - 1] * 1e3);
+}
+
+static void
+GenerateDirectly(
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t x,
+    _In_ uint32_t y,
+    _In_ uint64_t seed,
+    _Out_writes_(settings->width* settings->height) bool* layout)
+{
+    GenerateNoGuessLayout(settings->width, settings->height, settings->mines, x, y, seed, 0, layout, NULL);
+}
+
+static void
+PickFirstClick(
+    _In_ const PoolConfiguration* configuration,
+    _Inout_ struct splitmix64_state* random,
+    _Out_ uint32_t* x,
+    _Out_ uint32_t* y)
+{
+    const BoardSettings* settings = &configuration->settings;
+    uint64_t value = splitmix64(random);
+
+    *x = settings->width / 2;
+    *y = settings->height / 2;
+
+    if (!configuration->centerClick)
+    {
+        *x = (uint32_t)(((value >> 32) * settings->width) >> 32);
+        *y = (uint32_t)(((value & UINT32_MAX) * settings->height) >> 32);
+    }
+}
+
+// Lets the pool fill, then plays a short session with a pause between games the way a player would, and compares the
+// wait on the first click with and without the pool.
+static void
+BenchmarkConfiguration(_In_ const PoolConfiguration* configuration, _In_ BoardPool* pool, _Inout_ bool* layout)
+{
+    const BoardSettings* settings = &configuration->settings;
+    double pooled[POOL_BENCHMARK_GAMES];
+    double direct[POOL_BENCHMARK_GAMES];
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    BoardPoolStats before;
+    BoardPoolStats after;
+
+    SetBoardPoolSettings(pool, settings);
+
+    double fillStart = GetBenchmarkSeconds();
+
+    do
+    {
+        Sleep(10);
+        GetBoardPoolStats(pool, &before);
+    } while (before.available < BOARD_POOL_CAPACITY &&
+             GetBenchmarkSeconds() - fillStart < POOL_BENCHMARK_FILL_MS / 1e3);
+
+    double fillSeconds = GetBenchmarkSeconds() - fillStart;
+
+    for (uint32_t game = 0; game < POOL_BENCHMARK_GAMES; game++)
+    {
+        uint32_t x, y;
+
+        PickFirstClick(configuration, &random, &x, &y);
+        Sleep(POOL_BENCHMARK_PLAY_MS);
+
+        double start = GetBenchmarkSeconds();
+
+        if (!TakePooledBoard(pool, settings, x, y, layout))
+            GenerateDirectly(settings, x, y, game + 1, layout);
+
+        pooled[game] = GetBenchmarkSeconds() - start;
+    }
+
+    GetBoardPoolStats(pool, &after);
+
+    // Measured separately so that direct generation does not take cores away from the pool's workers.
+    random.s = 1;
+
+    for (uint32_t game = 0; game < POOL_BENCHMARK_GAMES; game++)
+    {
+        uint32_t x, y;
+
+        PickFirstClick(configuration, &random, &x, &y);
+
+        double start = GetBenchmarkSeconds();
+        GenerateDirectly(settings, x, y, game + 1, layout);
+        direct[game] = GetBenchmarkSeconds() - start;
+    }
+
+    printf("%s: pool filled to %u in %.2f s; %llu hits, %llu misses, %llu boards generated, %llu discarded\n",
+           configuration->name,
+           before.available,
+           fillSeconds,
+           (unsigned long long)(after.hits - before.hits),
+           (unsigned long long)(after.misses - before.misses),
+           (unsigned long long)(after.generated - before.generated),
+           (unsigned long long)(after.discarded - before.discarded));
+
+    PrintLatencies("pool", pooled, POOL_BENCHMARK_GAMES);
+    PrintLatencies("direct", direct, POOL_BENCHMARK_GAMES);
+}
+
+void
+RunBoardPoolBenchmark(void)
+{
+    static const PoolConfiguration configurations[] = {
+        {"No-guess Expert, center click", {30, 16, 99}, true},
+        {"No-guess Expert, random click", {30, 16, 99}, false},
+        {"No-guess 50x50, 400, random click", {50, 50, 400}, false},
+    };
+
+    BoardPool pool;
+    bool* layout = HeapAlloc(GetProcessHeap(), 0, sizeof(bool) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+
+    if (layout == NULL)
+        return;
+
+    if (!CreateBoardPool(&pool, GetParallelThreadCount() - 1))
+    {
+        HeapFree(GetProcessHeap(), 0, layout);
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+        BenchmarkConfiguration(&configurations[i], &pool, layout);
+
+    DestroyBoardPool(&pool);
+    HeapFree(GetProcessHeap(), 0, layout);
+}
@@ -0,0 +1,203 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "random.h"
+#include "replayer.h"
+
+#define REPLAY_BENCH_REPEATS 3
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t games;
+} ReplayConfiguration;
+
+typedef struct
+{
+    double seconds;
+    uint64_t actions;
+    uint64_t events;
+    uint64_t bytes;
+    uint64_t dropped;
+    double playbackSeconds;
+    uint64_t playbackEvents;
+    uint64_t verified;
+} ReplayTotals;
+
+typedef struct
+{
+    Minefield* field;
+    Minefield* playback;
+    OpeningIndex* openings;
+    ReplayLog* recorder;
+    ReplayLog* log;
+    uint8_t* file;
+    uint16_t* order;
+} ReplayWorkspace;
+
+// A player that knows where the mines are visits every cell in a random order, flagging mines, revealing safe cells
+// and chording numbers, so every game ends in a win after a long run of reveals, flags and chords.
+static void
+PlayKnownGame(_Inout_ Minefield* field, _Inout_ uint16_t* order, _In_ uint64_t seed, _Inout_ ReplayTotals* totals)
+{
+    uint32_t cellCount = field->width * field->height;
+
+    struct splitmix64_state random = {
+        .s = seed,
+    };
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        order[i] = (uint16_t)i;
+
+    for (uint32_t i = cellCount - 1; i > 0; i--)
+    {
+        uint32_t j = (uint32_t)(splitmix64(&random) % (i + 1));
+        uint16_t swap = order[i];
+
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    uint32_t first = field->height / 2 * field->width + field->width / 2;
+    uint64_t actions = 1;
+    double start = GetBenchmarkSeconds();
+
+    RevealCell(field, first % field->width, first / field->width);
+
+    for (uint32_t i = 0; i < cellCount && field->state == GAME_PLAYING; i++)
+    {
+        uint32_t x = order[i] % field->width;
+        uint32_t y = order[i] / field->width;
+        const Cell* cell = &field->cells[order[i]];
+
+        if (cell->state == CELL_REVEALED)
+            actions += ChordCell(field, x, y) ? 1 : 0;
+        else if (cell->hasMine)
+            actions += ToggleFlag(field, x, y) ? 1 : 0;
+        else
+            actions += RevealCell(field, x, y) ? 1 : 0;
+    }
+
+    totals->seconds += GetBenchmarkSeconds() - start;
+    totals->actions += actions;
+
+    if (field->replay == NULL)
+        return;
+
+    totals->events += field->replay->eventCount;
+    totals->bytes += field->replay->length;
+    totals->dropped += field->replay->droppedEvents;
+}
+
+// Saves the recorded game to a replay file in memory, reads it back and replays it on a second board.
+static void
+PlayBackGame(_Inout_ ReplayWorkspace* workspace, _Inout_ ReplayTotals* totals)
+{
+    uint32_t size = EncodeReplayFile(workspace->field, workspace->file);
+    ReplayOutcome recorded;
+    ReplayCheck check;
+
+    if (!DecodeReplayFile(workspace->file, size, &recorded, workspace->log))
+        return;
+
+    double start = GetBenchmarkSeconds();
+
+    VerifyReplay(workspace->playback, &recorded, workspace->log, &check);
+
+    totals->playbackSeconds += GetBenchmarkSeconds() - start;
+    totals->playbackEvents += check.events;
+    totals->verified += check.verdict == REPLAY_VERIFIED ? 1 : 0;
+}
+
+static ReplayTotals
+BenchmarkReplay(_In_ const ReplayConfiguration* configuration, _In_ bool recording, _Inout_ ReplayWorkspace* workspace)
+{
+    Minefield* field = workspace->field;
+
+    ReplayTotals fastest = {0};
+
+    for (uint32_t repeat = 0; repeat < REPLAY_BENCH_REPEATS; repeat++)
+    {
+        ReplayTotals totals = {0};
+
+        for (uint32_t game = 0; game < configuration->games; game++)
+        {
+            CreateCustomMinefield(field, configuration->width, configuration->height, configuration->mines);
+            field->seed = mix64(game + 1);
+            AttachOpeningIndex(field, workspace->openings);
+
+            if (recording)
+                AttachReplayLog(field, workspace->recorder);
+
+            PlayKnownGame(field, workspace->order, mix64(~(uint64_t)game), &totals);
+
+            if (recording)
+                PlayBackGame(workspace, &totals);
+        }
+
+        if (repeat == 0 || totals.seconds < fastest.seconds)
+            fastest = totals;
+    }
+
+    return fastest;
+}
+
+void
+RunReplayBenchmark(void)
+{
+    static const ReplayConfiguration configurations[] = {
+        {"Expert", 30, 16, 99, 20000},
+        {"100x100", 100, 100, 2000, 200},
+    };
+
+    HANDLE hHeap = GetProcessHeap();
+    ReplayWorkspace workspace = {
+        .field = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .playback = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .openings = HeapAlloc(hHeap, 0, sizeof(OpeningIndex)),
+        .recorder = HeapAlloc(hHeap, 0, sizeof(ReplayLog)),
+        .log = HeapAlloc(hHeap, 0, sizeof(ReplayLog)),
+        .file = HeapAlloc(hHeap, 0, REPLAY_FILE_MAX_SIZE),
+        .order = HeapAlloc(hHeap, 0, sizeof(uint16_t) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY),
+    };
+
+    if (workspace.field != NULL && workspace.playback != NULL && workspace.openings != NULL &&
+        workspace.recorder != NULL && workspace.log != NULL && workspace.file != NULL && workspace.order != NULL)
+    {
+        for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+        {
+            ReplayTotals plain = BenchmarkReplay(&configurations[i], false, &workspace);
+            ReplayTotals recorded = BenchmarkReplay(&configurations[i], true, &workspace);
+            double plainAction = plain.seconds / (double)plain.actions * 1e9;
+            double recordedAction = recorded.seconds / (double)recorded.actions * 1e9;
+
+            printf("%s, %u games won by a player that knows the mines\n",
+                   configurations[i].name,
+                   configurations[i].games);
+            printf("  unrecorded %7.1f ns per action, recorded %7.1f ns per action (%+.1f ns)\n",
+                   plainAction,
+                   recordedAction,
+                   recordedAction - plainAction);
+            printf("  %.0f events and %.0f bytes per game, %.2f bytes per event, %llu events dropped\n",
+                   (double)recorded.events / configurations[i].games,
+                   (double)recorded.bytes / configurations[i].games,
+                   (double)recorded.bytes / (double)recorded.events,
+                   (unsigned long long)recorded.dropped);
+            printf("  played back at %.2f M events per second, %llu of %u games verified\n",
+                   (double)recorded.playbackEvents / recorded.playbackSeconds / 1e6,
+                   (unsigned long long)recorded.verified,
+                   configurations[i].games);
+        }
+    }
+
+    HeapFree(hHeap, 0, workspace.order);
+    HeapFree(hHeap, 0, workspace.file);
+    HeapFree(hHeap, 0, workspace.log);
+    HeapFree(hHeap, 0, workspace.recorder);
+    HeapFree(hHeap, 0, workspace.openings);
+    HeapFree(hHeap, 0, workspace.playback);
+    HeapFree(hHeap, 0, workspace.field);
+}
@@ -0,0 +1,153 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "random.h"
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t boards;
+} RevealConfiguration;
+
+typedef struct
+{
+    double indexSeconds;
+    double firstSeconds;
+    double restSeconds;
+    uint64_t firstCells;
+    uint64_t restCells;
+    uint64_t restClicks;
+} RevealTotals;
+
+// Clicks the middle of the board, then every opening that is still hidden.
+static void
+RevealOpenings(_Inout_ Minefield* field, _Inout_ RevealTotals* totals)
+{
+    uint32_t before = field->revealedCells;
+    double start = GetBenchmarkSeconds();
+
+    RevealCell(field, field->width / 2, field->height / 2);
+
+    totals->firstSeconds += GetBenchmarkSeconds() - start;
+    totals->firstCells += field->revealedCells - before;
+    before = field->revealedCells;
+
+    for (uint32_t i = 0; i < field->width * field->height && field->state == GAME_PLAYING; i++)
+    {
+        const Cell* cell = &field->cells[i];
+
+        if (cell->state == CELL_HIDDEN && !cell->hasMine && cell->neighborMines == 0)
+        {
+            start = GetBenchmarkSeconds();
+            RevealCell(field, i % field->width, i / field->width);
+            totals->restSeconds += GetBenchmarkSeconds() - start;
+            totals->restClicks++;
+        }
+    }
+
+    totals->restCells += field->revealedCells - before;
+}
+
+static void
+PrintTotals(_In_z_ const char* label, _In_ uint32_t boards, _In_ const RevealTotals* totals)
+{
+    printf("  %-10s first click %9.2f us (%7.0f cells), other openings %8.3f us per click (%6.1f cells)",
+           label,
+           totals->firstSeconds * 1e6 / boards,
+           (double)totals->firstCells / boards,
+           totals->restClicks > 0 ? totals->restSeconds * 1e6 / (double)totals->restClicks : 0.0,
+           totals->restClicks > 0 ? (double)totals->restCells / (double)totals->restClicks : 0.0);
+
+    if (totals->indexSeconds > 0.0)
+        printf(", index built in %.2f us", totals->indexSeconds * 1e6 / boards);
+
+    printf("\n");
+}
+
+static void
+BenchmarkConfiguration(
+    _In_ const RevealConfiguration* configuration,
+    _Inout_ Minefield* indexed,
+    _Inout_ Minefield* searched,
+    _Inout_ OpeningIndex* openings,
+    _Inout_ bool* layout)
+{
+    RevealTotals indexTotals = {0};
+    RevealTotals searchTotals = {0};
+    struct splitmix64_state random = {
+        .s = 1,
+    };
+
+    uint32_t width = configuration->width;
+    uint32_t height = configuration->height;
+    uint32_t cellCount = width * height;
+    bool mismatch = false;
+
+    for (uint32_t board = 0; board < configuration->boards; board++)
+    {
+        uint32_t placed = 0;
+
+        ZeroMemory(layout, sizeof(bool) * cellCount);
+
+        while (placed < configuration->mines)
+        {
+            uint32_t index = (uint32_t)(((splitmix64(&random) >> 32) * cellCount) >> 32);
+            uint32_t dx = index % width - width / 2 + 1;
+            uint32_t dy = index / width - height / 2 + 1;
+
+            // Keeps the clicked cell and its neighbours clear so the first click always opens.
+            if (layout[index] || (dx < 3 && dy < 3))
+                continue;
+
+            layout[index] = true;
+            placed++;
+        }
+
+        CreateCustomMinefield(indexed, width, height, configuration->mines);
+        SetMinefieldLayout(indexed, layout);
+        CopyMemory(searched, indexed, sizeof(Minefield));
+
+        double start = GetBenchmarkSeconds();
+        AttachOpeningIndex(indexed, openings);
+        indexTotals.indexSeconds += GetBenchmarkSeconds() - start;
+
+        RevealOpenings(indexed, &indexTotals);
+        RevealOpenings(searched, &searchTotals);
+
+        mismatch |= indexed->hash != searched->hash || indexed->revealedCells != searched->revealedCells;
+    }
+
+    printf("%s%s\n", configuration->name, mismatch ? " (boards differ!)" : "");
+    PrintTotals("index", configuration->boards, &indexTotals);
+    PrintTotals("search", configuration->boards, &searchTotals);
+}
+
+void
+RunRevealBenchmark(void)
+{
+    static const RevealConfiguration configurations[] = {
+        {"Expert 30x16, 99", 30, 16, 99, 2000},
+        {"Custom 100x100, 500", 100, 100, 500, 200},
+        {"Custom 100x100, 100", 100, 100, 100, 200},
+    };
+
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* indexed = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    Minefield* searched = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    OpeningIndex* openings = HeapAlloc(hHeap, 0, sizeof(OpeningIndex));
+    bool* layout = HeapAlloc(hHeap, 0, sizeof(bool) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+
+    if (indexed != NULL && searched != NULL && openings != NULL && layout != NULL)
+    {
+        for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+            BenchmarkConfiguration(&configurations[i], indexed, searched, openings, layout);
+    }
+
+    HeapFree(hHeap, 0, indexed);
+    HeapFree(hHeap, 0, searched);
+    HeapFree(hHeap, 0, openings);
+    HeapFree(hHeap, 0, layout);
+}
@@ -0,0 +1,141 @@
+#include "pch.h"
+
+#include <math.h>
+
+#include "bench.h"
+#include "parallel.h"
+#include "sampler.h"
+#include "solver.h"
+
+#define ACCURACY_POSITIONS 20
+
+typedef struct
+{
+    double samplesPerSecond;
+    double potentialScaleReduction;
+    double maxError;
+    uint64_t samples;
+} SamplerRun;
+
+static bool
+RunSampler(
+    _In_ const Frontier* frontier,
+    _In_ uint32_t threads,
+    _In_opt_ const SolverResult* exact,
+    _Out_writes_(SOLVER_MAX_CELLS) double* estimate,
+    _Out_ SamplerRun* run)
+{
+    SamplerOptions options;
+    SamplerStats stats;
+
+    GetDefaultSamplerOptions(&options);
+    options.threads = threads;
+    options.chains = max(GetParallelThreadCount(), (uint32_t)SAMPLER_DEFAULT_CHAINS);
+
+    double start = GetBenchmarkSeconds();
+    bool success = SampleFrontier(frontier, &options, estimate, &stats);
+    double elapsed = GetBenchmarkSeconds() - start;
+
+    run->samples = stats.samples;
+    run->samplesPerSecond = (double)stats.samples / elapsed;
+    run->potentialScaleReduction = stats.potentialScaleReduction;
+    run->maxError = 0.0;
+
+    if (success && exact != NULL)
+    {
+        for (uint32_t v = 0; v < frontier->variableCount; v++)
+        {
+            uint32_t cell = frontier->variables[v];
+            run->maxError = max(run->maxError, fabs(estimate[cell] - exact->probability[cell]));
+        }
+    }
+
+    return success;
+}
+
+static void
+BenchmarkAccuracy(_Inout_ Minefield* field, _Inout_ Frontier* frontier, _Inout_ SolverResult* result, _Inout_ double* estimate)
+{
+    SamplerRun serial = {0};
+    SamplerRun parallel = {0};
+    double serialRate = 0.0;
+    double parallelRate = 0.0;
+    double worstError = 0.0;
+    double worstScaleReduction = 0.0;
+    uint32_t positions = 0;
+
+    for (uint32_t seed = 1; positions < ACCURACY_POSITIONS; seed++)
+    {
+        if (!GenerateBenchmarkBoard(field, 30, 16, 99, seed) || !RevealFirstOpening(field))
+            continue;
+
+        PlayUntilStuck(field, NULL, result);
+
+        if (field->state != GAME_PLAYING || !result->complete || !BuildFrontier(field, frontier))
+            continue;
+
+        if (!RunSampler(frontier, 1, result, estimate, &serial) || !RunSampler(frontier, 0, result, estimate, &parallel))
+            continue;
+
+        serialRate += serial.samplesPerSecond;
+        parallelRate += parallel.samplesPerSecond;
+        worstError = max(worstError, max(serial.maxError, parallel.maxError));
+        worstScaleReduction = max(worstScaleReduction, parallel.potentialScaleReduction);
+        positions++;
+    }
+
+    printf("Expert stuck positions against exact probabilities (%u positions)\n", positions);
+    printf("  serial %.0f samples/s, parallel %.0f samples/s on %u threads\n",
+           serialRate / positions,
+           parallelRate / positions,
+           GetParallelThreadCount());
+    printf("  worst absolute error %.4f, worst R-hat %.3f\n", worstError, worstScaleReduction);
+}
+
+static void
+BenchmarkLongFrontiers(_Inout_ Minefield* field, _Inout_ Frontier* frontier, _Inout_ double* estimate)
+{
+    static const uint32_t widths[] = {48, 64, 96, 100};
+
+    for (size_t i = 0; i < ARRAYSIZE(widths); i++)
+    {
+        SamplerRun serial = {0};
+        SamplerRun parallel = {0};
+
+        BuildLongFrontierBoard(field, widths[i], (uint32_t)i + 1);
+
+        if (!BuildFrontier(field, frontier) || !RunSampler(frontier, 1, NULL, estimate, &serial) ||
+            !RunSampler(frontier, 0, NULL, estimate, &parallel))
+        {
+            printf("Long frontier %3u wide: sampling failed\n", widths[i]);
+            continue;
+        }
+
+        printf("Long frontier %3u wide: serial %.0f samples/s, parallel %.0f samples/s, R-hat %.3f\n",
+               widths[i],
+               serial.samplesPerSecond,
+               parallel.samplesPerSecond,
+               parallel.potentialScaleReduction);
+    }
+}
+
+void
+RunSamplerBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    Frontier* frontier = HeapAlloc(hHeap, 0, sizeof(Frontier));
+    SolverResult* result = HeapAlloc(hHeap, 0, sizeof(SolverResult));
+    double* estimate = HeapAlloc(hHeap, 0, sizeof(double) * SOLVER_MAX_CELLS);
+
+    if (field != NULL && frontier != NULL && result != NULL && estimate != NULL)
+    {
+        BenchmarkAccuracy(field, frontier, result, estimate);
+        BenchmarkLongFrontiers(field, frontier, estimate);
+    }
+
+    HeapFree(hHeap, 0, field);
+    HeapFree(hHeap, 0, frontier);
+    HeapFree(hHeap, 0, result);
+    HeapFree(hHeap, 0, estimate);
+}
@@ -0,0 +1,236 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "bench.h"
+#include "random.h"
+#include "replay.h"
+#include "savegame.h"
+
+#define SAVEGAME_BENCH_ACTIONS_PER_SAVE 8
+#define SAVEGAME_BENCH_RESTORES_PER_GAME 16
+
+typedef struct
+{
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t games;
+} SaveGameConfiguration;
+
+typedef struct
+{
+    uint64_t saves;
+    uint64_t rewrites;
+    uint64_t chunks;
+    uint64_t bytes;
+    double seconds;
+    double slowest;
+    double restoreSeconds;
+    uint64_t restores;
+    uint64_t mismatches;
+} SaveGameTotals;
+
+static bool
+IsSameField(_In_ const Minefield* a, _In_ const Minefield* b)
+{
+    uint32_t cellCount = a->width * a->height;
+
+    if (a->width != b->width || a->height != b->height || a->totalMines != b->totalMines || a->hash != b->hash ||
+        a->state != b->state || a->difficulty != b->difficulty || a->revealedCells != b->revealedCells ||
+        a->flaggedCells != b->flaggedCells || a->firstClick != b->firstClick || a->minesPlaced != b->minesPlaced ||
+        (a->state != GAME_PLAYING && a->endTime - a->startTime != b->endTime - b->startTime) ||
+        a->replay->length != b->replay->length || a->replay->head != b->replay->head ||
+        a->replay->eventCount != b->replay->eventCount || a->openings->count != b->openings->count)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        const Cell* cellA = &a->cells[i];
+        const Cell* cellB = &b->cells[i];
+
+        if (cellA->state != cellB->state || cellA->hasMine != cellB->hasMine ||
+            cellA->neighborMines != cellB->neighborMines)
+        {
+            return false;
+        }
+    }
+
+    return memcmp(a->replay->events, b->replay->events, sizeof(a->replay->events)) == 0;
+}
+
+static void
+TimeSave(_Inout_ SaveGameWriter* writer, _In_ const Minefield* field, _Inout_ SaveGameTotals* totals)
+{
+    bool rewrite = !writer->compacted || writer->size - writer->liveSize > SAVE_GAME_MAX_GARBAGE;
+    double start = GetBenchmarkSeconds();
+
+    if (!SaveGame(writer, field))
+        return;
+
+    double seconds = GetBenchmarkSeconds() - start;
+
+    totals->saves++;
+    totals->rewrites += rewrite ? 1 : 0;
+    totals->chunks += writer->lastChunks;
+    totals->bytes += writer->lastBytes;
+    totals->seconds += seconds;
+    totals->slowest = max(totals->slowest, seconds);
+}
+
+// Plays a game that knows the mines, as the replay benchmark does, saving every few actions and now and then
+// restoring the file into a second field to check it against the game being played. Each field has the first or
+// second of the indexes and logs.
+static void
+PlaySavedGame(
+    _In_ const SaveGameConfiguration* configuration,
+    _In_ uint32_t game,
+    _Inout_ SaveGameWriter* writer,
+    _In_z_ const wchar_t* path,
+    _Inout_ Minefield* field,
+    _Inout_ Minefield* restored,
+    _Inout_updates_(2) OpeningIndex* openings,
+    _Inout_updates_(2) ReplayLog* logs,
+    _Inout_ uint16_t* order,
+    _Inout_ SaveGameTotals* totals)
+{
+    uint32_t cellCount = configuration->width * configuration->height;
+    uint32_t restoreEvery = max(cellCount / SAVEGAME_BENCH_RESTORES_PER_GAME, 1u);
+
+    struct splitmix64_state random = {
+        .s = mix64(game + 1),
+    };
+
+    CreateCustomMinefield(field, configuration->width, configuration->height, configuration->mines);
+    field->seed = mix64(~(uint64_t)game);
+    AttachOpeningIndex(field, &openings[0]);
+    AttachReplayLog(field, &logs[0]);
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        order[i] = (uint16_t)i;
+
+    for (uint32_t i = cellCount - 1; i > 0; i--)
+    {
+        uint32_t j = (uint32_t)(splitmix64(&random) % (i + 1));
+        uint16_t swap = order[i];
+
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    RevealCell(field, configuration->width / 2, configuration->height / 2);
+    TimeSave(writer, field, totals);
+
+    for (uint32_t i = 0, actions = 0; i < cellCount && field->state == GAME_PLAYING; i++)
+    {
+        uint32_t x = order[i] % field->width;
+        uint32_t y = order[i] / field->width;
+        const Cell* cell = &field->cells[order[i]];
+        bool acted;
+
+        if (cell->state == CELL_REVEALED)
+            acted = ChordCell(field, x, y);
+        else if (cell->hasMine)
+            acted = ToggleFlag(field, x, y);
+        else
+            acted = RevealCell(field, x, y);
+
+        if (acted && ++actions % SAVEGAME_BENCH_ACTIONS_PER_SAVE == 0)
+            TimeSave(writer, field, totals);
+
+        if (i % restoreEvery == 0)
+        {
+            TimeSave(writer, field, totals);
+
+            double start = GetBenchmarkSeconds();
+            bool loaded = LoadSavedGame(restored, &openings[1], &logs[1], path);
+
+            totals->restoreSeconds += GetBenchmarkSeconds() - start;
+            totals->restores++;
+            totals->mismatches += loaded && IsSameField(field, restored) ? 0 : 1;
+        }
+    }
+
+    TimeSave(writer, field, totals);
+}
+
+void
+RunSaveGameBenchmark(void)
+{
+    static const SaveGameConfiguration configurations[] = {
+        {"Expert", 30, 16, 99, 200},
+        {"100x100", 100, 100, 2000, 20},
+    };
+
+    wchar_t directory[MAX_PATH];
+    wchar_t path[MAX_PATH];
+
+    if (GetTempPathW(ARRAYSIZE(directory), directory) == 0 || GetTempFileNameW(directory, L"mss", 0, path) == 0)
+    {
+        printf("Cannot create a temporary file\n");
+        return;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    Minefield* restored = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    OpeningIndex* openings = HeapAlloc(hHeap, 0, sizeof(OpeningIndex) * 2);
+    ReplayLog* logs = HeapAlloc(hHeap, 0, sizeof(ReplayLog) * 2);
+    uint16_t* order = HeapAlloc(hHeap, 0, sizeof(uint16_t) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+    bool allocated = field != NULL && restored != NULL && openings != NULL && logs != NULL && order != NULL;
+
+    for (size_t i = 0; allocated && i < ARRAYSIZE(configurations); i++)
+    {
+        SaveGameWriter writer;
+        SaveGameTotals totals = {0};
+
+        if (!CreateSaveGameWriter(&writer, path))
+            break;
+
+        for (uint32_t game = 0; game < configurations[i].games; game++)
+            PlaySavedGame(&configurations[i], game, &writer, path, field, restored, openings, logs, order, &totals);
+
+        // Starting a new writer on the same file makes its first save a rewrite of every live chunk.
+        CloseSaveGameWriter(&writer);
+
+        if (!CreateSaveGameWriter(&writer, path))
+            break;
+
+        double fullSeconds = GetBenchmarkSeconds();
+
+        SaveGame(&writer, field);
+        fullSeconds = GetBenchmarkSeconds() - fullSeconds;
+
+        printf("%s, %u games saved every %u actions, %llu saves, %llu rewrites\n",
+               configurations[i].name,
+               configurations[i].games,
+               SAVEGAME_BENCH_ACTIONS_PER_SAVE,
+               (unsigned long long)totals.saves,
+               (unsigned long long)totals.rewrites);
+        printf("  save    %8.1f us on average, %8.1f us at most, %.1f chunks and %.0f bytes appended\n",
+               totals.seconds / (double)totals.saves * 1e6,
+               totals.slowest * 1e6,
+               (double)totals.chunks / (double)totals.saves,
+               (double)totals.bytes / (double)totals.saves);
+        printf("  rewrite %8.1f us for a finished game, %u bytes against %u for the Minefield\n",
+               fullSeconds * 1e6,
+               writer.lastBytes,
+               (uint32_t)sizeof(Minefield));
+        printf("  restore %8.1f us on average, %llu of %llu restored fields differ\n",
+               totals.restoreSeconds / (double)totals.restores * 1e6,
+               (unsigned long long)totals.mismatches,
+               (unsigned long long)totals.restores);
+
+        CloseSaveGameWriter(&writer);
+    }
+
+    HeapFree(hHeap, 0, order);
+    HeapFree(hHeap, 0, logs);
+    HeapFree(hHeap, 0, openings);
+    HeapFree(hHeap, 0, restored);
+    HeapFree(hHeap, 0, field);
+    DeleteFileW(path);
+}
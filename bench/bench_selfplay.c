@@ -0,0 +1,220 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "random.h"
+#include "simulator.h"
+
+#define SELF_PLAY_BENCH_REPEATS 3
+
+typedef struct
+{
+    const char* name;
+    Difficulty difficulty;
+    uint64_t games;
+} SelfPlayConfiguration;
+
+typedef struct
+{
+    uint64_t wins;
+    uint64_t moves;
+    uint64_t guesses;
+} SelfPlayTotals;
+
+// The single-cell rules of the simulator's rules player, made through the game's own moves and visiting cells and
+// neighbours in the same order, so that it plays exactly the same games.
+static bool
+ApplyMinefieldRules(_Inout_ Minefield* field, _Inout_ uint64_t* moves)
+{
+    bool progress = false;
+
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+        {
+            const Cell* cell = &field->cells[y * field->width + x];
+            uint32_t flagged = 0;
+            uint32_t hidden = 0;
+
+            if (cell->state != CELL_REVEALED || cell->neighborMines == 0)
+                continue;
+
+            for (int32_t dy = -1; dy <= 1; dy++)
+            {
+                for (int32_t dx = -1; dx <= 1; dx++)
+                {
+                    int32_t nx = (int32_t)x + dx;
+                    int32_t ny = (int32_t)y + dy;
+
+                    if ((dx == 0 && dy == 0) || nx < 0 || nx >= (int32_t)field->width || ny < 0 ||
+                        ny >= (int32_t)field->height)
+                        continue;
+
+                    CellState state = field->cells[ny * field->width + nx].state;
+
+                    if (state == CELL_FLAGGED)
+                        flagged++;
+                    else if (state == CELL_HIDDEN)
+                        hidden++;
+                }
+            }
+
+            if (hidden == 0 || (flagged != cell->neighborMines && flagged + hidden != cell->neighborMines))
+                continue;
+
+            for (int32_t dy = -1; dy <= 1; dy++)
+            {
+                for (int32_t dx = -1; dx <= 1; dx++)
+                {
+                    int32_t nx = (int32_t)x + dx;
+                    int32_t ny = (int32_t)y + dy;
+
+                    if ((dx == 0 && dy == 0) || nx < 0 || nx >= (int32_t)field->width || ny < 0 ||
+                        ny >= (int32_t)field->height || field->cells[ny * field->width + nx].state != CELL_HIDDEN)
+                        continue;
+
+                    if (flagged == cell->neighborMines)
+                        RevealCell(field, nx, ny);
+                    else
+                        ToggleFlag(field, nx, ny);
+
+                    (*moves)++;
+
+                    if (field->state != GAME_PLAYING)
+                        return true;
+                }
+            }
+
+            progress = true;
+        }
+    }
+
+    return progress;
+}
+
+// The rules player as it would run on a Minefield, with the simulator's game seeds and guesses.
+static void
+PlayMinefieldGames(
+    _Inout_ Minefield* field,
+    _In_ const SimulationOptions* options,
+    _Out_ SelfPlayTotals* totals)
+{
+    ZeroMemory(totals, sizeof(SelfPlayTotals));
+
+    for (uint64_t game = 0; game < options->games; game++)
+    {
+        uint64_t seed = GetSimulationGameSeed(options, game);
+
+        CreateMinefield(field, options->difficulty);
+        field->seed = seed;
+        RevealCell(field, field->width / 2, field->height / 2);
+        totals->moves++;
+
+        struct splitmix64_state guesses = {
+            .s = mix64(seed),
+        };
+
+        while (field->state == GAME_PLAYING)
+        {
+            if (ApplyMinefieldRules(field, &totals->moves))
+                continue;
+
+            uint32_t cellCount = field->width * field->height;
+            uint32_t cell = (uint32_t)(splitmix64(&guesses) % cellCount);
+
+            while (field->cells[cell].state != CELL_HIDDEN)
+                cell = cell + 1 < cellCount ? cell + 1 : 0;
+
+            totals->moves++;
+            totals->guesses++;
+            RevealCell(field, cell % field->width, cell / field->width);
+        }
+
+        if (field->state == GAME_WON)
+            totals->wins++;
+    }
+}
+
+// Games per second on one thread, the fastest of a few runs, through the simulator or on a Minefield.
+static double
+BenchmarkSelfPlay(
+    _In_ const SimulationOptions* options,
+    _In_ bool simulator,
+    _Inout_ Minefield* field,
+    _Out_ SelfPlayTotals* totals)
+{
+    double fastest = 0.0;
+
+    for (uint32_t i = 0; i < SELF_PLAY_BENCH_REPEATS; i++)
+    {
+        SimulationResult result;
+        double start = GetBenchmarkSeconds();
+
+        if (simulator)
+        {
+            RunSimulation(options, &result);
+            totals->wins = result.wins;
+            totals->moves = result.moves;
+            totals->guesses = result.guesses;
+        }
+        else
+        {
+            PlayMinefieldGames(field, options, totals);
+        }
+
+        double elapsed = GetBenchmarkSeconds() - start;
+
+        if (i == 0 || elapsed < fastest)
+            fastest = elapsed;
+    }
+
+    return options->games / fastest;
+}
+
+void
+RunSelfPlayBenchmark(void)
+{
+    static const SelfPlayConfiguration configurations[] = {
+        {"Beginner", DIFFICULTY_BEGINNER, 400000},
+        {"Intermediate", DIFFICULTY_INTERMEDIATE, 100000},
+        {"Expert", DIFFICULTY_EXPERT, 50000},
+    };
+
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+
+    if (field == NULL)
+    {
+        printf("Out of memory\n");
+        return;
+    }
+
+    printf("Rules player with random guesses, games per second on one thread\n");
+
+    for (size_t i = 0; i < ARRAYSIZE(configurations); i++)
+    {
+        SimulationOptions options = {
+            .seed = 1,
+            .games = configurations[i].games,
+            .threads = 1,
+            .difficulty = configurations[i].difficulty,
+            .strategy = STRATEGY_RULES,
+        };
+
+        SelfPlayTotals minefield;
+        SelfPlayTotals simulated;
+        double minefieldRate = BenchmarkSelfPlay(&options, false, field, &minefield);
+        double simulatedRate = BenchmarkSelfPlay(&options, true, field, &simulated);
+
+        printf("  %-12s Minefield %9.0f, simulate --strategy rules %9.0f, %5.2fx, %5.1f%% won%s\n",
+               configurations[i].name,
+               minefieldRate,
+               simulatedRate,
+               simulatedRate / minefieldRate,
+               simulated.wins * 100.0 / options.games,
+               memcmp(&minefield, &simulated, sizeof(SelfPlayTotals)) == 0 ? "" : ", MISMATCH");
+    }
+
+    printf("Both play the same games; wins, moves and guesses are checked to match.\n");
+
+    HeapFree(hHeap, 0, field);
+}
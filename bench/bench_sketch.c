@@ -0,0 +1,196 @@
+#include "pch.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "parallel.h"
+#include "quantilesketch.h"
+#include "random.h"
+
+static const uint32_t valueCounts[] = {1000, 100000, 1000000};
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+// Won times and 3BV/s both have a long right tail, so they are drawn from log-normal distributions around typical
+// Expert figures.
+typedef struct
+{
+    const char* name;
+    double median;
+    double spread;
+} SketchDistribution;
+
+static const SketchDistribution distributions[] = {
+    {"time s", 150.0, 0.6},
+    {"3BV/s", 1.2, 0.35},
+};
+
+typedef struct
+{
+    const double* values;
+    uint32_t count;
+    uint32_t parts;
+    QuantileSketch* sketches;
+} SketchBuild;
+
+static int
+CompareValues(_In_ const void* a, _In_ const void* b)
+{
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+
+    return (left > right) - (left < right);
+}
+
+static void
+GenerateValues(
+    _In_ const SketchDistribution* distribution,
+    _In_ uint32_t count,
+    _Out_writes_(count) double* values)
+{
+    struct splitmix64_state random = {
+        .s = count,
+    };
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Box-Muller from two uniforms in (0, 1].
+        double u = (double)((splitmix64(&random) >> 11) + 1) * 0x1.0p-53;
+        double v = (double)(splitmix64(&random) >> 11) * 0x1.0p-53;
+        double z = sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+
+        values[i] = distribution->median * exp(distribution->spread * z);
+    }
+}
+
+static void
+BuildSketchPart(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    SketchBuild* build = (SketchBuild*)context;
+    uint32_t first = (uint32_t)((uint64_t)build->count * index / build->parts);
+    uint32_t last = (uint32_t)((uint64_t)build->count * (index + 1) / build->parts);
+
+    for (uint32_t i = first; i < last; i++)
+        AddQuantileSketchValue(&build->sketches[index], build->values[i]);
+}
+
+// The sum is added up in another order, so only the counts and the extremes have to match exactly.
+static bool
+IsSameSketch(_In_ const QuantileSketch* a, _In_ const QuantileSketch* b)
+{
+    return a->count == b->count && a->minimum == b->minimum && a->maximum == b->maximum &&
+           memcmp(a->buckets, b->buckets, sizeof(a->buckets)) == 0;
+}
+
+static void
+BenchmarkDistribution(
+    _In_ const SketchDistribution* distribution,
+    _In_ uint32_t count,
+    _Inout_updates_(count) double* values,
+    _Inout_updates_(count) double* sorted,
+    _Inout_ QuantileSketch* sketches)
+{
+    uint32_t threads = GetParallelThreadCount();
+    QuantileSketch* sketch = &sketches[0];
+    QuantileSketch* merged = &sketches[1];
+
+    GenerateValues(distribution, count, values);
+    ZeroMemory(sketches, (size_t)(threads + 2) * sizeof(QuantileSketch));
+
+    double start = GetBenchmarkSeconds();
+
+    for (uint32_t i = 0; i < count; i++)
+        AddQuantileSketchValue(sketch, values[i]);
+
+    double sketchSeconds = GetBenchmarkSeconds() - start;
+
+    // Exact quantiles keep every value and sort them when they are asked for.
+    start = GetBenchmarkSeconds();
+
+    for (uint32_t i = 0; i < count; i++)
+        sorted[i] = values[i];
+
+    qsort(sorted, count, sizeof(double), CompareValues);
+
+    double sortSeconds = GetBenchmarkSeconds() - start;
+
+    SketchBuild build = {
+        .values = values,
+        .count = count,
+        .parts = threads,
+        .sketches = sketches + 2,
+    };
+
+    ParallelFor(threads, threads, BuildSketchPart, &build);
+
+    start = GetBenchmarkSeconds();
+
+    for (uint32_t i = 0; i < threads; i++)
+        MergeQuantileSketch(merged, &build.sketches[i]);
+
+    double mergeSeconds = GetBenchmarkSeconds() - start;
+
+    printf("%-8s %9u %10.1f %10.1f %9.1f %9.1f",
+           distribution->name,
+           count,
+           sketchSeconds * 1e9 / count,
+           sortSeconds * 1e9 / count,
+           sizeof(QuantileSketch) / 1024.0,
+           count * sizeof(double) / 1024.0);
+
+    for (size_t i = 0; i < ARRAYSIZE(quantiles); i++)
+    {
+        double exact = sorted[(size_t)(quantiles[i] * (count - 1))];
+        double estimate = GetQuantileSketchValue(sketch, quantiles[i]);
+
+        printf(" %8.3f%%", fabs(estimate - exact) * 100.0 / exact);
+    }
+
+    printf(" %8.1f %s\n", mergeSeconds * 1e6, IsSameSketch(sketch, merged) ? "merged matches" : "MISMATCH");
+}
+
+void
+RunQuantileSketchBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t largest = valueCounts[ARRAYSIZE(valueCounts) - 1];
+    double* values = HeapAlloc(hHeap, 0, (size_t)largest * sizeof(double));
+    double* sorted = HeapAlloc(hHeap, 0, (size_t)largest * sizeof(double));
+    QuantileSketch* sketches = HeapAlloc(hHeap, 0, (PARALLEL_MAX_THREADS + 2) * sizeof(QuantileSketch));
+
+    if (values == NULL || sorted == NULL || sketches == NULL)
+    {
+        printf("Out of memory\n");
+    }
+    else
+    {
+        printf("%-8s %9s %10s %10s %9s %9s %9s %9s %9s %9s %8s %s\n",
+               "values",
+               "count",
+               "sketch ns",
+               "sort ns",
+               "sketch KB",
+               "sorted KB",
+               "p50 err",
+               "p90 err",
+               "p99 err",
+               "p99.9 err",
+               "merge us",
+               "check");
+
+        for (size_t d = 0; d < ARRAYSIZE(distributions); d++)
+        {
+            for (size_t i = 0; i < ARRAYSIZE(valueCounts); i++)
+                BenchmarkDistribution(&distributions[d], valueCounts[i], values, sorted, sketches);
+        }
+
+        printf("Errors are relative to the exact quantile of the sorted values; sketches are built on %u threads and "
+               "merged.\n",
+               GetParallelThreadCount());
+    }
+
+    HeapFree(hHeap, 0, sketches);
+    HeapFree(hHeap, 0, sorted);
+    HeapFree(hHeap, 0, values);
+}
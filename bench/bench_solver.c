@@ -0,0 +1,96 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "solver.h"
+
+#define STUCK_POSITIONS 200
+#define SOLVES_PER_POSITION 20
+
+static void
+BenchmarkStuckPositions(_Inout_ Minefield* field, _Inout_ SolverResult* result)
+{
+    uint64_t solutions = 0;
+    uint64_t candidates = 0;
+    uint32_t positions = 0;
+    uint32_t incomplete = 0;
+    double elapsed = 0.0;
+
+    for (uint32_t seed = 1; positions < STUCK_POSITIONS; seed++)
+    {
+        if (!GenerateBenchmarkBoard(field, 30, 16, 99, seed) || !RevealFirstOpening(field))
+            continue;
+
+        PlayUntilStuck(field, NULL, result);
+
+        if (field->state != GAME_PLAYING)
+            continue;
+
+        double start = GetBenchmarkSeconds();
+
+        for (uint32_t i = 0; i < SOLVES_PER_POSITION; i++)
+        {
+            SolveMinefield(field, NULL, 0, result);
+            solutions += result->solutionsEnumerated;
+            candidates += result->candidatesTested;
+        }
+
+        elapsed += GetBenchmarkSeconds() - start;
+        incomplete += result->complete ? 0 : 1;
+        positions++;
+    }
+
+    uint32_t solves = positions * SOLVES_PER_POSITION;
+
+    printf("Expert stuck positions: %u positions, %u incomplete\n", positions, incomplete);
+    printf("  %.1f us per solve, %.2fM solutions/s, %.2fM candidates/s\n",
+           elapsed * 1e6 / solves,
+           (double)solutions / elapsed / 1e6,
+           (double)candidates / elapsed / 1e6);
+}
+
+static void
+BenchmarkLongFrontiers(_Inout_ Minefield* field, _Inout_ SolverResult* result)
+{
+    static const uint32_t widths[] = {12, 16, 20, 24, 28, 32, 40};
+
+    for (size_t i = 0; i < ARRAYSIZE(widths); i++)
+    {
+        BuildLongFrontierBoard(field, widths[i], (uint32_t)i + 1);
+
+        uint32_t iterations = 0;
+        double start = GetBenchmarkSeconds();
+        double elapsed = 0.0;
+        bool solved = false;
+
+        do
+        {
+            solved = SolveMinefield(field, NULL, 0, result);
+            iterations++;
+            elapsed = GetBenchmarkSeconds() - start;
+        } while (elapsed < 0.25 && iterations < 1000);
+
+        printf("Long frontier %3u wide: %s, %.3f ms per solve, %llu solutions, %.2fM solutions/s\n",
+               widths[i],
+               !solved ? "failed" : result->complete ? "exact" : "sampled",
+               elapsed * 1e3 / iterations,
+               (unsigned long long)result->solutionsEnumerated,
+               (double)result->solutionsEnumerated * iterations / elapsed / 1e6);
+    }
+}
+
+void
+RunSolverBenchmark(void)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    SolverResult* result = HeapAlloc(hHeap, 0, sizeof(SolverResult));
+
+    if (field != NULL && result != NULL)
+    {
+        BenchmarkStuckPositions(field, result);
+        BenchmarkLongFrontiers(field, result);
+    }
+
+    HeapFree(hHeap, 0, field);
+    HeapFree(hHeap, 0, result);
+}
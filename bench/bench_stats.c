@@ -0,0 +1,152 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "bench.h"
+#include "random.h"
+#include "statsfile.h"
+
+static const uint32_t historySizes[] = {1000, 10000, 100000, 1000000};
+
+typedef struct
+{
+    double appendSeconds;
+    double slowestAppend;
+    double openSeconds;
+    double rebuildSeconds;
+    uint64_t compactions;
+    uint64_t tail;
+    uint64_t bytes;
+    bool matches;
+} StatsHistoryResult;
+
+// Games a player might finish, mostly on the presets, with a win rate and times that vary by difficulty.
+static void
+GenerateGameRecord(_Inout_ struct splitmix64_state* random, _In_ uint64_t index, _Out_ GameRecord* record)
+{
+    static const uint32_t sizes[][3] = {{9, 9, 10}, {16, 16, 40}, {30, 16, 99}, {50, 50, 500}};
+    static const uint32_t winPercent[] = {85, 60, 35, 20};
+    static const uint32_t typicalSeconds[] = {12, 50, 150, 600};
+
+    uint64_t value = splitmix64(random);
+    Difficulty difficulty = (Difficulty)(value % 4);
+
+    record->difficulty = difficulty;
+    record->state = (value >> 8) % 100 < winPercent[difficulty] ? GAME_WON : GAME_LOST;
+    record->width = sizes[difficulty][0];
+    record->height = sizes[difficulty][1];
+    record->totalMines = sizes[difficulty][2];
+    record->duration = (uint32_t)(splitmix64(random) % (2000u * typicalSeconds[difficulty])) + 500;
+    record->bbbv = (uint32_t)(value >> 32) % 100 + 1;
+    record->seed = value;
+    record->finished = 133000000000000000ull + index * 600000000ull;
+}
+
+static void
+BenchmarkHistory(_In_z_ const wchar_t* path, _In_ uint32_t games, _Out_ StatsHistoryResult* result)
+{
+    HANDLE hHeap = GetProcessHeap();
+    StatsStore* store = HeapAlloc(hHeap, 0, sizeof(StatsStore));
+    StatsAggregates* rebuilt = HeapAlloc(hHeap, 0, sizeof(StatsAggregates));
+
+    struct splitmix64_state random = {
+        .s = games,
+    };
+
+    ZeroMemory(result, sizeof(StatsHistoryResult));
+    DeleteFileW(path);
+
+    if (store != NULL && rebuilt != NULL && OpenStatsStore(store, path))
+    {
+        for (uint32_t i = 0; i < games; i++)
+        {
+            GameRecord record;
+            uint64_t sequence = store->sequence;
+
+            GenerateGameRecord(&random, i, &record);
+
+            double start = GetBenchmarkSeconds();
+
+            AppendGameRecord(store, &record);
+
+            double seconds = GetBenchmarkSeconds() - start;
+
+            result->appendSeconds += seconds;
+            result->slowestAppend = max(result->slowestAppend, seconds);
+            result->compactions += store->sequence - sequence;
+        }
+
+        // Closing writes no snapshot for these, so the next open has a tail to fold in as a real one would.
+        result->tail = store->aggregates.records - store->snapshotRecords;
+        store->snapshotRecords = store->aggregates.records;
+        CloseStatsStore(store);
+
+        double start = GetBenchmarkSeconds();
+        bool opened = OpenStatsStore(store, path);
+
+        result->openSeconds = GetBenchmarkSeconds() - start;
+
+        if (opened)
+        {
+            start = GetBenchmarkSeconds();
+
+            bool success = RebuildStatsAggregates(store, rebuilt);
+
+            result->rebuildSeconds = GetBenchmarkSeconds() - start;
+            result->matches = success && memcmp(rebuilt, &store->aggregates, sizeof(StatsAggregates)) == 0 &&
+                              store->aggregates.records == games;
+            result->bytes = STATS_STORE_RECORDS_OFFSET + (uint64_t)games * STATS_STORE_RECORD_SIZE;
+
+            CloseStatsStore(store);
+        }
+    }
+
+    HeapFree(hHeap, 0, rebuilt);
+    HeapFree(hHeap, 0, store);
+    DeleteFileW(path);
+}
+
+void
+RunStatsBenchmark(void)
+{
+    wchar_t directory[MAX_PATH];
+    wchar_t path[MAX_PATH];
+
+    if (GetTempPathW(ARRAYSIZE(directory), directory) == 0 || GetTempFileNameW(directory, L"mst", 0, path) == 0)
+    {
+        printf("Cannot create a temporary file\n");
+        return;
+    }
+
+    printf("%10s %10s %12s %12s %11s %6s %10s %12s %s\n",
+           "games",
+           "MB",
+           "append us",
+           "slowest us",
+           "snapshots",
+           "tail",
+           "open ms",
+           "rebuild ms",
+           "check");
+
+    for (size_t i = 0; i < ARRAYSIZE(historySizes); i++)
+    {
+        StatsHistoryResult result;
+
+        BenchmarkHistory(path, historySizes[i], &result);
+
+        printf("%10u %10.1f %12.2f %12.1f %11llu %6llu %10.3f %12.3f %s\n",
+               historySizes[i],
+               (double)result.bytes / (1024.0 * 1024.0),
+               result.appendSeconds * 1e6 / historySizes[i],
+               result.slowestAppend * 1e6,
+               (unsigned long long)result.compactions,
+               (unsigned long long)result.tail,
+               result.openSeconds * 1e3,
+               result.rebuildSeconds * 1e3,
+               result.matches ? "snapshot matches rebuild" : "MISMATCH");
+    }
+
+    printf("Opening reads the newer snapshot and up to %u later records; a rebuild reads every record.\n",
+           STATS_STORE_COMPACT_RECORDS - 1);
+}
@@ -0,0 +1,121 @@
+#include "pch.h"
+
+#include "bench.h"
+#include "solver.h"
+
+bool
+GenerateBenchmarkBoard(
+    _Out_ Minefield* field,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t seed)
+{
+    if (!CreateCustomMinefield(field, width, height, mines))
+        return false;
+
+    bool layout[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+
+    PlaceSeededMines(width, height, mines, seed, width / 2, height / 2, layout);
+
+    if (!SetMinefieldLayout(field, layout))
+        return false;
+
+    field->firstClick = false;
+    field->startTime = GetTickCount64();
+
+    return true;
+}
+
+bool
+RevealFirstOpening(_Inout_ Minefield* field)
+{
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+        {
+            const Cell* cell = GetCell(field, x, y);
+
+            if (!cell->hasMine && cell->neighborMines == 0)
+                return RevealCell(field, x, y);
+        }
+    }
+
+    return false;
+}
+
+void
+PlayUntilStuck(_Inout_ Minefield* field, _Inout_opt_ SolverCache* cache, _Inout_ SolverResult* result)
+{
+    bool progress = true;
+
+    while (progress && field->state == GAME_PLAYING && SolveMinefield(field, cache, 0, result))
+    {
+        progress = false;
+
+        for (uint32_t y = 0; y < field->height; y++)
+        {
+            for (uint32_t x = 0; x < field->width; x++)
+            {
+                double p = result->probability[y * field->width + x];
+
+                if (GetCell(field, x, y)->state != CELL_HIDDEN)
+                    continue;
+
+                if (p == 0.0)
+                    progress |= RevealCell(field, x, y);
+                else if (p == 1.0)
+                    progress |= ToggleFlag(field, x, y);
+            }
+        }
+    }
+}
+
+void
+BuildLongFrontierBoard(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t seed)
+{
+    CreateCustomMinefield(field, width, 3, width * 3 / 4);
+
+    uint32_t state = seed;
+    uint32_t placed = 0;
+
+    while (placed < field->totalMines)
+    {
+        state = state * 1664525u + 1013904223u;
+        uint32_t x = (state >> 8) % width;
+        uint32_t y = (state >> 4) % 3;
+        Cell* cell = &field->cells[y * width + x];
+
+        if ((y < 2 || (x & 1) != 0) && !cell->hasMine)
+        {
+            cell->hasMine = true;
+            placed++;
+        }
+    }
+
+    for (uint32_t x = 0; x < width; x += 2)
+    {
+        Cell* cell = &field->cells[2 * width + x];
+
+        for (int32_t dy = -1; dy <= 0; dy++)
+        {
+            for (int32_t dx = -1; dx <= 1; dx++)
+            {
+                int32_t nx = (int32_t)x + dx;
+
+                if ((dx != 0 || dy != 0) && nx >= 0 && nx < (int32_t)width &&
+                    field->cells[(2 + dy) * (int32_t)width + nx].hasMine)
+                {
+                    cell->neighborMines++;
+                }
+            }
+        }
+
+        cell->state = CELL_REVEALED;
+        field->revealedCells++;
+    }
+
+    IndexOpenings(field);
+    field->firstClick = false;
+    field->hash = ComputeMinefieldHash(field);
+}
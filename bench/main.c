@@ -0,0 +1,93 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "bench.h"
+
+static const Benchmark benchmarks[] = {
+    {"solver", "Frontier enumeration on stuck Expert positions and long frontiers", RunSolverBenchmark},
+    {"sampler", "Consistent-layout sampling throughput, serial and parallel", RunSamplerBenchmark},
+    {"cache", "Solver component cache hit rate and time saved while playing Expert games", RunSolverCacheBenchmark},
+    {"noguess", "No-guess board generation rate and latency for Expert and large custom boards", RunNoGuessBenchmark},
+    {"pool", "First-click wait with and without the background board pool", RunBoardPoolBenchmark},
+    {"metrics", "3BV and ZiNi scoring throughput on random Expert and 1024x1024 boards", RunMetricsBenchmark},
+    {"reveal", "Opening reveal latency with the precomputed opening index against searching", RunRevealBenchmark},
+    {"largefield", "Tile-parallel generation of a 16384x16384 board, one thread to all cores", RunLargeFieldBenchmark},
+    {"layout", "Neighbour counting and flood fill with row and 8x8 block layouts", RunLayoutBenchmark},
+    {"lazycount", "First-click cost with eager and on-demand neighbour counts", RunLazyCountBenchmark},
+    {"hashfield", "Cell queries and memory per revealed cell with hashed, unstored mines", RunHashFieldBenchmark},
+    {"chunkfield", "Resident memory of an unbounded chunked board explored to 10^8 cells", RunChunkFieldBenchmark},
+    {"batch", "Steps per second of the struct-of-arrays batch engine for 1 to 65536 boards", RunBatchBenchmark},
+    {"observe", "Observation buffer cost per step, updated in place against re-encoded", RunObservationBenchmark},
+    {"selfplay", "Rules-player games per second in the simulator against the same player on a Minefield", RunSelfPlayBenchmark},
+    {"replay", "Per-action cost of recording reveals, flags and chords into the replay log", RunReplayBenchmark},
+    {"corpus", "Replays per second when a million-game replay corpus is mapped and scanned", RunCorpusBenchmark},
+    {"formats", "RAWVF video and MBF board parse throughput, with a mutation fuzz pass", RunFormatsBenchmark},
+    {"archive", "Bits per board and decode rate of the arithmetic-coded board archive", RunArchiveBenchmark},
+    {"savegame", "Autosave and restore latency with dirty-chunk appends and compaction", RunSaveGameBenchmark},
+    {"journal", "Undo and redo cost per move and after flood fills, with journal bytes per move", RunJournalBenchmark},
+    {"stats", "Stats store append and snapshot cost, and startup time against a full rebuild", RunStatsBenchmark},
+    {"sketch", "Quantile sketch update cost and accuracy against sorting every value", RunQuantileSketchBenchmark},
+};
+
+double
+GetBenchmarkSeconds(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+static void
+PrintUsage(void)
+{
+    printf("Usage: Benchmarks [name...]\n\nAvailable benchmarks:\n");
+
+    for (size_t i = 0; i < ARRAYSIZE(benchmarks); i++)
+        printf("  %-12s %s\n", benchmarks[i].name, benchmarks[i].description);
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        for (size_t i = 0; i < ARRAYSIZE(benchmarks); i++)
+        {
+            printf("== %s ==\n", benchmarks[i].name);
+            benchmarks[i].run();
+            printf("\n");
+        }
+
+        return 0;
+    }
+
+    for (int arg = 1; arg < argc; arg++)
+    {
+        bool found = false;
+
+        for (size_t i = 0; i < ARRAYSIZE(benchmarks); i++)
+        {
+            if (strcmp(argv[arg], benchmarks[i].name) == 0)
+            {
+                printf("== %s ==\n", benchmarks[i].name);
+                benchmarks[i].run();
+                printf("\n");
+                found = true;
+            }
+        }
+
+        if (!found)
+        {
+            fprintf(stderr, "Unknown benchmark: %s\n\n", argv[arg]);
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    return 0;
+}
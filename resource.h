@@ -57,8 +57,11 @@
 #define IDM_GAME_INTERMEDIATE           40017
 #define IDM_GAME_EXPERT                 40018
 #define IDM_GAME_CUSTOM                 40019
+#define IDM_GAME_NOGUESS                40020
 #define IDM_GAME_EXIT                   40021
+#define IDM_GAME_SAVE_REPLAY            40022
 #define IDM_HELP_ABOUT                  40023
+#define IDM_GAME_STATISTICS             40024
 // Removed unused command IDs: leaderboard, best times, marks, color, sound
 
 // Next default values for new objects
@@ -1,7 +1,9 @@
 #include "pch.h"
 
 #include "application.h"
+#include "parallel.h"
 #include "resource.h"
+#include "statsfile.h"
 #include "ui/window.h"
 
 static void
@@ -274,6 +276,31 @@ fail:
     return false;
 }
 
+// The game in progress and the statistics are kept in %LOCALAPPDATA%\Minesweeper so they survive the window being
+// closed.
+static bool
+GetDataPath(_Out_writes_(size) wchar_t* path, _In_ DWORD size, _In_z_ const wchar_t* name)
+{
+    DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", path, size);
+
+    if (length == 0 || length >= size || wcscat_s(path, size, L"\\Minesweeper") != 0)
+        return false;
+
+    if (!CreateDirectoryW(path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+        return false;
+
+    return wcscat_s(path, size, name) == 0;
+}
+
+static void
+FreeGameRecords(_Inout_ Application* app)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, app->openings);
+    HeapFree(hHeap, 0, app->replay);
+}
+
 _Ret_maybenull_ Application*
 CreateApplication(_In_ HINSTANCE hInstance)
 {
@@ -283,12 +310,34 @@ CreateApplication(_In_ HINSTANCE hInstance)
     if (app == NULL)
         return NULL;
 
-    if (!LoadAssets(app, hInstance))
+    app->openings = HeapAlloc(hHeap, 0, sizeof(OpeningIndex));
+    app->replay = HeapAlloc(hHeap, 0, sizeof(ReplayLog));
+
+    if (app->openings == NULL || app->replay == NULL || !LoadAssets(app, hInstance))
+    {
+        FreeGameRecords(app);
+        HeapFree(hHeap, 0, app);
+        return NULL;
+    }
+
+    // Leave one core for the window thread.
+    if (!CreateBoardPool(&app->boardPool, GetParallelThreadCount() - 1))
     {
+        UnloadAssets(app);
+        FreeGameRecords(app);
         HeapFree(hHeap, 0, app);
         return NULL;
     }
 
+    wchar_t autosavePath[MAX_PATH];
+    wchar_t statsPath[MAX_PATH];
+
+    // Without a place to save to the game is simply not kept, and finished games are not counted.
+    app->autosaveEnabled = GetDataPath(autosavePath, ARRAYSIZE(autosavePath), L"\\autosave.mss") &&
+                           CreateSaveGameWriter(&app->autosave, autosavePath);
+    app->statsEnabled =
+        GetDataPath(statsPath, ARRAYSIZE(statsPath), L"\\stats.mst") && OpenStatsStore(&app->stats, statsPath);
+
     app->baseMetrics.cellWidth = (uint32_t)CELL_SIZE;
     app->baseMetrics.cellHeight = (uint32_t)CELL_SIZE;
     app->baseMetrics.borderWidth = (uint32_t)BORDER_WIDTH;
@@ -319,6 +368,14 @@ DestroyApplication(_In_opt_ Application* app)
     if (app == NULL)
         return;
 
+    if (app->autosaveEnabled)
+        CloseSaveGameWriter(&app->autosave);
+
+    if (app->statsEnabled)
+        CloseStatsStore(&app->stats);
+
+    DestroyBoardPool(&app->boardPool);
     UnloadAssets(app);
+    FreeGameRecords(app);
     HeapFree(GetProcessHeap(), 0, app);
 }
@@ -2,7 +2,10 @@
 
 #include <Windows.h>
 
+#include "boardpool.h"
 #include "game.h"
+#include "savegame.h"
+#include "statsstore.h"
 
 typedef struct
 {
@@ -65,6 +68,11 @@ typedef struct
 typedef struct
 {
     Minefield minefield;
+    OpeningIndex* openings;
+    ReplayLog* replay;
+    BoardPool boardPool;
+    SaveGameWriter autosave;
+    StatsStore stats;
     CellResources cellResources;
     BorderResources borderResources;
     CounterResources counterResources;
@@ -77,8 +85,14 @@ typedef struct
     uint32_t clientHeight;
     uint32_t hoverCellX;
     uint32_t hoverCellY;
+    uint32_t pendingCellX;
+    uint32_t pendingCellY;
     bool isLeftMouseDown;
     bool isFaceHot;
+    bool noGuess;
+    bool firstClickPending;
+    bool autosaveEnabled;
+    bool statsEnabled;
 } Application;
 
 _Ret_maybenull_ Application* CreateApplication(_In_ HINSTANCE hInstance);
@@ -0,0 +1,416 @@
+#include "pch.h"
+
+#include "batchfield.h"
+#include "parallel.h"
+#include "random.h"
+
+typedef struct
+{
+    BatchField* batch;
+    const BatchAction* actions;
+    uint32_t shards;
+} BatchStep;
+
+// The same mines as a Minefield's PlaceMines, so a board matches a Minefield given the same seed.
+static void
+PlaceBoardMines(_Inout_ BatchField* batch, _In_ uint32_t board, _In_ uint32_t exclude)
+{
+    uint8_t* hasMine = &batch->hasMine[(size_t)board * batch->cellCount];
+    uint8_t* neighborMines = &batch->neighborMines[(size_t)board * batch->cellCount];
+    uint32_t width = batch->width;
+    uint32_t height = batch->height;
+    bool mines[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+
+    PlaceSeededMines(width, height, batch->mines, batch->seeds[board], exclude % width, exclude / width, mines);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            if (!mines[y * width + x])
+                continue;
+
+            hasMine[y * width + x] = 1;
+
+            // Counting outward from each mine touches far fewer cells than counting inward at every cell. A mine
+            // counts itself as well, which is harmless since the counts of mine cells are never read.
+            uint32_t left = x > 0 ? x - 1 : x;
+            uint32_t right = x + 1 < width ? x + 1 : x;
+            uint32_t top = y > 0 ? y - 1 : y;
+            uint32_t bottom = y + 1 < height ? y + 1 : y;
+
+            for (uint32_t ny = top; ny <= bottom; ny++)
+            {
+                for (uint32_t nx = left; nx <= right; nx++)
+                    neighborMines[ny * width + nx]++;
+            }
+        }
+    }
+}
+
+static int8_t
+GetObservationCode(_In_ uint8_t state, _In_ uint8_t hasMine, _In_ uint8_t neighborMines)
+{
+    if (state == CELL_HIDDEN)
+        return BATCH_OBSERVATION_HIDDEN;
+    else if (state == CELL_FLAGGED)
+        return BATCH_OBSERVATION_FLAGGED;
+    else if (hasMine)
+        return BATCH_OBSERVATION_MINE;
+    else
+        return (int8_t)neighborMines;
+}
+
+static uint32_t
+GetObservationChannel(_In_ int8_t code)
+{
+    return code >= 0 ? (uint32_t)code : (uint32_t)(8 - code);
+}
+
+static void
+EncodeBoard(
+    _In_ const BatchField* batch,
+    _In_ BatchObservationFormat format,
+    _In_ uint32_t board,
+    _Out_ uint8_t* buffer)
+{
+    size_t first = (size_t)board * batch->cellCount;
+    const uint8_t* hasMine = &batch->hasMine[first];
+    const uint8_t* neighborMines = &batch->neighborMines[first];
+    const uint8_t* states = &batch->states[first];
+
+    if (format == BATCH_OBSERVATION_CODES)
+    {
+        uint8_t* codes = &buffer[first];
+
+        for (uint32_t cell = 0; cell < batch->cellCount; cell++)
+            codes[cell] = (uint8_t)GetObservationCode(states[cell], hasMine[cell], neighborMines[cell]);
+
+        return;
+    }
+
+    uint8_t* planes = &buffer[first * BATCH_OBSERVATION_CHANNELS];
+
+    ZeroMemory(planes, (size_t)BATCH_OBSERVATION_CHANNELS * batch->cellCount);
+
+    for (uint32_t cell = 0; cell < batch->cellCount; cell++)
+    {
+        int8_t code = GetObservationCode(states[cell], hasMine[cell], neighborMines[cell]);
+
+        planes[GetObservationChannel(code) * batch->cellCount + cell] = 1;
+    }
+}
+
+// Called only with an observation attached, for each cell whose visible state a step changes.
+static void
+ObserveCell(_Inout_ BatchField* batch, _In_ uint32_t board, _In_ uint32_t cell, _In_ int8_t previous, _In_ int8_t code)
+{
+    if (batch->observationFormat == BATCH_OBSERVATION_CODES)
+    {
+        batch->observation[(size_t)board * batch->cellCount + cell] = (uint8_t)code;
+        return;
+    }
+
+    uint8_t* planes = &batch->observation[(size_t)board * BATCH_OBSERVATION_CHANNELS * batch->cellCount + cell];
+
+    planes[GetObservationChannel(previous) * batch->cellCount] = 0;
+    planes[GetObservationChannel(code) * batch->cellCount] = 1;
+}
+
+static void
+ResetBoard(_Inout_ BatchField* batch, _In_ uint32_t board)
+{
+    size_t first = (size_t)board * batch->cellCount;
+
+    struct splitmix64_state state = {
+        .s = batch->seeds[board],
+    };
+
+    ZeroMemory(&batch->hasMine[first], batch->cellCount);
+    ZeroMemory(&batch->neighborMines[first], batch->cellCount);
+    ZeroMemory(&batch->states[first], batch->cellCount);
+    batch->gameStates[board] = GAME_PLAYING;
+    batch->revealedCells[board] = 0;
+    batch->flaggedCells[board] = 0;
+    batch->seeds[board] = splitmix64(&state);
+
+    if (batch->observation == NULL)
+        return;
+
+    // A new game is all hidden, so it can be filled without looking at the board.
+    if (batch->observationFormat == BATCH_OBSERVATION_CODES)
+    {
+        FillMemory(&batch->observation[first], batch->cellCount, (uint8_t)BATCH_OBSERVATION_HIDDEN);
+    }
+    else
+    {
+        uint8_t* planes = &batch->observation[first * BATCH_OBSERVATION_CHANNELS];
+        uint8_t* hidden = &planes[GetObservationChannel(BATCH_OBSERVATION_HIDDEN) * batch->cellCount];
+
+        ZeroMemory(planes, (size_t)BATCH_OBSERVATION_CHANNELS * batch->cellCount);
+        FillMemory(hidden, batch->cellCount, 1);
+    }
+}
+
+static void
+RevealBoardCell(_Inout_ BatchField* batch, _In_ uint32_t board, _In_ uint32_t cell, _Inout_ uint16_t* stack)
+{
+    size_t first = (size_t)board * batch->cellCount;
+    const uint8_t* hasMine = &batch->hasMine[first];
+    const uint8_t* neighborMines = &batch->neighborMines[first];
+    uint8_t* states = &batch->states[first];
+    uint32_t width = batch->width;
+    uint32_t height = batch->height;
+    bool observed = batch->observation != NULL;
+
+    if (states[cell] != CELL_HIDDEN)
+        return;
+
+    // Nothing is revealed before the first click, which always reveals at least the clicked cell.
+    if (batch->revealedCells[board] == 0)
+        PlaceBoardMines(batch, board, cell);
+
+    states[cell] = CELL_REVEALED;
+
+    if (observed)
+    {
+        int8_t code = GetObservationCode(CELL_REVEALED, hasMine[cell], neighborMines[cell]);
+
+        ObserveCell(batch, board, cell, BATCH_OBSERVATION_HIDDEN, code);
+    }
+
+    if (hasMine[cell])
+    {
+        batch->gameStates[board] = GAME_LOST;
+        return;
+    }
+
+    uint32_t revealed = 1;
+    uint32_t count = 0;
+
+    if (neighborMines[cell] == 0)
+        stack[count++] = (uint16_t)cell;
+
+    while (count > 0)
+    {
+        uint32_t index = stack[--count];
+        uint32_t x = index % width;
+        uint32_t y = index / width;
+        uint32_t left = x > 0 ? x - 1 : x;
+        uint32_t right = x + 1 < width ? x + 1 : x;
+        uint32_t top = y > 0 ? y - 1 : y;
+        uint32_t bottom = y + 1 < height ? y + 1 : y;
+
+        for (uint32_t ny = top; ny <= bottom; ny++)
+        {
+            for (uint32_t nx = left; nx <= right; nx++)
+            {
+                uint32_t neighbor = ny * width + nx;
+
+                if (states[neighbor] != CELL_HIDDEN)
+                    continue;
+
+                states[neighbor] = CELL_REVEALED;
+                revealed++;
+
+                if (observed)
+                    ObserveCell(batch, board, neighbor, BATCH_OBSERVATION_HIDDEN, (int8_t)neighborMines[neighbor]);
+
+                if (neighborMines[neighbor] == 0)
+                    stack[count++] = (uint16_t)neighbor;
+            }
+        }
+    }
+
+    batch->revealedCells[board] += (uint16_t)revealed;
+
+    if (batch->revealedCells[board] == batch->cellCount - batch->mines)
+        batch->gameStates[board] = GAME_WON;
+}
+
+static void
+ToggleBoardFlag(_Inout_ BatchField* batch, _In_ uint32_t board, _In_ uint32_t cell)
+{
+    uint8_t* state = &batch->states[(size_t)board * batch->cellCount + cell];
+
+    if (*state == CELL_FLAGGED)
+    {
+        *state = CELL_HIDDEN;
+        batch->flaggedCells[board]--;
+
+        if (batch->observation != NULL)
+            ObserveCell(batch, board, cell, BATCH_OBSERVATION_FLAGGED, BATCH_OBSERVATION_HIDDEN);
+    }
+    else if (*state == CELL_HIDDEN)
+    {
+        *state = CELL_FLAGGED;
+        batch->flaggedCells[board]++;
+
+        if (batch->observation != NULL)
+            ObserveCell(batch, board, cell, BATCH_OBSERVATION_HIDDEN, BATCH_OBSERVATION_FLAGGED);
+    }
+}
+
+static void
+StepBatchShard(_Inout_opt_ void* context, _In_ uint32_t shard)
+{
+    BatchStep* step = context;
+    BatchField* batch = step->batch;
+    uint32_t begin = (uint32_t)((uint64_t)batch->boardCount * shard / step->shards);
+    uint32_t end = (uint32_t)((uint64_t)batch->boardCount * (shard + 1) / step->shards);
+    uint16_t* stack = &batch->stacks[(size_t)shard * batch->cellCount];
+
+    for (uint32_t board = begin; board < end; board++)
+    {
+        const BatchAction* action = &step->actions[board];
+
+        if (action->kind == BATCH_ACTION_RESET)
+        {
+            ResetBoard(batch, board);
+            continue;
+        }
+
+        if (action->kind == BATCH_ACTION_NONE || action->cell >= batch->cellCount ||
+            batch->gameStates[board] != GAME_PLAYING)
+        {
+            continue;
+        }
+
+        if (action->kind == BATCH_ACTION_REVEAL)
+            RevealBoardCell(batch, board, action->cell, stack);
+        else if (action->kind == BATCH_ACTION_FLAG)
+            ToggleBoardFlag(batch, board, action->cell);
+    }
+}
+
+bool
+CreateBatchField(
+    _Out_ BatchField* batch,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t boardCount,
+    _In_ uint64_t seed)
+{
+    ZeroMemory(batch, sizeof(BatchField));
+
+    if (width == 0 || height == 0 || width > MAX_CELLS_HORIZONTALLY || height > MAX_CELLS_VERTICALLY ||
+        mines >= width * height || boardCount == 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    size_t planeSize = (size_t)boardCount * width * height;
+
+    batch->width = width;
+    batch->height = height;
+    batch->mines = mines;
+    batch->cellCount = width * height;
+    batch->boardCount = boardCount;
+    batch->hasMine = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, planeSize);
+    batch->neighborMines = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, planeSize);
+    batch->states = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, planeSize);
+    batch->gameStates = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, boardCount);
+    batch->revealedCells = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint16_t) * boardCount);
+    batch->flaggedCells = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint16_t) * boardCount);
+    batch->seeds = HeapAlloc(hHeap, 0, sizeof(uint64_t) * boardCount);
+    batch->stacks = HeapAlloc(hHeap, 0, sizeof(uint16_t) * PARALLEL_MAX_THREADS * batch->cellCount);
+
+    if (batch->hasMine == NULL || batch->neighborMines == NULL || batch->states == NULL ||
+        batch->gameStates == NULL || batch->revealedCells == NULL || batch->flaggedCells == NULL ||
+        batch->seeds == NULL || batch->stacks == NULL)
+    {
+        DestroyBatchField(batch);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    struct splitmix64_state state = {
+        .s = seed,
+    };
+
+    for (uint32_t board = 0; board < boardCount; board++)
+        batch->seeds[board] = splitmix64(&state);
+
+    return true;
+}
+
+void
+DestroyBatchField(_Inout_ BatchField* batch)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, batch->hasMine);
+    HeapFree(hHeap, 0, batch->neighborMines);
+    HeapFree(hHeap, 0, batch->states);
+    HeapFree(hHeap, 0, batch->gameStates);
+    HeapFree(hHeap, 0, batch->revealedCells);
+    HeapFree(hHeap, 0, batch->flaggedCells);
+    HeapFree(hHeap, 0, batch->seeds);
+    HeapFree(hHeap, 0, batch->stacks);
+
+    ZeroMemory(batch, sizeof(BatchField));
+}
+
+void
+StepBatchField(
+    _Inout_ BatchField* batch,
+    _In_reads_(batch->boardCount) const BatchAction* actions,
+    _In_ uint32_t threads)
+{
+    if (threads == 0)
+        threads = GetParallelThreadCount();
+
+    BatchStep step = {
+        .batch = batch,
+        .actions = actions,
+        .shards = min(min(threads, batch->boardCount), (uint32_t)PARALLEL_MAX_THREADS),
+    };
+
+    if (step.shards == 1)
+        StepBatchShard(&step, 0);
+    else
+        ParallelFor(step.shards, step.shards, StepBatchShard, &step);
+}
+
+uint64_t
+GetBatchObservationSize(_In_ const BatchField* batch, _In_ BatchObservationFormat format)
+{
+    uint64_t size = (uint64_t)batch->boardCount * batch->cellCount;
+
+    return format == BATCH_OBSERVATION_ONE_HOT ? size * BATCH_OBSERVATION_CHANNELS : size;
+}
+
+void
+EncodeBatchObservation(
+    _In_ const BatchField* batch,
+    _In_ BatchObservationFormat format,
+    _Out_writes_bytes_(GetBatchObservationSize(batch, format)) void* buffer)
+{
+    for (uint32_t board = 0; board < batch->boardCount; board++)
+        EncodeBoard(batch, format, board, buffer);
+}
+
+bool
+AttachBatchObservation(
+    _Inout_ BatchField* batch,
+    _In_ BatchObservationFormat format,
+    _Inout_updates_bytes_opt_(GetBatchObservationSize(batch, format)) void* buffer)
+{
+    if ((format != BATCH_OBSERVATION_CODES && format != BATCH_OBSERVATION_ONE_HOT) ||
+        (uintptr_t)buffer % BATCH_OBSERVATION_ALIGNMENT != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    batch->observation = buffer;
+    batch->observationFormat = format;
+
+    if (buffer != NULL)
+        EncodeBatchObservation(batch, format, buffer);
+
+    return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+typedef enum
+{
+    BATCH_ACTION_NONE,
+    BATCH_ACTION_REVEAL,
+    BATCH_ACTION_FLAG,
+    BATCH_ACTION_RESET,
+} BatchActionKind;
+
+// The player-visible board as one signed byte per cell: the count of a revealed cell, or one of the codes below.
+#define BATCH_OBSERVATION_HIDDEN (-1)
+#define BATCH_OBSERVATION_FLAGGED (-2)
+#define BATCH_OBSERVATION_MINE (-3)
+
+// One-hot observations hold a plane of 0 or 1 bytes per channel: channels 0 to 8 for the counts, then hidden, flagged
+// and mine.
+#define BATCH_OBSERVATION_CHANNELS 12
+
+// Attached buffers must start on this boundary, so consumers can wrap them as aligned arrays without copying.
+#define BATCH_OBSERVATION_ALIGNMENT 64
+
+// Codes is an int8 array shaped [boards][height][width]. One-hot is a uint8 array shaped
+// [boards][BATCH_OBSERVATION_CHANNELS][height][width]. Both layouts are fixed, so buffers can be shared across a C
+// boundary as they are.
+typedef enum
+{
+    BATCH_OBSERVATION_CODES,
+    BATCH_OBSERVATION_ONE_HOT,
+} BatchObservationFormat;
+
+// One board's move for a step. Reset starts a new game on the board's next seed and ignores the cell.
+typedef struct
+{
+    uint16_t cell;
+    uint8_t kind;
+} BatchAction;
+
+// Many boards of one size stepped together, for training runs that play thousands of games at once. Each field is a
+// plane of its own holding that field for every board back to back, so a board's mines, counts and states are each
+// a contiguous run of width * height bytes. Games follow the same rules and mine placement as a Minefield with the
+// same seed: mines are placed on the first reveal, never under the clicked cell.
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t cellCount;
+    uint32_t boardCount;
+    uint8_t* hasMine;
+    uint8_t* neighborMines;
+    uint8_t* states;
+    uint8_t* gameStates;
+    uint16_t* revealedCells;
+    uint16_t* flaggedCells;
+    uint64_t* seeds;
+    uint16_t* stacks;
+    uint8_t* observation;
+    BatchObservationFormat observationFormat;
+} BatchField;
+
+bool CreateBatchField(
+    _Out_ BatchField* batch,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t boardCount,
+    _In_ uint64_t seed);
+
+void DestroyBatchField(_Inout_ BatchField* batch);
+
+// Applies one action to every board, splitting the boards into one contiguous shard per thread. Zero threads means
+// one per processor.
+void StepBatchField(
+    _Inout_ BatchField* batch,
+    _In_reads_(batch->boardCount) const BatchAction* actions,
+    _In_ uint32_t threads);
+
+uint64_t GetBatchObservationSize(_In_ const BatchField* batch, _In_ BatchObservationFormat format);
+
+// Writes every cell of every board; an attached buffer only needs this once.
+void EncodeBatchObservation(
+    _In_ const BatchField* batch,
+    _In_ BatchObservationFormat format,
+    _Out_writes_bytes_(GetBatchObservationSize(batch, format)) void* buffer);
+
+// Encodes the buffer once and from then on updates only the cells each step changes, in place. The buffer stays the
+// caller's and must stay alive until another one, or NULL, is attached.
+bool AttachBatchObservation(
+    _Inout_ BatchField* batch,
+    _In_ BatchObservationFormat format,
+    _Inout_updates_bytes_opt_(GetBatchObservationSize(batch, format)) void* buffer);
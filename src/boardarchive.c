@@ -0,0 +1,698 @@
+#include "pch.h"
+
+#include "boardarchive.h"
+#include "littleendian.h"
+#include "parallel.h"
+
+#define BOARD_ARCHIVE_MAGIC 0x4142534Du
+#define BOARD_ARCHIVE_VERSION 1
+#define BOARD_ARCHIVE_INITIAL_BLOCKS 1024
+#define BOARD_ARCHIVE_CODE_OFFSET 16
+
+#define CODER_TOP 0xFFFFFFFFull
+#define CODER_HALF 0x80000000ull
+#define CODER_QUARTER 0x40000000ull
+
+typedef struct
+{
+    BoardArchiveWriter* writer;
+    const bool* mines;
+    const uint32_t* firstClicks;
+    uint32_t count;
+    volatile LONG nextBoard;
+    volatile LONG failed;
+} ArchiveBatch;
+
+typedef struct
+{
+    uint8_t* bytes;
+    uint32_t capacity;
+    uint32_t bits;
+} BitWriter;
+
+static const uint8_t padding[8] = {0};
+
+static uint32_t
+PutVarint(_Out_writes_bytes_to_(5, return) uint8_t* bytes, _In_ uint32_t value)
+{
+    uint32_t size = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    bytes[size++] = (uint8_t)value;
+
+    return size;
+}
+
+static bool
+GetVarint(_Inout_ const uint8_t** position, _In_ const uint8_t* end, _Out_ uint32_t* value)
+{
+    *value = 0;
+
+    for (uint32_t shift = 0; shift < 35 && *position < end; shift += 7)
+    {
+        uint8_t byte = *(*position)++;
+
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+static void
+PutBit(_Inout_ BitWriter* writer, _In_ uint32_t bit)
+{
+    if (writer->bits < writer->capacity * 8)
+    {
+        if ((writer->bits & 7) == 0)
+            writer->bytes[writer->bits >> 3] = 0;
+
+        writer->bytes[writer->bits >> 3] |= (uint8_t)(bit << (7 - (writer->bits & 7)));
+    }
+
+    writer->bits++;
+}
+
+// Writes a bit followed by the opposite bits held back while the interval straddled the middle.
+static void
+PutBits(_Inout_ BitWriter* writer, _In_ uint32_t bit, _In_ uint32_t pending)
+{
+    PutBit(writer, bit);
+
+    for (; pending > 0; pending--)
+        PutBit(writer, bit ^ 1);
+}
+
+static uint32_t
+GetBit(_In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size, _In_ uint32_t position)
+{
+    return position < size * 8 ? bytes[position >> 3] >> (7 - (position & 7)) & 1 : 0;
+}
+
+// Each cell is coded with the odds of a mine among the cells left, so a board costs log2(C(cells, mines)) bits plus
+// the two that end the code. Coding stops once the cells left are all mines or all safe. Returns the code size in
+// bits, which exceeds the capacity only when the code did not fit.
+static uint32_t
+EncodeMinePlane(
+    _In_ uint32_t cellCount,
+    _In_ uint32_t totalMines,
+    _In_reads_(cellCount) const bool* mines,
+    _Out_writes_bytes_(capacity) uint8_t* code,
+    _In_ uint32_t capacity)
+{
+    BitWriter writer = {
+        .bytes = code,
+        .capacity = capacity,
+    };
+
+    uint64_t low = 0;
+    uint64_t high = CODER_TOP;
+    uint32_t pending = 0;
+    uint32_t minesLeft = totalMines;
+
+    for (uint32_t i = 0; minesLeft > 0 && minesLeft < cellCount - i; i++)
+    {
+        uint32_t cellsLeft = cellCount - i;
+        uint64_t safeWidth = (high - low + 1) * (cellsLeft - minesLeft) / cellsLeft;
+
+        if (mines[i])
+        {
+            low += safeWidth;
+            minesLeft--;
+        }
+        else
+        {
+            high = low + safeWidth - 1;
+        }
+
+        for (;;)
+        {
+            if (high < CODER_HALF)
+            {
+                PutBits(&writer, 0, pending);
+                pending = 0;
+            }
+            else if (low >= CODER_HALF)
+            {
+                PutBits(&writer, 1, pending);
+                pending = 0;
+                low -= CODER_HALF;
+                high -= CODER_HALF;
+            }
+            else if (low >= CODER_QUARTER && high < CODER_HALF + CODER_QUARTER)
+            {
+                pending++;
+                low -= CODER_QUARTER;
+                high -= CODER_QUARTER;
+            }
+            else
+            {
+                break;
+            }
+
+            low <<= 1;
+            high = high << 1 | 1;
+        }
+    }
+
+    // Two more bits pick a point inside the final interval whatever follows them; the decoder reads zeros past the end.
+    PutBits(&writer, low < CODER_QUARTER ? 0 : 1, pending + 1);
+
+    return writer.bits;
+}
+
+static void
+DecodeMinePlane(
+    _In_ uint32_t cellCount,
+    _In_ uint32_t totalMines,
+    _In_reads_bytes_(size) const uint8_t* code,
+    _In_ uint32_t size,
+    _Out_writes_(cellCount) bool* mines)
+{
+    uint64_t low = 0;
+    uint64_t high = CODER_TOP;
+    uint64_t value = 0;
+    uint32_t position = 0;
+    uint32_t minesLeft = totalMines;
+    uint32_t i = 0;
+
+    for (; position < 32; position++)
+        value = value << 1 | GetBit(code, size, position);
+
+    for (; minesLeft > 0 && minesLeft < cellCount - i; i++)
+    {
+        uint32_t cellsLeft = cellCount - i;
+        uint64_t safeWidth = (high - low + 1) * (cellsLeft - minesLeft) / cellsLeft;
+
+        mines[i] = value - low >= safeWidth;
+
+        if (mines[i])
+        {
+            low += safeWidth;
+            minesLeft--;
+        }
+        else
+        {
+            high = low + safeWidth - 1;
+        }
+
+        for (;;)
+        {
+            uint64_t offset;
+
+            if (high < CODER_HALF)
+                offset = 0;
+            else if (low >= CODER_HALF)
+                offset = CODER_HALF;
+            else if (low >= CODER_QUARTER && high < CODER_HALF + CODER_QUARTER)
+                offset = CODER_QUARTER;
+            else
+                break;
+
+            low = (low - offset) << 1;
+            high = (high - offset) << 1 | 1;
+            value = (value - offset) << 1 | GetBit(code, size, position++);
+        }
+    }
+
+    for (; i < cellCount; i++)
+        mines[i] = minesLeft > 0;
+}
+
+// A record is its 3BV, its first click plus one (zero for none), the code size in bytes, then the code. Returns the
+// record size, or zero when the board does not match the archive.
+static uint32_t
+EncodeBoardRecord(
+    _In_ const BoardArchiveWriter* writer,
+    _In_reads_(writer->width* writer->height) const bool* mines,
+    _In_ uint32_t bbbv,
+    _In_ uint32_t firstClick,
+    _Out_writes_bytes_to_(BOARD_ARCHIVE_MAX_RECORD_SIZE, return) uint8_t* record,
+    _Out_ uint32_t* codeBits)
+{
+    uint32_t cellCount = writer->width * writer->height;
+    uint32_t mineCount = 0;
+
+    *codeBits = 0;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        mineCount += mines[i] ? 1 : 0;
+
+    if (mineCount != writer->totalMines || (firstClick != BOARD_ARCHIVE_NO_CLICK && firstClick >= cellCount))
+        return 0;
+
+    uint8_t* code = record + BOARD_ARCHIVE_CODE_OFFSET;
+    uint32_t bits = EncodeMinePlane(cellCount, writer->totalMines, mines, code, BOARD_ARCHIVE_MAX_CODE_BYTES);
+    uint32_t codeBytes = (bits + 7) / 8;
+
+    if (codeBytes > BOARD_ARCHIVE_MAX_CODE_BYTES)
+        return 0;
+
+    uint32_t size = PutVarint(record, bbbv);
+
+    size += PutVarint(record + size, firstClick + 1);
+    size += PutVarint(record + size, codeBytes);
+    MoveMemory(record + size, code, codeBytes);
+    *codeBits = bits;
+
+    return size + codeBytes;
+}
+
+static void
+EncodeBatchBoards(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    ArchiveBatch* batch = (ArchiveBatch*)context;
+    BoardArchiveWriter* writer = batch->writer;
+    uint32_t cellCount = writer->width * writer->height;
+    MetricsWorkspace workspace;
+
+    if (!CreateMetricsWorkspace(&workspace, writer->width, writer->height))
+    {
+        InterlockedExchange(&batch->failed, 1);
+        return;
+    }
+
+    for (;;)
+    {
+        uint32_t board = (uint32_t)InterlockedIncrement(&batch->nextBoard) - 1;
+
+        if (board >= batch->count)
+            break;
+
+        const bool* mines = batch->mines + (size_t)board * cellCount;
+        uint32_t firstClick = batch->firstClicks != NULL ? batch->firstClicks[board] : BOARD_ARCHIVE_NO_CLICK;
+        uint8_t* record = writer->records + (size_t)board * BOARD_ARCHIVE_MAX_RECORD_SIZE;
+        BoardMetrics metrics;
+
+        if (!ComputeBoardMetrics(&workspace, writer->width, writer->height, mines, false, &metrics))
+            metrics.bbbv = 0;
+
+        writer->recordSizes[board] =
+            EncodeBoardRecord(writer, mines, metrics.bbbv, firstClick, record, &writer->recordBits[board]);
+
+        if (writer->recordSizes[board] == 0)
+            InterlockedExchange(&batch->failed, 1);
+    }
+
+    DestroyMetricsWorkspace(&workspace);
+}
+
+static bool
+FlushArchiveWriter(_Inout_ BoardArchiveWriter* writer)
+{
+    DWORD written = 0;
+    bool success = writer->buffered == 0 ||
+                   (WriteFile(writer->hFile, writer->buffer, writer->buffered, &written, NULL) &&
+                    written == writer->buffered);
+
+    writer->buffered = 0;
+
+    return success;
+}
+
+static bool
+WriteArchiveBytes(
+    _Inout_ BoardArchiveWriter* writer,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    while (size > 0)
+    {
+        if (writer->buffered == BOARD_ARCHIVE_WRITE_BUFFER_SIZE && !FlushArchiveWriter(writer))
+            return false;
+
+        uint32_t chunk = min(size, BOARD_ARCHIVE_WRITE_BUFFER_SIZE - writer->buffered);
+
+        CopyMemory(writer->buffer + writer->buffered, bytes, chunk);
+        writer->buffered += chunk;
+        writer->offset += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+static bool
+AppendArchiveRecord(
+    _Inout_ BoardArchiveWriter* writer,
+    _In_reads_bytes_(size) const uint8_t* record,
+    _In_ uint32_t size)
+{
+    if (writer->count % BOARD_ARCHIVE_BLOCK_BOARDS == 0)
+    {
+        uint64_t block = writer->count / BOARD_ARCHIVE_BLOCK_BOARDS;
+
+        if (block == writer->capacity)
+        {
+            uint64_t capacity = writer->capacity * 2;
+            uint64_t* blocks = HeapReAlloc(GetProcessHeap(), 0, writer->blocks, (SIZE_T)(capacity * sizeof(uint64_t)));
+
+            if (blocks == NULL)
+            {
+                SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+                return false;
+            }
+
+            writer->blocks = blocks;
+            writer->capacity = capacity;
+        }
+
+        writer->blocks[block] = writer->offset;
+    }
+
+    if (!WriteArchiveBytes(writer, record, size))
+        return false;
+
+    writer->count++;
+
+    return true;
+}
+
+bool
+CreateBoardArchiveWriter(
+    _Out_ BoardArchiveWriter* writer,
+    _In_z_ const char* path,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t totalMines)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    ZeroMemory(writer, sizeof(BoardArchiveWriter));
+    writer->hFile = INVALID_HANDLE_VALUE;
+
+    if (width == 0 || height == 0 || width > MAX_CELLS_HORIZONTALLY || height > MAX_CELLS_VERTICALLY ||
+        totalMines >= width * height)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    writer->hFile = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (writer->hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    writer->width = width;
+    writer->height = height;
+    writer->totalMines = totalMines;
+    writer->buffer = HeapAlloc(hHeap, 0, BOARD_ARCHIVE_WRITE_BUFFER_SIZE);
+    writer->blocks = HeapAlloc(hHeap, 0, sizeof(uint64_t) * BOARD_ARCHIVE_INITIAL_BLOCKS);
+    writer->records = HeapAlloc(hHeap, 0, (SIZE_T)BOARD_ARCHIVE_MAX_RECORD_SIZE * BOARD_ARCHIVE_BATCH_BOARDS);
+    writer->recordSizes = HeapAlloc(hHeap, 0, sizeof(uint32_t) * BOARD_ARCHIVE_BATCH_BOARDS);
+    writer->recordBits = HeapAlloc(hHeap, 0, sizeof(uint32_t) * BOARD_ARCHIVE_BATCH_BOARDS);
+    writer->capacity = BOARD_ARCHIVE_INITIAL_BLOCKS;
+
+    if (writer->buffer == NULL || writer->blocks == NULL || writer->records == NULL || writer->recordSizes == NULL ||
+        writer->recordBits == NULL)
+    {
+        CloseBoardArchiveWriter(writer);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    // The header is rewritten once the index is in place.
+    uint8_t header[BOARD_ARCHIVE_HEADER_SIZE] = {0};
+
+    return WriteArchiveBytes(writer, header, sizeof(header));
+}
+
+bool
+AppendArchiveBoards(
+    _Inout_ BoardArchiveWriter* writer,
+    _In_ uint32_t count,
+    _In_reads_(count* writer->width* writer->height) const bool* mines,
+    _In_reads_opt_(count) const uint32_t* firstClicks,
+    _In_ uint32_t threads)
+{
+    uint32_t cellCount = writer->width * writer->height;
+
+    for (uint32_t first = 0; first < count; first += BOARD_ARCHIVE_BATCH_BOARDS)
+    {
+        ArchiveBatch batch = {
+            .writer = writer,
+            .mines = mines + (size_t)first * cellCount,
+            .firstClicks = firstClicks != NULL ? firstClicks + first : NULL,
+            .count = min(count - first, (uint32_t)BOARD_ARCHIVE_BATCH_BOARDS),
+        };
+
+        uint32_t workers = threads == 0 ? GetParallelThreadCount() : threads;
+
+        ParallelFor(min(workers, batch.count), workers, EncodeBatchBoards, &batch);
+
+        if (batch.failed != 0)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+            return false;
+        }
+
+        for (uint32_t i = 0; i < batch.count; i++)
+        {
+            if (!AppendArchiveRecord(writer, writer->records + (size_t)i * BOARD_ARCHIVE_MAX_RECORD_SIZE,
+                                     writer->recordSizes[i]))
+            {
+                return false;
+            }
+
+            writer->codeBits += writer->recordBits[i];
+        }
+    }
+
+    return true;
+}
+
+bool
+CloseBoardArchiveWriter(_Inout_ BoardArchiveWriter* writer)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint64_t indexOffset = (writer->offset + 7) & ~(uint64_t)7;
+    uint64_t blockCount = (writer->count + BOARD_ARCHIVE_BLOCK_BOARDS - 1) / BOARD_ARCHIVE_BLOCK_BOARDS;
+    bool success = writer->hFile != INVALID_HANDLE_VALUE && writer->buffer != NULL && writer->blocks != NULL &&
+                   writer->records != NULL && writer->recordSizes != NULL && writer->recordBits != NULL;
+
+    if (success)
+    {
+        uint8_t header[BOARD_ARCHIVE_HEADER_SIZE] = {0};
+        LARGE_INTEGER start = {0};
+        DWORD written = 0;
+
+        PutLittleEndian(header, BOARD_ARCHIVE_MAGIC, 4);
+        PutLittleEndian(header + 4, BOARD_ARCHIVE_VERSION, 2);
+        PutLittleEndian(header + 6, writer->width, 2);
+        PutLittleEndian(header + 8, writer->height, 2);
+        PutLittleEndian(header + 10, writer->totalMines, 2);
+        PutLittleEndian(header + 16, writer->count, 8);
+        PutLittleEndian(header + 24, indexOffset, 8);
+
+        success = WriteArchiveBytes(writer, padding, (uint32_t)(indexOffset - writer->offset));
+
+        for (uint64_t i = 0; success && i < blockCount; i++)
+        {
+            uint8_t entry[8];
+
+            PutLittleEndian(entry, writer->blocks[i], 8);
+            success = WriteArchiveBytes(writer, entry, sizeof(entry));
+        }
+
+        success = success && FlushArchiveWriter(writer) && SetFilePointerEx(writer->hFile, start, NULL, FILE_BEGIN) &&
+                  WriteFile(writer->hFile, header, sizeof(header), &written, NULL) && written == sizeof(header);
+    }
+
+    if (writer->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(writer->hFile);
+
+    HeapFree(hHeap, 0, writer->buffer);
+    HeapFree(hHeap, 0, writer->blocks);
+    HeapFree(hHeap, 0, writer->records);
+    HeapFree(hHeap, 0, writer->recordSizes);
+    HeapFree(hHeap, 0, writer->recordBits);
+    ZeroMemory(writer, sizeof(BoardArchiveWriter));
+    writer->hFile = INVALID_HANDLE_VALUE;
+
+    return success;
+}
+
+static bool
+ViewBoardArchive(_Inout_ BoardArchive* archive, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint64_t size)
+{
+    if (size < BOARD_ARCHIVE_HEADER_SIZE || GetLittleEndian(bytes, 4) != BOARD_ARCHIVE_MAGIC ||
+        GetLittleEndian(bytes + 4, 2) != BOARD_ARCHIVE_VERSION)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    uint32_t width = (uint32_t)GetLittleEndian(bytes + 6, 2);
+    uint32_t height = (uint32_t)GetLittleEndian(bytes + 8, 2);
+    uint32_t totalMines = (uint32_t)GetLittleEndian(bytes + 10, 2);
+    uint64_t count = GetLittleEndian(bytes + 16, 8);
+    uint64_t indexOffset = GetLittleEndian(bytes + 24, 8);
+    uint64_t blockCount = (count + BOARD_ARCHIVE_BLOCK_BOARDS - 1) / BOARD_ARCHIVE_BLOCK_BOARDS;
+
+    if (width == 0 || height == 0 || width > MAX_CELLS_HORIZONTALLY || height > MAX_CELLS_VERTICALLY ||
+        totalMines >= width * height || indexOffset < BOARD_ARCHIVE_HEADER_SIZE || indexOffset > size ||
+        (size - indexOffset) % sizeof(uint64_t) != 0 || blockCount != (size - indexOffset) / sizeof(uint64_t))
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    archive->base = bytes;
+    archive->size = size;
+    archive->count = count;
+    archive->indexOffset = indexOffset;
+    archive->width = width;
+    archive->height = height;
+    archive->totalMines = totalMines;
+
+    return true;
+}
+
+bool
+OpenBoardArchive(_Out_ BoardArchive* archive, _In_z_ const char* path)
+{
+    LARGE_INTEGER size;
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    ZeroMemory(archive, sizeof(BoardArchive));
+    archive->hFile = INVALID_HANDLE_VALUE;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart < BOARD_ARCHIVE_HEADER_SIZE)
+    {
+        CloseHandle(hFile);
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    const uint8_t* base = hMapping != NULL ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    if (base == NULL || !ViewBoardArchive(archive, base, (uint64_t)size.QuadPart))
+    {
+        DWORD error = GetLastError();
+
+        if (base != NULL)
+            UnmapViewOfFile(base);
+
+        if (hMapping != NULL)
+            CloseHandle(hMapping);
+
+        CloseHandle(hFile);
+        SetLastError(error);
+
+        return false;
+    }
+
+    archive->hFile = hFile;
+    archive->hMapping = hMapping;
+
+    return true;
+}
+
+void
+CloseBoardArchive(_Inout_ BoardArchive* archive)
+{
+    if (archive->hMapping != NULL)
+    {
+        UnmapViewOfFile(archive->base);
+        CloseHandle(archive->hMapping);
+    }
+
+    if (archive->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(archive->hFile);
+
+    ZeroMemory(archive, sizeof(BoardArchive));
+    archive->hFile = INVALID_HANDLE_VALUE;
+}
+
+static bool
+ReadBoardRecord(
+    _Inout_ const uint8_t** position,
+    _In_ const uint8_t* end,
+    _Out_ ArchivedBoard* board,
+    _Outptr_ const uint8_t** code,
+    _Out_ uint32_t* codeBytes)
+{
+    uint32_t firstClick;
+
+    *code = NULL;
+
+    if (!GetVarint(position, end, &board->bbbv) || !GetVarint(position, end, &firstClick) ||
+        !GetVarint(position, end, codeBytes) || *codeBytes > (size_t)(end - *position))
+    {
+        return false;
+    }
+
+    board->firstClick = firstClick - 1;
+    *code = *position;
+    *position += *codeBytes;
+
+    return true;
+}
+
+bool
+ReadArchiveBoards(
+    _In_ const BoardArchive* archive,
+    _In_ uint64_t first,
+    _In_ uint32_t count,
+    _Out_writes_(count* archive->width* archive->height) bool* mines,
+    _Out_writes_(count) ArchivedBoard* boards)
+{
+    uint32_t cellCount = archive->width * archive->height;
+
+    if (first > archive->count || count > archive->count - first)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    if (count == 0)
+        return true;
+
+    const uint8_t* end = archive->base + archive->indexOffset;
+    uint64_t block = first / BOARD_ARCHIVE_BLOCK_BOARDS;
+    uint64_t offset = GetLittleEndian(end + block * sizeof(uint64_t), 8);
+
+    if (offset < BOARD_ARCHIVE_HEADER_SIZE || offset > archive->indexOffset)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    const uint8_t* position = archive->base + offset;
+    const uint8_t* code;
+    uint32_t codeBytes;
+
+    for (uint64_t skip = first % BOARD_ARCHIVE_BLOCK_BOARDS; skip > 0; skip--)
+    {
+        if (!ReadBoardRecord(&position, end, &boards[0], &code, &codeBytes))
+        {
+            SetLastError(ERROR_BAD_FORMAT);
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!ReadBoardRecord(&position, end, &boards[i], &code, &codeBytes))
+        {
+            SetLastError(ERROR_BAD_FORMAT);
+            return false;
+        }
+
+        DecodeMinePlane(cellCount, archive->totalMines, code, codeBytes, mines + (size_t)i * cellCount);
+    }
+
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "metrics.h"
+
+#define BOARD_ARCHIVE_HEADER_SIZE 32
+#define BOARD_ARCHIVE_BLOCK_BOARDS 64
+#define BOARD_ARCHIVE_BATCH_BOARDS 4096
+#define BOARD_ARCHIVE_WRITE_BUFFER_SIZE (1 << 20)
+#define BOARD_ARCHIVE_NO_CLICK UINT32_MAX
+#define BOARD_ARCHIVE_MAX_CODE_BYTES ((MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY + 7) / 8 + 16)
+#define BOARD_ARCHIVE_MAX_RECORD_SIZE (BOARD_ARCHIVE_MAX_CODE_BYTES + 16)
+
+// What an archive keeps about each board besides its mines.
+typedef struct
+{
+    uint32_t bbbv;
+    uint32_t firstClick;
+} ArchivedBoard;
+
+// A board archive holds boards of one size and mine count. Each board is its 3BV, its first click and the mine
+// bitplane arithmetic-coded cell by cell with the exact odds of a mine among the cells left, which comes within a few
+// bits of log2(C(cells, mines)). The records are byte-aligned and stored back to back behind a 32-byte header; an
+// index with the offset of every 64th record follows on an 8-byte boundary, so a board is found by skipping at most
+// 63 record lengths. An archive is read through a mapped view.
+typedef struct
+{
+    const uint8_t* base;
+    uint64_t size;
+    uint64_t count;
+    uint64_t indexOffset;
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalMines;
+    HANDLE hFile;
+    HANDLE hMapping;
+} BoardArchive;
+
+typedef struct
+{
+    HANDLE hFile;
+    uint8_t* buffer;
+    uint32_t buffered;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t capacity;
+    uint64_t* blocks;
+    uint8_t* records;
+    uint32_t* recordSizes;
+    uint32_t* recordBits;
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalMines;
+    uint64_t codeBits;
+} BoardArchiveWriter;
+
+bool CreateBoardArchiveWriter(
+    _Out_ BoardArchiveWriter* writer,
+    _In_z_ const char* path,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t totalMines);
+
+// Scores and encodes the boards on up to the given number of threads (zero for all cores), then appends them in order.
+// mines holds the boards back to back and firstClicks may be NULL.
+bool AppendArchiveBoards(
+    _Inout_ BoardArchiveWriter* writer,
+    _In_ uint32_t count,
+    _In_reads_(count* writer->width* writer->height) const bool* mines,
+    _In_reads_opt_(count) const uint32_t* firstClicks,
+    _In_ uint32_t threads);
+
+// Writes the index and header and closes the file; the writer is released even when this fails.
+bool CloseBoardArchiveWriter(_Inout_ BoardArchiveWriter* writer);
+
+bool OpenBoardArchive(_Out_ BoardArchive* archive, _In_z_ const char* path);
+
+void CloseBoardArchive(_Inout_ BoardArchive* archive);
+
+// Decodes count boards from first on, back to back into mines; only the first is looked up in the index.
+bool ReadArchiveBoards(
+    _In_ const BoardArchive* archive,
+    _In_ uint64_t first,
+    _In_ uint32_t count,
+    _Out_writes_(count* archive->width* archive->height) bool* mines,
+    _Out_writes_(count) ArchivedBoard* boards);
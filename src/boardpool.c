@@ -0,0 +1,378 @@
+#include "pch.h"
+
+#include "boardpool.h"
+#include "noguess.h"
+#include "random.h"
+
+static bool
+IsSameSettings(_In_ const BoardSettings* a, _In_ const BoardSettings* b)
+{
+    return a->width == b->width && a->height == b->height && a->mines == b->mines;
+}
+
+// Maps a cell of the played board to the pooled board under one of the eight symmetries of the rectangle. Those with
+// bit 2 set swap the axes and only apply to square boards.
+static uint32_t
+TransformCell(
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t symmetry,
+    _In_ uint32_t x,
+    _In_ uint32_t y)
+{
+    if (symmetry & 4)
+    {
+        uint32_t swap = x;
+        x = y;
+        y = swap;
+    }
+
+    if (symmetry & 1)
+        x = settings->width - 1 - x;
+
+    if (symmetry & 2)
+        y = settings->height - 1 - y;
+
+    return y * settings->width + x;
+}
+
+static uint32_t
+CountNeighborMines(_In_ const BoardSettings* settings, _In_ const bool* mines, _In_ uint32_t x, _In_ uint32_t y)
+{
+    uint32_t count = 0;
+
+    for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= y + 1 && ny < settings->height; ny++)
+    {
+        for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= x + 1 && nx < settings->width; nx++)
+            count += mines[ny * settings->width + nx] ? 1 : 0;
+    }
+
+    return count;
+}
+
+// A no-guess board is only known to be solvable from its start cell, but clicking any other zero cell of the same
+// opening reveals exactly the same cells.
+static void
+MarkStartableCells(
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t startX,
+    _In_ uint32_t startY,
+    _Inout_ PooledBoard* board,
+    _Inout_ uint32_t* queue)
+{
+    ZeroMemory(board->startable, sizeof(bool) * settings->width * settings->height);
+
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    queue[tail++] = startY * settings->width + startX;
+    board->startable[startY * settings->width + startX] = true;
+
+    while (head < tail)
+    {
+        uint32_t x = queue[head] % settings->width;
+        uint32_t y = queue[head] / settings->width;
+
+        head++;
+
+        if (CountNeighborMines(settings, board->mines, x, y) != 0)
+            continue;
+
+        for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= y + 1 && ny < settings->height; ny++)
+        {
+            for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= x + 1 && nx < settings->width; nx++)
+            {
+                uint32_t index = ny * settings->width + nx;
+
+                if (board->startable[index] || CountNeighborMines(settings, board->mines, nx, ny) != 0)
+                    continue;
+
+                board->startable[index] = true;
+                queue[tail++] = index;
+            }
+        }
+    }
+}
+
+static bool
+GenerateBoard(
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t startX,
+    _In_ uint32_t startY,
+    _In_ uint64_t seed,
+    _Out_ PooledBoard* board,
+    _Inout_ uint32_t* queue)
+{
+    if (!GenerateNoGuessLayout(
+            settings->width, settings->height, settings->mines, startX, startY, seed, 1, board->mines, NULL))
+    {
+        return false;
+    }
+
+    MarkStartableCells(settings, startX, startY, board, queue);
+    return true;
+}
+
+static DWORD WINAPI
+BoardPoolWorker(_In_ LPVOID parameter)
+{
+    BoardPool* pool = (BoardPool*)parameter;
+    HANDLE hHeap = GetProcessHeap();
+    PooledBoard* board = HeapAlloc(hHeap, 0, sizeof(PooledBoard));
+    uint32_t* queue = HeapAlloc(hHeap, 0, sizeof(uint32_t) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+
+    if (board == NULL || queue == NULL)
+    {
+        HeapFree(hHeap, 0, board);
+        HeapFree(hHeap, 0, queue);
+        return 1;
+    }
+
+    AcquireSRWLockExclusive(&pool->lock);
+
+    for (;;)
+    {
+        while (!pool->stopping && (!pool->active || pool->boardCount == BOARD_POOL_CAPACITY))
+            SleepConditionVariableSRW(&pool->wake, &pool->lock, INFINITE, 0);
+
+        if (pool->stopping)
+            break;
+
+        BoardSettings settings = pool->settings;
+        uint64_t epoch = pool->epoch;
+        uint64_t seed = mix64(pool->seedBase + pool->nextSeed++);
+
+        // Every other board starts where the player last opened a game; the rest start anywhere, so that between them
+        // the pool has an opening under most cells. A click that found no board gets all of them.
+        uint32_t startX = pool->lastFirstX;
+        uint32_t startY = pool->lastFirstY;
+
+        if ((seed & 1) && !pool->waiting)
+        {
+            startX = (uint32_t)(((mix64(seed) >> 32) * settings.width) >> 32);
+            startY = (uint32_t)(((mix64(seed) & UINT32_MAX) * settings.height) >> 32);
+        }
+
+        ReleaseSRWLockExclusive(&pool->lock);
+
+        bool generated = GenerateBoard(&settings, startX, startY, seed, board, queue);
+
+        AcquireSRWLockExclusive(&pool->lock);
+
+        // Settings no board can be made for, such as a dense no-guess board, would otherwise keep every worker busy.
+        if (!generated && epoch == pool->epoch && ++pool->failures >= BOARD_POOL_MAX_FAILURES)
+        {
+            pool->active = false;
+            pool->exhausted = true;
+        }
+        else if (!generated && epoch == pool->epoch)
+        {
+            uint64_t now = GetTickCount64();
+            uint64_t until = now + ((uint64_t)BOARD_POOL_BACKOFF_MS << (pool->failures - 1));
+
+            for (; !pool->stopping && pool->active && epoch == pool->epoch && now < until; now = GetTickCount64())
+                SleepConditionVariableSRW(&pool->wake, &pool->lock, (DWORD)(until - now), 0);
+        }
+
+        // The settings may have changed while the board was being made, or other workers may have filled the pool.
+        if (!generated || epoch != pool->epoch || pool->boardCount == BOARD_POOL_CAPACITY)
+        {
+            pool->stats.discarded++;
+            continue;
+        }
+
+        PooledBoard* swap = pool->boards[pool->boardCount];
+        pool->boards[pool->boardCount++] = board;
+        board = swap;
+        pool->failures = 0;
+        pool->stats.generated++;
+    }
+
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    HeapFree(hHeap, 0, board);
+    HeapFree(hHeap, 0, queue);
+    return 0;
+}
+
+bool
+CreateBoardPool(_Out_ BoardPool* pool, _In_ uint32_t threads)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    ZeroMemory(pool, sizeof(BoardPool));
+    InitializeSRWLock(&pool->lock);
+    InitializeConditionVariable(&pool->wake);
+    pool->seedBase = GetTickCount64();
+
+    // Workers swap their scratch board with the slot they fill, so every slot owns a board at all times.
+    for (uint32_t i = 0; i < BOARD_POOL_CAPACITY; i++)
+    {
+        pool->boards[i] = HeapAlloc(hHeap, 0, sizeof(PooledBoard));
+
+        if (pool->boards[i] == NULL)
+        {
+            DestroyBoardPool(pool);
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return false;
+        }
+    }
+
+    threads = max(1u, min(threads, (uint32_t)BOARD_POOL_MAX_THREADS));
+
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        pool->threads[pool->threadCount] = CreateThread(NULL, 0, BoardPoolWorker, pool, 0, NULL);
+
+        if (pool->threads[pool->threadCount] == NULL)
+            break;
+
+        pool->threadCount++;
+    }
+
+    if (pool->threadCount == 0)
+    {
+        DestroyBoardPool(pool);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DestroyBoardPool(_Inout_ BoardPool* pool)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+    pool->stopping = true;
+    WakeAllConditionVariable(&pool->wake);
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->threadCount; i++)
+    {
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+    }
+
+    for (uint32_t i = 0; i < BOARD_POOL_CAPACITY; i++)
+        HeapFree(GetProcessHeap(), 0, pool->boards[i]);
+
+    ZeroMemory(pool, sizeof(BoardPool));
+}
+
+void
+SetBoardPoolSettings(_Inout_ BoardPool* pool, _In_ const BoardSettings* settings)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+
+    // Settings the workers gave up on stay off until other settings are chosen.
+    if (!IsSameSettings(&pool->settings, settings) || (!pool->active && !pool->exhausted))
+    {
+        pool->settings = *settings;
+        pool->lastFirstX = settings->width / 2;
+        pool->lastFirstY = settings->height / 2;
+        pool->boardCount = 0;
+        pool->failures = 0;
+        pool->epoch++;
+        pool->active = true;
+        pool->exhausted = false;
+        pool->waiting = false;
+        WakeAllConditionVariable(&pool->wake);
+    }
+
+    ReleaseSRWLockExclusive(&pool->lock);
+}
+
+void
+StopBoardPool(_Inout_ BoardPool* pool)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+
+    ZeroMemory(&pool->settings, sizeof(BoardSettings));
+    pool->boardCount = 0;
+    pool->failures = 0;
+    pool->epoch++;
+    pool->active = false;
+    pool->exhausted = false;
+    pool->waiting = false;
+
+    ReleaseSRWLockExclusive(&pool->lock);
+}
+
+_Success_(return) bool
+TakePooledBoard(
+    _Inout_ BoardPool* pool,
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t firstX,
+    _In_ uint32_t firstY,
+    _Out_writes_(settings->width* settings->height) bool* layout)
+{
+    uint32_t symmetries = settings->width == settings->height ? 8 : 4;
+    bool found = false;
+
+    AcquireSRWLockExclusive(&pool->lock);
+
+    if (pool->active && IsSameSettings(&pool->settings, settings))
+    {
+        // Oldest boards first, so none of them sits in the pool for long.
+        for (uint32_t i = 0; i < pool->boardCount && !found; i++)
+        {
+            PooledBoard* board = pool->boards[i];
+
+            for (uint32_t symmetry = 0; symmetry < symmetries && !found; symmetry++)
+            {
+                if (!board->startable[TransformCell(settings, symmetry, firstX, firstY)])
+                    continue;
+
+                for (uint32_t y = 0; y < settings->height; y++)
+                {
+                    for (uint32_t x = 0; x < settings->width; x++)
+                        layout[y * settings->width + x] = board->mines[TransformCell(settings, symmetry, x, y)];
+                }
+
+                MoveMemory(&pool->boards[i], &pool->boards[i + 1], sizeof(PooledBoard*) * (pool->boardCount - i - 1));
+                pool->boards[--pool->boardCount] = board;
+                found = true;
+            }
+        }
+    }
+
+    if (pool->active && IsSameSettings(&pool->settings, settings))
+    {
+        pool->lastFirstX = firstX;
+        pool->lastFirstY = firstY;
+        pool->waiting = !found;
+
+        // A full pool that could not serve this click makes room for a board started closer to where the player
+        // clicks.
+        if (!found && pool->boardCount == BOARD_POOL_CAPACITY)
+        {
+            PooledBoard* oldest = pool->boards[0];
+
+            MoveMemory(&pool->boards[0], &pool->boards[1], sizeof(PooledBoard*) * (BOARD_POOL_CAPACITY - 1));
+            pool->boards[--pool->boardCount] = oldest;
+            pool->stats.discarded++;
+        }
+
+        WakeConditionVariable(&pool->wake);
+    }
+
+    if (found)
+        pool->stats.hits++;
+    else
+        pool->stats.misses++;
+
+    ReleaseSRWLockExclusive(&pool->lock);
+
+    return found;
+}
+
+void
+GetBoardPoolStats(_Inout_ BoardPool* pool, _Out_ BoardPoolStats* stats)
+{
+    AcquireSRWLockExclusive(&pool->lock);
+
+    *stats = pool->stats;
+    stats->available = pool->boardCount;
+    stats->exhausted = pool->exhausted;
+
+    ReleaseSRWLockExclusive(&pool->lock);
+}
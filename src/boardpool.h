@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define BOARD_POOL_CAPACITY 16
+#define BOARD_POOL_MAX_THREADS 4
+
+// Boards that fail to generate in a row before the workers wait BOARD_POOL_BACKOFF_MS, doubling each time, and the
+// count after which they give up on the settings until they change.
+#define BOARD_POOL_BACKOFF_MS 50
+#define BOARD_POOL_MAX_FAILURES 8
+
+// Only no-guess boards are pooled. Ordinary games are cheap to place on the first click and keep their seeded mines,
+// which their replays and stats records rebuild the board from.
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+} BoardSettings;
+
+// startable marks every cell whose first click plays out the same way as the one the board was generated for, which is
+// any cell of the opening it starts from.
+typedef struct
+{
+    bool mines[MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY];
+    bool startable[MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY];
+} PooledBoard;
+
+typedef struct
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t generated;
+    uint64_t discarded;
+    uint32_t available;
+    bool exhausted;
+} BoardPoolStats;
+
+typedef struct
+{
+    SRWLOCK lock;
+    CONDITION_VARIABLE wake;
+    HANDLE threads[BOARD_POOL_MAX_THREADS];
+    uint32_t threadCount;
+    PooledBoard* boards[BOARD_POOL_CAPACITY];
+    uint32_t boardCount;
+    BoardSettings settings;
+    uint64_t epoch;
+    uint64_t seedBase;
+    uint64_t nextSeed;
+    uint32_t lastFirstX;
+    uint32_t lastFirstY;
+    uint32_t failures;
+    bool active;
+    bool exhausted;
+    bool waiting;
+    bool stopping;
+    BoardPoolStats stats;
+} BoardPool;
+
+bool CreateBoardPool(_Out_ BoardPool* pool, _In_ uint32_t threads);
+
+void DestroyBoardPool(_Inout_ BoardPool* pool);
+
+// Drops boards made for other settings and starts refilling in the background. Never waits on generation.
+void SetBoardPoolSettings(_Inout_ BoardPool* pool, _In_ const BoardSettings* settings);
+
+// Drops every pooled board and leaves the workers idle until settings are set again.
+void StopBoardPool(_Inout_ BoardPool* pool);
+
+// Copies out a pooled board, mirrored or rotated so that (firstX, firstY) is a valid first click. Returns false when
+// no pooled board fits; the workers then make every board for that click until one is taken.
+_Success_(return) bool TakePooledBoard(
+    _Inout_ BoardPool* pool,
+    _In_ const BoardSettings* settings,
+    _In_ uint32_t firstX,
+    _In_ uint32_t firstY,
+    _Out_writes_(settings->width* settings->height) bool* layout);
+
+void GetBoardPoolStats(_Inout_ BoardPool* pool, _Out_ BoardPoolStats* stats);
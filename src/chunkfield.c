@@ -0,0 +1,527 @@
+#include "pch.h"
+
+#include "chunkfield.h"
+#include "random.h"
+#include "revealqueue.h"
+
+#define CHUNK_SHIFT 6
+#define CHUNK_HALO_SIDE (CHUNK_SIDE + 2)
+#define CHUNK_INITIAL_DELTAS 256
+#define CHUNK_INITIAL_FLAG_SETS 16
+
+// Coordinates are shifted up by 2^30 first, like HashField's, so chunk coordinates are never negative.
+static uint64_t
+GetChunkKey(_In_ int32_t x, _In_ int32_t y, _Out_ uint32_t* local)
+{
+    uint32_t px = (uint32_t)((int64_t)x + HASH_FIELD_LIMIT + 1);
+    uint32_t py = (uint32_t)((int64_t)y + HASH_FIELD_LIMIT + 1);
+
+    *local = (py & (CHUNK_SIDE - 1)) * CHUNK_SIDE + (px & (CHUNK_SIDE - 1));
+
+    return (uint64_t)(py >> CHUNK_SHIFT) << 32 | (px >> CHUNK_SHIFT);
+}
+
+static bool
+IsInside(_In_ int32_t x, _In_ int32_t y)
+{
+    return x >= -HASH_FIELD_LIMIT && x <= HASH_FIELD_LIMIT && y >= -HASH_FIELD_LIMIT && y <= HASH_FIELD_LIMIT;
+}
+
+static bool
+IsFieldMine(_In_ const ChunkField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (field->started && x >= field->safeX - 1 && x <= field->safeX + 1 && y >= field->safeY - 1 &&
+        y <= field->safeY + 1)
+    {
+        return false;
+    }
+
+    return IsSeededMine(field->seed, field->threshold, x, y);
+}
+
+static uint32_t
+FindDeltaSlot(_In_ const ChunkField* field, _In_ uint64_t key)
+{
+    uint32_t slot = (uint32_t)mix64(key) & field->deltaIndexMask;
+
+    while (field->deltaIndex[slot] != 0 && field->deltas[field->deltaIndex[slot] - 1].key != key)
+        slot = (slot + 1) & field->deltaIndexMask;
+
+    return slot;
+}
+
+static uint32_t
+FindDelta(_In_ const ChunkField* field, _In_ uint64_t key)
+{
+    uint32_t entry = field->deltaIndex[FindDeltaSlot(field, key)];
+
+    return entry != 0 ? entry - 1 : CHUNK_NONE;
+}
+
+// The index holds delta numbers plus one, so that zero can mark an empty slot, and is kept at most half full.
+static bool
+GrowDeltaIndex(_Inout_ ChunkField* field)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t capacity = (field->deltaIndexMask + 1) * 2;
+    uint32_t* index = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint32_t) * capacity);
+
+    if (index == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    HeapFree(hHeap, 0, field->deltaIndex);
+    field->deltaIndex = index;
+    field->deltaIndexMask = capacity - 1;
+
+    for (uint32_t i = 0; i < field->deltaCount; i++)
+        index[FindDeltaSlot(field, field->deltas[i].key)] = i + 1;
+
+    return true;
+}
+
+static uint32_t
+CreateDelta(_Inout_ ChunkField* field, _In_ uint64_t key)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    if (field->deltaCount == field->deltaCapacity)
+    {
+        uint32_t capacity = field->deltaCapacity * 2;
+        ChunkDelta* deltas = HeapReAlloc(hHeap, 0, field->deltas, sizeof(ChunkDelta) * capacity);
+
+        if (deltas == NULL)
+        {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return CHUNK_NONE;
+        }
+
+        field->deltas = deltas;
+        field->deltaCapacity = capacity;
+    }
+
+    if ((field->deltaCount + 1) * 2 > field->deltaIndexMask + 1 && !GrowDeltaIndex(field))
+        return CHUNK_NONE;
+
+    uint32_t delta = field->deltaCount++;
+
+    ZeroMemory(&field->deltas[delta], sizeof(ChunkDelta));
+    field->deltas[delta].key = key;
+    field->deltas[delta].flags = CHUNK_NONE;
+    field->deltaIndex[FindDeltaSlot(field, key)] = delta + 1;
+
+    return delta;
+}
+
+static void
+BuildChunk(_Inout_ ChunkField* field, _Inout_ Chunk* chunk, _In_ uint64_t key)
+{
+    uint8_t mines[CHUNK_HALO_SIDE * CHUNK_HALO_SIDE];
+    int32_t left = (int32_t)((int64_t)(uint32_t)key * CHUNK_SIDE - HASH_FIELD_LIMIT - 1);
+    int32_t top = (int32_t)((int64_t)(key >> 32) * CHUNK_SIDE - HASH_FIELD_LIMIT - 1);
+
+    for (int32_t y = 0; y < CHUNK_HALO_SIDE; y++)
+    {
+        for (int32_t x = 0; x < CHUNK_HALO_SIDE; x++)
+            mines[y * CHUNK_HALO_SIDE + x] = IsFieldMine(field, left + x - 1, top + y - 1);
+    }
+
+    for (uint32_t y = 0; y < CHUNK_SIDE; y++)
+    {
+        for (uint32_t x = 0; x < CHUNK_SIDE; x++)
+        {
+            const uint8_t* above = &mines[y * CHUNK_HALO_SIDE + x];
+            const uint8_t* row = above + CHUNK_HALO_SIDE;
+            const uint8_t* below = row + CHUNK_HALO_SIDE;
+            uint8_t count = above[0] + above[1] + above[2] + row[0] + row[2] + below[0] + below[1] + below[2];
+
+            chunk->cells[y * CHUNK_SIDE + x] = (row[1] ? CHUNK_CELL_MINE : 0) | count;
+        }
+    }
+
+    chunk->key = key;
+    chunk->delta = FindDelta(field, key);
+    field->builtChunks++;
+}
+
+static void
+UnlinkChunk(_Inout_ ChunkField* field, _In_ uint32_t index)
+{
+    Chunk* chunk = &field->chunks[index];
+
+    if (chunk->newer != CHUNK_NONE)
+        field->chunks[chunk->newer].older = chunk->older;
+    else
+        field->newest = chunk->older;
+
+    if (chunk->older != CHUNK_NONE)
+        field->chunks[chunk->older].newer = chunk->newer;
+    else
+        field->oldest = chunk->newer;
+}
+
+static void
+LinkNewestChunk(_Inout_ ChunkField* field, _In_ uint32_t index)
+{
+    Chunk* chunk = &field->chunks[index];
+
+    chunk->older = field->newest;
+    chunk->newer = CHUNK_NONE;
+
+    if (field->newest != CHUNK_NONE)
+        field->chunks[field->newest].newer = index;
+    else
+        field->oldest = index;
+
+    field->newest = index;
+}
+
+static void
+RemoveFromBucket(_Inout_ ChunkField* field, _In_ uint32_t index)
+{
+    uint32_t* link = &field->buckets[(uint32_t)mix64(field->chunks[index].key) & field->bucketMask];
+
+    while (*link != index)
+        link = &field->chunks[*link].bucketNext;
+
+    *link = field->chunks[index].bucketNext;
+}
+
+// Consecutive lookups mostly stay in one chunk, which is then already the newest and costs a single compare.
+static Chunk*
+LoadChunk(_Inout_ ChunkField* field, _In_ uint64_t key)
+{
+    if (field->newest != CHUNK_NONE && field->chunks[field->newest].key == key)
+        return &field->chunks[field->newest];
+
+    uint32_t* bucket = &field->buckets[(uint32_t)mix64(key) & field->bucketMask];
+
+    for (uint32_t index = *bucket; index != CHUNK_NONE; index = field->chunks[index].bucketNext)
+    {
+        if (field->chunks[index].key == key)
+        {
+            UnlinkChunk(field, index);
+            LinkNewestChunk(field, index);
+            return &field->chunks[index];
+        }
+    }
+
+    uint32_t index;
+
+    if (field->chunkCount < field->chunkCapacity)
+    {
+        index = field->chunkCount++;
+    }
+    else
+    {
+        index = field->oldest;
+        UnlinkChunk(field, index);
+        RemoveFromBucket(field, index);
+        field->evictedChunks++;
+    }
+
+    BuildChunk(field, &field->chunks[index], key);
+    field->chunks[index].bucketNext = *bucket;
+    *bucket = index;
+    LinkNewestChunk(field, index);
+
+    return &field->chunks[index];
+}
+
+static void
+DropChunks(_Inout_ ChunkField* field)
+{
+    FillMemory(field->buckets, sizeof(uint32_t) * (field->bucketMask + 1), 0xFF);
+    field->chunkCount = 0;
+    field->newest = CHUNK_NONE;
+    field->oldest = CHUNK_NONE;
+}
+
+static uint8_t
+GetDeltaState(_In_ const ChunkField* field, _In_ uint32_t delta, _In_ uint32_t local)
+{
+    if (delta == CHUNK_NONE)
+        return 0;
+
+    uint64_t bit = 1ull << (local % 64);
+    const ChunkDelta* changes = &field->deltas[delta];
+
+    if (changes->revealed[local / 64] & bit)
+        return CHUNK_CELL_REVEALED;
+
+    if (changes->flags != CHUNK_NONE && (field->flagWords[changes->flags * CHUNK_WORDS + local / 64] & bit))
+        return CHUNK_CELL_FLAGGED;
+
+    return 0;
+}
+
+static bool
+MarkRevealed(_Inout_ ChunkField* field, _Inout_ Chunk* chunk, _In_ uint32_t local)
+{
+    if (chunk->delta == CHUNK_NONE)
+    {
+        chunk->delta = CreateDelta(field, chunk->key);
+
+        if (chunk->delta == CHUNK_NONE)
+            return false;
+    }
+
+    field->deltas[chunk->delta].revealed[local / 64] |= 1ull << (local % 64);
+
+    return true;
+}
+
+static uint64_t
+PackPosition(_In_ int32_t x, _In_ int32_t y)
+{
+    return (uint64_t)(uint32_t)y << 32 | (uint32_t)x;
+}
+
+bool
+CreateChunkField(
+    _Out_ ChunkField* field,
+    _In_ uint64_t seed,
+    _In_ double density,
+    _In_ uint32_t residentChunks)
+{
+    ZeroMemory(field, sizeof(ChunkField));
+
+    if (!(density >= HASH_FIELD_MIN_DENSITY && density < 1.0) || residentChunks == 0 || residentChunks > (1u << 24))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t buckets = 1;
+
+    while (buckets < residentChunks * 2)
+        buckets *= 2;
+
+    field->seed = seed;
+    field->threshold = GetMineThreshold(density);
+    field->chunkCapacity = residentChunks;
+    field->bucketMask = buckets - 1;
+    field->deltaCapacity = CHUNK_INITIAL_DELTAS;
+    field->deltaIndexMask = CHUNK_INITIAL_DELTAS * 2 - 1;
+    field->chunks = HeapAlloc(hHeap, 0, sizeof(Chunk) * residentChunks);
+    field->buckets = HeapAlloc(hHeap, 0, sizeof(uint32_t) * buckets);
+    field->deltas = HeapAlloc(hHeap, 0, sizeof(ChunkDelta) * field->deltaCapacity);
+    field->deltaIndex = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint32_t) * (field->deltaIndexMask + 1));
+
+    if (field->chunks == NULL || field->buckets == NULL || field->deltas == NULL || field->deltaIndex == NULL)
+    {
+        DestroyChunkField(field);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    DropChunks(field);
+
+    return true;
+}
+
+void
+DestroyChunkField(_Inout_ ChunkField* field)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, field->chunks);
+    HeapFree(hHeap, 0, field->buckets);
+    HeapFree(hHeap, 0, field->deltas);
+    HeapFree(hHeap, 0, field->deltaIndex);
+    HeapFree(hHeap, 0, field->flagWords);
+    HeapFree(hHeap, 0, field->queue);
+
+    ZeroMemory(field, sizeof(ChunkField));
+}
+
+uint8_t
+GetChunkCell(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    uint32_t local;
+
+    if (!IsInside(x, y))
+        return 0;
+
+    uint64_t key = GetChunkKey(x, y, &local);
+
+    return LoadChunk(field, key)->cells[local];
+}
+
+uint8_t
+GetChunkCellState(_In_ const ChunkField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    uint32_t local;
+
+    if (!IsInside(x, y))
+        return 0;
+
+    uint64_t key = GetChunkKey(x, y, &local);
+
+    return GetDeltaState(field, FindDelta(field, key), local);
+}
+
+bool
+RevealChunkCell(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (!IsInside(x, y) || field->exploded)
+        return true;
+
+    // Chunks built before the safe zone existed may hold mines inside it.
+    if (!field->started)
+    {
+        field->started = true;
+        field->safeX = x;
+        field->safeY = y;
+        DropChunks(field);
+    }
+
+    uint32_t local;
+    uint64_t key = GetChunkKey(x, y, &local);
+    Chunk* chunk = LoadChunk(field, key);
+
+    if (GetDeltaState(field, chunk->delta, local) != 0)
+        return true;
+
+    if (!MarkRevealed(field, chunk, local))
+        return false;
+
+    if (chunk->cells[local] & CHUNK_CELL_MINE)
+    {
+        field->exploded = true;
+        return true;
+    }
+
+    field->revealedCells++;
+
+    if ((chunk->cells[local] & CHUNK_CELL_COUNT_MASK) != 0)
+        return true;
+
+    uint32_t head = 0;
+    uint32_t count = 0;
+
+    if (field->queueCapacity == 0 && !GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+        return false;
+
+    field->queue[count++] = PackPosition(x, y);
+
+    while (count > 0)
+    {
+        int32_t cx = (int32_t)(uint32_t)field->queue[head];
+        int32_t cy = (int32_t)(uint32_t)(field->queue[head] >> 32);
+
+        head = (head + 1) & (field->queueCapacity - 1);
+        count--;
+
+        for (int32_t ny = cy - 1; ny <= cy + 1; ny++)
+        {
+            for (int32_t nx = cx - 1; nx <= cx + 1; nx++)
+            {
+                if (!IsInside(nx, ny))
+                    continue;
+
+                // Neighbours of a zero cell are never mines, and the chunk lookup crosses chunk edges by itself.
+                key = GetChunkKey(nx, ny, &local);
+                chunk = LoadChunk(field, key);
+
+                if (GetDeltaState(field, chunk->delta, local) != 0)
+                    continue;
+
+                if (!MarkRevealed(field, chunk, local))
+                    return false;
+
+                field->revealedCells++;
+
+                if ((chunk->cells[local] & CHUNK_CELL_COUNT_MASK) != 0)
+                    continue;
+
+                if (count == field->queueCapacity)
+                {
+                    if (!GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+                        return false;
+
+                    head = 0;
+                }
+
+                field->queue[(head + count) & (field->queueCapacity - 1)] = PackPosition(nx, ny);
+                count++;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool
+ToggleChunkFlag(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (!IsInside(x, y) || field->exploded)
+        return true;
+
+    uint32_t local;
+    uint64_t key = GetChunkKey(x, y, &local);
+    uint32_t delta = FindDelta(field, key);
+
+    if (delta == CHUNK_NONE)
+    {
+        delta = CreateDelta(field, key);
+
+        if (delta == CHUNK_NONE)
+            return false;
+
+        // A resident chunk must see the delta it now has.
+        for (uint32_t index = field->buckets[(uint32_t)mix64(key) & field->bucketMask]; index != CHUNK_NONE;
+             index = field->chunks[index].bucketNext)
+        {
+            if (field->chunks[index].key == key)
+                field->chunks[index].delta = delta;
+        }
+    }
+
+    ChunkDelta* changes = &field->deltas[delta];
+    uint64_t bit = 1ull << (local % 64);
+
+    if (changes->revealed[local / 64] & bit)
+        return true;
+
+    if (changes->flags == CHUNK_NONE)
+    {
+        if (field->flagSetCount == field->flagSetCapacity)
+        {
+            HANDLE hHeap = GetProcessHeap();
+            uint32_t capacity = field->flagSetCapacity > 0 ? field->flagSetCapacity * 2 : CHUNK_INITIAL_FLAG_SETS;
+            SIZE_T bytes = sizeof(uint64_t) * CHUNK_WORDS * capacity;
+            uint64_t* words = field->flagWords != NULL ? HeapReAlloc(hHeap, 0, field->flagWords, bytes)
+                                                       : HeapAlloc(hHeap, 0, bytes);
+
+            if (words == NULL)
+            {
+                SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+                return false;
+            }
+
+            field->flagWords = words;
+            field->flagSetCapacity = capacity;
+        }
+
+        changes->flags = field->flagSetCount++;
+        ZeroMemory(&field->flagWords[changes->flags * CHUNK_WORDS], sizeof(uint64_t) * CHUNK_WORDS);
+    }
+
+    field->flagWords[changes->flags * CHUNK_WORDS + local / 64] ^= bit;
+
+    return true;
+}
+
+uint64_t
+GetChunkFieldMemory(_In_ const ChunkField* field)
+{
+    return sizeof(ChunkField) + sizeof(Chunk) * (uint64_t)field->chunkCapacity +
+           sizeof(uint32_t) * ((uint64_t)field->bucketMask + 1) + sizeof(ChunkDelta) * (uint64_t)field->deltaCapacity +
+           sizeof(uint32_t) * ((uint64_t)field->deltaIndexMask + 1) +
+           sizeof(uint64_t) * CHUNK_WORDS * (uint64_t)field->flagSetCapacity +
+           sizeof(uint64_t) * (uint64_t)field->queueCapacity;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hashfield.h"
+
+#define CHUNK_SIDE 64
+#define CHUNK_CELLS (CHUNK_SIDE * CHUNK_SIDE)
+#define CHUNK_WORDS (CHUNK_CELLS / 64)
+
+#define CHUNK_CELL_COUNT_MASK 0x0F
+#define CHUNK_CELL_MINE 0x10
+
+#define CHUNK_CELL_REVEALED HASH_CELL_REVEALED
+#define CHUNK_CELL_FLAGGED HASH_CELL_FLAGGED
+
+#define CHUNK_NONE UINT32_MAX
+
+// The mines and counts of one 64x64 chunk, worked out from the seed. Nothing in it is ever changed by play, so a
+// chunk that has not been used for a while can be dropped and built again when it is next needed.
+typedef struct
+{
+    uint64_t key;
+    uint32_t bucketNext;
+    uint32_t older;
+    uint32_t newer;
+    uint32_t delta;
+    uint8_t cells[CHUNK_CELLS];
+} Chunk;
+
+// What the player has changed in one chunk, one bit per cell. Kept for every chunk ever revealed or flagged in. Few
+// chunks are ever flagged in, so their flag bits are kept apart and only allocated on the first flag.
+typedef struct
+{
+    uint64_t key;
+    uint32_t flags;
+    uint64_t revealed[CHUNK_WORDS];
+} ChunkDelta;
+
+// An unbounded board over the same hashed mines as HashField, with at most a fixed number of chunks resident. The
+// chunks form a hash map of bucket chains and a least-recently-used list, and the oldest is rebuilt in place when a
+// new one is needed. Player changes live apart from the chunks, in an array of deltas found through an open-addressed
+// index, so dropping a chunk never loses anything.
+typedef struct
+{
+    uint64_t seed;
+    uint64_t threshold;
+    bool started;
+    int32_t safeX;
+    int32_t safeY;
+    Chunk* chunks;
+    uint32_t chunkCapacity;
+    uint32_t chunkCount;
+    uint32_t* buckets;
+    uint32_t bucketMask;
+    uint32_t newest;
+    uint32_t oldest;
+    ChunkDelta* deltas;
+    uint32_t deltaCount;
+    uint32_t deltaCapacity;
+    uint32_t* deltaIndex;
+    uint32_t deltaIndexMask;
+    uint64_t* flagWords;
+    uint32_t flagSetCount;
+    uint32_t flagSetCapacity;
+    uint64_t revealedCells;
+    bool exploded;
+    uint64_t builtChunks;
+    uint64_t evictedChunks;
+    uint64_t* queue;
+    uint32_t queueCapacity;
+} ChunkField;
+
+bool CreateChunkField(
+    _Out_ ChunkField* field,
+    _In_ uint64_t seed,
+    _In_ double density,
+    _In_ uint32_t residentChunks);
+
+void DestroyChunkField(_Inout_ ChunkField* field);
+
+// The cell's mine bit and neighbour count, building its chunk if it is not resident.
+uint8_t GetChunkCell(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y);
+
+uint8_t GetChunkCellState(_In_ const ChunkField* field, _In_ int32_t x, _In_ int32_t y);
+
+// Both fail only when the delta store cannot grow.
+bool RevealChunkCell(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y);
+
+bool ToggleChunkFlag(_Inout_ ChunkField* field, _In_ int32_t x, _In_ int32_t y);
+
+uint64_t GetChunkFieldMemory(_In_ const ChunkField* field);
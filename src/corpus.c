@@ -0,0 +1,260 @@
+#include "pch.h"
+
+#include "corpus.h"
+#include "littleendian.h"
+
+#define CORPUS_MAGIC 0x4352534Du
+#define CORPUS_VERSION 1
+#define CORPUS_INITIAL_CAPACITY 1024
+
+static const uint8_t padding[8] = {0};
+
+static bool
+FlushCorpusWriter(_Inout_ CorpusWriter* writer)
+{
+    DWORD written = 0;
+    bool success = writer->buffered == 0 ||
+                   (WriteFile(writer->hFile, writer->buffer, writer->buffered, &written, NULL) &&
+                    written == writer->buffered);
+
+    writer->buffered = 0;
+
+    return success;
+}
+
+static bool
+WriteCorpusBytes(_Inout_ CorpusWriter* writer, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    while (size > 0)
+    {
+        if (writer->buffered == CORPUS_WRITE_BUFFER_SIZE && !FlushCorpusWriter(writer))
+            return false;
+
+        uint32_t chunk = min(size, CORPUS_WRITE_BUFFER_SIZE - writer->buffered);
+
+        CopyMemory(writer->buffer + writer->buffered, bytes, chunk);
+        writer->buffered += chunk;
+        writer->offset += chunk;
+        bytes += chunk;
+        size -= chunk;
+    }
+
+    return true;
+}
+
+bool
+CreateCorpusWriter(_Out_ CorpusWriter* writer, _In_z_ const char* path)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    ZeroMemory(writer, sizeof(CorpusWriter));
+    writer->hFile = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (writer->hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    writer->buffer = HeapAlloc(hHeap, 0, CORPUS_WRITE_BUFFER_SIZE);
+    writer->index = HeapAlloc(hHeap, 0, (SIZE_T)CORPUS_INITIAL_CAPACITY * CORPUS_INDEX_ENTRY_SIZE);
+    writer->capacity = CORPUS_INITIAL_CAPACITY;
+
+    if (writer->buffer == NULL || writer->index == NULL)
+    {
+        CloseCorpusWriter(writer);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    // The header is rewritten once the index is in place.
+    uint8_t header[CORPUS_HEADER_SIZE] = {0};
+
+    return WriteCorpusBytes(writer, header, sizeof(header));
+}
+
+bool
+AppendCorpusReplay(_Inout_ CorpusWriter* writer, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    if (writer->count == writer->capacity)
+    {
+        uint64_t capacity = writer->capacity * 2;
+        uint8_t* index = HeapReAlloc(
+            GetProcessHeap(), 0, writer->index, (SIZE_T)(capacity * CORPUS_INDEX_ENTRY_SIZE));
+
+        if (index == NULL)
+        {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return false;
+        }
+
+        writer->index = index;
+        writer->capacity = capacity;
+    }
+
+    uint8_t* entry = writer->index + writer->count * CORPUS_INDEX_ENTRY_SIZE;
+
+    PutLittleEndian(entry, writer->offset, 8);
+    PutLittleEndian(entry + 8, size, 4);
+    PutLittleEndian(entry + 12, 0, 4);
+
+    if (!WriteCorpusBytes(writer, bytes, size))
+        return false;
+
+    writer->count++;
+
+    return true;
+}
+
+bool
+CloseCorpusWriter(_Inout_ CorpusWriter* writer)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint64_t indexOffset = (writer->offset + 7) & ~(uint64_t)7;
+    bool success = writer->hFile != INVALID_HANDLE_VALUE && writer->buffer != NULL && writer->index != NULL;
+
+    if (success)
+    {
+        uint8_t header[CORPUS_HEADER_SIZE] = {0};
+        LARGE_INTEGER start = {0};
+        DWORD written = 0;
+
+        PutLittleEndian(header, CORPUS_MAGIC, 4);
+        PutLittleEndian(header + 4, CORPUS_VERSION, 2);
+        PutLittleEndian(header + 8, writer->count, 8);
+        PutLittleEndian(header + 16, indexOffset, 8);
+
+        success = WriteCorpusBytes(writer, padding, (uint32_t)(indexOffset - writer->offset));
+
+        for (uint64_t i = 0; success && i < writer->count; i++)
+            success = WriteCorpusBytes(writer, writer->index + i * CORPUS_INDEX_ENTRY_SIZE, CORPUS_INDEX_ENTRY_SIZE);
+
+        success = success && FlushCorpusWriter(writer) && SetFilePointerEx(writer->hFile, start, NULL, FILE_BEGIN) &&
+                  WriteFile(writer->hFile, header, sizeof(header), &written, NULL) && written == sizeof(header);
+    }
+
+    if (writer->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(writer->hFile);
+
+    HeapFree(hHeap, 0, writer->buffer);
+    HeapFree(hHeap, 0, writer->index);
+    ZeroMemory(writer, sizeof(CorpusWriter));
+    writer->hFile = INVALID_HANDLE_VALUE;
+
+    return success;
+}
+
+bool
+ViewReplayCorpus(_Out_ ReplayCorpus* corpus, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint64_t size)
+{
+    ZeroMemory(corpus, sizeof(ReplayCorpus));
+    corpus->hFile = INVALID_HANDLE_VALUE;
+
+    if (size < CORPUS_HEADER_SIZE || GetLittleEndian(bytes, 4) != CORPUS_MAGIC ||
+        GetLittleEndian(bytes + 4, 2) != CORPUS_VERSION)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    uint64_t count = GetLittleEndian(bytes + 8, 8);
+    uint64_t indexOffset = GetLittleEndian(bytes + 16, 8);
+
+    if (indexOffset < CORPUS_HEADER_SIZE || indexOffset > size ||
+        count != (size - indexOffset) / CORPUS_INDEX_ENTRY_SIZE ||
+        (size - indexOffset) % CORPUS_INDEX_ENTRY_SIZE != 0)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    corpus->base = bytes;
+    corpus->size = size;
+    corpus->count = count;
+    corpus->indexOffset = indexOffset;
+
+    return true;
+}
+
+bool
+OpenReplayCorpus(_Out_ ReplayCorpus* corpus, _In_z_ const char* path)
+{
+    LARGE_INTEGER size;
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    ZeroMemory(corpus, sizeof(ReplayCorpus));
+    corpus->hFile = INVALID_HANDLE_VALUE;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart < CORPUS_HEADER_SIZE)
+    {
+        CloseHandle(hFile);
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    const uint8_t* base = hMapping != NULL ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    if (base == NULL || !ViewReplayCorpus(corpus, base, (uint64_t)size.QuadPart))
+    {
+        DWORD error = GetLastError();
+
+        if (base != NULL)
+            UnmapViewOfFile(base);
+
+        if (hMapping != NULL)
+            CloseHandle(hMapping);
+
+        CloseHandle(hFile);
+        SetLastError(error);
+
+        return false;
+    }
+
+    corpus->hFile = hFile;
+    corpus->hMapping = hMapping;
+
+    return true;
+}
+
+void
+CloseReplayCorpus(_Inout_ ReplayCorpus* corpus)
+{
+    if (corpus->hMapping != NULL)
+    {
+        UnmapViewOfFile(corpus->base);
+        CloseHandle(corpus->hMapping);
+    }
+
+    if (corpus->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(corpus->hFile);
+
+    ZeroMemory(corpus, sizeof(ReplayCorpus));
+    corpus->hFile = INVALID_HANDLE_VALUE;
+}
+
+_Success_(return) bool
+GetCorpusReplay(
+    _In_ const ReplayCorpus* corpus,
+    _In_ uint64_t index,
+    _Outptr_ const uint8_t** bytes,
+    _Out_ uint32_t* size)
+{
+    *bytes = NULL;
+    *size = 0;
+
+    if (index >= corpus->count)
+        return false;
+
+    const uint8_t* entry = corpus->base + corpus->indexOffset + index * CORPUS_INDEX_ENTRY_SIZE;
+    uint64_t offset = GetLittleEndian(entry, 8);
+
+    *size = (uint32_t)GetLittleEndian(entry + 8, 4);
+
+    if (offset < CORPUS_HEADER_SIZE || offset > corpus->indexOffset || *size > corpus->indexOffset - offset)
+        return false;
+
+    *bytes = corpus->base + offset;
+
+    return true;
+}
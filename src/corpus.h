@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CORPUS_HEADER_SIZE 32
+#define CORPUS_INDEX_ENTRY_SIZE 16
+#define CORPUS_WRITE_BUFFER_SIZE (1 << 20)
+
+// A replay corpus packs replay files back to back behind a 32-byte header, followed by an index with the offset and
+// size of each one. The index comes last so a corpus is written in one pass, and it starts on an 8-byte boundary.
+// A corpus is read through a mapped view and its replays are parsed where they lie.
+typedef struct
+{
+    const uint8_t* base;
+    uint64_t size;
+    uint64_t count;
+    uint64_t indexOffset;
+    HANDLE hFile;
+    HANDLE hMapping;
+} ReplayCorpus;
+
+typedef struct
+{
+    HANDLE hFile;
+    uint8_t* buffer;
+    uint32_t buffered;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t capacity;
+    uint8_t* index;
+} CorpusWriter;
+
+bool CreateCorpusWriter(_Out_ CorpusWriter* writer, _In_z_ const char* path);
+
+bool AppendCorpusReplay(_Inout_ CorpusWriter* writer, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size);
+
+// Writes the index and header and closes the file; the writer is released even when this fails.
+bool CloseCorpusWriter(_Inout_ CorpusWriter* writer);
+
+bool OpenReplayCorpus(_Out_ ReplayCorpus* corpus, _In_z_ const char* path);
+
+// Reads a corpus already in memory; CloseReplayCorpus leaves the bytes alone.
+bool ViewReplayCorpus(_Out_ ReplayCorpus* corpus, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint64_t size);
+
+void CloseReplayCorpus(_Inout_ ReplayCorpus* corpus);
+
+_Success_(return) bool GetCorpusReplay(
+    _In_ const ReplayCorpus* corpus,
+    _In_ uint64_t index,
+    _Outptr_ const uint8_t** bytes,
+    _Out_ uint32_t* size);
@@ -0,0 +1,191 @@
+#include "pch.h"
+
+#include "corpusstats.h"
+#include "metrics.h"
+#include "parallel.h"
+#include "replay.h"
+
+typedef struct
+{
+    const ReplayCorpus* corpus;
+    CorpusStats* workerStats;
+    volatile LONG64 nextReplay;
+} CorpusScan;
+
+static void
+ScoreWonGame(
+    _Inout_ MetricsWorkspace* workspace,
+    _Inout_updates_(MAX_CELLS_HORIZONTALLY* MAX_CELLS_VERTICALLY) bool* mines,
+    _In_ const ReplayOutcome* outcome,
+    _In_ const ReplayFileView* view,
+    _Inout_ DifficultyStats* stats)
+{
+    uint32_t cellCount = outcome->width * outcome->height;
+    BoardMetrics metrics;
+
+    if (view->layout != NULL)
+    {
+        for (uint32_t i = 0; i < cellCount; i++)
+            mines[i] = (view->layout[i / 8] >> (i % 8) & 1) != 0;
+    }
+    else
+    {
+        PlaceSeededMines(
+            outcome->width,
+            outcome->height,
+            outcome->totalMines,
+            view->seed,
+            view->firstClick % outcome->width,
+            view->firstClick / outcome->width,
+            mines);
+    }
+
+    ComputeBoardMetrics(workspace, outcome->width, outcome->height, mines, false, &metrics);
+
+    stats->bbbv += metrics.bbbv;
+    stats->clicks += view->eventCount;
+    stats->efficiency += (double)metrics.bbbv / (double)max(view->eventCount, 1);
+    AddQuantileSketchValue(&stats->times, outcome->duration / 1000.0);
+
+    if (outcome->duration > 0)
+    {
+        double bbbvPerSecond = metrics.bbbv * 1000.0 / (double)outcome->duration;
+
+        stats->timedWins++;
+        stats->bbbvPerSecond += bbbvPerSecond;
+        AddQuantileSketchValue(&stats->bbbvRates, bbbvPerSecond);
+    }
+}
+
+static void
+ScanReplays(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    CorpusScan* scan = (CorpusScan*)context;
+    CorpusStats* stats = &scan->workerStats[index];
+    bool* mines = HeapAlloc(GetProcessHeap(), 0, sizeof(bool) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+    MetricsWorkspace workspace;
+
+    if (mines != NULL && CreateMetricsWorkspace(&workspace, MAX_CELLS_HORIZONTALLY, MAX_CELLS_VERTICALLY))
+    {
+        for (;;)
+        {
+            uint64_t first = (uint64_t)InterlockedExchangeAdd64(&scan->nextReplay, CORPUS_BATCH_REPLAYS);
+
+            if (first >= scan->corpus->count)
+                break;
+
+            uint64_t last = min(first + CORPUS_BATCH_REPLAYS, scan->corpus->count);
+
+            for (uint64_t replay = first; replay < last; replay++)
+            {
+                const uint8_t* bytes;
+                uint32_t size;
+                ReplayOutcome outcome;
+                ReplayFileView view;
+
+                stats->replays++;
+
+                if (!GetCorpusReplay(scan->corpus, replay, &bytes, &size) ||
+                    !ViewReplayFile(bytes, size, &outcome, &view))
+                {
+                    stats->invalid++;
+                    continue;
+                }
+
+                DifficultyStats* difficulty = &stats->difficulties[outcome.difficulty];
+
+                difficulty->games++;
+
+                if (outcome.state == GAME_WON)
+                {
+                    difficulty->wins++;
+                    ScoreWonGame(&workspace, mines, &outcome, &view, difficulty);
+                }
+                else if (outcome.state == GAME_LOST)
+                {
+                    difficulty->losses++;
+                }
+                else
+                {
+                    difficulty->unfinished++;
+                }
+            }
+        }
+
+        DestroyMetricsWorkspace(&workspace);
+    }
+
+    HeapFree(GetProcessHeap(), 0, mines);
+}
+
+static void
+MergeDifficultyStats(_Inout_ DifficultyStats* total, _In_ const DifficultyStats* part)
+{
+    total->games += part->games;
+    total->wins += part->wins;
+    total->losses += part->losses;
+    total->unfinished += part->unfinished;
+    total->timedWins += part->timedWins;
+    total->bbbv += part->bbbv;
+    total->clicks += part->clicks;
+    total->bbbvPerSecond += part->bbbvPerSecond;
+    total->efficiency += part->efficiency;
+
+    MergeQuantileSketch(&total->times, &part->times);
+    MergeQuantileSketch(&total->bbbvRates, &part->bbbvRates);
+}
+
+bool
+AnalyzeReplayCorpus(_In_ const ReplayCorpus* corpus, _In_ uint32_t threads, _Out_ CorpusStats* stats)
+{
+    ZeroMemory(stats, sizeof(CorpusStats));
+
+    if (threads == 0)
+        threads = GetParallelThreadCount();
+
+    threads = min(threads, (uint32_t)PARALLEL_MAX_THREADS);
+
+    HANDLE hHeap = GetProcessHeap();
+    CorpusScan scan = {
+        .corpus = corpus,
+        .workerStats = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(CorpusStats) * threads),
+    };
+
+    if (scan.workerStats == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    LARGE_INTEGER frequency, start, end;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    ParallelFor(threads, threads, ScanReplays, &scan);
+    QueryPerformanceCounter(&end);
+
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        const CorpusStats* part = &scan.workerStats[t];
+
+        for (uint32_t d = 0; d <= DIFFICULTY_CUSTOM; d++)
+            MergeDifficultyStats(&stats->difficulties[d], &part->difficulties[d]);
+
+        stats->replays += part->replays;
+        stats->invalid += part->invalid;
+    }
+
+    stats->seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+    stats->threads = threads;
+
+    HeapFree(hHeap, 0, scan.workerStats);
+
+    // A worker that could not allocate its scratch space leaves replays unscanned.
+    if (stats->replays != corpus->count)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    return true;
+}
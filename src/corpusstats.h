@@ -0,0 +1,42 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "corpus.h"
+#include "game.h"
+#include "quantilesketch.h"
+
+#define CORPUS_BATCH_REPLAYS 1024
+
+// Totals for one difficulty. 3BV, clicks, efficiency (3BV per click) and times cover won games only, and 3BV/s only
+// the won games that took at least a millisecond. Won times, in seconds, and 3BV/s go into quantile sketches that each
+// worker thread keeps and the scan merges at the end.
+typedef struct
+{
+    uint64_t games;
+    uint64_t wins;
+    uint64_t losses;
+    uint64_t unfinished;
+    uint64_t timedWins;
+    uint64_t bbbv;
+    uint64_t clicks;
+    double bbbvPerSecond;
+    double efficiency;
+    QuantileSketch times;
+    QuantileSketch bbbvRates;
+} DifficultyStats;
+
+typedef struct
+{
+    DifficultyStats difficulties[DIFFICULTY_CUSTOM + 1];
+    uint64_t replays;
+    uint64_t invalid;
+    double seconds;
+    uint32_t threads;
+} CorpusStats;
+
+// Scans every replay in place, in batches taken by worker threads; a thread count of zero uses every core.
+bool AnalyzeReplayCorpus(_In_ const ReplayCorpus* corpus, _In_ uint32_t threads, _Out_ CorpusStats* stats);
@@ -1,9 +1,11 @@
 #include "pch.h"
 
 #include "game.h"
+#include "journal.h"
 #include "random.h"
+#include "replay.h"
 
-static void
+void
 GetDifficultySettings(_In_ Difficulty difficulty, _Out_ uint32_t* width, _Out_ uint32_t* height, _Out_ uint32_t* mines)
 {
     switch (difficulty)
@@ -36,6 +38,30 @@ GetDifficultySettings(_In_ Difficulty difficulty, _Out_ uint32_t* width, _Out_ u
     }
 }
 
+// Zobrist key of a cell's visible state. Hidden cells contribute nothing, so a fresh board hashes to its dimensions.
+static uint64_t
+GetCellHashKey(_In_ uint32_t index, _In_ const Cell* cell)
+{
+    uint64_t visible;
+
+    if (cell->state == CELL_HIDDEN)
+        return 0;
+    else if (cell->state == CELL_FLAGGED)
+        visible = 9;
+    else if (cell->hasMine)
+        visible = 10;
+    else
+        visible = cell->neighborMines;
+
+    return mix64(((uint64_t)index << 4 | visible) + 0x9E3779B97F4A7C15ull);
+}
+
+static uint64_t
+GetEmptyMinefieldHash(_In_ const Minefield* field)
+{
+    return mix64((uint64_t)field->width << 40 | (uint64_t)field->height << 20 | field->totalMines);
+}
+
 static void
 RevealConnectedCells(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
 {
@@ -49,10 +75,24 @@ RevealConnectedCells(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
 
     cell->state = CELL_REVEALED;
     field->revealedCells++;
+    field->hash ^= GetCellHashKey(y * field->width + x, cell);
+
+    if (field->journal != NULL)
+        RecordJournalCell(field->journal, y * field->width + x);
 
     if (cell->neighborMines > 0)
         return;
 
+    if (field->openings != NULL && field->openings->indexed)
+    {
+        uint32_t opening = field->openings->label[y * field->width + x] - 1u;
+
+        if (field->journal != NULL && !field->openings->opened[opening])
+            RecordJournalOpening(field->journal, opening);
+
+        field->openings->opened[opening] = true;
+    }
+
     for (int32_t dy = -1; dy <= 1; dy++)
     {
         for (int32_t dx = -1; dx <= 1; dx++)
@@ -71,38 +111,56 @@ RevealConnectedCells(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
     }
 }
 
-static void
-PlaceMines(_Inout_ Minefield* field, _In_ uint32_t excludeX, _In_ uint32_t excludeY)
+static bool
+RevealOpening(_Inout_ Minefield* field, _In_ uint32_t index)
 {
-    if (excludeX >= field->width || excludeY >= field->height)
-        return;
+    OpeningIndex* openings = field->openings;
+    const Cell* cell = &field->cells[index];
 
-    struct xorshift32_state state = {
-        .a = (uint32_t)GetTickCount64(),
-    };
+    if (openings == NULL || !openings->indexed || cell->hasMine || cell->neighborMines != 0)
+        return false;
 
-    uint32_t minesPlaced = 0;
-    uint32_t attempts = 0;
-    uint32_t maxAttempts = field->width * field->height * 10;
+    uint32_t opening = openings->label[index] - 1u;
 
-    while (minesPlaced < field->totalMines && attempts < maxAttempts)
-    {
-        uint32_t x = xorshift32(&state) % field->width;
-        uint32_t y = xorshift32(&state) % field->height;
+    if (openings->flagged[opening] != 0 || openings->opened[opening])
+        return false;
 
-        attempts++;
+    uint32_t revealed = 0;
 
-        if (x == excludeX && y == excludeY)
+    for (uint32_t i = openings->first[opening]; i < openings->first[opening + 1]; i++)
+    {
+        Cell* member = &field->cells[openings->cells[i]];
+
+        // Border numbers may already be revealed or flagged on their own.
+        if (member->state != CELL_HIDDEN)
             continue;
 
-        Cell* cell = &field->cells[y * field->width + x];
+        member->state = CELL_REVEALED;
+        field->hash ^= GetCellHashKey(openings->cells[i], member);
+        revealed++;
 
-        if (!cell->hasMine)
-        {
-            cell->hasMine = true;
-            minesPlaced++;
-        }
+        if (field->journal != NULL)
+            RecordJournalCell(field->journal, openings->cells[i]);
     }
+
+    if (field->journal != NULL)
+        RecordJournalOpening(field->journal, opening);
+
+    openings->opened[opening] = true;
+    field->revealedCells += revealed;
+
+    return true;
+}
+
+static void
+PlaceMines(_Inout_ Minefield* field, _In_ uint32_t excludeX, _In_ uint32_t excludeY)
+{
+    bool mines[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+
+    PlaceSeededMines(field->width, field->height, field->totalMines, field->seed, excludeX, excludeY, mines);
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+        field->cells[i].hasMine = mines[i];
 }
 
 static void
@@ -144,6 +202,48 @@ CalculateNeighborMines(_Inout_ Minefield* field)
     }
 }
 
+void
+PlaceSeededMines(
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t totalMines,
+    _In_ uint64_t seed,
+    _In_ uint32_t excludeX,
+    _In_ uint32_t excludeY,
+    _Out_writes_(width* height) bool* mines)
+{
+    ZeroMemory(mines, sizeof(bool) * width * height);
+
+    if (excludeX >= width || excludeY >= height)
+        return;
+
+    struct splitmix64_state state = {
+        .s = seed,
+    };
+
+    uint32_t minesPlaced = 0;
+    uint32_t attempts = 0;
+    uint32_t maxAttempts = width * height * 10;
+
+    while (minesPlaced < totalMines && attempts < maxAttempts)
+    {
+        uint64_t random = splitmix64(&state);
+        uint32_t x = (uint32_t)((random >> 32) % width);
+        uint32_t y = (uint32_t)((random & UINT32_MAX) % height);
+
+        attempts++;
+
+        if (x == excludeX && y == excludeY)
+            continue;
+
+        if (!mines[y * width + x])
+        {
+            mines[y * width + x] = true;
+            minesPlaced++;
+        }
+    }
+}
+
 bool
 CreateMinefield(_Out_ Minefield* field, _In_ Difficulty difficulty)
 {
@@ -170,6 +270,8 @@ CreateMinefield(_Out_ Minefield* field, _In_ Difficulty difficulty)
     field->revealedCells = 0;
     field->firstClick = true;
     field->startTime = 0;
+    field->seed = GetTickCount64();
+    field->hash = GetEmptyMinefieldHash(field);
 
     return true;
 }
@@ -208,44 +310,168 @@ CreateCustomMinefield(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t
     field->revealedCells = 0;
     field->firstClick = true;
     field->startTime = 0;
+    field->seed = GetTickCount64();
+    field->hash = GetEmptyMinefieldHash(field);
 
     return true;
 }
 
 bool
-RevealCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+CreateSizedMinefield(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t totalMines)
 {
-    if (x >= field->width || y >= field->height || field->state != GAME_PLAYING)
+    for (Difficulty difficulty = DIFFICULTY_BEGINNER; difficulty < DIFFICULTY_CUSTOM; difficulty++)
     {
+        uint32_t presetWidth, presetHeight, presetMines;
+
+        GetDifficultySettings(difficulty, &presetWidth, &presetHeight, &presetMines);
+
+        if (presetWidth == width && presetHeight == height && presetMines == totalMines)
+            return CreateMinefield(field, difficulty);
+    }
+
+    return CreateCustomMinefield(field, width, height, totalMines);
+}
+
+bool
+SetMinefieldLayout(_Inout_ Minefield* field, _In_reads_(field->width* field->height) const bool* mines)
+{
+    uint32_t cellCount = field->width * field->height;
+    uint32_t mineCount = 0;
+
+    if (!field->firstClick)
+    {
+        SetLastError(ERROR_INVALID_STATE);
         return false;
     }
 
-    Cell* cell = &field->cells[y * field->width + x];
+    for (uint32_t i = 0; i < cellCount; i++)
+        mineCount += mines[i] ? 1 : 0;
 
-    if (cell->state != CELL_HIDDEN)
+    if (mineCount != field->totalMines)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
         return false;
+    }
 
-    if (field->firstClick)
+    for (uint32_t i = 0; i < cellCount; i++)
+        field->cells[i].hasMine = mines[i];
+
+    if (field->replay != NULL)
+        RecordReplayLayout(field->replay, cellCount, mines);
+
+    CalculateNeighborMines(field);
+    IndexOpenings(field);
+    field->minesPlaced = true;
+
+    return true;
+}
+
+void
+IndexOpenings(_Inout_ Minefield* field)
+{
+    OpeningIndex* openings = field->openings;
+    uint32_t cellCount = field->width * field->height;
+    uint32_t length = 0;
+
+    if (openings == NULL)
+        return;
+
+    ZeroMemory(openings->label, sizeof(uint16_t) * cellCount);
+    openings->count = 0;
+
+    // Each opening is labelled by a flood fill that uses its own list as the queue. Numbers are listed but not
+    // expanded; until the end their label records the last opening that listed them, so each is listed once per
+    // opening it borders.
+    for (uint32_t seed = 0; seed < cellCount; seed++)
     {
-        field->firstClick = false;
-        field->startTime = GetTickCount64();
+        const Cell* seedCell = &field->cells[seed];
 
-        PlaceMines(field, x, y);
-        CalculateNeighborMines(field);
+        if (seedCell->hasMine || seedCell->neighborMines != 0 || openings->label[seed] != 0)
+            continue;
+
+        uint32_t opening = openings->count++;
+        uint16_t label = (uint16_t)(opening + 1);
+
+        openings->first[opening] = length;
+        openings->flagged[opening] = 0;
+        openings->opened[opening] = false;
+        openings->label[seed] = label;
+        openings->cells[length++] = (uint16_t)seed;
+
+        for (uint32_t i = openings->first[opening]; i < length; i++)
+        {
+            uint32_t index = openings->cells[i];
+            const Cell* cell = &field->cells[index];
+
+            if (cell->neighborMines != 0)
+                continue;
+
+            openings->flagged[opening] += cell->state == CELL_FLAGGED ? 1 : 0;
+            openings->opened[opening] |= cell->state == CELL_REVEALED;
+
+            uint32_t x = index % field->width;
+            uint32_t y = index / field->width;
+
+            for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= y + 1 && ny < field->height; ny++)
+            {
+                for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= x + 1 && nx < field->width; nx++)
+                {
+                    uint32_t neighbor = ny * field->width + nx;
+
+                    if (field->cells[neighbor].hasMine || openings->label[neighbor] == label)
+                        continue;
+
+                    openings->label[neighbor] = label;
+                    openings->cells[length++] = (uint16_t)neighbor;
+                }
+            }
+        }
     }
 
+    openings->first[openings->count] = length;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        if (field->cells[i].neighborMines != 0)
+            openings->label[i] = 0;
+    }
+
+    openings->indexed = true;
+}
+
+void
+AttachOpeningIndex(_Inout_ Minefield* field, _Inout_ OpeningIndex* openings)
+{
+    openings->indexed = false;
+    field->openings = openings;
+
+    if (field->minesPlaced)
+        IndexOpenings(field);
+}
+
+static void
+OpenCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    Cell* cell = &field->cells[y * field->width + x];
+
     if (cell->hasMine)
     {
         cell->state = CELL_REVEALED;
+        field->hash ^= GetCellHashKey(y * field->width + x, cell);
         field->state = GAME_LOST;
+
+        if (field->journal != NULL)
+            RecordJournalCell(field->journal, y * field->width + x);
+
         field->blastX = x;
         field->blastY = y;
         field->endTime = GetTickCount64();
 
-        return true;
+        return;
     }
 
-    RevealConnectedCells(field, x, y);
+    if (!RevealOpening(field, y * field->width + x))
+        RevealConnectedCells(field, x, y);
 
     uint32_t totalCells = field->width * field->height;
     if (field->revealedCells == totalCells - field->totalMines)
@@ -253,28 +479,74 @@ RevealCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
         field->state = GAME_WON;
         field->endTime = GetTickCount64();
     }
-
-    return true;
 }
 
 bool
-ToggleFlag(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+RevealCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
 {
-    if (x >= field->width || y >= field->height)
-        return false;
-
-    if (field->state != GAME_PLAYING)
+    if (x >= field->width || y >= field->height || field->state != GAME_PLAYING)
+    {
         return false;
+    }
 
     Cell* cell = &field->cells[y * field->width + x];
 
-    if (cell->state == CELL_REVEALED)
+    if (cell->state != CELL_HIDDEN)
         return false;
 
+    if (field->replay != NULL)
+        RecordReplayEvent(field->replay, REPLAY_REVEAL, y * field->width + x);
+
+    if (field->journal != NULL)
+        BeginJournalMove(field->journal, field, JOURNAL_REVEAL);
+
+    if (field->firstClick)
+    {
+        field->firstClick = false;
+        field->startTime = GetTickCount64();
+
+        if (field->replay != NULL)
+        {
+            field->replay->seed = field->seed;
+            field->replay->firstClick = y * field->width + x;
+        }
+
+        if (!field->minesPlaced)
+        {
+            PlaceMines(field, x, y);
+            CalculateNeighborMines(field);
+            IndexOpenings(field);
+            field->minesPlaced = true;
+
+            if (field->journal != NULL)
+                RecordJournalPlacement(field->journal, y * field->width + x);
+        }
+    }
+
+    OpenCell(field, x, y);
+
+    return true;
+}
+
+// Flagging and unflagging undo each other, so undoing and redoing a flag toggles it again.
+static void
+FlipFlag(_Inout_ Minefield* field, _In_ uint32_t index)
+{
+    Cell* cell = &field->cells[index];
+    uint16_t* openingFlags = NULL;
+
+    field->hash ^= GetCellHashKey(index, cell);
+
+    if (field->openings != NULL && field->openings->indexed && !cell->hasMine && cell->neighborMines == 0)
+        openingFlags = &field->openings->flagged[field->openings->label[index] - 1];
+
     if (cell->state == CELL_FLAGGED)
     {
         cell->state = CELL_HIDDEN;
 
+        if (openingFlags != NULL)
+            (*openingFlags)--;
+
         if (field->flaggedCells > 0)
         {
             field->flaggedCells--;
@@ -284,11 +556,227 @@ ToggleFlag(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
     {
         cell->state = CELL_FLAGGED;
         field->flaggedCells++;
+
+        if (openingFlags != NULL)
+            (*openingFlags)++;
+    }
+
+    field->hash ^= GetCellHashKey(index, cell);
+}
+
+bool
+ToggleFlag(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    if (x >= field->width || y >= field->height)
+        return false;
+
+    if (field->state != GAME_PLAYING)
+        return false;
+
+    if (field->cells[y * field->width + x].state == CELL_REVEALED)
+        return false;
+
+    if (field->replay != NULL)
+        RecordReplayEvent(field->replay, REPLAY_FLAG, y * field->width + x);
+
+    if (field->journal != NULL)
+    {
+        BeginJournalMove(field->journal, field, JOURNAL_FLAG);
+        RecordJournalCell(field->journal, y * field->width + x);
     }
 
+    FlipFlag(field, y * field->width + x);
+
     return true;
 }
 
+bool
+ChordCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    if (x >= field->width || y >= field->height || field->state != GAME_PLAYING)
+        return false;
+
+    const Cell* cell = &field->cells[y * field->width + x];
+    uint32_t left = x > 0 ? x - 1 : x;
+    uint32_t right = x + 1 < field->width ? x + 1 : x;
+    uint32_t top = y > 0 ? y - 1 : y;
+    uint32_t bottom = y + 1 < field->height ? y + 1 : y;
+    uint32_t flagged = 0;
+    uint32_t hidden = 0;
+
+    if (cell->state != CELL_REVEALED || cell->hasMine || cell->neighborMines == 0)
+        return false;
+
+    for (uint32_t ny = top; ny <= bottom; ny++)
+    {
+        for (uint32_t nx = left; nx <= right; nx++)
+        {
+            flagged += field->cells[ny * field->width + nx].state == CELL_FLAGGED ? 1 : 0;
+            hidden += field->cells[ny * field->width + nx].state == CELL_HIDDEN ? 1 : 0;
+        }
+    }
+
+    // A chord with nothing left to open is not a move, so it leaves no replay event or undo step behind.
+    if (flagged != cell->neighborMines || hidden == 0)
+        return false;
+
+    if (field->replay != NULL)
+        RecordReplayEvent(field->replay, REPLAY_CHORD, y * field->width + x);
+
+    if (field->journal != NULL)
+        BeginJournalMove(field->journal, field, JOURNAL_REVEAL);
+
+    for (uint32_t ny = top; ny <= bottom; ny++)
+    {
+        for (uint32_t nx = left; nx <= right; nx++)
+        {
+            if (field->state == GAME_PLAYING && field->cells[ny * field->width + nx].state == CELL_HIDDEN)
+                OpenCell(field, nx, ny);
+        }
+    }
+
+    return true;
+}
+
+bool
+UndoMove(_Inout_ Minefield* field)
+{
+    MoveJournal* journal = field->journal;
+
+    if (journal == NULL || journal->failed || journal->applied == 0)
+    {
+        SetLastError(journal != NULL && journal->failed ? ERROR_NOT_ENOUGH_MEMORY : ERROR_INVALID_STATE);
+        return false;
+    }
+
+    JournalMove* move = &journal->moves[--journal->applied];
+    uint32_t lastCell = journal->applied + 1 < journal->moveCount ? move[1].firstCell : journal->cellCount;
+    uint32_t lastOpening = journal->applied + 1 < journal->moveCount ? move[1].firstOpening : journal->openingCount;
+
+    if (field->replay != NULL)
+        field->replay->recording = false;
+
+    move->startTime = field->startTime;
+    move->endTime = field->endTime;
+    move->state = (uint8_t)field->state;
+
+    if (move->kind == JOURNAL_FLAG)
+    {
+        FlipFlag(field, journal->cells[move->firstCell]);
+    }
+    else
+    {
+        for (uint32_t i = move->firstCell; i < lastCell; i++)
+        {
+            Cell* cell = &field->cells[journal->cells[i]];
+
+            field->hash ^= GetCellHashKey(journal->cells[i], cell);
+            field->revealedCells -= cell->hasMine ? 0 : 1;
+            cell->state = CELL_HIDDEN;
+        }
+
+        for (uint32_t i = move->firstOpening; i < lastOpening; i++)
+            field->openings->opened[journal->openings[i]] = false;
+    }
+
+    // Taking back the click that placed the mines takes the mines away too, so the next first click is safe wherever it
+    // lands. Every cell is hidden or flagged again, and neither depends on the mines in the hash.
+    if (move->placedMines)
+    {
+        for (uint32_t i = 0; i < field->width * field->height; i++)
+        {
+            field->cells[i].hasMine = false;
+            field->cells[i].neighborMines = 0;
+        }
+
+        if (field->openings != NULL)
+            field->openings->indexed = false;
+
+        field->minesPlaced = false;
+    }
+
+    field->state = GAME_PLAYING;
+    field->endTime = 0;
+
+    if (move->firstClick)
+    {
+        field->firstClick = true;
+        field->startTime = 0;
+    }
+
+    return true;
+}
+
+bool
+RedoMove(_Inout_ Minefield* field)
+{
+    MoveJournal* journal = field->journal;
+
+    if (journal == NULL || journal->failed || journal->applied == journal->moveCount)
+    {
+        SetLastError(journal != NULL && journal->failed ? ERROR_NOT_ENOUGH_MEMORY : ERROR_INVALID_STATE);
+        return false;
+    }
+
+    JournalMove* move = &journal->moves[journal->applied++];
+    uint32_t lastCell = journal->applied < journal->moveCount ? move[1].firstCell : journal->cellCount;
+    uint32_t lastOpening = journal->applied < journal->moveCount ? move[1].firstOpening : journal->openingCount;
+
+    // The mines come back from the seed exactly as the first click placed them.
+    if (move->placedMines)
+    {
+        PlaceMines(field, move->placedAround % field->width, move->placedAround / field->width);
+        CalculateNeighborMines(field);
+        IndexOpenings(field);
+        field->minesPlaced = true;
+    }
+
+    if (move->kind == JOURNAL_FLAG)
+    {
+        FlipFlag(field, journal->cells[move->firstCell]);
+    }
+    else
+    {
+        for (uint32_t i = move->firstCell; i < lastCell; i++)
+        {
+            uint32_t index = journal->cells[i];
+            Cell* cell = &field->cells[index];
+
+            cell->state = CELL_REVEALED;
+            field->hash ^= GetCellHashKey(index, cell);
+            field->revealedCells += cell->hasMine ? 0 : 1;
+
+            if (cell->hasMine)
+            {
+                field->blastX = index % field->width;
+                field->blastY = index / field->width;
+            }
+        }
+
+        for (uint32_t i = move->firstOpening; i < lastOpening; i++)
+            field->openings->opened[journal->openings[i]] = true;
+    }
+
+    // Flags placed before the first reveal leave the clock unstarted.
+    field->state = (GameState)move->state;
+    field->endTime = move->endTime;
+    field->startTime = move->startTime;
+    field->firstClick = move->startTime == 0;
+
+    return true;
+}
+
+uint64_t
+ComputeMinefieldHash(_In_ const Minefield* field)
+{
+    uint64_t hash = GetEmptyMinefieldHash(field);
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+        hash ^= GetCellHashKey(i, &field->cells[i]);
+
+    return hash;
+}
+
 _Ret_maybenull_ const Cell*
 GetCell(_In_ const Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
 {
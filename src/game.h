@@ -8,6 +8,11 @@
 #define MAX_CELLS_VERTICALLY 100
 #define MAX_CELLS_HORIZONTALLY 100
 
+// Zero cells of different openings are never adjacent, so no 2x2 block holds zero cells of two openings. A number
+// borders at most four openings, which bounds the combined length of the opening lists.
+#define MAX_OPENINGS (((MAX_CELLS_HORIZONTALLY + 1) / 2) * ((MAX_CELLS_VERTICALLY + 1) / 2))
+#define MAX_OPENING_CELLS (MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY * 4)
+
 typedef enum
 {
     CELL_HIDDEN,
@@ -22,6 +27,46 @@ typedef struct
     bool hasMine;
 } Cell;
 
+// Every opening's cells, its numbered border included, stored back to back so that clicking into an untouched opening
+// reveals a list instead of searching the board. label holds the 1-based opening of each zero cell. An opening with a
+// flagged zero cell, or one already partly revealed, is revealed by searching as before. The index is kept apart from
+// the Minefield and attached with AttachOpeningIndex; a field without one always searches.
+typedef struct
+{
+    uint32_t count;
+    uint32_t first[MAX_OPENINGS + 1];
+    uint16_t cells[MAX_OPENING_CELLS];
+    uint16_t label[MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY];
+    uint16_t flagged[MAX_OPENINGS];
+    bool opened[MAX_OPENINGS];
+    bool indexed;
+} OpeningIndex;
+
+#define REPLAY_BUFFER_SIZE 32768
+#define REPLAY_LAYOUT_BYTES ((MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY + 7) / 8)
+#define REPLAY_NO_CELL UINT32_MAX
+
+// Every reveal, flag and chord of the current game, as a ring of varint-encoded events: the cell index with the action
+// in its low bits, then the milliseconds since the previous event. When the ring fills up the oldest events are
+// dropped and their time is folded into baseTime. The board is recorded by its seed and first click, or, when the
+// layout was set by hand, by a bitmap of its mines. The log is kept apart from the Minefield and attached with
+// AttachReplayLog, so recording never allocates; a field without one records nothing.
+typedef struct
+{
+    uint64_t seed;
+    uint64_t baseTime;
+    uint64_t lastTime;
+    uint32_t firstClick;
+    uint32_t head;
+    uint32_t length;
+    uint32_t eventCount;
+    uint32_t droppedEvents;
+    bool recording;
+    bool layoutRecorded;
+    uint8_t layout[REPLAY_LAYOUT_BYTES];
+    uint8_t events[REPLAY_BUFFER_SIZE];
+} ReplayLog;
+
 typedef enum
 {
     GAME_PLAYING,
@@ -29,6 +74,46 @@ typedef enum
     GAME_LOST
 } GameState;
 
+typedef enum
+{
+    JOURNAL_REVEAL,
+    JOURNAL_FLAG
+} JournalMoveKind;
+
+// A move in a MoveJournal: where its cells and openings start in the journal, whether it was the first click, and
+// the cell it placed the mines around if it did. The state and times it left behind are filled in when it is undone,
+// so that redoing it restores them exactly.
+typedef struct
+{
+    uint32_t firstCell;
+    uint32_t firstOpening;
+    uint32_t placedAround;
+    uint8_t kind;
+    uint8_t state;
+    bool firstClick;
+    bool placedMines;
+    uint64_t startTime;
+    uint64_t endTime;
+} JournalMove;
+
+// Undo history of a game. A reveal or chord only turns hidden cells into revealed ones and a flag toggles a single
+// cell, so a move is undone from the 16-bit indices of the cells it changed and of the openings it marked opened,
+// without copying the board. Moves after applied have been undone and can be redone until a new move is made.
+typedef struct
+{
+    JournalMove* moves;
+    uint16_t* cells;
+    uint16_t* openings;
+    uint32_t moveCount;
+    uint32_t applied;
+    uint32_t cellCount;
+    uint32_t openingCount;
+    uint32_t moveCapacity;
+    uint32_t cellCapacity;
+    uint32_t openingCapacity;
+    bool failed;
+} MoveJournal;
+
 typedef enum
 {
     DIFFICULTY_BEGINNER,
@@ -40,6 +125,8 @@ typedef enum
 typedef struct
 {
     Cell cells[MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY];
+    uint64_t hash;
+    uint64_t seed;
     uint64_t startTime;
     uint64_t endTime;
     uint32_t width;
@@ -52,14 +139,60 @@ typedef struct
     uint32_t blastX;
     uint32_t blastY;
     bool firstClick;
+    bool minesPlaced;
+    OpeningIndex* openings;
+    ReplayLog* replay;
+    MoveJournal* journal;
 } Minefield;
 
+// Board size and mine count of a preset; custom and unknown difficulties get Beginner's.
+void GetDifficultySettings(
+    _In_ Difficulty difficulty,
+    _Out_ uint32_t* width,
+    _Out_ uint32_t* height,
+    _Out_ uint32_t* mines);
+
+// Places mines from the seed exactly as the first click on (excludeX, excludeY) does, so a board can be rebuilt
+// from its seed and first click alone.
+void PlaceSeededMines(
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t totalMines,
+    _In_ uint64_t seed,
+    _In_ uint32_t excludeX,
+    _In_ uint32_t excludeY,
+    _Out_writes_(width* height) bool* mines);
+
 bool CreateMinefield(_Out_ Minefield* field, _In_ Difficulty difficulty);
 
 bool CreateCustomMinefield(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t totalMines);
 
+// Creates the preset with this size and mine count, so boards loaded from elsewhere are counted with it, or else a
+// custom field.
+bool CreateSizedMinefield(_Out_ Minefield* field, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t totalMines);
+
+bool SetMinefieldLayout(_Inout_ Minefield* field, _In_reads_(field->width* field->height) const bool* mines);
+
+// Rebuilds the opening index from the current layout and cell states; needed after mines are moved by hand.
+void IndexOpenings(_Inout_ Minefield* field);
+
+// Creating a field detaches its index, so it is attached again for every game. A board whose mines are already placed
+// is indexed at once.
+void AttachOpeningIndex(_Inout_ Minefield* field, _Inout_ OpeningIndex* openings);
+
 bool RevealCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y);
 
 bool ToggleFlag(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y);
 
+// Reveals every hidden neighbour of a revealed number whose mines are all flagged. Fails when there is none.
+bool ChordCell(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y);
+
+// Both work on the journal attached with AttachMoveJournal and fail when there is nothing to undo or redo. The replay
+// log cannot express an undo, so it stops recording at the first one.
+bool UndoMove(_Inout_ Minefield* field);
+
+bool RedoMove(_Inout_ Minefield* field);
+
+uint64_t ComputeMinefieldHash(_In_ const Minefield* field);
+
 _Ret_maybenull_ const Cell* GetCell(_In_ const Minefield* field, _In_ uint32_t x, _In_ uint32_t y);
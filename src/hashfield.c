@@ -0,0 +1,281 @@
+#include "pch.h"
+
+#include "hashfield.h"
+#include "random.h"
+#include "revealqueue.h"
+
+#define HASH_FIELD_STATE_BITS 2
+#define HASH_FIELD_STATE_MASK ((1u << HASH_FIELD_STATE_BITS) - 1)
+#define HASH_FIELD_INITIAL_CAPACITY 4096
+
+// Shifting both coordinates up by 2^30 makes them positive, non-zero and 31 bits wide, so a packed key is never zero
+// and an entry of zero can mark an empty slot.
+static uint64_t
+PackCell(_In_ int32_t x, _In_ int32_t y)
+{
+    uint64_t px = (uint64_t)((int64_t)x + HASH_FIELD_LIMIT + 1);
+    uint64_t py = (uint64_t)((int64_t)y + HASH_FIELD_LIMIT + 1);
+
+    return py << 31 | px;
+}
+
+static void
+UnpackCell(_In_ uint64_t key, _Out_ int32_t* x, _Out_ int32_t* y)
+{
+    *x = (int32_t)((int64_t)(key & 0x7FFFFFFF) - HASH_FIELD_LIMIT - 1);
+    *y = (int32_t)((int64_t)(key >> 31) - HASH_FIELD_LIMIT - 1);
+}
+
+static bool
+IsInside(_In_ int32_t x, _In_ int32_t y)
+{
+    return x >= -HASH_FIELD_LIMIT && x <= HASH_FIELD_LIMIT && y >= -HASH_FIELD_LIMIT && y <= HASH_FIELD_LIMIT;
+}
+
+static uint32_t
+FindSlot(_In_ const HashField* field, _In_ uint64_t key)
+{
+    uint32_t mask = field->capacity - 1;
+    uint32_t slot = (uint32_t)mix64(key) & mask;
+
+    while (field->entries[slot] != 0 && field->entries[slot] >> HASH_FIELD_STATE_BITS != key)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+static bool
+GrowEntries(_Inout_ HashField* field)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint64_t* previous = field->entries;
+    uint32_t previousCapacity = field->capacity;
+    uint32_t capacity = previousCapacity > 0 ? previousCapacity * 2 : HASH_FIELD_INITIAL_CAPACITY;
+    uint64_t* entries = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint64_t) * capacity);
+
+    if (capacity < previousCapacity || entries == NULL)
+    {
+        HeapFree(hHeap, 0, entries);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    field->entries = entries;
+    field->capacity = capacity;
+
+    for (uint32_t i = 0; i < previousCapacity; i++)
+    {
+        if (previous[i] != 0)
+            entries[FindSlot(field, previous[i] >> HASH_FIELD_STATE_BITS)] = previous[i];
+    }
+
+    HeapFree(hHeap, 0, previous);
+
+    return true;
+}
+
+static bool
+SetCellState(_Inout_ HashField* field, _In_ int32_t x, _In_ int32_t y, _In_ uint8_t state)
+{
+    uint64_t key = PackCell(x, y);
+    uint32_t slot = FindSlot(field, key);
+
+    if (field->entries[slot] == 0)
+    {
+        // Kept at most three quarters full.
+        if ((field->used + 1) * 4 > field->capacity * 3)
+        {
+            if (!GrowEntries(field))
+                return false;
+
+            slot = FindSlot(field, key);
+        }
+
+        field->used++;
+    }
+
+    field->entries[slot] = key << HASH_FIELD_STATE_BITS | state;
+
+    return true;
+}
+
+bool
+CreateHashField(_Out_ HashField* field, _In_ uint64_t seed, _In_ double density)
+{
+    ZeroMemory(field, sizeof(HashField));
+
+    if (!(density >= HASH_FIELD_MIN_DENSITY && density < 1.0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    field->seed = seed;
+    field->threshold = GetMineThreshold(density);
+
+    if (!GrowEntries(field))
+        return false;
+
+    return true;
+}
+
+void
+DestroyHashField(_Inout_ HashField* field)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, field->entries);
+    HeapFree(hHeap, 0, field->queue);
+
+    ZeroMemory(field, sizeof(HashField));
+}
+
+uint64_t
+GetMineThreshold(_In_ double density)
+{
+    return (uint64_t)(density * 18446744073709551616.0);
+}
+
+// SplitMix64 evaluated at a position instead of stepped: the packed coordinates take the place of the counter.
+bool
+IsSeededMine(_In_ uint64_t seed, _In_ uint64_t threshold, _In_ int32_t x, _In_ int32_t y)
+{
+    return IsInside(x, y) && mix64(seed + PackCell(x, y) * 0x9E3779B97F4A7C15ull) < threshold;
+}
+
+bool
+IsHashMine(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (field->started && x >= field->safeX - 1 && x <= field->safeX + 1 && y >= field->safeY - 1 &&
+        y <= field->safeY + 1)
+    {
+        return false;
+    }
+
+    return IsSeededMine(field->seed, field->threshold, x, y);
+}
+
+uint8_t
+GetHashNeighborCount(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    uint8_t count = 0;
+
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            if ((dx != 0 || dy != 0) && IsHashMine(field, x + dx, y + dy))
+                count++;
+        }
+    }
+
+    return count;
+}
+
+uint8_t
+GetHashCellState(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (!IsInside(x, y))
+        return 0;
+
+    return (uint8_t)(field->entries[FindSlot(field, PackCell(x, y))] & HASH_FIELD_STATE_MASK);
+}
+
+bool
+RevealHashCell(_Inout_ HashField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (!IsInside(x, y) || field->exploded)
+        return true;
+
+    if (!field->started)
+    {
+        field->started = true;
+        field->safeX = x;
+        field->safeY = y;
+    }
+
+    if (GetHashCellState(field, x, y) != 0)
+        return true;
+
+    if (!SetCellState(field, x, y, HASH_CELL_REVEALED))
+        return false;
+
+    if (IsHashMine(field, x, y))
+    {
+        field->exploded = true;
+        return true;
+    }
+
+    field->revealedCells++;
+
+    if (GetHashNeighborCount(field, x, y) != 0)
+        return true;
+
+    // Neighbours of a zero cell are never mines, so only their state needs checking before they are revealed.
+    uint32_t head = 0;
+    uint32_t count = 0;
+
+    if (field->queueCapacity == 0 && !GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+        return false;
+
+    field->queue[count++] = PackCell(x, y);
+
+    while (count > 0)
+    {
+        int32_t cx, cy;
+
+        UnpackCell(field->queue[head], &cx, &cy);
+        head = (head + 1) & (field->queueCapacity - 1);
+        count--;
+
+        for (int32_t ny = cy - 1; ny <= cy + 1; ny++)
+        {
+            for (int32_t nx = cx - 1; nx <= cx + 1; nx++)
+            {
+                if (!IsInside(nx, ny) || GetHashCellState(field, nx, ny) != 0)
+                    continue;
+
+                if (!SetCellState(field, nx, ny, HASH_CELL_REVEALED))
+                    return false;
+
+                field->revealedCells++;
+
+                if (GetHashNeighborCount(field, nx, ny) != 0)
+                    continue;
+
+                if (count == field->queueCapacity)
+                {
+                    if (!GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+                        return false;
+
+                    head = 0;
+                }
+
+                field->queue[(head + count) & (field->queueCapacity - 1)] = PackCell(nx, ny);
+                count++;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool
+ToggleHashFlag(_Inout_ HashField* field, _In_ int32_t x, _In_ int32_t y)
+{
+    if (!IsInside(x, y) || field->exploded)
+        return true;
+
+    uint8_t state = GetHashCellState(field, x, y);
+
+    if (state & HASH_CELL_REVEALED)
+        return true;
+
+    return SetCellState(field, x, y, state ^ HASH_CELL_FLAGGED);
+}
+
+uint64_t
+GetHashFieldMemory(_In_ const HashField* field)
+{
+    return sizeof(HashField) + sizeof(uint64_t) * ((uint64_t)field->capacity + field->queueCapacity);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Coordinates run from -HASH_FIELD_LIMIT to HASH_FIELD_LIMIT on both axes.
+#define HASH_FIELD_LIMIT ((1 << 30) - 1)
+
+// Below roughly 9.5% mines the zero cells percolate, so a single click could open a region with no end.
+#define HASH_FIELD_MIN_DENSITY 0.12
+
+#define HASH_CELL_REVEALED 0x01
+#define HASH_CELL_FLAGGED 0x02
+
+// A board that never stores its mines. Whether a cell holds one is a hash of the seed and its coordinates, so any
+// cell can be asked about in any order, and only the cells the player has revealed or flagged take memory. They are
+// kept in an open-addressed set of 64-bit entries, each packing both coordinates with the cell's state bits.
+typedef struct
+{
+    uint64_t seed;
+    uint64_t threshold;
+    bool started;
+    int32_t safeX;
+    int32_t safeY;
+    uint64_t* entries;
+    uint32_t capacity;
+    uint32_t used;
+    uint64_t revealedCells;
+    bool exploded;
+    uint64_t* queue;
+    uint32_t queueCapacity;
+} HashField;
+
+// The fraction of hash values below the threshold is the density.
+uint64_t GetMineThreshold(_In_ double density);
+
+// The hash behind every hashed board, without the first-click safe zone. Cells outside the limits are never mines.
+bool IsSeededMine(_In_ uint64_t seed, _In_ uint64_t threshold, _In_ int32_t x, _In_ int32_t y);
+
+bool CreateHashField(_Out_ HashField* field, _In_ uint64_t seed, _In_ double density);
+
+void DestroyHashField(_Inout_ HashField* field);
+
+// The first reveal makes its cell and the eight around it safe, as the window's first click does.
+bool IsHashMine(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y);
+
+uint8_t GetHashNeighborCount(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y);
+
+uint8_t GetHashCellState(_In_ const HashField* field, _In_ int32_t x, _In_ int32_t y);
+
+// Both fail only when the set of touched cells cannot grow. A flag that is taken off keeps its slot.
+bool RevealHashCell(_Inout_ HashField* field, _In_ int32_t x, _In_ int32_t y);
+
+bool ToggleHashFlag(_Inout_ HashField* field, _In_ int32_t x, _In_ int32_t y);
+
+uint64_t GetHashFieldMemory(_In_ const HashField* field);
@@ -0,0 +1,141 @@
+#include "pch.h"
+
+#include "journal.h"
+
+#define JOURNAL_INITIAL_MOVES 256
+#define JOURNAL_INITIAL_CELLS 4096
+#define JOURNAL_INITIAL_OPENINGS 256
+
+_Success_(return) static bool
+GrowJournalArray(_Inout_ void** items, _Inout_ uint32_t* capacity, _In_ size_t itemSize)
+{
+    uint32_t grown = *capacity * 2;
+    void* resized = HeapReAlloc(GetProcessHeap(), 0, *items, grown * itemSize);
+
+    if (resized == NULL)
+        return false;
+
+    *items = resized;
+    *capacity = grown;
+
+    return true;
+}
+
+bool
+CreateMoveJournal(_Out_ MoveJournal* journal)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    ZeroMemory(journal, sizeof(MoveJournal));
+    journal->moves = HeapAlloc(hHeap, 0, sizeof(JournalMove) * JOURNAL_INITIAL_MOVES);
+    journal->cells = HeapAlloc(hHeap, 0, sizeof(uint16_t) * JOURNAL_INITIAL_CELLS);
+    journal->openings = HeapAlloc(hHeap, 0, sizeof(uint16_t) * JOURNAL_INITIAL_OPENINGS);
+    journal->moveCapacity = JOURNAL_INITIAL_MOVES;
+    journal->cellCapacity = JOURNAL_INITIAL_CELLS;
+    journal->openingCapacity = JOURNAL_INITIAL_OPENINGS;
+
+    if (journal->moves == NULL || journal->cells == NULL || journal->openings == NULL)
+    {
+        DestroyMoveJournal(journal);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DestroyMoveJournal(_Inout_ MoveJournal* journal)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, journal->moves);
+    HeapFree(hHeap, 0, journal->cells);
+    HeapFree(hHeap, 0, journal->openings);
+    ZeroMemory(journal, sizeof(MoveJournal));
+}
+
+void
+AttachMoveJournal(_Inout_ Minefield* field, _Inout_ MoveJournal* journal)
+{
+    journal->moveCount = 0;
+    journal->applied = 0;
+    journal->cellCount = 0;
+    journal->openingCount = 0;
+    journal->failed = false;
+    field->journal = journal;
+}
+
+void
+BeginJournalMove(_Inout_ MoveJournal* journal, _In_ const Minefield* field, _In_ JournalMoveKind kind)
+{
+    if (journal->applied < journal->moveCount)
+    {
+        journal->cellCount = journal->moves[journal->applied].firstCell;
+        journal->openingCount = journal->moves[journal->applied].firstOpening;
+        journal->moveCount = journal->applied;
+    }
+
+    if (journal->moveCount == journal->moveCapacity &&
+        !GrowJournalArray((void**)&journal->moves, &journal->moveCapacity, sizeof(JournalMove)))
+    {
+        journal->failed = true;
+        return;
+    }
+
+    JournalMove* move = &journal->moves[journal->moveCount++];
+
+    move->firstCell = journal->cellCount;
+    move->firstOpening = journal->openingCount;
+    move->startTime = 0;
+    move->endTime = 0;
+    move->kind = (uint8_t)kind;
+    move->state = GAME_PLAYING;
+    move->firstClick = field->firstClick;
+    move->placedMines = false;
+    move->placedAround = 0;
+    journal->applied = journal->moveCount;
+}
+
+void
+RecordJournalCell(_Inout_ MoveJournal* journal, _In_ uint32_t cell)
+{
+    if (journal->cellCount == journal->cellCapacity &&
+        !GrowJournalArray((void**)&journal->cells, &journal->cellCapacity, sizeof(uint16_t)))
+    {
+        journal->failed = true;
+        return;
+    }
+
+    journal->cells[journal->cellCount++] = (uint16_t)cell;
+}
+
+void
+RecordJournalOpening(_Inout_ MoveJournal* journal, _In_ uint32_t opening)
+{
+    if (journal->openingCount == journal->openingCapacity &&
+        !GrowJournalArray((void**)&journal->openings, &journal->openingCapacity, sizeof(uint16_t)))
+    {
+        journal->failed = true;
+        return;
+    }
+
+    journal->openings[journal->openingCount++] = (uint16_t)opening;
+}
+
+void
+RecordJournalPlacement(_Inout_ MoveJournal* journal, _In_ uint32_t cell)
+{
+    if (journal->failed || journal->moveCount == 0)
+        return;
+
+    journal->moves[journal->moveCount - 1].placedMines = true;
+    journal->moves[journal->moveCount - 1].placedAround = cell;
+}
+
+uint64_t
+GetMoveJournalSize(_In_ const MoveJournal* journal)
+{
+    return (uint64_t)journal->moveCount * sizeof(JournalMove) + (uint64_t)journal->cellCount * sizeof(uint16_t) +
+           (uint64_t)journal->openingCount * sizeof(uint16_t);
+}
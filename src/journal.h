@@ -0,0 +1,30 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+bool CreateMoveJournal(_Out_ MoveJournal* journal);
+
+void DestroyMoveJournal(_Inout_ MoveJournal* journal);
+
+// Empties the journal and records the field's moves into it from now on. Creating a new game on the field detaches
+// it again.
+void AttachMoveJournal(_Inout_ Minefield* field, _Inout_ MoveJournal* journal);
+
+// Called by the game as it makes a move, dropping any moves that were undone. When the journal cannot grow it is
+// marked failed and nothing more can be undone.
+void BeginJournalMove(_Inout_ MoveJournal* journal, _In_ const Minefield* field, _In_ JournalMoveKind kind);
+
+void RecordJournalCell(_Inout_ MoveJournal* journal, _In_ uint32_t cell);
+
+void RecordJournalOpening(_Inout_ MoveJournal* journal, _In_ uint32_t opening);
+
+// Marks the current move as the one that placed the seeded mines around the cell, so undoing it takes them away.
+void RecordJournalPlacement(_Inout_ MoveJournal* journal, _In_ uint32_t cell);
+
+// Bytes held for the moves, cells and openings recorded so far.
+uint64_t GetMoveJournalSize(_In_ const MoveJournal* journal);
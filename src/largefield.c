@@ -0,0 +1,604 @@
+#include "pch.h"
+
+#include "largefield.h"
+#include "parallel.h"
+#include "random.h"
+#include "revealqueue.h"
+
+typedef struct
+{
+    uint32_t left;
+    uint32_t top;
+    uint32_t right;
+    uint32_t bottom;
+} LargeTile;
+
+typedef struct
+{
+    LargeField* field;
+    volatile LONG64 openingCount;
+} LabelJob;
+
+static void
+GetLargeTile(_In_ const LargeField* field, _In_ uint32_t index, _Out_ LargeTile* tile)
+{
+    tile->left = index % field->tilesX * LARGE_FIELD_TILE_SIDE;
+    tile->top = index / field->tilesX * LARGE_FIELD_TILE_SIDE;
+    tile->right = min(tile->left + LARGE_FIELD_TILE_SIDE, field->width);
+    tile->bottom = min(tile->top + LARGE_FIELD_TILE_SIDE, field->height);
+}
+
+// A row is stored as runs of consecutive indices, the whole row or the part of it in one block. Returns where the run
+// holding x ends, stopping at last.
+static uint32_t
+GetRunEnd(_In_ const LargeField* field, _In_ uint32_t x, _In_ uint32_t last)
+{
+    if (field->layout == LARGE_LAYOUT_ROWS)
+        return last;
+
+    return min(last, (x / LARGE_FIELD_BLOCK_SIDE + 1) * LARGE_FIELD_BLOCK_SIDE);
+}
+
+// The index distance from any cell of row y to the cell directly above or below it, which is the same along the row.
+static int32_t
+GetRowStep(_In_ const LargeField* field, _In_ uint32_t y, _In_ bool down)
+{
+    if (field->layout == LARGE_LAYOUT_ROWS)
+        return down ? (int32_t)field->width : -(int32_t)field->width;
+
+    uint32_t row = y % LARGE_FIELD_BLOCK_SIDE;
+    int32_t blockRow = (int32_t)(field->blocksX * LARGE_FIELD_BLOCK_SIDE * LARGE_FIELD_BLOCK_SIDE);
+    int32_t wrap = (LARGE_FIELD_BLOCK_SIDE - 1) * LARGE_FIELD_BLOCK_SIDE;
+
+    if (down)
+        return row + 1 < LARGE_FIELD_BLOCK_SIDE ? LARGE_FIELD_BLOCK_SIDE : blockRow - wrap;
+
+    return row > 0 ? -LARGE_FIELD_BLOCK_SIDE : wrap - blockRow;
+}
+
+// Tiles in earlier rows are full height and tiles earlier in the same row are full width, so the cells before a tile
+// follow from its position alone. Rounding the running share keeps the shares summing to exactly the mine count.
+static uint32_t
+GetTileMineCount(_In_ const LargeField* field, _In_ const LargeTile* tile)
+{
+    uint64_t cellCount = (uint64_t)field->width * field->height;
+    uint64_t before = (uint64_t)tile->top * field->width + (uint64_t)tile->left * (tile->bottom - tile->top);
+    uint64_t after = before + (uint64_t)(tile->right - tile->left) * (tile->bottom - tile->top);
+
+    return (uint32_t)(field->mines * after / cellCount - field->mines * before / cellCount);
+}
+
+static void
+PlaceTileMines(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    LargeField* field = (LargeField*)context;
+    LargeTile tile;
+
+    GetLargeTile(field, index, &tile);
+
+    uint32_t tileWidth = tile.right - tile.left;
+    uint32_t area = tileWidth * (tile.bottom - tile.top);
+    uint32_t mines = GetTileMineCount(field, &tile);
+    struct splitmix64_state random = {
+        .s = mix64(field->seed ^ mix64(index)),
+    };
+
+    // Dense tiles start full and have their safe cells drawn instead, so rejection never dominates.
+    bool inverted = mines > area / 2;
+    uint32_t target = inverted ? area - mines : mines;
+    uint8_t fill = inverted ? LARGE_CELL_MINE : 0;
+
+    for (uint32_t y = tile.top; y < tile.bottom; y++)
+    {
+        for (uint32_t x = tile.left, end; x < tile.right; x = end)
+        {
+            end = GetRunEnd(field, x, tile.right);
+            FillMemory(&field->cells[GetLargeCellIndex(field, x, y)], end - x, fill);
+        }
+    }
+
+    for (uint32_t placed = 0; placed < target;)
+    {
+        uint32_t offset = (uint32_t)(((splitmix64(&random) >> 32) * area) >> 32);
+        uint32_t cell = GetLargeCellIndex(field, tile.left + offset % tileWidth, tile.top + offset / tileWidth);
+
+        if (field->cells[cell] == fill)
+        {
+            field->cells[cell] ^= LARGE_CELL_MINE;
+            placed++;
+        }
+    }
+}
+
+static bool
+IsZeroCell(_In_ uint8_t cell)
+{
+    return (cell & (LARGE_CELL_MINE | LARGE_CELL_COUNT_MASK)) == 0;
+}
+
+// Counts row by row from three-cell column sums. The halo around the tile is read from the neighbouring tiles, whose
+// mines are all placed before any counting starts and whose mine bits the counting never changes.
+static void
+CountTileNeighbors(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    LargeField* field = (LargeField*)context;
+    uint8_t* cells = field->cells;
+    uint8_t columns[LARGE_FIELD_TILE_SIDE + 2];
+    LargeTile tile;
+
+    GetLargeTile(field, index, &tile);
+
+    uint32_t first = tile.left > 0 ? tile.left - 1 : 0;
+    uint32_t last = min(tile.right + 1, field->width);
+
+    ZeroMemory(columns, sizeof(columns));
+
+    for (uint32_t y = tile.top; y < tile.bottom; y++)
+    {
+        int32_t up = y > 0 ? GetRowStep(field, y, false) : 0;
+        int32_t down = y + 1 < field->height ? GetRowStep(field, y, true) : 0;
+        uint8_t* sum = columns + first + 1 - tile.left;
+
+        // Rows off the board are read as the row itself with its mine bits masked out.
+        uint8_t upMask = y > 0 ? LARGE_CELL_MINE : 0;
+        uint8_t downMask = y + 1 < field->height ? LARGE_CELL_MINE : 0;
+
+        for (uint32_t x = first, end; x < last; x = end)
+        {
+            const uint8_t* cell = &cells[GetLargeCellIndex(field, x, y)];
+            const uint8_t* above = cell + up;
+            const uint8_t* below = cell + down;
+
+            end = GetRunEnd(field, x, last);
+
+            for (uint32_t k = 0; k < end - x; k++)
+                *sum++ = ((cell[k] & LARGE_CELL_MINE) + (above[k] & upMask) + (below[k] & downMask)) >> 4;
+        }
+
+        for (uint32_t x = tile.left, end; x < tile.right; x = end)
+        {
+            uint8_t* cell = &cells[GetLargeCellIndex(field, x, y)];
+            const uint8_t* column = columns + x - tile.left;
+
+            end = GetRunEnd(field, x, tile.right);
+
+            for (uint32_t k = 0; k < end - x; k++)
+            {
+                uint8_t mine = cell[k] & LARGE_CELL_MINE;
+                uint8_t count = (uint8_t)(column[k] + column[k + 1] + column[k + 2] - (mine >> 4));
+
+                cell[k] = mine | LARGE_CELL_COUNTED | count;
+            }
+        }
+    }
+}
+
+static uint32_t
+FindOpening(_In_ const volatile LONG* parent, _In_ uint32_t index)
+{
+    for (;;)
+    {
+        uint32_t next = (uint32_t)parent[index];
+
+        if (next == index)
+            return index;
+
+        index = next;
+    }
+}
+
+// Roots always link to the smaller index, so every region ends up rooted at its first cell whatever order the
+// unions happen in. The exchange fails only if another thread linked the same root first, and then the roots are
+// simply found again.
+static void
+UniteOpenings(_Inout_ volatile LONG* parent, _In_ uint32_t a, _In_ uint32_t b)
+{
+    for (;;)
+    {
+        a = FindOpening(parent, a);
+        b = FindOpening(parent, b);
+
+        if (a == b)
+            return;
+
+        uint32_t child = max(a, b);
+        uint32_t root = min(a, b);
+
+        if ((uint32_t)InterlockedCompareExchange(&parent[child], (LONG)root, (LONG)child) == child)
+            return;
+    }
+}
+
+static uint32_t
+FindTileOpening(_Inout_ uint32_t* parent, _In_ uint32_t index)
+{
+    while (parent[index] != index)
+    {
+        parent[index] = parent[parent[index]];
+        index = parent[index];
+    }
+
+    return index;
+}
+
+static void
+UniteTileOpenings(_Inout_ uint32_t* parent, _In_ uint32_t a, _In_ uint32_t b)
+{
+    a = FindTileOpening(parent, a);
+    b = FindTileOpening(parent, b);
+    parent[max(a, b)] = min(a, b);
+}
+
+// The same raster union-find as the metrics use, kept inside the tile so no other thread touches these parents yet.
+// A zero cell above already joins every other zero neighbour visited so far, so at most two unions are needed.
+static void
+LabelTileOpenings(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    LabelJob* job = (LabelJob*)context;
+    LargeField* field = job->field;
+    const uint8_t* cells = field->cells;
+    uint32_t* parent = field->openings;
+    LargeTile tile;
+
+    GetLargeTile(field, index, &tile);
+
+    for (uint32_t y = tile.top; y < tile.bottom; y++)
+    {
+        int32_t up = y > tile.top ? GetRowStep(field, y, false) : 0;
+
+        for (uint32_t x = tile.left, end; x < tile.right; x = end)
+        {
+            uint32_t start = GetLargeCellIndex(field, x, y);
+
+            end = GetRunEnd(field, x, tile.right);
+
+            // Neighbours across the ends of the run are stored elsewhere and are looked up separately.
+            uint32_t leftNeighbor = x > tile.left ? GetLargeCellIndex(field, x - 1, y) : 0;
+            uint32_t upLeftNeighbor = x > tile.left && up != 0 ? GetLargeCellIndex(field, x - 1, y - 1) : 0;
+            uint32_t upRightNeighbor = end < tile.right && up != 0 ? GetLargeCellIndex(field, end, y - 1) : 0;
+
+            for (uint32_t k = 0; k < end - x; k++)
+            {
+                uint32_t cell = start + k;
+
+                if (!IsZeroCell(cells[cell]))
+                {
+                    parent[cell] = LARGE_FIELD_NO_OPENING;
+                    continue;
+                }
+
+                parent[cell] = cell;
+
+                bool left = x + k > tile.left;
+                bool right = x + k + 1 < tile.right;
+                uint32_t above = (uint32_t)((int32_t)cell + up);
+
+                if (up != 0 && IsZeroCell(cells[above]))
+                {
+                    UniteTileOpenings(parent, cell, above);
+                    continue;
+                }
+
+                uint32_t west = k > 0 ? cell - 1 : leftNeighbor;
+                uint32_t northWest = k > 0 ? above - 1 : upLeftNeighbor;
+                uint32_t northEast = k + 1 < end - x ? above + 1 : upRightNeighbor;
+
+                if (left && IsZeroCell(cells[west]))
+                    UniteTileOpenings(parent, cell, west);
+                else if (left && up != 0 && IsZeroCell(cells[northWest]))
+                    UniteTileOpenings(parent, cell, northWest);
+
+                if (right && up != 0 && IsZeroCell(cells[northEast]))
+                    UniteTileOpenings(parent, cell, northEast);
+            }
+        }
+    }
+}
+
+// Joins the regions that cross the tile's right and bottom edges. Between them these cover every pair of touching
+// cells in different tiles, including the diagonal ones across tile corners.
+static void
+MergeTileOpenings(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    LabelJob* job = (LabelJob*)context;
+    LargeField* field = job->field;
+    volatile LONG* parent = (volatile LONG*)field->openings;
+    LargeTile tile;
+
+    GetLargeTile(field, index, &tile);
+
+    if (tile.right < field->width)
+    {
+        for (uint32_t y = tile.top; y < tile.bottom; y++)
+        {
+            uint32_t cell = GetLargeCellIndex(field, tile.right - 1, y);
+
+            if (!IsZeroCell(field->cells[cell]))
+                continue;
+
+            for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= y + 1 && ny < field->height; ny++)
+            {
+                uint32_t neighbor = GetLargeCellIndex(field, tile.right, ny);
+
+                if (IsZeroCell(field->cells[neighbor]))
+                    UniteOpenings(parent, cell, neighbor);
+            }
+        }
+    }
+
+    if (tile.bottom < field->height)
+    {
+        for (uint32_t x = tile.left; x < tile.right; x++)
+        {
+            uint32_t cell = GetLargeCellIndex(field, x, tile.bottom - 1);
+
+            if (!IsZeroCell(field->cells[cell]))
+                continue;
+
+            for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= x + 1 && nx < field->width; nx++)
+            {
+                uint32_t neighbor = GetLargeCellIndex(field, nx, tile.bottom);
+
+                if (IsZeroCell(field->cells[neighbor]))
+                    UniteOpenings(parent, cell, neighbor);
+            }
+        }
+    }
+}
+
+// Other tiles may be shortening the same paths at the same time, but they only ever write a cell's final root, so
+// any parent read here is still on the way to it.
+static void
+ResolveTileOpenings(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    LabelJob* job = (LabelJob*)context;
+    LargeField* field = job->field;
+    volatile LONG* parent = (volatile LONG*)field->openings;
+    LONG64 roots = 0;
+    LargeTile tile;
+
+    GetLargeTile(field, index, &tile);
+
+    for (uint32_t y = tile.top; y < tile.bottom; y++)
+    {
+        for (uint32_t x = tile.left, end; x < tile.right; x = end)
+        {
+            uint32_t start = GetLargeCellIndex(field, x, y);
+
+            end = GetRunEnd(field, x, tile.right);
+
+            for (uint32_t cell = start; cell < start + end - x; cell++)
+            {
+                if ((uint32_t)parent[cell] == LARGE_FIELD_NO_OPENING)
+                    continue;
+
+                uint32_t root = FindOpening(parent, cell);
+
+                parent[cell] = (LONG)root;
+                roots += root == cell;
+            }
+        }
+    }
+
+    InterlockedExchangeAdd64(&job->openingCount, roots);
+}
+
+bool
+CreateLargeField(
+    _Out_ LargeField* field,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint64_t seed,
+    _In_ LargeFieldLayout layout)
+{
+    uint32_t blocksX = (width + LARGE_FIELD_BLOCK_SIDE - 1) / LARGE_FIELD_BLOCK_SIDE;
+    uint32_t blocksY = (height + LARGE_FIELD_BLOCK_SIDE - 1) / LARGE_FIELD_BLOCK_SIDE;
+    uint64_t cellCount = (uint64_t)width * height;
+    uint64_t storedCells = layout == LARGE_LAYOUT_BLOCKS
+                               ? (uint64_t)blocksX * blocksY * LARGE_FIELD_BLOCK_SIDE * LARGE_FIELD_BLOCK_SIDE
+                               : cellCount;
+
+    ZeroMemory(field, sizeof(LargeField));
+
+    // Cell indices have to fit the opening labels with LARGE_FIELD_NO_OPENING to spare.
+    if (width == 0 || height == 0 || storedCells >= LARGE_FIELD_NO_OPENING || mines > cellCount ||
+        (layout != LARGE_LAYOUT_ROWS && layout != LARGE_LAYOUT_BLOCKS))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+
+    field->width = width;
+    field->height = height;
+    field->mines = mines;
+    field->seed = seed;
+    field->layout = layout;
+    field->blocksX = blocksX;
+    field->storedCells = (uint32_t)storedCells;
+    field->tilesX = (width + LARGE_FIELD_TILE_SIDE - 1) / LARGE_FIELD_TILE_SIDE;
+    field->tilesY = (height + LARGE_FIELD_TILE_SIDE - 1) / LARGE_FIELD_TILE_SIDE;
+
+    // Zeroed so the padding of partial blocks, which nothing ever writes, reads the same on every run.
+    field->cells = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, (SIZE_T)storedCells);
+    field->openings = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint32_t) * (SIZE_T)storedCells);
+
+    if (field->cells == NULL || field->openings == NULL)
+    {
+        DestroyLargeField(field);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DestroyLargeField(_Inout_ LargeField* field)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, field->cells);
+    HeapFree(hHeap, 0, field->openings);
+    HeapFree(hHeap, 0, field->queue);
+
+    ZeroMemory(field, sizeof(LargeField));
+}
+
+uint32_t
+GetLargeCellIndex(_In_ const LargeField* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    if (field->layout == LARGE_LAYOUT_ROWS)
+        return y * field->width + x;
+
+    uint32_t block = (y / LARGE_FIELD_BLOCK_SIDE) * field->blocksX + x / LARGE_FIELD_BLOCK_SIDE;
+
+    uint32_t offset = (y % LARGE_FIELD_BLOCK_SIDE) * LARGE_FIELD_BLOCK_SIDE + x % LARGE_FIELD_BLOCK_SIDE;
+
+    return block * LARGE_FIELD_BLOCK_SIDE * LARGE_FIELD_BLOCK_SIDE + offset;
+}
+
+void
+PlaceLargeFieldMines(_Inout_ LargeField* field, _In_ uint32_t threads)
+{
+    field->revealedCells = 0;
+    field->exploded = false;
+
+    ParallelFor(field->tilesX * field->tilesY, threads, PlaceTileMines, field);
+}
+
+void
+CountLargeFieldNeighbors(_Inout_ LargeField* field, _In_ uint32_t threads)
+{
+    ParallelFor(field->tilesX * field->tilesY, threads, CountTileNeighbors, field);
+}
+
+void
+LabelLargeFieldOpenings(_Inout_ LargeField* field, _In_ uint32_t threads)
+{
+    LabelJob job = {
+        .field = field,
+        .openingCount = 0,
+    };
+
+    uint32_t tileCount = field->tilesX * field->tilesY;
+
+    ParallelFor(tileCount, threads, LabelTileOpenings, &job);
+    ParallelFor(tileCount, threads, MergeTileOpenings, &job);
+    ParallelFor(tileCount, threads, ResolveTileOpenings, &job);
+
+    field->openingCount = (uint64_t)job.openingCount;
+}
+
+void
+GenerateLargeField(_Inout_ LargeField* field, _In_ uint32_t threads)
+{
+    PlaceLargeFieldMines(field, threads);
+    CountLargeFieldNeighbors(field, threads);
+    LabelLargeFieldOpenings(field, threads);
+}
+
+// Counts are computed the first time they are needed unless CountLargeFieldNeighbors has already filled them in.
+static uint8_t
+GetNeighborCount(_In_ const LargeField* field, _In_ uint32_t x, _In_ uint32_t y, _Inout_ uint8_t* cell)
+{
+    if (*cell & LARGE_CELL_COUNTED)
+        return *cell & LARGE_CELL_COUNT_MASK;
+
+    uint8_t count = 0;
+
+    for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= y + 1 && ny < field->height; ny++)
+    {
+        for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= x + 1 && nx < field->width; nx++)
+        {
+            if ((nx != x || ny != y) && (field->cells[GetLargeCellIndex(field, nx, ny)] & LARGE_CELL_MINE))
+                count++;
+        }
+    }
+
+    *cell |= LARGE_CELL_COUNTED | count;
+
+    return count;
+}
+
+uint8_t
+GetLargeNeighborCount(_Inout_ LargeField* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    return GetNeighborCount(field, x, y, &field->cells[GetLargeCellIndex(field, x, y)]);
+}
+
+bool
+RevealLargeCell(_Inout_ LargeField* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    if (x >= field->width || y >= field->height || field->exploded)
+        return true;
+
+    uint8_t* cell = &field->cells[GetLargeCellIndex(field, x, y)];
+
+    if (*cell & LARGE_CELL_REVEALED)
+        return true;
+
+    *cell |= LARGE_CELL_REVEALED;
+
+    if (*cell & LARGE_CELL_MINE)
+    {
+        field->exploded = true;
+        return true;
+    }
+
+    field->revealedCells++;
+
+    if (GetNeighborCount(field, x, y, cell) != 0)
+        return true;
+
+    // Only zero cells are queued, and each one is marked revealed as it is queued so it is never queued twice.
+    uint32_t head = 0;
+    uint32_t count = 0;
+
+    if (field->queueCapacity == 0 && !GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+        return false;
+
+    field->queue[count++] = (uint64_t)y << 32 | x;
+
+    while (count > 0)
+    {
+        uint64_t position = field->queue[head];
+        uint32_t cx = (uint32_t)position;
+        uint32_t cy = (uint32_t)(position >> 32);
+
+        head = (head + 1) & (field->queueCapacity - 1);
+        count--;
+
+        for (uint32_t ny = cy > 0 ? cy - 1 : 0; ny <= cy + 1 && ny < field->height; ny++)
+        {
+            for (uint32_t nx = cx > 0 ? cx - 1 : 0; nx <= cx + 1 && nx < field->width; nx++)
+            {
+                uint8_t* neighbor = &field->cells[GetLargeCellIndex(field, nx, ny)];
+
+                if (*neighbor & (LARGE_CELL_REVEALED | LARGE_CELL_MINE))
+                    continue;
+
+                *neighbor |= LARGE_CELL_REVEALED;
+                field->revealedCells++;
+
+                if (GetNeighborCount(field, nx, ny, neighbor) != 0)
+                    continue;
+
+                if (count == field->queueCapacity)
+                {
+                    if (!GrowRevealQueue(&field->queue, &field->queueCapacity, head, count))
+                        return false;
+
+                    head = 0;
+                }
+
+                field->queue[(head + count) & (field->queueCapacity - 1)] = (uint64_t)ny << 32 | nx;
+                count++;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LARGE_FIELD_TILE_SIDE 256
+#define LARGE_FIELD_BLOCK_SIDE 8
+
+#define LARGE_CELL_COUNT_MASK 0x0F
+#define LARGE_CELL_MINE 0x10
+#define LARGE_CELL_REVEALED 0x20
+#define LARGE_CELL_COUNTED 0x40
+
+#define LARGE_FIELD_NO_OPENING UINT32_MAX
+
+// Rows store the board row after row. Blocks store it as 8x8 squares of 64 contiguous bytes, row after row of
+// squares, so that most vertical neighbours share a cache line instead of lying a whole board width apart.
+typedef enum
+{
+    LARGE_LAYOUT_ROWS,
+    LARGE_LAYOUT_BLOCKS,
+} LargeFieldLayout;
+
+// A board far beyond the window's 100x100 limit, generated in square tiles that are processed independently. Each
+// tile draws its mines from its own random stream and receives a fixed share of the mine count proportional to its
+// area, so the board depends only on the seed and never on how many threads built it.
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint64_t seed;
+    LargeFieldLayout layout;
+    uint32_t blocksX;
+    uint32_t storedCells;
+    uint32_t tilesX;
+    uint32_t tilesY;
+    uint8_t* cells;
+    uint32_t* openings;
+    uint64_t openingCount;
+    uint64_t revealedCells;
+    bool exploded;
+    uint64_t* queue;
+    uint32_t queueCapacity;
+} LargeField;
+
+bool CreateLargeField(
+    _Out_ LargeField* field,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint64_t seed,
+    _In_ LargeFieldLayout layout);
+
+void DestroyLargeField(_Inout_ LargeField* field);
+
+// Where cell (x, y) is kept in cells and openings for the field's layout.
+uint32_t GetLargeCellIndex(_In_ const LargeField* field, _In_ uint32_t x, _In_ uint32_t y);
+
+void PlaceLargeFieldMines(_Inout_ LargeField* field, _In_ uint32_t threads);
+
+// Fills in every neighbour count up front. It can be skipped when only a small part of the board will be explored,
+// since reveals and GetLargeNeighborCount count the cells they touch themselves.
+void CountLargeFieldNeighbors(_Inout_ LargeField* field, _In_ uint32_t threads);
+
+uint8_t GetLargeNeighborCount(_Inout_ LargeField* field, _In_ uint32_t x, _In_ uint32_t y);
+
+// Gives every zero cell the index of the first cell, in storage order, of the zero region it belongs to and leaves
+// the other cells at LARGE_FIELD_NO_OPENING. Needs every neighbour count, so CountLargeFieldNeighbors must run first.
+void LabelLargeFieldOpenings(_Inout_ LargeField* field, _In_ uint32_t threads);
+
+void GenerateLargeField(_Inout_ LargeField* field, _In_ uint32_t threads);
+
+// Reveals a cell and, breadth first, everything a zero cell opens. Fails only when the search queue cannot grow.
+bool RevealLargeCell(_Inout_ LargeField* field, _In_ uint32_t x, _In_ uint32_t y);
@@ -0,0 +1,19 @@
+#include "littleendian.h"
+
+void
+PutLittleEndian(_Out_writes_bytes_(size) uint8_t* bytes, _In_ uint64_t value, _In_ uint32_t size)
+{
+    for (uint32_t i = 0; i < size; i++)
+        bytes[i] = (uint8_t)(value >> (i * 8));
+}
+
+uint64_t
+GetLittleEndian(_In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    uint64_t value = 0;
+
+    for (uint32_t i = 0; i < size; i++)
+        value |= (uint64_t)bytes[i] << (i * 8);
+
+    return value;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdint.h>
+
+// The files the game writes keep every number little-endian in the given number of bytes, whatever the machine.
+void PutLittleEndian(_Out_writes_bytes_(size) uint8_t* bytes, _In_ uint64_t value, _In_ uint32_t size);
+
+uint64_t GetLittleEndian(_In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size);
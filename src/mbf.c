@@ -0,0 +1,71 @@
+#include "pch.h"
+
+#include "mbf.h"
+
+bool
+LoadMbfBoard(_Out_ Minefield* field, _In_reads_bytes_(size) const uint8_t* bytes, _In_ size_t size)
+{
+    if (size < MBF_HEADER_SIZE)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    uint32_t width = bytes[0];
+    uint32_t height = bytes[1];
+    uint32_t mines = (uint32_t)bytes[2] << 8 | bytes[3];
+
+    if (size != MBF_HEADER_SIZE + (size_t)mines * 2 || !CreateSizedMinefield(field, width, height, mines))
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    bool layout[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+
+    ZeroMemory(layout, sizeof(bool) * width * height);
+
+    for (uint32_t i = 0; i < mines; i++)
+    {
+        uint32_t x = bytes[MBF_HEADER_SIZE + i * 2];
+        uint32_t y = bytes[MBF_HEADER_SIZE + i * 2 + 1];
+
+        if (x >= width || y >= height || layout[y * width + x])
+        {
+            SetLastError(ERROR_BAD_FORMAT);
+            return false;
+        }
+
+        layout[y * width + x] = true;
+    }
+
+    return SetMinefieldLayout(field, layout);
+}
+
+uint32_t
+SaveMbfBoard(_In_ const Minefield* field, _Out_writes_bytes_(MBF_MAX_SIZE) uint8_t* buffer)
+{
+    uint32_t size = MBF_HEADER_SIZE;
+
+    if (!field->minesPlaced)
+        return 0;
+
+    buffer[0] = (uint8_t)field->width;
+    buffer[1] = (uint8_t)field->height;
+    buffer[2] = (uint8_t)(field->totalMines >> 8);
+    buffer[3] = (uint8_t)field->totalMines;
+
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+        {
+            if (!field->cells[y * field->width + x].hasMine)
+                continue;
+
+            buffer[size++] = (uint8_t)x;
+            buffer[size++] = (uint8_t)y;
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define MBF_HEADER_SIZE 4
+#define MBF_MAX_SIZE (MBF_HEADER_SIZE + 2 * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY)
+
+// An MBF board is a byte each for width and height, a big-endian 16-bit mine count, then a column and row byte for
+// every mine. The board is loaded through SetMinefieldLayout, so the first click no longer places mines.
+bool LoadMbfBoard(_Out_ Minefield* field, _In_reads_bytes_(size) const uint8_t* bytes, _In_ size_t size);
+
+// Returns the size written, or zero when the mines have not been placed yet.
+uint32_t SaveMbfBoard(_In_ const Minefield* field, _Out_writes_bytes_(MBF_MAX_SIZE) uint8_t* buffer);
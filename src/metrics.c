@@ -0,0 +1,548 @@
+#include "pch.h"
+
+#include "metrics.h"
+
+#define METRICS_COUNT_MASK 0x0F
+#define METRICS_MINE 0x10
+#define METRICS_BORDER 0x20
+#define METRICS_DIRTY 0x40
+
+#define METRICS_HIDDEN 0
+#define METRICS_REVEALED 1
+#define METRICS_FLAGGED 2
+
+#define METRICS_NO_UNIT UINT32_MAX
+#define METRICS_MAX_PREMIUM 9
+
+typedef struct
+{
+    MetricsWorkspace* workspace;
+    int32_t offsets[8];
+    uint32_t heads[METRICS_MAX_PREMIUM + 1];
+    uint32_t dirtyCount;
+    uint32_t clicks;
+} ZiniSearch;
+
+static uint32_t
+FindRoot(_Inout_ uint32_t* parent, _In_ uint32_t index)
+{
+    while (parent[index] != index)
+    {
+        parent[index] = parent[parent[index]];
+        index = parent[index];
+    }
+
+    return index;
+}
+
+static void
+MarkMines(
+    _Inout_ MetricsWorkspace* workspace,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_reads_(width* height) const bool* mines,
+    _In_reads_(8) const int32_t* offsets)
+{
+    uint32_t stride = width + 2;
+    uint32_t padded = stride * (height + 2);
+    uint8_t* cells = workspace->cells;
+
+    ZeroMemory(cells, padded);
+
+    for (uint32_t x = 0; x < stride; x++)
+    {
+        cells[x] = METRICS_BORDER;
+        cells[padded - stride + x] = METRICS_BORDER;
+    }
+
+    for (uint32_t y = 1; y <= height; y++)
+    {
+        cells[y * stride] = METRICS_BORDER;
+        cells[y * stride + width + 1] = METRICS_BORDER;
+    }
+
+    // Border cells count at most three mines, so their counts never reach the flag bits.
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            if (!mines[y * width + x])
+                continue;
+
+            uint32_t index = (y + 1) * stride + x + 1;
+            cells[index] |= METRICS_MINE;
+
+            for (uint32_t k = 0; k < 8; k++)
+                cells[index + offsets[k]]++;
+        }
+    }
+}
+
+// Labels every zero cell with the root of its opening in a single raster pass. Only the neighbours already visited,
+// left and in the row above, need to be joined, since the rest will join this cell when they are visited.
+static uint32_t
+LabelOpenings(_Inout_ MetricsWorkspace* workspace, _In_ uint32_t width, _In_ uint32_t height)
+{
+    uint32_t stride = width + 2;
+    const uint8_t* cells = workspace->cells;
+    uint32_t* parent = workspace->parent;
+    int32_t visited[4] = {-1, -(int32_t)stride - 1, -(int32_t)stride, -(int32_t)stride + 1};
+    uint32_t zeros = 0;
+    uint32_t unions = 0;
+
+    for (uint32_t y = 1; y <= height; y++)
+    {
+        for (uint32_t x = 1; x <= width; x++)
+        {
+            uint32_t index = y * stride + x;
+
+            if (cells[index] != 0)
+                continue;
+
+            parent[index] = index;
+            zeros++;
+
+            for (uint32_t k = 0; k < 4; k++)
+            {
+                uint32_t neighbor = index + visited[k];
+
+                if (cells[neighbor] != 0)
+                    continue;
+
+                uint32_t a = FindRoot(parent, index);
+                uint32_t b = FindRoot(parent, neighbor);
+
+                if (a != b)
+                {
+                    parent[max(a, b)] = min(a, b);
+                    unions++;
+                }
+            }
+        }
+    }
+
+    return zeros - unions;
+}
+
+// Gives every safe cell the unit a click on it clears: its opening for zero cells, itself for numbers that border no
+// opening, and none for numbers that are cleared along with an opening anyway.
+static uint32_t
+AssignUnits(
+    _Inout_ MetricsWorkspace* workspace,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_reads_(8) const int32_t* offsets)
+{
+    uint32_t stride = width + 2;
+    const uint8_t* cells = workspace->cells;
+    uint32_t* parent = workspace->parent;
+    uint32_t islands = 0;
+
+    for (uint32_t y = 1; y <= height; y++)
+    {
+        for (uint32_t x = 1; x <= width; x++)
+        {
+            uint32_t index = y * stride + x;
+
+            if (cells[index] == 0)
+            {
+                parent[index] = FindRoot(parent, index);
+                continue;
+            }
+
+            parent[index] = METRICS_NO_UNIT;
+
+            if (cells[index] & METRICS_MINE)
+                continue;
+
+            bool bordersOpening = false;
+
+            for (uint32_t k = 0; k < 8 && !bordersOpening; k++)
+                bordersOpening = cells[index + offsets[k]] == 0;
+
+            if (!bordersOpening)
+            {
+                parent[index] = index;
+                islands++;
+            }
+        }
+    }
+
+    return islands;
+}
+
+// Clicks a chord on this number saves: the hidden units it would clear, less a click to reveal it, one per flag still
+// to place and one for the chord itself.
+static int32_t
+ComputePremium(_In_ const ZiniSearch* search, _In_ uint32_t index)
+{
+    const MetricsWorkspace* workspace = search->workspace;
+    uint32_t units[9];
+    uint32_t unitCount = 0;
+    int32_t cost = 1;
+
+    if (workspace->state[index] == METRICS_HIDDEN)
+    {
+        cost++;
+
+        if (workspace->parent[index] != METRICS_NO_UNIT)
+            units[unitCount++] = workspace->parent[index];
+    }
+
+    for (uint32_t k = 0; k < 8; k++)
+    {
+        uint32_t neighbor = index + search->offsets[k];
+        uint8_t cell = workspace->cells[neighbor];
+
+        if (cell & METRICS_MINE)
+        {
+            cost += workspace->state[neighbor] != METRICS_FLAGGED;
+            continue;
+        }
+
+        if ((cell & METRICS_BORDER) || workspace->state[neighbor] != METRICS_HIDDEN ||
+            workspace->parent[neighbor] == METRICS_NO_UNIT)
+        {
+            continue;
+        }
+
+        uint32_t unit = workspace->parent[neighbor];
+        bool seen = false;
+
+        for (uint32_t i = 0; i < unitCount && !seen; i++)
+            seen = units[i] == unit;
+
+        if (!seen)
+            units[unitCount++] = unit;
+    }
+
+    return (int32_t)unitCount - cost;
+}
+
+static void
+RefreshPremium(_Inout_ ZiniSearch* search, _In_ uint32_t index)
+{
+    MetricsWorkspace* workspace = search->workspace;
+    uint8_t cell = workspace->cells[index];
+
+    if ((cell & (METRICS_MINE | METRICS_BORDER)) || (cell & METRICS_COUNT_MASK) == 0)
+        return;
+
+    int32_t premium = ComputePremium(search, index);
+    int32_t previous = workspace->premium[index];
+
+    if (premium == previous)
+        return;
+
+    // Numbers worth chording sit in one intrusive list per premium, so the best is found without a scan.
+    if (previous > 0)
+    {
+        uint32_t before = workspace->previous[index];
+        uint32_t after = workspace->next[index];
+
+        if (before != METRICS_NO_UNIT)
+            workspace->next[before] = after;
+        else
+            search->heads[previous] = after;
+
+        if (after != METRICS_NO_UNIT)
+            workspace->previous[after] = before;
+    }
+
+    workspace->premium[index] = (int8_t)premium;
+
+    if (premium > 0)
+    {
+        uint32_t head = search->heads[premium];
+
+        workspace->previous[index] = METRICS_NO_UNIT;
+        workspace->next[index] = head;
+
+        if (head != METRICS_NO_UNIT)
+            workspace->previous[head] = index;
+
+        search->heads[premium] = index;
+    }
+}
+
+// Numbers next to a changed cell are queued once and refreshed together after the move, since an opening revealed by
+// a chord would otherwise refresh most of its border several times over.
+static void
+MarkDirtyAround(_Inout_ ZiniSearch* search, _In_ uint32_t index)
+{
+    MetricsWorkspace* workspace = search->workspace;
+
+    for (int32_t k = -1; k < 8; k++)
+    {
+        uint32_t neighbor = k < 0 ? index : index + search->offsets[k];
+        uint8_t cell = workspace->cells[neighbor];
+
+        if ((cell & (METRICS_MINE | METRICS_BORDER | METRICS_DIRTY)) || (cell & METRICS_COUNT_MASK) == 0)
+            continue;
+
+        workspace->cells[neighbor] = cell | METRICS_DIRTY;
+        workspace->dirty[search->dirtyCount++] = neighbor;
+    }
+}
+
+static void
+RefreshDirty(_Inout_ ZiniSearch* search)
+{
+    MetricsWorkspace* workspace = search->workspace;
+
+    for (uint32_t i = 0; i < search->dirtyCount; i++)
+    {
+        uint32_t index = workspace->dirty[i];
+
+        workspace->cells[index] &= (uint8_t)~METRICS_DIRTY;
+        RefreshPremium(search, index);
+    }
+
+    search->dirtyCount = 0;
+}
+
+static void
+RevealFrom(_Inout_ ZiniSearch* search, _In_ uint32_t start)
+{
+    MetricsWorkspace* workspace = search->workspace;
+    uint32_t top = 0;
+
+    if (workspace->state[start] != METRICS_HIDDEN || (workspace->cells[start] & (METRICS_MINE | METRICS_BORDER)))
+        return;
+
+    // Cells are marked when pushed, so none is pushed twice and the stack never outgrows the board.
+    workspace->state[start] = METRICS_REVEALED;
+    workspace->stack[top++] = start;
+
+    while (top > 0)
+    {
+        uint32_t index = workspace->stack[--top];
+
+        MarkDirtyAround(search, index);
+
+        if (workspace->cells[index] != 0)
+            continue;
+
+        for (uint32_t k = 0; k < 8; k++)
+        {
+            uint32_t neighbor = index + search->offsets[k];
+
+            if (workspace->state[neighbor] != METRICS_HIDDEN ||
+                (workspace->cells[neighbor] & (METRICS_MINE | METRICS_BORDER)))
+            {
+                continue;
+            }
+
+            workspace->state[neighbor] = METRICS_REVEALED;
+            workspace->stack[top++] = neighbor;
+        }
+    }
+}
+
+static void
+ChordBestNumber(_Inout_ ZiniSearch* search, _In_ uint32_t index)
+{
+    MetricsWorkspace* workspace = search->workspace;
+
+    if (workspace->state[index] == METRICS_HIDDEN)
+    {
+        search->clicks++;
+        RevealFrom(search, index);
+    }
+
+    for (uint32_t k = 0; k < 8; k++)
+    {
+        uint32_t neighbor = index + search->offsets[k];
+
+        if ((workspace->cells[neighbor] & METRICS_MINE) && workspace->state[neighbor] != METRICS_FLAGGED)
+        {
+            workspace->state[neighbor] = METRICS_FLAGGED;
+            search->clicks++;
+            MarkDirtyAround(search, neighbor);
+        }
+    }
+
+    search->clicks++;
+
+    for (uint32_t k = 0; k < 8; k++)
+        RevealFrom(search, index + search->offsets[k]);
+
+    RefreshDirty(search);
+}
+
+static uint32_t
+EstimateZini(
+    _Inout_ MetricsWorkspace* workspace,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_reads_(8) const int32_t* offsets)
+{
+    uint32_t stride = width + 2;
+    uint32_t padded = stride * (height + 2);
+
+    ZiniSearch search = {
+        .workspace = workspace,
+        .dirtyCount = 0,
+        .clicks = 0,
+    };
+
+    CopyMemory(search.offsets, offsets, sizeof(search.offsets));
+
+    for (uint32_t i = 0; i <= METRICS_MAX_PREMIUM; i++)
+        search.heads[i] = METRICS_NO_UNIT;
+
+    ZeroMemory(workspace->state, padded);
+    ZeroMemory(workspace->premium, padded);
+
+    for (uint32_t y = 1; y <= height; y++)
+    {
+        for (uint32_t x = 1; x <= width; x++)
+            RefreshPremium(&search, y * stride + x);
+    }
+
+    for (;;)
+    {
+        int32_t best = METRICS_MAX_PREMIUM;
+
+        while (best > 0 && search.heads[best] == METRICS_NO_UNIT)
+            best--;
+
+        if (best == 0)
+            break;
+
+        ChordBestNumber(&search, search.heads[best]);
+    }
+
+    // Whatever no chord paid for is cleared with one click per remaining unit.
+    for (uint32_t y = 1; y <= height; y++)
+    {
+        for (uint32_t x = 1; x <= width; x++)
+        {
+            uint32_t index = y * stride + x;
+
+            if (workspace->state[index] == METRICS_HIDDEN && workspace->parent[index] == index)
+                search.clicks++;
+        }
+    }
+
+    return search.clicks;
+}
+
+bool
+CreateMetricsWorkspace(_Out_ MetricsWorkspace* workspace, _In_ uint32_t width, _In_ uint32_t height)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint64_t padded = (uint64_t)(width + 2) * (height + 2);
+
+    ZeroMemory(workspace, sizeof(MetricsWorkspace));
+
+    if (width == 0 || height == 0 || padded > UINT32_MAX / sizeof(uint32_t))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    workspace->capacity = (uint32_t)padded;
+    workspace->cells = HeapAlloc(hHeap, 0, workspace->capacity);
+    workspace->state = HeapAlloc(hHeap, 0, workspace->capacity);
+    workspace->premium = HeapAlloc(hHeap, 0, workspace->capacity);
+    workspace->parent = HeapAlloc(hHeap, 0, sizeof(uint32_t) * workspace->capacity);
+    workspace->next = HeapAlloc(hHeap, 0, sizeof(uint32_t) * workspace->capacity);
+    workspace->previous = HeapAlloc(hHeap, 0, sizeof(uint32_t) * workspace->capacity);
+    workspace->stack = HeapAlloc(hHeap, 0, sizeof(uint32_t) * workspace->capacity);
+    workspace->dirty = HeapAlloc(hHeap, 0, sizeof(uint32_t) * workspace->capacity);
+
+    if (workspace->cells == NULL || workspace->state == NULL || workspace->premium == NULL ||
+        workspace->parent == NULL || workspace->next == NULL || workspace->previous == NULL ||
+        workspace->stack == NULL || workspace->dirty == NULL)
+    {
+        DestroyMetricsWorkspace(workspace);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DestroyMetricsWorkspace(_Inout_ MetricsWorkspace* workspace)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    HeapFree(hHeap, 0, workspace->cells);
+    HeapFree(hHeap, 0, workspace->state);
+    HeapFree(hHeap, 0, workspace->premium);
+    HeapFree(hHeap, 0, workspace->parent);
+    HeapFree(hHeap, 0, workspace->next);
+    HeapFree(hHeap, 0, workspace->previous);
+    HeapFree(hHeap, 0, workspace->stack);
+    HeapFree(hHeap, 0, workspace->dirty);
+
+    ZeroMemory(workspace, sizeof(MetricsWorkspace));
+}
+
+bool
+ComputeBoardMetrics(
+    _Inout_ MetricsWorkspace* workspace,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_reads_(width* height) const bool* mines,
+    _In_ bool estimateZini,
+    _Out_ BoardMetrics* metrics)
+{
+    ZeroMemory(metrics, sizeof(BoardMetrics));
+
+    if (width == 0 || height == 0 || (uint64_t)(width + 2) * (height + 2) > workspace->capacity)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    int32_t stride = (int32_t)width + 2;
+    int32_t offsets[8] = {-stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1};
+
+    MarkMines(workspace, width, height, mines, offsets);
+
+    metrics->openings = LabelOpenings(workspace, width, height);
+    metrics->islands = AssignUnits(workspace, width, height, offsets);
+    metrics->bbbv = metrics->openings + metrics->islands;
+
+    if (estimateZini)
+        metrics->zini = EstimateZini(workspace, width, height, offsets);
+
+    return true;
+}
+
+bool
+ComputeMinefieldMetrics(_In_ const Minefield* field, _Out_ BoardMetrics* metrics)
+{
+    ZeroMemory(metrics, sizeof(BoardMetrics));
+
+    if (!field->minesPlaced)
+    {
+        SetLastError(ERROR_INVALID_STATE);
+        return false;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t cellCount = field->width * field->height;
+    bool* mines = HeapAlloc(hHeap, 0, sizeof(bool) * cellCount);
+    MetricsWorkspace workspace;
+
+    if (mines == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        mines[i] = field->cells[i].hasMine;
+
+    bool success = CreateMetricsWorkspace(&workspace, field->width, field->height) &&
+                   ComputeBoardMetrics(&workspace, field->width, field->height, mines, true, metrics);
+
+    DestroyMetricsWorkspace(&workspace);
+    HeapFree(hHeap, 0, mines);
+
+    return success;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+typedef struct
+{
+    uint32_t bbbv;
+    uint32_t openings;
+    uint32_t islands;
+    uint32_t zini;
+} BoardMetrics;
+
+// Scratch space for scoring boards, padded with a ring of border cells so neighbour walks need no bounds checks.
+// One workspace serves any number of boards up to the size it was created for, but only one thread at a time.
+typedef struct
+{
+    uint32_t capacity;
+    uint8_t* cells;
+    uint8_t* state;
+    int8_t* premium;
+    uint32_t* parent;
+    uint32_t* next;
+    uint32_t* previous;
+    uint32_t* stack;
+    uint32_t* dirty;
+} MetricsWorkspace;
+
+bool CreateMetricsWorkspace(_Out_ MetricsWorkspace* workspace, _In_ uint32_t width, _In_ uint32_t height);
+
+void DestroyMetricsWorkspace(_Inout_ MetricsWorkspace* workspace);
+
+// 3BV is the number of openings plus the numbered cells that border none; it is the fewest clicks that clear the
+// board without flags. ZiNi, the fewest clicks when flagging and chording, is estimated greedily by always chording
+// the number that saves the most clicks, and is left at zero unless estimateZini is set.
+bool ComputeBoardMetrics(
+    _Inout_ MetricsWorkspace* workspace,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_reads_(width* height) const bool* mines,
+    _In_ bool estimateZini,
+    _Out_ BoardMetrics* metrics);
+
+bool ComputeMinefieldMetrics(_In_ const Minefield* field, _Out_ BoardMetrics* metrics);
@@ -0,0 +1,440 @@
+#include "pch.h"
+
+#include "noguess.h"
+#include "parallel.h"
+#include "random.h"
+#include "solver.h"
+#include "solvercache.h"
+
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mines;
+    uint32_t firstX;
+    uint32_t firstY;
+    uint64_t seed;
+    bool* layout;
+    SolverCache* cache;
+    SRWLOCK lock;
+    volatile LONG64 nextCandidate;
+    volatile LONG64 winner;
+    volatile LONG64 candidates;
+    volatile LONG64 repairs;
+    volatile LONG64 solves;
+} Generator;
+
+typedef struct
+{
+    Generator* generator;
+    Minefield* field;
+    Frontier* frontier;
+    SolverResult* result;
+    bool* mines;
+    struct splitmix64_state random;
+    uint64_t candidate;
+    uint32_t repairs;
+} Attempt;
+
+static uint32_t
+RandomBelow(_Inout_ struct splitmix64_state* random, _In_ uint32_t bound)
+{
+    return (uint32_t)(((splitmix64(random) >> 32) * bound) >> 32);
+}
+
+static bool
+IsAbandoned(_In_ const Attempt* attempt)
+{
+    return attempt->candidate > (uint64_t)attempt->generator->winner;
+}
+
+static bool
+IsOpeningCell(_In_ const Generator* generator, _In_ uint32_t x, _In_ uint32_t y)
+{
+    return x + 1 >= generator->firstX && x <= generator->firstX + 1 && y + 1 >= generator->firstY &&
+           y <= generator->firstY + 1;
+}
+
+static bool
+HasRevealedNeighbor(_In_ const Minefield* field, _In_ uint32_t x, _In_ uint32_t y)
+{
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            const Cell* neighbor = GetCell(field, (uint32_t)((int32_t)x + dx), (uint32_t)((int32_t)y + dy));
+
+            if ((dx != 0 || dy != 0) && neighbor != NULL && neighbor->state == CELL_REVEALED)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+static void
+PlaceCandidateMines(_Inout_ Attempt* attempt)
+{
+    const Generator* generator = attempt->generator;
+    uint32_t cellCount = generator->width * generator->height;
+    uint32_t openingCells = 0;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        openingCells += IsOpeningCell(generator, i % generator->width, i / generator->width) ? 1 : 0;
+
+    // Keep the first click on an opening whenever the board has room for one.
+    bool keepOpening = generator->mines <= cellCount - openingCells;
+    uint32_t placed = 0;
+
+    ZeroMemory(attempt->mines, sizeof(bool) * cellCount);
+
+    while (placed < generator->mines)
+    {
+        uint32_t index = RandomBelow(&attempt->random, cellCount);
+        uint32_t x = index % generator->width;
+        uint32_t y = index / generator->width;
+
+        if (attempt->mines[index] || (x == generator->firstX && y == generator->firstY) ||
+            (keepOpening && IsOpeningCell(generator, x, y)))
+        {
+            continue;
+        }
+
+        attempt->mines[index] = true;
+        placed++;
+    }
+}
+
+static void
+AdjustNeighborCounts(_Inout_ Minefield* field, _In_ uint32_t x, _In_ uint32_t y, _In_ bool addMine)
+{
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            int32_t nx = (int32_t)x + dx;
+            int32_t ny = (int32_t)y + dy;
+
+            if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= (int32_t)field->width || ny >= (int32_t)field->height)
+                continue;
+
+            Cell* neighbor = &field->cells[ny * (int32_t)field->width + nx];
+
+            if (neighbor->hasMine)
+                continue;
+
+            if (addMine)
+                neighbor->neighborMines++;
+            else
+                neighbor->neighborMines--;
+        }
+    }
+}
+
+// Moves a random mine off the frontier, preferably into a cell no revealed number can see, then lets any number that
+// dropped to zero open its neighbors. Cells already revealed stay safe, so the game continues from where the solver got
+// stuck. Near the end of a game there may be no such cell left, and the mine goes to another hidden safe cell instead.
+static bool
+RepairLayout(_Inout_ Attempt* attempt)
+{
+    Minefield* field = attempt->field;
+    uint32_t cellCount = field->width * field->height;
+    uint32_t frontierMines = 0;
+    uint32_t interiorCells = 0;
+    uint32_t safeCells = 0;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        const Cell* cell = &field->cells[i];
+
+        if (cell->state != CELL_HIDDEN)
+            continue;
+
+        bool frontier = HasRevealedNeighbor(field, i % field->width, i / field->width);
+
+        frontierMines += frontier && cell->hasMine ? 1 : 0;
+        interiorCells += !frontier && !cell->hasMine ? 1 : 0;
+        safeCells += !cell->hasMine ? 1 : 0;
+    }
+
+    if (frontierMines == 0 || safeCells == 0)
+        return false;
+
+    bool interior = interiorCells > 0;
+    uint32_t pickMine = RandomBelow(&attempt->random, frontierMines);
+    uint32_t pickCell = RandomBelow(&attempt->random, interior ? interiorCells : safeCells);
+    uint32_t from = UINT32_MAX;
+    uint32_t to = UINT32_MAX;
+
+    for (uint32_t i = 0; i < cellCount && (from == UINT32_MAX || to == UINT32_MAX); i++)
+    {
+        const Cell* cell = &field->cells[i];
+
+        if (cell->state != CELL_HIDDEN)
+            continue;
+
+        bool frontier = HasRevealedNeighbor(field, i % field->width, i / field->width);
+
+        if (frontier && cell->hasMine && pickMine-- == 0)
+            from = i;
+        else if (!cell->hasMine && (!interior || !frontier) && pickCell-- == 0)
+            to = i;
+    }
+
+    uint32_t fromX = from % field->width;
+    uint32_t fromY = from / field->width;
+
+    field->cells[from].hasMine = false;
+    field->cells[to].hasMine = true;
+    attempt->mines[from] = false;
+    attempt->mines[to] = true;
+
+    AdjustNeighborCounts(field, fromX, fromY, false);
+    AdjustNeighborCounts(field, to % field->width, to / field->width, true);
+
+    uint8_t count = 0;
+
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            const Cell* neighbor = GetCell(field, (uint32_t)((int32_t)fromX + dx), (uint32_t)((int32_t)fromY + dy));
+
+            if ((dx != 0 || dy != 0) && neighbor != NULL && neighbor->hasMine)
+                count++;
+        }
+    }
+
+    field->cells[from].neighborMines = count;
+    IndexOpenings(field);
+
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            uint32_t nx = (uint32_t)((int32_t)fromX + dx);
+            uint32_t ny = (uint32_t)((int32_t)fromY + dy);
+            const Cell* neighbor = GetCell(field, nx, ny);
+
+            if (neighbor == NULL || neighbor->state != CELL_REVEALED || neighbor->neighborMines != 0)
+                continue;
+
+            for (int32_t oy = -1; oy <= 1; oy++)
+            {
+                for (int32_t ox = -1; ox <= 1; ox++)
+                    RevealCell(field, (uint32_t)((int32_t)nx + ox), (uint32_t)((int32_t)ny + oy));
+            }
+        }
+    }
+
+    return true;
+}
+
+// Components too large to enumerate are left unknown rather than sampled. A probability of exactly 0 or 1 elsewhere
+// still holds in every consistent layout, so every deduction made here is one a player could make.
+static bool
+Solve(_Inout_ Attempt* attempt)
+{
+    const Minefield* field = attempt->field;
+    Frontier* frontier = attempt->frontier;
+    SolverResult* result = attempt->result;
+
+    InterlockedIncrement64(&attempt->generator->solves);
+
+    if (!BuildFrontier(field, frontier) || !SolveFrontier(frontier, attempt->generator->cache, result))
+        return false;
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+    {
+        if (field->cells[i].state == CELL_HIDDEN && frontier->cellVariable[i] == SOLVER_NO_VARIABLE)
+            result->probability[i] = result->unconstrainedProbability;
+    }
+
+    return true;
+}
+
+static bool
+PlayWithoutGuessing(_Inout_ Attempt* attempt, _Out_ uint32_t* repairs)
+{
+    Generator* generator = attempt->generator;
+    Minefield* field = attempt->field;
+
+    *repairs = 0;
+
+    if (!CreateCustomMinefield(field, generator->width, generator->height, generator->mines) ||
+        !SetMinefieldLayout(field, attempt->mines) || !RevealCell(field, generator->firstX, generator->firstY))
+    {
+        return false;
+    }
+
+    while (field->state == GAME_PLAYING)
+    {
+        if (IsAbandoned(attempt))
+            return false;
+
+        if (!Solve(attempt))
+            return false;
+
+        bool progress = false;
+
+        for (uint32_t i = 0; i < field->width * field->height && field->state == GAME_PLAYING; i++)
+        {
+            double p = attempt->result->probability[i];
+
+            if (field->cells[i].state != CELL_HIDDEN)
+                continue;
+
+            if (p == 0.0)
+                progress |= RevealCell(field, i % field->width, i / field->width);
+            else if (p == 1.0)
+                progress |= ToggleFlag(field, i % field->width, i / field->width);
+        }
+
+        if (progress)
+            continue;
+
+        if (attempt->repairs >= NOGUESS_MAX_REPAIRS || !RepairLayout(attempt))
+            return false;
+
+        attempt->repairs++;
+        (*repairs)++;
+        InterlockedIncrement64(&generator->repairs);
+    }
+
+    return field->state == GAME_WON;
+}
+
+// A repair changes numbers the solver has already used, so a repaired layout is replayed from the first click until
+// a pass clears it without needing any repair.
+static bool
+TryCandidate(_Inout_ Attempt* attempt)
+{
+    uint32_t repairs;
+
+    PlaceCandidateMines(attempt);
+    attempt->repairs = 0;
+
+    do
+    {
+        if (!PlayWithoutGuessing(attempt, &repairs))
+            return false;
+    } while (repairs > 0);
+
+    return true;
+}
+
+static void
+RunGenerator(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    UNREFERENCED_PARAMETER(index);
+
+    Generator* generator = (Generator*)context;
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t cellCount = generator->width * generator->height;
+
+    Attempt attempt = {
+        .generator = generator,
+        .field = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .frontier = HeapAlloc(hHeap, 0, sizeof(Frontier)),
+        .result = HeapAlloc(hHeap, 0, sizeof(SolverResult)),
+        .mines = HeapAlloc(hHeap, 0, sizeof(bool) * cellCount),
+    };
+
+    if (attempt.field != NULL && attempt.frontier != NULL && attempt.result != NULL && attempt.mines != NULL)
+    {
+        for (;;)
+        {
+            attempt.candidate = (uint64_t)InterlockedIncrement64(&generator->nextCandidate) - 1;
+
+            if (attempt.candidate >= NOGUESS_MAX_CANDIDATES || IsAbandoned(&attempt))
+                break;
+
+            attempt.random.s = mix64(generator->seed + attempt.candidate);
+            InterlockedIncrement64(&generator->candidates);
+
+            if (!TryCandidate(&attempt))
+                continue;
+
+            AcquireSRWLockExclusive(&generator->lock);
+
+            if (attempt.candidate < (uint64_t)generator->winner)
+            {
+                CopyMemory(generator->layout, attempt.mines, sizeof(bool) * cellCount);
+                generator->winner = (LONG64)attempt.candidate;
+            }
+
+            ReleaseSRWLockExclusive(&generator->lock);
+        }
+    }
+
+    HeapFree(hHeap, 0, attempt.field);
+    HeapFree(hHeap, 0, attempt.frontier);
+    HeapFree(hHeap, 0, attempt.result);
+    HeapFree(hHeap, 0, attempt.mines);
+}
+
+bool
+GenerateNoGuessLayout(
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t firstX,
+    _In_ uint32_t firstY,
+    _In_ uint64_t seed,
+    _In_ uint32_t threads,
+    _Out_writes_(width* height) bool* layout,
+    _Out_opt_ NoGuessStats* stats)
+{
+    if (stats != NULL)
+        ZeroMemory(stats, sizeof(NoGuessStats));
+
+    if (width == 0 || height == 0 || width > MAX_CELLS_HORIZONTALLY || height > MAX_CELLS_VERTICALLY ||
+        mines >= width * height || firstX >= width || firstY >= height)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    SolverCache cache;
+
+    Generator generator = {
+        .width = width,
+        .height = height,
+        .mines = mines,
+        .firstX = firstX,
+        .firstY = firstY,
+        .seed = seed,
+        .layout = layout,
+        .cache = &cache,
+        .lock = SRWLOCK_INIT,
+        .nextCandidate = 0,
+        .winner = INT64_MAX,
+    };
+
+    if (!CreateSolverCache(&cache, SOLVER_CACHE_DEFAULT_ENTRIES))
+        generator.cache = NULL;
+
+    if (threads == 0)
+        threads = GetParallelThreadCount();
+
+    ParallelFor(threads, threads, RunGenerator, &generator);
+
+    if (generator.cache != NULL)
+        DestroySolverCache(&cache);
+
+    if (stats != NULL)
+    {
+        stats->candidates = (uint64_t)generator.candidates;
+        stats->repairs = (uint64_t)generator.repairs;
+        stats->solves = (uint64_t)generator.solves;
+        stats->winningCandidate = (uint64_t)generator.winner;
+    }
+
+    if (generator.winner == INT64_MAX)
+    {
+        SetLastError(ERROR_RETRY);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+// Layouts abandoned before giving up, and mines moved off the frontier before a layout is abandoned.
+#define NOGUESS_MAX_CANDIDATES 4096
+#define NOGUESS_MAX_REPAIRS 64
+
+typedef struct
+{
+    uint64_t candidates;
+    uint64_t repairs;
+    uint64_t solves;
+    uint64_t winningCandidate;
+} NoGuessStats;
+
+// Produces a layout that the solver clears from (firstX, firstY) without guessing. Candidates are tried on all
+// threads at once; the lowest-numbered one that succeeds is returned, so the layout depends only on the seed.
+bool GenerateNoGuessLayout(
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint32_t firstX,
+    _In_ uint32_t firstY,
+    _In_ uint64_t seed,
+    _In_ uint32_t threads,
+    _Out_writes_(width* height) bool* layout,
+    _Out_opt_ NoGuessStats* stats);
@@ -0,0 +1,77 @@
+#include "pch.h"
+
+#include "parallel.h"
+
+typedef struct
+{
+    ParallelTask task;
+    void* context;
+    uint32_t count;
+    volatile LONG next;
+} ParallelJob;
+
+static void
+RunParallelJob(_Inout_ ParallelJob* job)
+{
+    for (;;)
+    {
+        uint32_t index = (uint32_t)InterlockedIncrement(&job->next) - 1;
+
+        if (index >= job->count)
+            break;
+
+        job->task(job->context, index);
+    }
+}
+
+static DWORD WINAPI
+ParallelWorker(_In_ LPVOID parameter)
+{
+    RunParallelJob((ParallelJob*)parameter);
+    return 0;
+}
+
+uint32_t
+GetParallelThreadCount(void)
+{
+    DWORD processors = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+
+    return max(1u, min((uint32_t)processors, (uint32_t)PARALLEL_MAX_THREADS));
+}
+
+void
+ParallelFor(_In_ uint32_t count, _In_ uint32_t threads, _In_ ParallelTask task, _Inout_opt_ void* context)
+{
+    ParallelJob job = {
+        .task = task,
+        .context = context,
+        .count = count,
+        .next = 0,
+    };
+
+    if (threads == 0)
+        threads = GetParallelThreadCount();
+
+    threads = min(min(threads, count), (uint32_t)PARALLEL_MAX_THREADS);
+
+    HANDLE workers[PARALLEL_MAX_THREADS];
+    uint32_t started = 0;
+
+    for (uint32_t i = 1; i < threads; i++)
+    {
+        workers[started] = CreateThread(NULL, 0, ParallelWorker, &job, 0, NULL);
+
+        if (workers[started] == NULL)
+            break;
+
+        started++;
+    }
+
+    RunParallelJob(&job);
+
+    for (uint32_t i = 0; i < started; i++)
+    {
+        WaitForSingleObject(workers[i], INFINITE);
+        CloseHandle(workers[i]);
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PARALLEL_MAX_THREADS 64
+
+typedef void (*ParallelTask)(_Inout_opt_ void* context, _In_ uint32_t index);
+
+uint32_t GetParallelThreadCount(void);
+
+void ParallelFor(_In_ uint32_t count, _In_ uint32_t threads, _In_ ParallelTask task, _Inout_opt_ void* context);
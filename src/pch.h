@@ -7,6 +7,7 @@
 
 #include <Windows.h>
 #include <Windowsx.h>
+#include <commdlg.h>
 #include <dwmapi.h>
 
 #include <stdbool.h>
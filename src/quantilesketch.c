@@ -0,0 +1,73 @@
+#include <math.h>
+
+#include "quantilesketch.h"
+
+// gamma = (1 + QUANTILE_SKETCH_ACCURACY) / (1 - QUANTILE_SKETCH_ACCURACY) and its natural logarithm.
+#define QUANTILE_SKETCH_GAMMA 1.0408163265306123
+#define QUANTILE_SKETCH_LOG_GAMMA 0.040005334613699206
+
+static uint32_t
+GetQuantileSketchBucket(_In_ double value)
+{
+    if (!(value > 0.0))
+        return 0;
+
+    double key = ceil(log(value) / QUANTILE_SKETCH_LOG_GAMMA) - QUANTILE_SKETCH_MIN_KEY;
+
+    if (key <= 0.0)
+        return 0;
+
+    return key >= QUANTILE_SKETCH_BUCKETS - 1 ? QUANTILE_SKETCH_BUCKETS - 1 : (uint32_t)key;
+}
+
+void
+AddQuantileSketchValue(_Inout_ QuantileSketch* sketch, _In_ double value)
+{
+    sketch->minimum = sketch->count == 0 || value < sketch->minimum ? value : sketch->minimum;
+    sketch->maximum = sketch->count == 0 || value > sketch->maximum ? value : sketch->maximum;
+    sketch->count++;
+    sketch->sum += value;
+    sketch->buckets[GetQuantileSketchBucket(value)]++;
+}
+
+void
+MergeQuantileSketch(_Inout_ QuantileSketch* total, _In_ const QuantileSketch* part)
+{
+    if (part->count == 0)
+        return;
+
+    total->minimum = total->count == 0 || part->minimum < total->minimum ? part->minimum : total->minimum;
+    total->maximum = total->count == 0 || part->maximum > total->maximum ? part->maximum : total->maximum;
+    total->count += part->count;
+    total->sum += part->sum;
+
+    for (uint32_t i = 0; i < QUANTILE_SKETCH_BUCKETS; i++)
+        total->buckets[i] += part->buckets[i];
+}
+
+double
+GetQuantileSketchValue(_In_ const QuantileSketch* sketch, _In_ double quantile)
+{
+    if (sketch->count == 0)
+        return 0.0;
+
+    quantile = quantile < 0.0 ? 0.0 : quantile > 1.0 ? 1.0 : quantile;
+
+    // The same rank as an exact quantile taken from the sorted values would use.
+    uint64_t rank = (uint64_t)(quantile * (double)(sketch->count - 1));
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+
+    for (; bucket < QUANTILE_SKETCH_BUCKETS - 1; bucket++)
+    {
+        seen += sketch->buckets[bucket];
+
+        if (seen > rank)
+            break;
+    }
+
+    double key = (double)((int32_t)bucket + QUANTILE_SKETCH_MIN_KEY);
+    double value = 2.0 * exp(key * QUANTILE_SKETCH_LOG_GAMMA) / (QUANTILE_SKETCH_GAMMA + 1.0);
+
+    return value < sketch->minimum ? sketch->minimum : value > sketch->maximum ? sketch->maximum : value;
+}
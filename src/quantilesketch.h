@@ -0,0 +1,31 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Every quantile is within 2% of a value that was added, relative to it, for values between about 1e-9 and 7e8.
+#define QUANTILE_SKETCH_ACCURACY 0.02
+#define QUANTILE_SKETCH_BUCKETS 1024
+#define QUANTILE_SKETCH_MIN_KEY (-512)
+
+// A DDSketch: bucket k counts the values in (gamma^(k-1), gamma^k] with gamma = (1 + a) / (1 - a), so a bucket's
+// midpoint is within the accuracy a of anything in it. Values past either end go into the end buckets, and the
+// smallest and largest values are kept exactly. The buckets are fixed, so sketches built apart, on other threads or
+// from other files, merge by adding their counts, and a zeroed sketch is an empty one.
+typedef struct
+{
+    uint64_t count;
+    double sum;
+    double minimum;
+    double maximum;
+    uint32_t buckets[QUANTILE_SKETCH_BUCKETS];
+} QuantileSketch;
+
+void AddQuantileSketchValue(_Inout_ QuantileSketch* sketch, _In_ double value);
+
+void MergeQuantileSketch(_Inout_ QuantileSketch* total, _In_ const QuantileSketch* part);
+
+// The value with the given fraction of the others below it, or zero for an empty sketch.
+double GetQuantileSketchValue(_In_ const QuantileSketch* sketch, _In_ double quantile);
@@ -1,5 +1,3 @@
-#include "pch.h"
-
 #include "random.h"
 
 uint32_t
@@ -13,3 +11,18 @@ xorshift32(_In_ struct xorshift32_state* state)
 
     return state->a = x;
 }
+
+uint64_t
+splitmix64(_In_ struct splitmix64_state* state)
+{
+    return mix64(state->s += 0x9E3779B97F4A7C15ull);
+}
+
+uint64_t
+mix64(_In_ uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+
+    return value ^ (value >> 31);
+}
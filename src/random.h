@@ -10,3 +10,12 @@ struct xorshift32_state
 };
 
 uint32_t xorshift32(_In_ struct xorshift32_state* state);
+
+struct splitmix64_state
+{
+    uint64_t s;
+};
+
+uint64_t splitmix64(_In_ struct splitmix64_state* state);
+
+uint64_t mix64(_In_ uint64_t value);
@@ -0,0 +1,530 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "rawvf.h"
+
+#define RAWVF_SQUARE_SIZE 16
+#define RAWVF_MAX_NUMBER 1000000
+
+static const char* const levelNames[] = {"Beginner", "Intermediate", "Expert", "Custom"};
+
+static bool
+IsRawvfSpace(_In_ char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static bool
+MatchLine(_In_reads_(length) const char* line, _In_ size_t length, _In_z_ const char* text)
+{
+    size_t textLength = strlen(text);
+
+    return length == textLength && memcmp(line, text, length) == 0;
+}
+
+// Reads the next run of non-blank characters, returning false at the end of the line.
+static bool
+ReadToken(
+    _In_reads_(length) const char* line,
+    _In_ size_t length,
+    _Inout_ size_t* position,
+    _Out_ const char** token,
+    _Out_ size_t* tokenLength)
+{
+    size_t i = *position;
+
+    while (i < length && IsRawvfSpace(line[i]))
+        i++;
+
+    size_t start = i;
+
+    while (i < length && !IsRawvfSpace(line[i]))
+        i++;
+
+    *token = line + start;
+    *tokenLength = i - start;
+    *position = i;
+
+    return i > start;
+}
+
+static bool
+ParseNumber(_In_reads_(length) const char* text, _In_ size_t length, _Out_ uint32_t* value)
+{
+    *value = 0;
+
+    if (length == 0)
+        return false;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] < '0' || text[i] > '9')
+            return false;
+
+        *value = *value * 10 + (uint32_t)(text[i] - '0');
+
+        if (*value > RAWVF_MAX_NUMBER)
+            return false;
+    }
+
+    return true;
+}
+
+// Times are seconds with up to three decimals kept; events before the start are clamped to zero.
+static bool
+ParseTime(_In_reads_(length) const char* text, _In_ size_t length, _Out_ uint64_t* time)
+{
+    bool negative = length > 0 && text[0] == '-';
+    size_t i = negative ? 1 : 0;
+    uint64_t seconds = 0;
+    uint64_t milliseconds = 0;
+    uint32_t digits = 0;
+
+    *time = 0;
+
+    for (; i < length && text[i] != '.'; i++, digits++)
+    {
+        if (text[i] < '0' || text[i] > '9' || seconds > UINT32_MAX)
+            return false;
+
+        seconds = seconds * 10 + (uint64_t)(text[i] - '0');
+    }
+
+    if (i < length)
+    {
+        uint64_t scale = 100;
+
+        for (i++; i < length; i++, digits++, scale /= 10)
+        {
+            if (text[i] < '0' || text[i] > '9')
+                return false;
+
+            milliseconds += (uint64_t)(text[i] - '0') * scale;
+        }
+    }
+
+    if (digits == 0)
+        return false;
+
+    *time = negative ? 0 : seconds * 1000 + milliseconds;
+
+    return true;
+}
+
+static bool
+ParseHeaderLine(_Inout_ RawvfParser* parser, _In_reads_(length) const char* line, _In_ size_t length)
+{
+    if (MatchLine(line, length, "Board:"))
+    {
+        if (!CreateSizedMinefield(parser->field, parser->width, parser->height, parser->totalMines))
+            return false;
+
+        parser->section = RAWVF_SECTION_BOARD;
+        ZeroMemory(parser->layout, sizeof(bool) * parser->width * parser->height);
+
+        return true;
+    }
+
+    const char* colon = memchr(line, ':', length);
+
+    if (colon == NULL)
+        return true;
+
+    size_t keyLength = (size_t)(colon - line);
+    uint32_t* value = NULL;
+
+    if (MatchLine(line, keyLength, "Width"))
+        value = &parser->width;
+    else if (MatchLine(line, keyLength, "Height"))
+        value = &parser->height;
+    else if (MatchLine(line, keyLength, "Mines"))
+        value = &parser->totalMines;
+    else if (MatchLine(line, keyLength, "Events"))
+        return false;
+
+    if (value == NULL)
+        return true;
+
+    size_t position = keyLength + 1;
+    const char* token;
+    size_t tokenLength;
+
+    return ReadToken(line, length, &position, &token, &tokenLength) && ParseNumber(token, tokenLength, value);
+}
+
+static bool
+ParseBoardRow(_Inout_ RawvfParser* parser, _In_reads_(length) const char* line, _In_ size_t length)
+{
+    if (parser->boardRows == parser->height)
+    {
+        if (MatchLine(line, length, "Events:"))
+            parser->section = RAWVF_SECTION_EVENTS;
+
+        return true;
+    }
+
+    while (length > 0 && IsRawvfSpace(line[length - 1]))
+        length--;
+
+    if (length != parser->width)
+        return false;
+
+    bool* row = parser->layout + parser->boardRows * parser->width;
+
+    for (size_t x = 0; x < length; x++)
+    {
+        if (line[x] == '*')
+            row[x] = true;
+        else if (line[x] != '0' && line[x] != '.')
+            return false;
+    }
+
+    parser->boardRows++;
+
+    return parser->boardRows < parser->height || SetMinefieldLayout(parser->field, parser->layout);
+}
+
+// Follows the buttons as the game window does: a right press flags, a left release reveals, and releasing either
+// button while both are down, or releasing the middle button, chords.
+static void
+ApplyMouseEvent(_Inout_ RawvfParser* parser, _In_ char button, _In_ char edge, _In_ uint32_t x, _In_ uint32_t y)
+{
+    Minefield* field = parser->field;
+    bool press = edge == 'c';
+    bool applied = false;
+
+    if (button == 'l' && press)
+    {
+        parser->leftDown = true;
+        parser->chording = parser->rightDown;
+    }
+    else if (button == 'r' && press)
+    {
+        parser->rightDown = true;
+        parser->chording = parser->leftDown;
+
+        if (!parser->chording)
+            applied = ToggleFlag(field, x, y);
+    }
+    else if (button == 'l')
+    {
+        if (parser->chording)
+            applied = parser->rightDown && ChordCell(field, x, y);
+        else if (parser->leftDown)
+            applied = RevealCell(field, x, y);
+
+        parser->leftDown = false;
+        parser->chording = parser->chording && parser->rightDown;
+    }
+    else if (button == 'r')
+    {
+        if (parser->chording)
+            applied = parser->leftDown && ChordCell(field, x, y);
+
+        parser->rightDown = false;
+        parser->chording = parser->chording && parser->leftDown;
+    }
+    else if (button == 'm' && !press)
+    {
+        applied = ChordCell(field, x, y);
+    }
+
+    parser->actions += applied ? 1 : 0;
+}
+
+static bool
+ParseEventLine(_Inout_ RawvfParser* parser, _In_reads_(length) const char* line, _In_ size_t length)
+{
+    size_t position = 0;
+    const char* token;
+    size_t tokenLength;
+    uint64_t time;
+
+    if (!ReadToken(line, length, &position, &token, &tokenLength))
+        return true;
+
+    if (!ParseTime(token, tokenLength, &time) || !ReadToken(line, length, &position, &token, &tokenLength))
+        return false;
+
+    parser->time = max(parser->time, time);
+    parser->events++;
+
+    bool mouse = tokenLength == 2 && (token[0] == 'l' || token[0] == 'r' || token[0] == 'm') &&
+                 (token[1] == 'c' || token[1] == 'r');
+
+    if (!mouse)
+        return true;
+
+    char button = token[0];
+    char edge = token[1];
+    uint32_t x, y;
+
+    if (!ReadToken(line, length, &position, &token, &tokenLength) || !ParseNumber(token, tokenLength, &x) ||
+        !ReadToken(line, length, &position, &token, &tokenLength) || !ParseNumber(token, tokenLength, &y))
+    {
+        return false;
+    }
+
+    // Cells are numbered from one; clicks outside the board, numbered zero, fall through the game's bounds checks.
+    ApplyMouseEvent(parser, button, edge, x - 1, y - 1);
+
+    return true;
+}
+
+static bool
+ParseRawvfLine(_Inout_ RawvfParser* parser, _In_reads_(length) const char* line, _In_ size_t length)
+{
+    parser->line++;
+
+    if (length > 0 && line[length - 1] == '\r')
+        length--;
+
+    switch (parser->section)
+    {
+        case RAWVF_SECTION_HEADER:
+            return ParseHeaderLine(parser, line, length);
+        case RAWVF_SECTION_BOARD:
+            return ParseBoardRow(parser, line, length);
+        case RAWVF_SECTION_EVENTS:
+            return ParseEventLine(parser, line, length);
+        default:
+            return false;
+    }
+}
+
+void
+BeginRawvfParse(_Out_ RawvfParser* parser, _Inout_ Minefield* field)
+{
+    parser->field = field;
+    parser->section = RAWVF_SECTION_HEADER;
+    parser->width = 0;
+    parser->height = 0;
+    parser->totalMines = 0;
+    parser->boardRows = 0;
+    parser->line = 0;
+    parser->events = 0;
+    parser->actions = 0;
+    parser->time = 0;
+    parser->leftDown = false;
+    parser->rightDown = false;
+    parser->chording = false;
+    parser->failed = false;
+    parser->pending = 0;
+}
+
+bool
+ParseRawvfChunk(_Inout_ RawvfParser* parser, _In_reads_bytes_(size) const char* text, _In_ size_t size)
+{
+    const char* end = text + size;
+
+    while (!parser->failed && text < end)
+    {
+        const char* newline = memchr(text, '\n', (size_t)(end - text));
+        size_t length = (size_t)((newline != NULL ? newline : end) - text);
+
+        if (parser->pending + length > RAWVF_MAX_LINE)
+        {
+            parser->failed = true;
+            break;
+        }
+
+        if (newline == NULL)
+        {
+            CopyMemory(parser->buffer + parser->pending, text, length);
+            parser->pending += (uint32_t)length;
+            break;
+        }
+
+        if (parser->pending > 0)
+        {
+            CopyMemory(parser->buffer + parser->pending, text, length);
+            parser->failed = !ParseRawvfLine(parser, parser->buffer, parser->pending + length);
+            parser->pending = 0;
+        }
+        else
+        {
+            parser->failed = !ParseRawvfLine(parser, text, length);
+        }
+
+        text = newline + 1;
+    }
+
+    if (parser->failed)
+        SetLastError(ERROR_BAD_FORMAT);
+
+    return !parser->failed;
+}
+
+bool
+EndRawvfParse(_Inout_ RawvfParser* parser)
+{
+    if (!parser->failed && parser->pending > 0)
+    {
+        parser->failed = !ParseRawvfLine(parser, parser->buffer, parser->pending);
+        parser->pending = 0;
+    }
+
+    if (parser->section == RAWVF_SECTION_HEADER || parser->boardRows < parser->height)
+        parser->failed = true;
+
+    if (parser->failed)
+        SetLastError(ERROR_BAD_FORMAT);
+
+    return !parser->failed;
+}
+
+static _Ret_notnull_ char*
+AppendText(_Out_ char* out, _In_z_ const char* text)
+{
+    while (*text != '\0')
+        *out++ = *text++;
+
+    return out;
+}
+
+static _Ret_notnull_ char*
+AppendNumber(_Out_ char* out, _In_ uint64_t value)
+{
+    char digits[20];
+    uint32_t count = 0;
+
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0)
+        *out++ = digits[--count];
+
+    return out;
+}
+
+static _Ret_notnull_ char*
+AppendSeconds(_Out_ char* out, _In_ uint64_t milliseconds)
+{
+    out = AppendNumber(out, milliseconds / 1000);
+    *out++ = '.';
+    *out++ = (char)('0' + milliseconds / 100 % 10);
+    *out++ = (char)('0' + milliseconds / 10 % 10);
+    *out++ = (char)('0' + milliseconds % 10);
+
+    return out;
+}
+
+static _Ret_notnull_ char*
+AppendHeaderNumber(_Out_ char* out, _In_z_ const char* key, _In_ uint32_t value)
+{
+    out = AppendText(out, key);
+    out = AppendNumber(out, value);
+    *out++ = '\n';
+
+    return out;
+}
+
+static _Ret_notnull_ char*
+AppendMouseEvent(
+    _Out_ char* out,
+    _In_ uint64_t time,
+    _In_z_ const char* name,
+    _In_ uint32_t cell,
+    _In_ uint32_t width)
+{
+    uint32_t x = cell % width;
+    uint32_t y = cell / width;
+
+    out = AppendSeconds(out, time);
+    *out++ = ' ';
+    out = AppendText(out, name);
+    *out++ = ' ';
+    out = AppendNumber(out, x + 1);
+    *out++ = ' ';
+    out = AppendNumber(out, y + 1);
+    out = AppendText(out, " (");
+    out = AppendNumber(out, x * RAWVF_SQUARE_SIZE + RAWVF_SQUARE_SIZE / 2);
+    *out++ = ' ';
+    out = AppendNumber(out, y * RAWVF_SQUARE_SIZE + RAWVF_SQUARE_SIZE / 2);
+    out = AppendText(out, ")\n");
+
+    return out;
+}
+
+uint32_t
+ExportRawvf(_In_ const Minefield* field, _In_opt_ const ReplayLog* log, _Out_writes_bytes_(RAWVF_MAX_SIZE) char* buffer)
+{
+    static const char* const pressNames[] = {"lc", "rc", "mc"};
+    static const char* const releaseNames[] = {"lr", "rr", "mr"};
+
+    if (!field->minesPlaced)
+        return 0;
+
+    ReplayCursor cursor;
+    ReplayEvent event;
+    uint64_t firstTime = 0;
+    uint64_t duration = 0;
+    char* out = buffer;
+
+    if (log != NULL)
+    {
+        BeginReplayEvents(log, &cursor);
+
+        for (bool first = true; ReadReplayEvent(log, &cursor, &event); first = false)
+        {
+            firstTime = first ? event.time : firstTime;
+            duration = min(event.time - firstTime, (uint64_t)UINT32_MAX);
+        }
+    }
+
+    out = AppendText(out, "RawVF_Version: Rev7\nProgram: Minesweeper\nLevel: ");
+    out = AppendText(out, levelNames[min((uint32_t)field->difficulty, (uint32_t)DIFFICULTY_CUSTOM)]);
+    *out++ = '\n';
+    out = AppendHeaderNumber(out, "Width: ", field->width);
+    out = AppendHeaderNumber(out, "Height: ", field->height);
+    out = AppendHeaderNumber(out, "Mines: ", field->totalMines);
+    out = AppendText(out, "Marks: Off\n");
+
+    if (log != NULL)
+    {
+        out = AppendText(out, "Time: ");
+        out = AppendSeconds(out, duration);
+        *out++ = '\n';
+    }
+
+    out = AppendText(out, "Board:\n");
+
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+            *out++ = field->cells[y * field->width + x].hasMine ? '*' : '0';
+
+        *out++ = '\n';
+    }
+
+    out = AppendText(out, "Events:\n");
+
+    if (log == NULL)
+        return (uint32_t)(out - buffer);
+
+    out = AppendText(out, "0.000 start\n");
+    BeginReplayEvents(log, &cursor);
+
+    while (ReadReplayEvent(log, &cursor, &event))
+    {
+        if (event.action > REPLAY_CHORD || event.cell >= field->width * field->height)
+            continue;
+
+        uint64_t time = min(event.time - firstTime, (uint64_t)UINT32_MAX);
+
+        out = AppendMouseEvent(out, time, pressNames[event.action], event.cell, field->width);
+        out = AppendMouseEvent(out, time, releaseNames[event.action], event.cell, field->width);
+    }
+
+    if (field->state != GAME_PLAYING)
+    {
+        out = AppendSeconds(out, duration);
+        out = AppendText(out, field->state == GAME_WON ? " won\n" : " blast\n");
+    }
+
+    return (uint32_t)(out - buffer);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "replay.h"
+
+#define RAWVF_MAX_LINE 256
+#define RAWVF_MAX_EVENT_LINE 48
+#define RAWVF_MAX_HEADER_SIZE 512
+
+// Every logged event takes at least two bytes and is written as a press and a release line.
+#define RAWVF_MAX_SIZE                                                                                                 \
+    (RAWVF_MAX_HEADER_SIZE + (MAX_CELLS_HORIZONTALLY + 1) * MAX_CELLS_VERTICALLY +                                     \
+     REPLAY_BUFFER_SIZE * RAWVF_MAX_EVENT_LINE)
+
+typedef enum
+{
+    RAWVF_SECTION_HEADER,
+    RAWVF_SECTION_BOARD,
+    RAWVF_SECTION_EVENTS,
+} RawvfSection;
+
+// Reads a RAWVF video, the text form AVF, MVF and RMV videos are converted to, from chunks of any size: "Key: value"
+// lines, a "Board:" section with a row of '*' and '0' per line, then an "Events:" section of timed mouse events. Lines
+// are parsed where they lie in the chunk; only a line split between two chunks is copied. The board is loaded through
+// SetMinefieldLayout and the mouse events are played through RevealCell, ToggleFlag and ChordCell as the game would
+// handle them, with replay recording off since the video holds its own times.
+typedef struct
+{
+    Minefield* field;
+    RawvfSection section;
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalMines;
+    uint32_t boardRows;
+    uint32_t line;
+    uint32_t events;
+    uint32_t actions;
+    uint64_t time;
+    bool leftDown;
+    bool rightDown;
+    bool chording;
+    bool failed;
+    uint32_t pending;
+    char buffer[RAWVF_MAX_LINE];
+    bool layout[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+} RawvfParser;
+
+void BeginRawvfParse(_Out_ RawvfParser* parser, _Inout_ Minefield* field);
+
+bool ParseRawvfChunk(_Inout_ RawvfParser* parser, _In_reads_bytes_(size) const char* text, _In_ size_t size);
+
+// Parses a last line without a line break and checks that the whole board was read.
+bool EndRawvfParse(_Inout_ RawvfParser* parser);
+
+// Writes the board and, when a log is given, its events as presses and releases timed from the first event. Returns
+// the size written, or zero when the mines have not been placed yet.
+uint32_t ExportRawvf(
+    _In_ const Minefield* field,
+    _In_opt_ const ReplayLog* log,
+    _Out_writes_bytes_(RAWVF_MAX_SIZE) char* buffer);
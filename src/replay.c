@@ -0,0 +1,297 @@
+#include "pch.h"
+
+#include "littleendian.h"
+#include "replay.h"
+
+#define REPLAY_ACTION_BITS 2
+#define REPLAY_BUFFER_MASK (REPLAY_BUFFER_SIZE - 1)
+
+// A cell index below 2^14 shifted by the action bits, and a delta clamped to 32 bits, take at most 3 and 5 bytes.
+#define REPLAY_MAX_EVENT_BYTES 8
+
+#define REPLAY_FILE_MAGIC 0x5052534Du
+#define REPLAY_FILE_VERSION 1
+#define REPLAY_FILE_LAYOUT_FLAG 0x01
+
+static uint32_t
+WriteVarint(_Out_writes_(5) uint8_t* bytes, _In_ uint32_t value)
+{
+    uint32_t size = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+
+    bytes[size++] = (uint8_t)value;
+
+    return size;
+}
+
+static uint32_t
+ReadVarint(_In_ const ReplayLog* log, _Inout_ uint32_t* position)
+{
+    uint32_t value = 0;
+
+    // Stops after five bytes, so a damaged log read back from a file cannot run on.
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        uint8_t byte = log->events[*position];
+
+        *position = (*position + 1) & REPLAY_BUFFER_MASK;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            break;
+    }
+
+    return value;
+}
+
+static uint32_t
+GetOldestPosition(_In_ const ReplayLog* log)
+{
+    return (log->head - log->length) & REPLAY_BUFFER_MASK;
+}
+
+static void
+DropOldestEvent(_Inout_ ReplayLog* log)
+{
+    uint32_t start = GetOldestPosition(log);
+    uint32_t position = start;
+
+    ReadVarint(log, &position);
+    log->baseTime += ReadVarint(log, &position);
+    log->length -= (position - start) & REPLAY_BUFFER_MASK;
+    log->eventCount--;
+    log->droppedEvents++;
+}
+
+void
+ResetReplayLog(_Out_ ReplayLog* log)
+{
+    log->seed = 0;
+    log->baseTime = 0;
+    log->lastTime = 0;
+    log->firstClick = REPLAY_NO_CELL;
+    log->head = 0;
+    log->length = 0;
+    log->eventCount = 0;
+    log->droppedEvents = 0;
+    log->recording = true;
+    log->layoutRecorded = false;
+}
+
+void
+AttachReplayLog(_Inout_ Minefield* field, _Out_ ReplayLog* log)
+{
+    ResetReplayLog(log);
+    field->replay = log;
+}
+
+void
+RecordReplayLayout(_Inout_ ReplayLog* log, _In_ uint32_t cellCount, _In_reads_(cellCount) const bool* mines)
+{
+    ZeroMemory(log->layout, sizeof(log->layout));
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        if (mines[i])
+            log->layout[i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+
+    log->layoutRecorded = true;
+}
+
+void
+RecordReplayEvent(_Inout_ ReplayLog* log, _In_ ReplayAction action, _In_ uint32_t cell)
+{
+    if (!log->recording)
+        return;
+
+    uint64_t now = GetTickCount64();
+    uint8_t bytes[REPLAY_MAX_EVENT_BYTES];
+
+    if (log->eventCount == 0 && log->droppedEvents == 0)
+    {
+        log->baseTime = now;
+        log->lastTime = now;
+    }
+
+    uint32_t size = WriteVarint(bytes, cell << REPLAY_ACTION_BITS | (uint32_t)action);
+    size += WriteVarint(bytes + size, (uint32_t)min(now - log->lastTime, (uint64_t)UINT32_MAX));
+
+    while (REPLAY_BUFFER_SIZE - log->length < size)
+        DropOldestEvent(log);
+
+    for (uint32_t i = 0; i < size; i++)
+        log->events[(log->head + i) & REPLAY_BUFFER_MASK] = bytes[i];
+
+    log->head = (log->head + size) & REPLAY_BUFFER_MASK;
+    log->length += size;
+    log->eventCount++;
+    log->lastTime = now;
+}
+
+void
+BeginReplayEvents(_In_ const ReplayLog* log, _Out_ ReplayCursor* cursor)
+{
+    cursor->offset = 0;
+    cursor->time = log->baseTime;
+}
+
+bool
+ReadReplayEvent(_In_ const ReplayLog* log, _Inout_ ReplayCursor* cursor, _Out_ ReplayEvent* event)
+{
+    if (cursor->offset >= log->length)
+        return false;
+
+    uint32_t start = (GetOldestPosition(log) + cursor->offset) & REPLAY_BUFFER_MASK;
+    uint32_t position = start;
+    uint32_t key = ReadVarint(log, &position);
+
+    uint32_t delta = ReadVarint(log, &position);
+    uint32_t offset = cursor->offset + ((position - start) & REPLAY_BUFFER_MASK);
+
+    if (offset > log->length)
+        return false;
+
+    cursor->time += delta;
+    cursor->offset = offset;
+
+    event->action = (ReplayAction)(key & ((1u << REPLAY_ACTION_BITS) - 1));
+    event->cell = key >> REPLAY_ACTION_BITS;
+    event->time = cursor->time;
+
+    return true;
+}
+
+uint32_t
+EncodeReplayFile(_In_ const Minefield* field, _Out_writes_bytes_(REPLAY_FILE_MAX_SIZE) uint8_t* buffer)
+{
+    const ReplayLog* log = field->replay;
+
+    if (log == NULL || field->firstClick)
+        return 0;
+
+    uint32_t layoutBytes = log->layoutRecorded ? (field->width * field->height + 7) / 8 : 0;
+    uint64_t duration = field->state != GAME_PLAYING ? field->endTime - field->startTime : 0;
+
+    PutLittleEndian(buffer + 0, REPLAY_FILE_MAGIC, 4);
+    PutLittleEndian(buffer + 4, REPLAY_FILE_VERSION, 2);
+    PutLittleEndian(buffer + 6, field->width, 2);
+    PutLittleEndian(buffer + 8, field->height, 2);
+    PutLittleEndian(buffer + 10, field->totalMines, 2);
+    buffer[12] = (uint8_t)field->difficulty;
+    buffer[13] = (uint8_t)field->state;
+    buffer[14] = log->layoutRecorded ? REPLAY_FILE_LAYOUT_FLAG : 0;
+    buffer[15] = 0;
+    PutLittleEndian(buffer + 16, log->seed, 8);
+    PutLittleEndian(buffer + 24, log->baseTime, 8);
+    PutLittleEndian(buffer + 32, duration, 8);
+    PutLittleEndian(buffer + 40, field->hash, 8);
+    PutLittleEndian(buffer + 48, log->firstClick, 4);
+    PutLittleEndian(buffer + 52, field->revealedCells, 4);
+    PutLittleEndian(buffer + 56, field->flaggedCells, 4);
+    PutLittleEndian(buffer + 60, log->eventCount, 4);
+    PutLittleEndian(buffer + 64, log->droppedEvents, 4);
+    PutLittleEndian(buffer + 68, log->length, 4);
+
+    uint8_t* layout = buffer + REPLAY_FILE_HEADER_SIZE;
+    uint8_t* events = layout + layoutBytes;
+    uint32_t oldest = GetOldestPosition(log);
+    uint32_t firstPart = min(log->length, REPLAY_BUFFER_SIZE - oldest);
+
+    CopyMemory(layout, log->layout, layoutBytes);
+    CopyMemory(events, log->events + oldest, firstPart);
+    CopyMemory(events + firstPart, log->events, log->length - firstPart);
+
+    return REPLAY_FILE_HEADER_SIZE + layoutBytes + log->length;
+}
+
+bool
+ViewReplayFile(
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size,
+    _Out_ ReplayOutcome* outcome,
+    _Out_ ReplayFileView* view)
+{
+    ZeroMemory(outcome, sizeof(ReplayOutcome));
+    ZeroMemory(view, sizeof(ReplayFileView));
+
+    if (size < REPLAY_FILE_HEADER_SIZE || GetLittleEndian(bytes, 4) != REPLAY_FILE_MAGIC ||
+        GetLittleEndian(bytes + 4, 2) != REPLAY_FILE_VERSION)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    outcome->width = (uint32_t)GetLittleEndian(bytes + 6, 2);
+    outcome->height = (uint32_t)GetLittleEndian(bytes + 8, 2);
+    outcome->totalMines = (uint32_t)GetLittleEndian(bytes + 10, 2);
+    outcome->difficulty = (Difficulty)bytes[12];
+    outcome->state = (GameState)bytes[13];
+    outcome->duration = GetLittleEndian(bytes + 32, 8);
+    outcome->hash = GetLittleEndian(bytes + 40, 8);
+    outcome->revealedCells = (uint32_t)GetLittleEndian(bytes + 52, 4);
+    outcome->flaggedCells = (uint32_t)GetLittleEndian(bytes + 56, 4);
+
+    view->seed = GetLittleEndian(bytes + 16, 8);
+    view->baseTime = GetLittleEndian(bytes + 24, 8);
+    view->firstClick = (uint32_t)GetLittleEndian(bytes + 48, 4);
+    view->eventCount = (uint32_t)GetLittleEndian(bytes + 60, 4);
+    view->droppedEvents = (uint32_t)GetLittleEndian(bytes + 64, 4);
+    view->length = (uint32_t)GetLittleEndian(bytes + 68, 4);
+
+    bool layoutRecorded = (bytes[14] & REPLAY_FILE_LAYOUT_FLAG) != 0;
+    uint32_t cellCount = outcome->width * outcome->height;
+    uint32_t layoutBytes = layoutRecorded ? (cellCount + 7) / 8 : 0;
+
+    if (outcome->width == 0 || outcome->width > MAX_CELLS_HORIZONTALLY || outcome->height == 0 ||
+        outcome->height > MAX_CELLS_VERTICALLY || outcome->totalMines >= cellCount ||
+        outcome->difficulty > DIFFICULTY_CUSTOM || outcome->state > GAME_LOST || view->firstClick >= cellCount ||
+        view->length > REPLAY_BUFFER_SIZE || size != REPLAY_FILE_HEADER_SIZE + layoutBytes + view->length)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    view->layout = layoutRecorded ? bytes + REPLAY_FILE_HEADER_SIZE : NULL;
+    view->events = bytes + REPLAY_FILE_HEADER_SIZE + layoutBytes;
+
+    return true;
+}
+
+bool
+DecodeReplayFile(
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size,
+    _Out_ ReplayOutcome* outcome,
+    _Out_ ReplayLog* log)
+{
+    ReplayFileView view;
+
+    ResetReplayLog(log);
+    log->recording = false;
+
+    if (!ViewReplayFile(bytes, size, outcome, &view))
+        return false;
+
+    log->layoutRecorded = view.layout != NULL;
+    log->seed = view.seed;
+    log->baseTime = view.baseTime;
+    log->lastTime = view.baseTime;
+    log->firstClick = view.firstClick;
+    log->eventCount = view.eventCount;
+    log->droppedEvents = view.droppedEvents;
+    log->length = view.length;
+    log->head = view.length & REPLAY_BUFFER_MASK;
+
+    if (view.layout != NULL)
+        CopyMemory(log->layout, view.layout, (outcome->width * outcome->height + 7) / 8);
+
+    CopyMemory(log->events, view.events, view.length);
+
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define REPLAY_FILE_HEADER_SIZE 72
+#define REPLAY_FILE_MAX_SIZE (REPLAY_FILE_HEADER_SIZE + REPLAY_LAYOUT_BYTES + REPLAY_BUFFER_SIZE)
+
+typedef enum
+{
+    REPLAY_REVEAL,
+    REPLAY_FLAG,
+    REPLAY_CHORD,
+} ReplayAction;
+
+typedef struct
+{
+    ReplayAction action;
+    uint32_t cell;
+    uint64_t time;
+} ReplayEvent;
+
+typedef struct
+{
+    uint32_t offset;
+    uint64_t time;
+} ReplayCursor;
+
+// How a recorded game stood when it was saved, which a replay of it has to reproduce. duration is zero while the game
+// is still being played.
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalMines;
+    Difficulty difficulty;
+    GameState state;
+    uint32_t revealedCells;
+    uint32_t flaggedCells;
+    uint64_t duration;
+    uint64_t hash;
+} ReplayOutcome;
+
+// Empties the log and starts recording.
+void ResetReplayLog(_Out_ ReplayLog* log);
+
+// Creating a field detaches its log, so a game is recorded only when a log is attached to it before the first move.
+void AttachReplayLog(_Inout_ Minefield* field, _Out_ ReplayLog* log);
+
+void RecordReplayLayout(_Inout_ ReplayLog* log, _In_ uint32_t cellCount, _In_reads_(cellCount) const bool* mines);
+
+void RecordReplayEvent(_Inout_ ReplayLog* log, _In_ ReplayAction action, _In_ uint32_t cell);
+
+// Events are read oldest first, with times in GetTickCount64 milliseconds.
+void BeginReplayEvents(_In_ const ReplayLog* log, _Out_ ReplayCursor* cursor);
+
+bool ReadReplayEvent(_In_ const ReplayLog* log, _Inout_ ReplayCursor* cursor, _Out_ ReplayEvent* event);
+
+// The parts of a replay file that are used where they lie, without copying the events into a ReplayLog. layout is
+// NULL unless the mines were set by hand.
+typedef struct
+{
+    uint64_t seed;
+    uint64_t baseTime;
+    uint32_t firstClick;
+    uint32_t eventCount;
+    uint32_t droppedEvents;
+    uint32_t length;
+    const uint8_t* layout;
+    const uint8_t* events;
+} ReplayFileView;
+
+// A replay file is a little-endian header with the board and its outcome, the mine bitmap when the layout was set by
+// hand, then the events oldest first. Returns the file size, or zero when the game has not started yet or was not
+// recorded.
+uint32_t EncodeReplayFile(_In_ const Minefield* field, _Out_writes_bytes_(REPLAY_FILE_MAX_SIZE) uint8_t* buffer);
+
+bool ViewReplayFile(
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size,
+    _Out_ ReplayOutcome* outcome,
+    _Out_ ReplayFileView* view);
+
+bool DecodeReplayFile(
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size,
+    _Out_ ReplayOutcome* outcome,
+    _Out_ ReplayLog* log);
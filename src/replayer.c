@@ -0,0 +1,157 @@
+#include "pch.h"
+
+#include "replayer.h"
+
+static bool
+RebuildBoard(_Out_ Minefield* field, _In_ const ReplayOutcome* recorded, _In_ const ReplayLog* log)
+{
+    bool created = recorded->difficulty == DIFFICULTY_CUSTOM
+                       ? CreateCustomMinefield(field, recorded->width, recorded->height, recorded->totalMines)
+                       : CreateMinefield(field, recorded->difficulty);
+
+    if (!created || field->width != recorded->width || field->height != recorded->height ||
+        field->totalMines != recorded->totalMines)
+    {
+        return false;
+    }
+
+    field->seed = log->seed;
+
+    if (!log->layoutRecorded)
+        return true;
+
+    bool mines[MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY];
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+        mines[i] = (log->layout[i / 8] >> (i % 8) & 1) != 0;
+
+    return SetMinefieldLayout(field, mines);
+}
+
+static bool
+ApplyReplayEvent(_Inout_ Minefield* field, _In_ const ReplayEvent* event)
+{
+    uint32_t x = event->cell % field->width;
+    uint32_t y = event->cell / field->width;
+
+    switch (event->action)
+    {
+        case REPLAY_REVEAL:
+            return RevealCell(field, x, y);
+        case REPLAY_FLAG:
+            return ToggleFlag(field, x, y);
+        case REPLAY_CHORD:
+            return ChordCell(field, x, y);
+        default:
+            return false;
+    }
+}
+
+static uint64_t
+GetTimeDifference(_In_ uint64_t a, _In_ uint64_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+_Ret_z_ const char*
+GetReplayVerdictName(_In_ ReplayVerdict verdict)
+{
+    switch (verdict)
+    {
+        case REPLAY_VERIFIED:
+            return "verified";
+        case REPLAY_INCOMPLETE:
+            return "incomplete";
+        case REPLAY_BAD_BOARD:
+            return "bad board";
+        case REPLAY_REJECTED:
+            return "rejected event";
+        case REPLAY_STATE_DIVERGED:
+            return "state diverged";
+        case REPLAY_COUNTERS_DIVERGED:
+            return "counters diverged";
+        case REPLAY_TIME_DIVERGED:
+            return "time diverged";
+        case REPLAY_HASH_DIVERGED:
+            return "hash diverged";
+        default:
+            return "unknown";
+    }
+}
+
+void
+VerifyReplay(
+    _Inout_ Minefield* field,
+    _In_ const ReplayOutcome* recorded,
+    _In_ const ReplayLog* log,
+    _Out_ ReplayCheck* check)
+{
+    ZeroMemory(check, sizeof(ReplayCheck));
+
+    // Without its oldest events a game cannot be replayed from the start.
+    if (log->droppedEvents != 0)
+    {
+        check->verdict = REPLAY_INCOMPLETE;
+        return;
+    }
+
+    if (!RebuildBoard(field, recorded, log))
+    {
+        check->verdict = REPLAY_BAD_BOARD;
+        return;
+    }
+
+    ReplayCursor cursor;
+    ReplayEvent event;
+    uint64_t startTime = 0;
+    uint64_t endTime = 0;
+    bool started = false;
+
+    BeginReplayEvents(log, &cursor);
+    check->verdict = REPLAY_VERIFIED;
+
+    while (ReadReplayEvent(log, &cursor, &event))
+    {
+        if (!ApplyReplayEvent(field, &event))
+        {
+            check->verdict = REPLAY_REJECTED;
+            check->rejectedEvent = check->events;
+            break;
+        }
+
+        if (!started && event.action == REPLAY_REVEAL)
+        {
+            started = true;
+            startTime = event.time;
+        }
+
+        endTime = event.time;
+        check->events++;
+    }
+
+    ReplayOutcome* outcome = &check->outcome;
+
+    outcome->width = field->width;
+    outcome->height = field->height;
+    outcome->totalMines = field->totalMines;
+    outcome->difficulty = field->difficulty;
+    outcome->state = field->state;
+    outcome->revealedCells = field->revealedCells;
+    outcome->flaggedCells = field->flaggedCells;
+    outcome->duration = field->state != GAME_PLAYING ? endTime - startTime : 0;
+    outcome->hash = field->hash;
+
+    if (check->verdict != REPLAY_VERIFIED)
+        return;
+
+    if (check->events != log->eventCount)
+        check->verdict = REPLAY_INCOMPLETE;
+    else if (outcome->state != recorded->state)
+        check->verdict = REPLAY_STATE_DIVERGED;
+    else if (outcome->revealedCells != recorded->revealedCells || outcome->flaggedCells != recorded->flaggedCells)
+        check->verdict = REPLAY_COUNTERS_DIVERGED;
+    else if (GetTimeDifference(outcome->duration, recorded->duration) > REPLAY_TIME_TOLERANCE)
+        check->verdict = REPLAY_TIME_DIVERGED;
+    else if (outcome->hash != recorded->hash)
+        check->verdict = REPLAY_HASH_DIVERGED;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "replay.h"
+
+// GetTickCount64 is read separately for the game clock and for each event, so a replayed duration may differ from
+// the recorded one by a timer tick either way.
+#define REPLAY_TIME_TOLERANCE 32
+
+typedef enum
+{
+    REPLAY_VERIFIED,
+    REPLAY_INCOMPLETE,
+    REPLAY_BAD_BOARD,
+    REPLAY_REJECTED,
+    REPLAY_STATE_DIVERGED,
+    REPLAY_COUNTERS_DIVERGED,
+    REPLAY_TIME_DIVERGED,
+    REPLAY_HASH_DIVERGED
+} ReplayVerdict;
+
+// The replayed game, with the index of the event the engine refused when the verdict is REPLAY_REJECTED.
+typedef struct
+{
+    ReplayVerdict verdict;
+    uint32_t events;
+    uint32_t rejectedEvent;
+    ReplayOutcome outcome;
+} ReplayCheck;
+
+_Ret_z_ const char* GetReplayVerdictName(_In_ ReplayVerdict verdict);
+
+// Rebuilds the board from its seed and first click, or from the recorded layout, and applies every event through
+// RevealCell, ToggleFlag and ChordCell without recording. The field is the caller's scratch board.
+void VerifyReplay(
+    _Inout_ Minefield* field,
+    _In_ const ReplayOutcome* recorded,
+    _In_ const ReplayLog* log,
+    _Out_ ReplayCheck* check);
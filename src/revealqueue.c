@@ -0,0 +1,31 @@
+#include "pch.h"
+
+#include "revealqueue.h"
+
+bool
+GrowRevealQueue(
+    _Inout_ uint64_t** queue,
+    _Inout_ uint32_t* capacity,
+    _In_ uint32_t head,
+    _In_ uint32_t count)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t grown = *capacity > 0 ? *capacity * 2 : REVEAL_QUEUE_INITIAL_CAPACITY;
+    uint64_t* buffer = HeapAlloc(hHeap, 0, sizeof(uint64_t) * grown);
+
+    if (grown < *capacity || buffer == NULL)
+    {
+        HeapFree(hHeap, 0, buffer);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+        buffer[i] = (*queue)[(head + i) & (*capacity - 1)];
+
+    HeapFree(hHeap, 0, *queue);
+    *queue = buffer;
+    *capacity = grown;
+
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define REVEAL_QUEUE_INITIAL_CAPACITY 4096
+
+// The breadth-first reveals of the large and unbounded boards queue packed cell positions in a ring buffer whose
+// capacity is zero or a power of two. This doubles the buffer, or allocates the first one, and unwraps the count
+// positions queued from head to the front of the new buffer.
+bool GrowRevealQueue(
+    _Inout_ uint64_t** queue,
+    _Inout_ uint32_t* capacity,
+    _In_ uint32_t head,
+    _In_ uint32_t count);
@@ -0,0 +1,454 @@
+#include "pch.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "parallel.h"
+#include "random.h"
+#include "sampler.h"
+
+#define SAMPLER_MAX_ENERGY_DELTA 16
+#define SAMPLER_SWEEP_LIMIT_FACTOR 8
+#define SAMPLER_REPLICAS ARRAYSIZE(inverseTemperatures)
+
+// Replicas of one chain run at these inverse temperatures and exchange states, so the hot replicas carry the cold
+// ones between otherwise disconnected layouts. Every replica's zero-energy states are uniform over consistent layouts.
+static const double inverseTemperatures[] = {0.75, 1.5, 2.5, 4.0};
+
+typedef struct
+{
+    uint64_t* mineCounts;
+    uint64_t unconstrainedMines;
+    uint64_t samples;
+    uint64_t proposals;
+    uint64_t acceptedProposals;
+    double mean;
+    double m2;
+} ChainAccumulator;
+
+typedef struct
+{
+    const Frontier* frontier;
+    const SamplerOptions* options;
+    uint32_t* variableConstraints;
+    uint8_t* variableConstraintCount;
+    ChainAccumulator* chains;
+    double acceptance[SAMPLER_REPLICAS][SAMPLER_MAX_ENERGY_DELTA + 1];
+} SamplerModel;
+
+typedef struct
+{
+    uint8_t* variables;
+    int32_t* sums;
+    uint32_t unconstrainedMines;
+    int32_t energy;
+} Replica;
+
+typedef struct
+{
+    const SamplerModel* model;
+    struct splitmix64_state random;
+    Replica replicas[SAMPLER_REPLICAS];
+} Chain;
+
+static uint32_t
+RandomBelow(_Inout_ struct splitmix64_state* random, _In_ uint32_t bound)
+{
+    return (uint32_t)(((splitmix64(random) >> 32) * bound) >> 32);
+}
+
+static double
+RandomUnit(_Inout_ struct splitmix64_state* random)
+{
+    return (double)(splitmix64(random) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int32_t
+FlipVariable(_In_ const SamplerModel* model, _Inout_ Replica* replica, _In_ uint32_t variable)
+{
+    const uint32_t* constraints = &model->variableConstraints[variable * 8];
+    int32_t step = replica->variables[variable] ? -1 : 1;
+    int32_t delta = 0;
+
+    replica->variables[variable] ^= 1;
+
+    for (uint32_t i = 0; i < model->variableConstraintCount[variable]; i++)
+    {
+        uint32_t c = constraints[i];
+        int32_t target = model->frontier->constraints[c].mines;
+        int32_t before = abs(replica->sums[c] - target);
+
+        replica->sums[c] += step;
+        delta += abs(replica->sums[c] - target) - before;
+    }
+
+    return delta;
+}
+
+static bool
+Accept(_Inout_ Chain* chain, _In_ uint32_t replica, _In_ int32_t delta)
+{
+    if (delta <= 0)
+        return true;
+
+    if (delta > SAMPLER_MAX_ENERGY_DELTA)
+        return false;
+
+    return RandomUnit(&chain->random) < chain->model->acceptance[replica][delta];
+}
+
+static void
+ProposeSwap(_Inout_ Chain* chain, _In_ uint32_t index, _Inout_ ChainAccumulator* accumulator)
+{
+    const SamplerModel* model = chain->model;
+    const Frontier* frontier = model->frontier;
+    Replica* replica = &chain->replicas[index];
+    uint32_t a = RandomBelow(&chain->random, frontier->variableCount);
+    uint32_t b = RandomBelow(&chain->random, frontier->variableCount + frontier->unconstrainedCount);
+
+    accumulator->proposals++;
+
+    if (b < frontier->variableCount)
+    {
+        if (a == b || replica->variables[a] == replica->variables[b])
+            return;
+
+        int32_t delta = FlipVariable(model, replica, a);
+        delta += FlipVariable(model, replica, b);
+
+        if (Accept(chain, index, delta))
+        {
+            replica->energy += delta;
+            accumulator->acceptedProposals++;
+        }
+        else
+        {
+            FlipVariable(model, replica, b);
+            FlipVariable(model, replica, a);
+        }
+
+        return;
+    }
+
+    bool unconstrainedMine = RandomBelow(&chain->random, frontier->unconstrainedCount) < replica->unconstrainedMines;
+
+    if (replica->variables[a] == unconstrainedMine)
+        return;
+
+    int32_t delta = FlipVariable(model, replica, a);
+
+    if (Accept(chain, index, delta))
+    {
+        replica->energy += delta;
+        accumulator->acceptedProposals++;
+
+        if (unconstrainedMine)
+            replica->unconstrainedMines--;
+        else
+            replica->unconstrainedMines++;
+    }
+    else
+    {
+        FlipVariable(model, replica, a);
+    }
+}
+
+static void
+ExchangeReplicas(_Inout_ Chain* chain)
+{
+    for (uint32_t i = 0; i + 1 < SAMPLER_REPLICAS; i++)
+    {
+        Replica* colder = &chain->replicas[i + 1];
+        Replica* hotter = &chain->replicas[i];
+        double exponent = (inverseTemperatures[i + 1] - inverseTemperatures[i]) * (colder->energy - hotter->energy);
+
+        if (exponent >= 0.0 || RandomUnit(&chain->random) < exp(exponent))
+        {
+            Replica swapped = *colder;
+            *colder = *hotter;
+            *hotter = swapped;
+        }
+    }
+}
+
+static void
+RecordSample(_In_ const Chain* chain, _In_ const Replica* replica, _Inout_ ChainAccumulator* accumulator)
+{
+    const Frontier* frontier = chain->model->frontier;
+    const SamplerOptions* options = chain->model->options;
+    uint32_t mines = 0;
+
+    for (uint32_t v = 0; v < frontier->variableCount; v++)
+    {
+        accumulator->mineCounts[v] += replica->variables[v];
+        mines += replica->variables[v];
+    }
+
+    accumulator->unconstrainedMines += replica->unconstrainedMines;
+    accumulator->samples++;
+
+    double delta = (double)mines - accumulator->mean;
+    accumulator->mean += delta / (double)accumulator->samples;
+    accumulator->m2 += delta * ((double)mines - accumulator->mean);
+
+    if (options->callback != NULL)
+        options->callback(options->context, replica->variables, frontier->variableCount, replica->unconstrainedMines);
+}
+
+static void
+InitReplica(_In_ const SamplerModel* model, _Inout_ struct splitmix64_state* random, _Inout_ Replica* replica)
+{
+    const Frontier* frontier = model->frontier;
+    uint32_t remaining = frontier->remainingMines;
+
+    replica->unconstrainedMines = min(remaining, frontier->unconstrainedCount);
+    remaining -= replica->unconstrainedMines;
+
+    while (remaining > 0)
+    {
+        uint32_t v = RandomBelow(random, frontier->variableCount);
+
+        if (!replica->variables[v])
+        {
+            replica->variables[v] = 1;
+            remaining--;
+        }
+    }
+
+    for (uint32_t v = 0; v < frontier->variableCount; v++)
+    {
+        for (uint32_t i = 0; i < model->variableConstraintCount[v]; i++)
+            replica->sums[model->variableConstraints[v * 8 + i]] += replica->variables[v];
+    }
+
+    replica->energy = 0;
+
+    for (uint32_t c = 0; c < frontier->constraintCount; c++)
+        replica->energy += abs(replica->sums[c] - (int32_t)frontier->constraints[c].mines);
+}
+
+static void
+RunChain(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    SamplerModel* model = (SamplerModel*)context;
+    const Frontier* frontier = model->frontier;
+    const SamplerOptions* options = model->options;
+    ChainAccumulator* accumulator = &model->chains[index];
+    HANDLE hHeap = GetProcessHeap();
+    bool allocated = true;
+
+    Chain chain = {
+        .model = model,
+        .random = {.s = options->seed ^ ((uint64_t)(index + 1) * 0xD1B54A32D192ED03ull)},
+    };
+
+    for (uint32_t r = 0; r < SAMPLER_REPLICAS; r++)
+    {
+        Replica* replica = &chain.replicas[r];
+        replica->variables = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, frontier->variableCount);
+        replica->sums = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(int32_t) * max(frontier->constraintCount, 1u));
+
+        if (replica->variables == NULL || replica->sums == NULL)
+            allocated = false;
+        else
+            InitReplica(model, &chain.random, replica);
+    }
+
+    if (allocated)
+    {
+        uint32_t sweepsPerSample = max(options->sweepsPerSample, 1u);
+        uint64_t sweepLimit = options->burnIn +
+                              (uint64_t)options->samplesPerChain * sweepsPerSample * SAMPLER_SWEEP_LIMIT_FACTOR;
+
+        for (uint64_t sweep = 0; sweep < sweepLimit && accumulator->samples < options->samplesPerChain; sweep++)
+        {
+            for (uint32_t r = 0; r < SAMPLER_REPLICAS; r++)
+            {
+                for (uint32_t i = 0; i < frontier->variableCount; i++)
+                    ProposeSwap(&chain, r, accumulator);
+            }
+
+            ExchangeReplicas(&chain);
+
+            if (sweep < options->burnIn || (sweep - options->burnIn) % sweepsPerSample != 0)
+                continue;
+
+            for (uint32_t r = 0; r < SAMPLER_REPLICAS && accumulator->samples < options->samplesPerChain; r++)
+            {
+                if (chain.replicas[r].energy == 0)
+                    RecordSample(&chain, &chain.replicas[r], accumulator);
+            }
+        }
+    }
+
+    for (uint32_t r = 0; r < SAMPLER_REPLICAS; r++)
+    {
+        HeapFree(hHeap, 0, chain.replicas[r].variables);
+        HeapFree(hHeap, 0, chain.replicas[r].sums);
+    }
+}
+
+static double
+GetPotentialScaleReduction(_In_reads_(chainCount) const ChainAccumulator* chains, _In_ uint32_t chainCount)
+{
+    double meanOfMeans = 0.0;
+    double within = 0.0;
+    double length = 0.0;
+    uint32_t used = 0;
+
+    for (uint32_t i = 0; i < chainCount; i++)
+    {
+        if (chains[i].samples < 2)
+            continue;
+
+        meanOfMeans += chains[i].mean;
+        within += chains[i].m2 / (double)(chains[i].samples - 1);
+        length += (double)chains[i].samples;
+        used++;
+    }
+
+    if (used < 2)
+        return NAN;
+
+    meanOfMeans /= used;
+    within /= used;
+    length /= used;
+
+    double between = 0.0;
+
+    for (uint32_t i = 0; i < chainCount; i++)
+    {
+        if (chains[i].samples >= 2)
+            between += (chains[i].mean - meanOfMeans) * (chains[i].mean - meanOfMeans);
+    }
+
+    between /= used - 1;
+
+    if (within <= 0.0)
+        return between <= 0.0 ? 1.0 : INFINITY;
+
+    double pooled = (length - 1.0) / length * within + between;
+    return sqrt(pooled / within);
+}
+
+void
+GetDefaultSamplerOptions(_Out_ SamplerOptions* options)
+{
+    options->seed = 0x5DEECE66Dull;
+    options->chains = SAMPLER_DEFAULT_CHAINS;
+    options->threads = 0;
+    options->burnIn = SAMPLER_DEFAULT_BURN_IN;
+    options->samplesPerChain = SAMPLER_DEFAULT_SAMPLES;
+    options->sweepsPerSample = SAMPLER_DEFAULT_SWEEPS_PER_SAMPLE;
+    options->callback = NULL;
+    options->context = NULL;
+}
+
+bool
+SampleFrontier(
+    _In_ const Frontier* frontier,
+    _In_ const SamplerOptions* options,
+    _Out_writes_(frontier->width* frontier->height) double* probability,
+    _Out_ SamplerStats* stats)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t variableCount = frontier->variableCount;
+    uint32_t chainCount = max(options->chains, 1u);
+
+    ZeroMemory(stats, sizeof(SamplerStats));
+
+    if (frontier->remainingMines > variableCount + frontier->unconstrainedCount)
+        return false;
+
+    if (variableCount == 0)
+    {
+        if (frontier->unconstrainedCount > 0)
+            stats->unconstrainedProbability = (double)frontier->remainingMines / frontier->unconstrainedCount;
+
+        return true;
+    }
+
+    SamplerModel model = {
+        .frontier = frontier,
+        .options = options,
+        .variableConstraints = HeapAlloc(hHeap, 0, sizeof(uint32_t) * 8 * variableCount),
+        .variableConstraintCount = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, variableCount),
+        .chains = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(ChainAccumulator) * chainCount),
+    };
+
+    uint64_t* mineCounts = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(uint64_t) * variableCount * chainCount);
+    bool success = false;
+
+    if (model.variableConstraints == NULL || model.variableConstraintCount == NULL || model.chains == NULL ||
+        mineCounts == NULL)
+    {
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < frontier->componentCount; i++)
+    {
+        const FrontierComponent* component = &frontier->components[i];
+
+        for (uint32_t c = component->firstConstraint; c < component->firstConstraint + component->constraintCount; c++)
+        {
+            const FrontierConstraint* constraint = &frontier->constraints[c];
+
+            for (uint32_t j = 0; j < constraint->variableCount; j++)
+            {
+                uint32_t v = component->firstVariable + constraint->variables[j];
+                model.variableConstraints[v * 8 + model.variableConstraintCount[v]++] = c;
+            }
+        }
+    }
+
+    for (uint32_t r = 0; r < SAMPLER_REPLICAS; r++)
+    {
+        for (uint32_t delta = 0; delta <= SAMPLER_MAX_ENERGY_DELTA; delta++)
+            model.acceptance[r][delta] = exp(-inverseTemperatures[r] * delta);
+    }
+
+    for (uint32_t i = 0; i < chainCount; i++)
+        model.chains[i].mineCounts = &mineCounts[(size_t)i * variableCount];
+
+    ParallelFor(chainCount, options->threads, RunChain, &model);
+
+    uint64_t unconstrainedMines = 0;
+
+    for (uint32_t i = 0; i < chainCount; i++)
+    {
+        stats->samples += model.chains[i].samples;
+        stats->proposals += model.chains[i].proposals;
+        stats->acceptedProposals += model.chains[i].acceptedProposals;
+        unconstrainedMines += model.chains[i].unconstrainedMines;
+    }
+
+    if (stats->samples == 0)
+        goto cleanup;
+
+    for (uint32_t v = 0; v < variableCount; v++)
+    {
+        uint64_t mines = 0;
+
+        for (uint32_t i = 0; i < chainCount; i++)
+            mines += model.chains[i].mineCounts[v];
+
+        probability[frontier->variables[v]] = (double)mines / (double)stats->samples;
+    }
+
+    if (frontier->unconstrainedCount > 0)
+    {
+        stats->unconstrainedProbability =
+            (double)unconstrainedMines / (double)stats->samples / (double)frontier->unconstrainedCount;
+    }
+
+    stats->potentialScaleReduction = GetPotentialScaleReduction(model.chains, chainCount);
+    success = true;
+
+cleanup:
+    HeapFree(hHeap, 0, model.variableConstraints);
+    HeapFree(hHeap, 0, model.variableConstraintCount);
+    HeapFree(hHeap, 0, model.chains);
+    HeapFree(hHeap, 0, mineCounts);
+
+    return success;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "solver.h"
+
+#define SAMPLER_DEFAULT_CHAINS 8
+#define SAMPLER_DEFAULT_BURN_IN 200
+#define SAMPLER_DEFAULT_SAMPLES 2000
+#define SAMPLER_DEFAULT_SWEEPS_PER_SAMPLE 2
+
+// Called once per consistent sample, from worker threads unless options->threads is 1.
+typedef void (*SamplerCallback)(
+    _Inout_opt_ void* context,
+    _In_reads_(variableCount) const uint8_t* variables,
+    _In_ uint32_t variableCount,
+    _In_ uint32_t unconstrainedMines);
+
+typedef struct
+{
+    uint64_t seed;
+    uint32_t chains;
+    uint32_t threads;
+    uint32_t burnIn;
+    uint32_t samplesPerChain;
+    uint32_t sweepsPerSample;
+    SamplerCallback callback;
+    void* context;
+} SamplerOptions;
+
+typedef struct
+{
+    double unconstrainedProbability;
+    double potentialScaleReduction;
+    uint64_t samples;
+    uint64_t proposals;
+    uint64_t acceptedProposals;
+} SamplerStats;
+
+void GetDefaultSamplerOptions(_Out_ SamplerOptions* options);
+
+bool SampleFrontier(
+    _In_ const Frontier* frontier,
+    _In_ const SamplerOptions* options,
+    _Out_writes_(frontier->width* frontier->height) double* probability,
+    _Out_ SamplerStats* stats);
@@ -0,0 +1,581 @@
+#include "pch.h"
+
+#include <wchar.h>
+
+#include "littleendian.h"
+#include "replay.h"
+#include "savegame.h"
+
+#define SAVE_GAME_MAGIC 0x5653534Du
+#define SAVE_GAME_VERSION 1
+#define SAVE_GAME_RECORD_HEADER_SIZE 8
+#define SAVE_GAME_STATE_SIZE 104
+#define SAVE_GAME_IMAGE_CAPACITY (SAVE_GAME_CHUNKS * SAVE_GAME_CHUNK_SIZE)
+#define SAVE_GAME_CHUNK_RECORD_SIZE (SAVE_GAME_RECORD_HEADER_SIZE + SAVE_GAME_CHUNK_SIZE)
+#define SAVE_GAME_STATE_RECORD_SIZE (SAVE_GAME_RECORD_HEADER_SIZE + SAVE_GAME_STATE_SIZE)
+#define SAVE_GAME_BUFFER_SIZE                                                                                          \
+    (SAVE_GAME_HEADER_SIZE + SAVE_GAME_CHUNKS * SAVE_GAME_CHUNK_RECORD_SIZE + SAVE_GAME_STATE_RECORD_SIZE)
+
+#define SAVED_CELL_COUNT_MASK 0x0F
+#define SAVED_CELL_MINE 0x10
+#define SAVED_CELL_STATE_SHIFT 5
+
+#define SAVED_FIRST_CLICK 0x01
+#define SAVED_MINES_PLACED 0x02
+#define SAVED_RECORDING 0x04
+#define SAVED_LAYOUT_RECORDED 0x08
+
+typedef enum
+{
+    SAVE_RECORD_CHUNK = 1,
+    SAVE_RECORD_STATE = 2
+} SaveRecordType;
+
+// Times are saved as their age when the game was saved, plus one so that a time that was never set stays zero.
+static uint64_t
+GetSavedAge(_In_ uint64_t now, _In_ uint64_t time)
+{
+    return time == 0 ? 0 : now - time + 1;
+}
+
+static uint64_t
+GetRestoredTime(_In_ uint64_t now, _In_ uint64_t age)
+{
+    return age == 0 ? 0 : now - (age - 1);
+}
+
+static bool
+IsZeroChunk(_In_reads_bytes_(SAVE_GAME_CHUNK_SIZE) const uint8_t* chunk)
+{
+    for (uint32_t i = 0; i < SAVE_GAME_CHUNK_SIZE; i++)
+    {
+        if (chunk[i] != 0)
+            return false;
+    }
+
+    return true;
+}
+
+static void
+BuildSaveImage(_Out_writes_bytes_(SAVE_GAME_IMAGE_CAPACITY) uint8_t* image, _In_ const Minefield* field)
+{
+    uint32_t cellCount = field->width * field->height;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        const Cell* cell = &field->cells[i];
+
+        image[i] = (uint8_t)(cell->neighborMines | (cell->hasMine ? SAVED_CELL_MINE : 0) |
+                             (uint32_t)cell->state << SAVED_CELL_STATE_SHIFT);
+    }
+
+    ZeroMemory(image + cellCount, SAVE_GAME_CELL_BYTES - cellCount);
+
+    if (field->replay != NULL)
+    {
+        CopyMemory(image + SAVE_GAME_CELL_BYTES, field->replay->layout, REPLAY_LAYOUT_BYTES);
+        CopyMemory(image + SAVE_GAME_CELL_BYTES + REPLAY_LAYOUT_BYTES, field->replay->events, REPLAY_BUFFER_SIZE);
+    }
+    else
+    {
+        ZeroMemory(image + SAVE_GAME_CELL_BYTES, REPLAY_LAYOUT_BYTES + REPLAY_BUFFER_SIZE);
+    }
+
+    ZeroMemory(image + SAVE_GAME_IMAGE_SIZE, SAVE_GAME_IMAGE_CAPACITY - SAVE_GAME_IMAGE_SIZE);
+}
+
+static uint32_t
+PutChunkRecord(
+    _Out_writes_bytes_(SAVE_GAME_CHUNK_RECORD_SIZE) uint8_t* record,
+    _In_ uint32_t chunk,
+    _In_reads_bytes_(SAVE_GAME_IMAGE_CAPACITY) const uint8_t* image)
+{
+    PutLittleEndian(record, SAVE_RECORD_CHUNK, 2);
+    PutLittleEndian(record + 2, chunk, 2);
+    PutLittleEndian(record + 4, SAVE_GAME_CHUNK_SIZE, 4);
+    CopyMemory(record + SAVE_GAME_RECORD_HEADER_SIZE, image + chunk * SAVE_GAME_CHUNK_SIZE, SAVE_GAME_CHUNK_SIZE);
+
+    return SAVE_GAME_CHUNK_RECORD_SIZE;
+}
+
+static uint32_t
+PutStateRecord(_Out_writes_bytes_(SAVE_GAME_STATE_RECORD_SIZE) uint8_t* record, _In_ const Minefield* field)
+{
+    const ReplayLog* log = field->replay;
+    uint8_t* state = record + SAVE_GAME_RECORD_HEADER_SIZE;
+    uint64_t now = GetTickCount64();
+    uint32_t flags = (field->firstClick ? SAVED_FIRST_CLICK : 0) | (field->minesPlaced ? SAVED_MINES_PLACED : 0);
+
+    ZeroMemory(record, SAVE_GAME_STATE_RECORD_SIZE);
+    PutLittleEndian(record, SAVE_RECORD_STATE, 2);
+    PutLittleEndian(record + 4, SAVE_GAME_STATE_SIZE, 4);
+
+    PutLittleEndian(state, field->width, 2);
+    PutLittleEndian(state + 2, field->height, 2);
+    PutLittleEndian(state + 4, field->totalMines, 2);
+    PutLittleEndian(state + 6, field->difficulty, 1);
+    PutLittleEndian(state + 7, field->state, 1);
+    PutLittleEndian(state + 8, field->flaggedCells, 4);
+    PutLittleEndian(state + 12, field->revealedCells, 4);
+    PutLittleEndian(state + 16, field->blastX, 4);
+    PutLittleEndian(state + 20, field->blastY, 4);
+    PutLittleEndian(state + 24, field->hash, 8);
+    PutLittleEndian(state + 32, field->seed, 8);
+    PutLittleEndian(state + 40, GetSavedAge(now, field->startTime), 8);
+    PutLittleEndian(state + 48, GetSavedAge(now, field->endTime), 8);
+
+    // Without a log the replay fields stay zero, which restores as an empty log that is not recording.
+    if (log == NULL)
+    {
+        PutLittleEndian(state + 56, flags, 1);
+        return SAVE_GAME_STATE_RECORD_SIZE;
+    }
+
+    flags |= (log->recording ? SAVED_RECORDING : 0) | (log->layoutRecorded ? SAVED_LAYOUT_RECORDED : 0);
+
+    PutLittleEndian(state + 56, flags, 1);
+    PutLittleEndian(state + 60, log->firstClick, 4);
+    PutLittleEndian(state + 64, log->seed, 8);
+    PutLittleEndian(state + 72, GetSavedAge(now, log->baseTime), 8);
+    PutLittleEndian(state + 80, GetSavedAge(now, log->lastTime), 8);
+    PutLittleEndian(state + 88, log->head, 4);
+    PutLittleEndian(state + 92, log->length, 4);
+    PutLittleEndian(state + 96, log->eventCount, 4);
+    PutLittleEndian(state + 100, log->droppedEvents, 4);
+
+    return SAVE_GAME_STATE_RECORD_SIZE;
+}
+
+static bool
+WriteSaveBytes(_In_ HANDLE hFile, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    DWORD written = 0;
+
+    return WriteFile(hFile, bytes, size, &written, NULL) && written == size;
+}
+
+// Writes the live chunks to a new file next to the old one and moves it into place, so a failure at any point
+// leaves the previous save whole.
+static bool
+RewriteSaveGame(_Inout_ SaveGameWriter* writer, _In_ const Minefield* field)
+{
+    wchar_t temporary[MAX_PATH + 4];
+    uint8_t* buffer = writer->buffer;
+    uint32_t size = SAVE_GAME_HEADER_SIZE;
+    uint32_t chunks = 0;
+
+    ZeroMemory(buffer, SAVE_GAME_HEADER_SIZE);
+    PutLittleEndian(buffer, SAVE_GAME_MAGIC, 4);
+    PutLittleEndian(buffer + 4, SAVE_GAME_VERSION, 2);
+    PutLittleEndian(buffer + 6, SAVE_GAME_CHUNK_SIZE, 2);
+    PutLittleEndian(buffer + 8, SAVE_GAME_IMAGE_SIZE, 4);
+
+    for (uint32_t chunk = 0; chunk < SAVE_GAME_CHUNKS; chunk++)
+    {
+        if (!IsZeroChunk(writer->image + chunk * SAVE_GAME_CHUNK_SIZE))
+        {
+            size += PutChunkRecord(buffer + size, chunk, writer->image);
+            chunks++;
+        }
+    }
+
+    size += PutStateRecord(buffer + size, field);
+
+    if (writer->hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(writer->hFile);
+        writer->hFile = INVALID_HANDLE_VALUE;
+    }
+
+    writer->compacted = false;
+    wcscpy_s(temporary, ARRAYSIZE(temporary), writer->path);
+    wcscat_s(temporary, ARRAYSIZE(temporary), L".tmp");
+
+    HANDLE hFile = CreateFileW(temporary, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool success = WriteSaveBytes(hFile, buffer, size) && FlushFileBuffers(hFile);
+
+    CloseHandle(hFile);
+
+    if (!success || !MoveFileExW(temporary, writer->path, MOVEFILE_REPLACE_EXISTING))
+    {
+        DWORD error = GetLastError();
+
+        DeleteFileW(temporary);
+        SetLastError(error);
+
+        return false;
+    }
+
+    writer->hFile =
+        CreateFileW(writer->path, FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (writer->hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    uint8_t* saved = writer->saved;
+
+    writer->saved = writer->image;
+    writer->image = saved;
+    writer->size = size;
+    writer->liveSize = size;
+    writer->lastChunks = chunks;
+    writer->lastBytes = size;
+    writer->compacted = true;
+
+    return true;
+}
+
+bool
+CreateSaveGameWriter(_Out_ SaveGameWriter* writer, _In_z_ const wchar_t* path)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    ZeroMemory(writer, sizeof(SaveGameWriter));
+    writer->hFile = INVALID_HANDLE_VALUE;
+
+    // Leaves room for the suffix of the file a rewrite goes through.
+    if (wcslen(path) >= MAX_PATH - 4)
+    {
+        SetLastError(ERROR_FILENAME_EXCED_RANGE);
+        return false;
+    }
+
+    wcscpy_s(writer->path, ARRAYSIZE(writer->path), path);
+    writer->image = HeapAlloc(hHeap, 0, SAVE_GAME_IMAGE_CAPACITY);
+    writer->saved = HeapAlloc(hHeap, 0, SAVE_GAME_IMAGE_CAPACITY);
+    writer->buffer = HeapAlloc(hHeap, 0, SAVE_GAME_BUFFER_SIZE);
+
+    if (writer->image == NULL || writer->saved == NULL || writer->buffer == NULL)
+    {
+        CloseSaveGameWriter(writer);
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SaveGame(_Inout_ SaveGameWriter* writer, _In_ const Minefield* field)
+{
+    BuildSaveImage(writer->image, field);
+
+    if (!writer->compacted || writer->size - writer->liveSize > SAVE_GAME_MAX_GARBAGE)
+        return RewriteSaveGame(writer, field);
+
+    uint8_t* buffer = writer->buffer;
+    uint32_t size = 0;
+    uint32_t chunks = 0;
+    uint64_t liveSize = writer->liveSize;
+
+    for (uint32_t chunk = 0; chunk < SAVE_GAME_CHUNKS; chunk++)
+    {
+        const uint8_t* current = writer->image + chunk * SAVE_GAME_CHUNK_SIZE;
+        const uint8_t* previous = writer->saved + chunk * SAVE_GAME_CHUNK_SIZE;
+
+        if (memcmp(current, previous, SAVE_GAME_CHUNK_SIZE) == 0)
+            continue;
+
+        size += PutChunkRecord(buffer + size, chunk, writer->image);
+        chunks++;
+
+        // A rewrite leaves out chunks that are all zero, so only the others count towards its size.
+        liveSize -= IsZeroChunk(previous) ? 0 : SAVE_GAME_CHUNK_RECORD_SIZE;
+        liveSize += IsZeroChunk(current) ? 0 : SAVE_GAME_CHUNK_RECORD_SIZE;
+    }
+
+    size += PutStateRecord(buffer + size, field);
+
+    if (!WriteSaveBytes(writer->hFile, buffer, size))
+    {
+        // The file may end in part of a record now, so the next save starts a new one.
+        writer->compacted = false;
+        return false;
+    }
+
+    uint8_t* saved = writer->saved;
+
+    writer->saved = writer->image;
+    writer->image = saved;
+    writer->size += size;
+    writer->liveSize = liveSize;
+    writer->lastChunks = chunks;
+    writer->lastBytes = size;
+
+    return true;
+}
+
+void
+CloseSaveGameWriter(_Inout_ SaveGameWriter* writer)
+{
+    HANDLE hHeap = GetProcessHeap();
+
+    if (writer->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(writer->hFile);
+
+    HeapFree(hHeap, 0, writer->image);
+    HeapFree(hHeap, 0, writer->saved);
+    HeapFree(hHeap, 0, writer->buffer);
+    ZeroMemory(writer, sizeof(SaveGameWriter));
+    writer->hFile = INVALID_HANDLE_VALUE;
+}
+
+_Success_(return) static bool
+GetSaveRecord(
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint64_t size,
+    _In_ uint64_t offset,
+    _Out_ SaveRecordType* type,
+    _Out_ uint32_t* chunk)
+{
+    if (size - offset < SAVE_GAME_RECORD_HEADER_SIZE)
+        return false;
+
+    *type = (SaveRecordType)GetLittleEndian(bytes + offset, 2);
+    *chunk = (uint32_t)GetLittleEndian(bytes + offset + 2, 2);
+
+    uint64_t length = GetLittleEndian(bytes + offset + 4, 4);
+
+    if (*type == SAVE_RECORD_CHUNK)
+        return *chunk < SAVE_GAME_CHUNKS && length == SAVE_GAME_CHUNK_SIZE &&
+               size - offset >= SAVE_GAME_CHUNK_RECORD_SIZE;
+
+    return *type == SAVE_RECORD_STATE && length == SAVE_GAME_STATE_SIZE &&
+           size - offset >= SAVE_GAME_STATE_RECORD_SIZE;
+}
+
+static uint64_t
+GetSaveRecordSize(_In_ SaveRecordType type)
+{
+    return type == SAVE_RECORD_CHUNK ? SAVE_GAME_CHUNK_RECORD_SIZE : SAVE_GAME_STATE_RECORD_SIZE;
+}
+
+static bool
+ApplySavedChunk(
+    _Inout_ Minefield* field,
+    _In_ uint32_t chunk,
+    _In_reads_bytes_(SAVE_GAME_CHUNK_SIZE) const uint8_t* bytes)
+{
+    uint32_t cellCount = field->width * field->height;
+
+    for (uint32_t i = 0; i < SAVE_GAME_CHUNK_SIZE; i++)
+    {
+        uint32_t offset = chunk * SAVE_GAME_CHUNK_SIZE + i;
+
+        if (offset < cellCount)
+        {
+            Cell* cell = &field->cells[offset];
+            uint32_t count = bytes[i] & SAVED_CELL_COUNT_MASK;
+            uint32_t state = bytes[i] >> SAVED_CELL_STATE_SHIFT;
+
+            if (count > 8 || state > CELL_FLAGGED)
+                return false;
+
+            cell->neighborMines = (uint8_t)count;
+            cell->hasMine = (bytes[i] & SAVED_CELL_MINE) != 0;
+            cell->state = (CellState)state;
+        }
+        else if (field->replay == NULL)
+        {
+            continue;
+        }
+        else if (offset >= SAVE_GAME_CELL_BYTES && offset < SAVE_GAME_CELL_BYTES + REPLAY_LAYOUT_BYTES)
+        {
+            field->replay->layout[offset - SAVE_GAME_CELL_BYTES] = bytes[i];
+        }
+        else if (offset >= SAVE_GAME_CELL_BYTES + REPLAY_LAYOUT_BYTES && offset < SAVE_GAME_IMAGE_SIZE)
+        {
+            field->replay->events[offset - SAVE_GAME_CELL_BYTES - REPLAY_LAYOUT_BYTES] = bytes[i];
+        }
+    }
+
+    return true;
+}
+
+static bool
+ApplySavedState(_Inout_ Minefield* field, _In_reads_bytes_(SAVE_GAME_STATE_SIZE) const uint8_t* state)
+{
+    ReplayLog* log = field->replay;
+    uint64_t now = GetTickCount64();
+    uint32_t flags = (uint32_t)GetLittleEndian(state + 56, 1);
+    uint32_t difficulty = (uint32_t)GetLittleEndian(state + 6, 1);
+    uint32_t gameState = (uint32_t)GetLittleEndian(state + 7, 1);
+
+    if (difficulty > DIFFICULTY_CUSTOM || gameState > GAME_LOST)
+        return false;
+
+    field->difficulty = (Difficulty)difficulty;
+    field->state = (GameState)gameState;
+    field->flaggedCells = (uint32_t)GetLittleEndian(state + 8, 4);
+    field->revealedCells = (uint32_t)GetLittleEndian(state + 12, 4);
+    field->blastX = (uint32_t)GetLittleEndian(state + 16, 4);
+    field->blastY = (uint32_t)GetLittleEndian(state + 20, 4);
+    field->hash = GetLittleEndian(state + 24, 8);
+    field->seed = GetLittleEndian(state + 32, 8);
+    field->startTime = GetRestoredTime(now, GetLittleEndian(state + 40, 8));
+    field->endTime = GetRestoredTime(now, GetLittleEndian(state + 48, 8));
+    field->firstClick = (flags & SAVED_FIRST_CLICK) != 0;
+    field->minesPlaced = (flags & SAVED_MINES_PLACED) != 0;
+
+    if (log == NULL)
+        return true;
+
+    log->firstClick = (uint32_t)GetLittleEndian(state + 60, 4);
+    log->seed = GetLittleEndian(state + 64, 8);
+    log->baseTime = GetRestoredTime(now, GetLittleEndian(state + 72, 8));
+    log->lastTime = GetRestoredTime(now, GetLittleEndian(state + 80, 8));
+    log->head = (uint32_t)GetLittleEndian(state + 88, 4);
+    log->length = (uint32_t)GetLittleEndian(state + 92, 4);
+    log->eventCount = (uint32_t)GetLittleEndian(state + 96, 4);
+    log->droppedEvents = (uint32_t)GetLittleEndian(state + 100, 4);
+    log->recording = (flags & SAVED_RECORDING) != 0;
+    log->layoutRecorded = (flags & SAVED_LAYOUT_RECORDED) != 0;
+
+    return log->head < REPLAY_BUFFER_SIZE && log->length <= REPLAY_BUFFER_SIZE;
+}
+
+// The counters and hash are kept as well as the cells, so a save whose records do not fit together is caught here.
+static bool
+CheckRestoredField(_In_ const Minefield* field)
+{
+    uint32_t cellCount = field->width * field->height;
+    uint32_t mines = 0;
+    uint32_t revealed = 0;
+    uint32_t flagged = 0;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        const Cell* cell = &field->cells[i];
+
+        mines += cell->hasMine ? 1 : 0;
+        revealed += cell->state == CELL_REVEALED && !cell->hasMine ? 1 : 0;
+        flagged += cell->state == CELL_FLAGGED ? 1 : 0;
+    }
+
+    if (mines != (field->minesPlaced ? field->totalMines : 0))
+        return false;
+
+    if (revealed != field->revealedCells || flagged != field->flaggedCells)
+        return false;
+
+    if (field->state == GAME_LOST && (field->blastX >= field->width || field->blastY >= field->height))
+        return false;
+
+    return ComputeMinefieldHash(field) == field->hash;
+}
+
+bool
+RestoreSavedGame(
+    _Out_ Minefield* field,
+    _Inout_opt_ OpeningIndex* openings,
+    _Inout_opt_ ReplayLog* log,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint64_t size)
+{
+    if (size < SAVE_GAME_HEADER_SIZE || GetLittleEndian(bytes, 4) != SAVE_GAME_MAGIC ||
+        GetLittleEndian(bytes + 4, 2) != SAVE_GAME_VERSION || GetLittleEndian(bytes + 6, 2) != SAVE_GAME_CHUNK_SIZE ||
+        GetLittleEndian(bytes + 8, 4) != SAVE_GAME_IMAGE_SIZE)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    SaveRecordType type;
+    uint32_t chunk;
+    uint64_t committed = 0;
+    uint64_t offset = SAVE_GAME_HEADER_SIZE;
+
+    // Only the record headers are read to find where the last complete save ends.
+    for (; GetSaveRecord(bytes, size, offset, &type, &chunk); offset += GetSaveRecordSize(type))
+    {
+        if (type == SAVE_RECORD_STATE)
+            committed = offset;
+    }
+
+    if (committed == 0)
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    uint64_t latest[SAVE_GAME_CHUNKS] = {0};
+
+    for (offset = SAVE_GAME_HEADER_SIZE; offset < committed; offset += GetSaveRecordSize(type))
+    {
+        GetSaveRecord(bytes, size, offset, &type, &chunk);
+
+        if (type == SAVE_RECORD_CHUNK)
+            latest[chunk] = offset;
+    }
+
+    const uint8_t* state = bytes + committed + SAVE_GAME_RECORD_HEADER_SIZE;
+    uint32_t width = (uint32_t)GetLittleEndian(state, 2);
+    uint32_t height = (uint32_t)GetLittleEndian(state + 2, 2);
+    uint32_t totalMines = (uint32_t)GetLittleEndian(state + 4, 2);
+
+    if (!CreateSizedMinefield(field, width, height, totalMines))
+        return false;
+
+    if (log != NULL)
+        AttachReplayLog(field, log);
+
+    bool success = true;
+
+    for (chunk = 0; success && chunk < SAVE_GAME_CHUNKS; chunk++)
+    {
+        if (latest[chunk] != 0)
+            success = ApplySavedChunk(field, chunk, bytes + latest[chunk] + SAVE_GAME_RECORD_HEADER_SIZE);
+    }
+
+    if (!success || !ApplySavedState(field, state) || !CheckRestoredField(field))
+    {
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    if (openings != NULL)
+        AttachOpeningIndex(field, openings);
+
+    return true;
+}
+
+bool
+LoadSavedGame(
+    _Out_ Minefield* field,
+    _Inout_opt_ OpeningIndex* openings,
+    _Inout_opt_ ReplayLog* log,
+    _In_z_ const wchar_t* path)
+{
+    LARGE_INTEGER size;
+    HANDLE hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart < SAVE_GAME_HEADER_SIZE)
+    {
+        CloseHandle(hFile);
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    const uint8_t* base = hMapping != NULL ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    bool success = base != NULL && RestoreSavedGame(field, openings, log, base, (uint64_t)size.QuadPart);
+    DWORD error = GetLastError();
+
+    if (base != NULL)
+        UnmapViewOfFile(base);
+
+    if (hMapping != NULL)
+        CloseHandle(hMapping);
+
+    CloseHandle(hFile);
+    SetLastError(error);
+
+    return success;
+}
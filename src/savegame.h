@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define SAVE_GAME_HEADER_SIZE 32
+#define SAVE_GAME_CHUNK_SIZE 256
+#define SAVE_GAME_CELL_BYTES (MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY)
+#define SAVE_GAME_IMAGE_SIZE (SAVE_GAME_CELL_BYTES + REPLAY_LAYOUT_BYTES + REPLAY_BUFFER_SIZE)
+#define SAVE_GAME_CHUNKS ((SAVE_GAME_IMAGE_SIZE + SAVE_GAME_CHUNK_SIZE - 1) / SAVE_GAME_CHUNK_SIZE)
+
+// Superseded records allowed to pile up in the file before the next save rewrites it from scratch.
+#define SAVE_GAME_MAX_GARBAGE (256 * 1024)
+
+// A saved game is an image of the board, one byte per cell with its count, mine and state, followed by the replay
+// log's layout bitmap and event ring, cut into 256-byte chunks. The file is a 32-byte header and a log of records: a
+// save appends the chunks that changed since the previous one and then a state record with the counters, the flags
+// and the times as ages, so the clock resumes where it stopped. Records after the last state record belong to a save
+// that never finished and are ignored. Once superseded records outgrow SAVE_GAME_MAX_GARBAGE the next save writes a
+// fresh file holding only the live chunks and moves it over the old one.
+typedef struct
+{
+    HANDLE hFile;
+    wchar_t path[MAX_PATH];
+    uint64_t size;
+    uint64_t liveSize;
+    uint8_t* image;
+    uint8_t* saved;
+    uint8_t* buffer;
+    uint32_t lastChunks;
+    uint32_t lastBytes;
+    bool compacted;
+} SaveGameWriter;
+
+bool CreateSaveGameWriter(_Out_ SaveGameWriter* writer, _In_z_ const wchar_t* path);
+
+// Appends the chunks that changed since the last save, or rewrites the file when it holds too many stale records or
+// has not been written by this writer yet.
+bool SaveGame(_Inout_ SaveGameWriter* writer, _In_ const Minefield* field);
+
+void CloseSaveGameWriter(_Inout_ SaveGameWriter* writer);
+
+// Rebuilds a field from the latest complete save, taking each chunk straight from the bytes of its last record. The
+// counters and hash are checked against the cells. The index and log given are attached to the field: the opening
+// index is built again and the log picks up the saved replay. A save made without a log restores an empty one.
+bool RestoreSavedGame(
+    _Out_ Minefield* field,
+    _Inout_opt_ OpeningIndex* openings,
+    _Inout_opt_ ReplayLog* log,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint64_t size);
+
+// Restores from a mapped view of the file.
+bool LoadSavedGame(
+    _Out_ Minefield* field,
+    _Inout_opt_ OpeningIndex* openings,
+    _Inout_opt_ ReplayLog* log,
+    _In_z_ const wchar_t* path);
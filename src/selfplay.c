@@ -0,0 +1,235 @@
+#include "pch.h"
+
+#include "random.h"
+#include "selfplay.h"
+
+#define SELF_PLAY_COUNT_MASK 0x0F
+#define SELF_PLAY_MINE 0x10
+#define SELF_PLAY_OPEN 0x20
+#define SELF_PLAY_FLAG 0x40
+
+static void
+GetNeighborOffsets(_In_ uint32_t width, _Out_writes_(8) int32_t* offsets)
+{
+    int32_t stride = (int32_t)width + 2;
+
+    offsets[0] = -stride - 1;
+    offsets[1] = -stride;
+    offsets[2] = -stride + 1;
+    offsets[3] = -1;
+    offsets[4] = 1;
+    offsets[5] = stride - 1;
+    offsets[6] = stride;
+    offsets[7] = stride + 1;
+}
+
+static uint32_t
+GetPaddedIndex(_In_ uint32_t width, _In_ uint32_t x, _In_ uint32_t y)
+{
+    return (y + 1) * (width + 2) + x + 1;
+}
+
+static uint32_t
+RevealSelfPlayCell(_Inout_ SelfPlayBoard* play, _In_ uint32_t index)
+{
+    uint8_t* board = play->board;
+    uint32_t revealed = 1;
+    uint32_t count = 0;
+    int32_t offsets[8];
+
+    GetNeighborOffsets(play->width, offsets);
+    board[index] |= SELF_PLAY_OPEN;
+
+    if ((board[index] & (SELF_PLAY_MINE | SELF_PLAY_COUNT_MASK)) == 0)
+        play->stack[count++] = (uint16_t)index;
+
+    // Neighbours of a zero cell are never mines and, with a sound player, never flagged.
+    while (count > 0)
+    {
+        int32_t cell = play->stack[--count];
+
+        for (uint32_t k = 0; k < 8; k++)
+        {
+            uint32_t neighbor = (uint32_t)(cell + offsets[k]);
+
+            if (board[neighbor] & (SELF_PLAY_OPEN | SELF_PLAY_FLAG))
+                continue;
+
+            board[neighbor] |= SELF_PLAY_OPEN;
+            revealed++;
+
+            if ((board[neighbor] & SELF_PLAY_COUNT_MASK) == 0)
+                play->stack[count++] = (uint16_t)neighbor;
+        }
+    }
+
+    return revealed;
+}
+
+// One pass of the single-cell rules over every revealed number: all its mines flagged means the rest are safe, and as
+// many hidden neighbours as unflagged mines means they are all mines. Returns whether anything changed.
+static bool
+ApplySelfPlayRules(_Inout_ SelfPlayBoard* play, _Inout_ uint32_t* revealed, _Inout_ SelfPlayGame* game)
+{
+    uint8_t* board = play->board;
+    bool progress = false;
+    int32_t offsets[8];
+
+    GetNeighborOffsets(play->width, offsets);
+
+    for (uint32_t y = 0; y < play->height; y++)
+    {
+        for (uint32_t x = 0; x < play->width; x++)
+        {
+            uint32_t index = GetPaddedIndex(play->width, x, y);
+            uint8_t cell = board[index];
+            uint32_t mines = cell & SELF_PLAY_COUNT_MASK;
+
+            if ((cell & SELF_PLAY_OPEN) == 0 || mines == 0)
+                continue;
+
+            uint32_t flagged = 0;
+            uint32_t hidden = 0;
+
+            for (uint32_t k = 0; k < 8; k++)
+            {
+                uint8_t neighbor = board[(int32_t)index + offsets[k]];
+
+                if (neighbor & SELF_PLAY_FLAG)
+                    flagged++;
+                else if ((neighbor & SELF_PLAY_OPEN) == 0)
+                    hidden++;
+            }
+
+            if (hidden == 0 || (flagged != mines && flagged + hidden != mines))
+                continue;
+
+            for (uint32_t k = 0; k < 8; k++)
+            {
+                uint32_t neighbor = (uint32_t)((int32_t)index + offsets[k]);
+
+                if (board[neighbor] & (SELF_PLAY_OPEN | SELF_PLAY_FLAG))
+                    continue;
+
+                if (flagged == mines)
+                    *revealed += RevealSelfPlayCell(play, neighbor);
+                else
+                    board[neighbor] |= SELF_PLAY_FLAG;
+
+                game->moves++;
+
+                if (*revealed == play->safeCells)
+                    return true;
+            }
+
+            progress = true;
+        }
+    }
+
+    return progress;
+}
+
+// Guesses the first cell that is neither revealed nor flagged, in reading order from a random start.
+static uint32_t
+ChooseSelfPlayGuess(_In_ const SelfPlayBoard* play, _Inout_ struct splitmix64_state* random)
+{
+    uint32_t cellCount = play->width * play->height;
+    uint32_t cell = (uint32_t)(splitmix64(random) % cellCount);
+
+    for (;;)
+    {
+        uint32_t index = GetPaddedIndex(play->width, cell % play->width, cell / play->width);
+
+        if ((play->board[index] & (SELF_PLAY_OPEN | SELF_PLAY_FLAG)) == 0)
+            return index;
+
+        cell = cell + 1 < cellCount ? cell + 1 : 0;
+    }
+}
+
+bool
+SetUpSelfPlayGame(
+    _Out_ SelfPlayBoard* play,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint32_t mines,
+    _In_ uint64_t seed)
+{
+    if (width == 0 || height == 0 || width > MAX_CELLS_HORIZONTALLY || height > MAX_CELLS_VERTICALLY ||
+        mines >= width * height)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    uint32_t paddedCells = (width + 2) * (height + 2);
+    uint32_t minesPlaced = 0;
+    int32_t offsets[8];
+
+    GetNeighborOffsets(width, offsets);
+    PlaceSeededMines(width, height, mines, seed, width / 2, height / 2, play->mines);
+
+    play->width = width;
+    play->height = height;
+
+    for (uint32_t i = 0; i < paddedCells; i++)
+        play->board[i] = SELF_PLAY_OPEN;
+
+    for (uint32_t y = 0; y < height; y++)
+        ZeroMemory(&play->board[GetPaddedIndex(width, 0, y)], width);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint32_t index = GetPaddedIndex(width, x, y);
+
+            if (!play->mines[y * width + x])
+                continue;
+
+            play->board[index] |= SELF_PLAY_MINE;
+            minesPlaced++;
+
+            // Border cells take counts too but are never read; no cell gets more than eight, so nothing carries over.
+            for (uint32_t k = 0; k < 8; k++)
+                play->board[(int32_t)index + offsets[k]]++;
+        }
+    }
+
+    play->safeCells = width * height - minesPlaced;
+
+    return true;
+}
+
+void
+PlaySelfPlayGame(_Inout_ SelfPlayBoard* play, _In_ uint64_t seed, _Out_ SelfPlayGame* game)
+{
+    struct splitmix64_state guesses = {
+        .s = mix64(seed),
+    };
+
+    ZeroMemory(game, sizeof(SelfPlayGame));
+
+    uint32_t revealed = RevealSelfPlayCell(play, GetPaddedIndex(play->width, play->width / 2, play->height / 2));
+    bool lost = false;
+
+    game->moves++;
+
+    while (revealed < play->safeCells && !lost)
+    {
+        if (ApplySelfPlayRules(play, &revealed, game))
+            continue;
+
+        uint32_t guess = ChooseSelfPlayGuess(play, &guesses);
+
+        game->moves++;
+        game->guesses++;
+
+        if (play->board[guess] & SELF_PLAY_MINE)
+            lost = true;
+        else
+            revealed += RevealSelfPlayCell(play, guess);
+    }
+
+    game->won = !lost;
+}
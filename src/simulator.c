@@ -0,0 +1,374 @@
+#include "pch.h"
+
+#include <math.h>
+
+#include "parallel.h"
+#include "random.h"
+#include "selfplay.h"
+#include "simulator.h"
+#include "solver.h"
+#include "solvercache.h"
+
+#define CONFIDENCE_Z 1.959963984540054
+
+typedef struct
+{
+    uint64_t wins;
+    uint64_t moves;
+    uint64_t guesses;
+    double generateSeconds;
+    double solveSeconds;
+    double moveSeconds;
+    QuantileSketch gameSeconds;
+} WorkerTotals;
+
+typedef struct
+{
+    const SimulationOptions* options;
+    SolverCache* cache;
+    WorkerTotals* totals;
+    volatile LONG64 nextGame;
+    double frequency;
+} Simulation;
+
+typedef struct
+{
+    Simulation* simulation;
+    WorkerTotals* totals;
+    Minefield* field;
+    SolverResult* result;
+    SelfPlayBoard* play;
+    bool* mines;
+    struct splitmix64_state random;
+} Worker;
+
+static double
+GetCounterSeconds(_In_ const Simulation* simulation)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / simulation->frequency;
+}
+
+static void
+MakeMove(_Inout_ Worker* worker, _In_ uint32_t x, _In_ uint32_t y, _In_ bool flag)
+{
+    double start = GetCounterSeconds(worker->simulation);
+
+    if (flag)
+        ToggleFlag(worker->field, x, y);
+    else
+        RevealCell(worker->field, x, y);
+
+    worker->totals->moveSeconds += GetCounterSeconds(worker->simulation) - start;
+    worker->totals->moves++;
+}
+
+// Returns false when no cell is left hidden, which only wrong flags can cause.
+static bool
+GuessRandomCell(_Inout_ Worker* worker)
+{
+    const Minefield* field = worker->field;
+    uint32_t hidden = 0;
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+        hidden += field->cells[i].state == CELL_HIDDEN;
+
+    if (hidden == 0)
+        return false;
+
+    uint32_t pick = (uint32_t)(((splitmix64(&worker->random) >> 32) * hidden) >> 32);
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+    {
+        if (field->cells[i].state == CELL_HIDDEN && pick-- == 0)
+        {
+            worker->totals->guesses++;
+            MakeMove(worker, i % field->width, i / field->width, false);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool
+GuessLeastLikelyCell(_Inout_ Worker* worker)
+{
+    const Minefield* field = worker->field;
+    uint32_t best = UINT32_MAX;
+    double bestProbability = 2.0;
+
+    for (uint32_t i = 0; i < field->width * field->height; i++)
+    {
+        double p = worker->result->probability[i];
+
+        if (field->cells[i].state == CELL_HIDDEN && p != SOLVER_PROBABILITY_UNKNOWN && p < bestProbability)
+        {
+            best = i;
+            bestProbability = p;
+        }
+    }
+
+    if (best == UINT32_MAX)
+        return GuessRandomCell(worker);
+
+    worker->totals->guesses++;
+    MakeMove(worker, best % field->width, best / field->width, false);
+
+    return true;
+}
+
+// Returns false when the game can make no further move. The workers already use every core, so the solver samples on
+// the calling thread.
+static bool
+PlaySolverMove(_Inout_ Worker* worker, _In_ BotStrategy strategy)
+{
+    Minefield* field = worker->field;
+    double start = GetCounterSeconds(worker->simulation);
+    bool solved = SolveMinefield(field, worker->simulation->cache, 1, worker->result);
+
+    worker->totals->solveSeconds += GetCounterSeconds(worker->simulation) - start;
+
+    if (!solved)
+        return GuessRandomCell(worker);
+
+    // Sampled frequencies never reach 0 or 1, so even when worker->result->sampled is set only proven cells are played
+    // here; anything picked from a sampled probability goes through the guesses below and is counted as one.
+    bool progress = false;
+
+    for (uint32_t y = 0; y < field->height && field->state == GAME_PLAYING; y++)
+    {
+        for (uint32_t x = 0; x < field->width && field->state == GAME_PLAYING; x++)
+        {
+            double p = worker->result->probability[y * field->width + x];
+
+            if (GetCell(field, x, y)->state != CELL_HIDDEN || (p != 0.0 && p != 1.0))
+                continue;
+
+            MakeMove(worker, x, y, p == 1.0);
+            progress = true;
+        }
+    }
+
+    if (progress)
+        return true;
+
+    if (strategy == STRATEGY_PROBABILITY)
+        return GuessLeastLikelyCell(worker);
+
+    return GuessRandomCell(worker);
+}
+
+// The rules player never needs the solver, so it plays on a board that holds only what it reads. Its moves are timed
+// as a whole.
+static void
+PlayRulesGame(_Inout_ Worker* worker, _In_ uint64_t seed)
+{
+    const SimulationOptions* options = worker->simulation->options;
+    double start = GetCounterSeconds(worker->simulation);
+    uint32_t width, height, mines;
+    SelfPlayGame game;
+
+    GetDifficultySettings(options->difficulty, &width, &height, &mines);
+    SetUpSelfPlayGame(worker->play, width, height, mines, seed);
+
+    double placed = GetCounterSeconds(worker->simulation);
+
+    PlaySelfPlayGame(worker->play, seed, &game);
+
+    double end = GetCounterSeconds(worker->simulation);
+
+    worker->totals->generateSeconds += placed - start;
+    worker->totals->moveSeconds += end - placed;
+    worker->totals->moves += game.moves;
+    worker->totals->guesses += game.guesses;
+    worker->totals->wins += game.won ? 1 : 0;
+
+    AddQuantileSketchValue(&worker->totals->gameSeconds, end - start);
+}
+
+static void
+PlayGame(_Inout_ Worker* worker, _In_ uint64_t game)
+{
+    const SimulationOptions* options = worker->simulation->options;
+    Minefield* field = worker->field;
+    uint64_t seed = GetSimulationGameSeed(options, game);
+
+    if (options->strategy == STRATEGY_RULES)
+    {
+        PlayRulesGame(worker, seed);
+        return;
+    }
+
+    double start = GetCounterSeconds(worker->simulation);
+
+    // Mines are placed here, as the first click would place them, so that placing them counts as generation rather
+    // than as a move.
+    CreateMinefield(field, options->difficulty);
+
+    uint32_t firstX = field->width / 2;
+    uint32_t firstY = field->height / 2;
+
+    field->seed = seed;
+    PlaceSeededMines(field->width, field->height, field->totalMines, seed, firstX, firstY, worker->mines);
+    SetMinefieldLayout(field, worker->mines);
+    worker->random.s = seed ^ 0xA0761D6478BD642Full;
+
+    worker->totals->generateSeconds += GetCounterSeconds(worker->simulation) - start;
+
+    MakeMove(worker, firstX, firstY, false);
+
+    // A game with nothing left to click is given up and counted as lost.
+    bool moved = true;
+
+    while (field->state == GAME_PLAYING && moved)
+    {
+        if (options->strategy == STRATEGY_RANDOM)
+            moved = GuessRandomCell(worker);
+        else
+            moved = PlaySolverMove(worker, options->strategy);
+    }
+
+    if (field->state == GAME_WON)
+        worker->totals->wins++;
+
+    AddQuantileSketchValue(&worker->totals->gameSeconds, GetCounterSeconds(worker->simulation) - start);
+}
+
+static void
+RunWorker(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    Simulation* simulation = (Simulation*)context;
+    HANDLE hHeap = GetProcessHeap();
+
+    Worker worker = {
+        .simulation = simulation,
+        .totals = &simulation->totals[index],
+        .field = HeapAlloc(hHeap, 0, sizeof(Minefield)),
+        .result = HeapAlloc(hHeap, 0, sizeof(SolverResult)),
+        .play = HeapAlloc(hHeap, 0, sizeof(SelfPlayBoard)),
+        .mines = HeapAlloc(hHeap, 0, sizeof(bool) * MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY),
+    };
+
+    if (worker.field != NULL && worker.result != NULL && worker.play != NULL && worker.mines != NULL)
+    {
+        for (;;)
+        {
+            uint64_t first = (uint64_t)InterlockedExchangeAdd64(&simulation->nextGame, SIMULATOR_BATCH_GAMES);
+
+            if (first >= simulation->options->games)
+                break;
+
+            uint64_t last = min(first + SIMULATOR_BATCH_GAMES, simulation->options->games);
+
+            for (uint64_t game = first; game < last; game++)
+                PlayGame(&worker, game);
+        }
+    }
+
+    HeapFree(hHeap, 0, worker.field);
+    HeapFree(hHeap, 0, worker.result);
+    HeapFree(hHeap, 0, worker.play);
+    HeapFree(hHeap, 0, worker.mines);
+}
+
+_Ret_maybenull_z_ const char*
+GetBotStrategyName(_In_ BotStrategy strategy)
+{
+    switch (strategy)
+    {
+        case STRATEGY_RANDOM:
+            return "random";
+        case STRATEGY_SAFE:
+            return "safe";
+        case STRATEGY_PROBABILITY:
+            return "probability";
+        case STRATEGY_RULES:
+            return "rules";
+        default:
+            return NULL;
+    }
+}
+
+// Results do not change with the thread count, and every strategy plays the same boards.
+uint64_t
+GetSimulationGameSeed(_In_ const SimulationOptions* options, _In_ uint64_t game)
+{
+    return mix64(options->seed + mix64((uint64_t)options->difficulty << 56 | game));
+}
+
+bool
+RunSimulation(_In_ const SimulationOptions* options, _Out_ SimulationResult* result)
+{
+    ZeroMemory(result, sizeof(SimulationResult));
+
+    if (options->games == 0 || GetBotStrategyName(options->strategy) == NULL)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    uint32_t threads = options->threads != 0 ? options->threads : GetParallelThreadCount();
+    threads = (uint32_t)min(min((uint64_t)threads, options->games), (uint64_t)PARALLEL_MAX_THREADS);
+
+    HANDLE hHeap = GetProcessHeap();
+    LARGE_INTEGER frequency;
+    SolverCache cache;
+
+    Simulation simulation = {
+        .options = options,
+        .cache = &cache,
+        .totals = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(WorkerTotals) * threads),
+        .nextGame = 0,
+    };
+
+    if (simulation.totals == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    if (!CreateSolverCache(&cache, SOLVER_CACHE_DEFAULT_ENTRIES))
+        simulation.cache = NULL;
+
+    QueryPerformanceFrequency(&frequency);
+    simulation.frequency = (double)frequency.QuadPart;
+
+    double start = GetCounterSeconds(&simulation);
+    ParallelFor(threads, threads, RunWorker, &simulation);
+    result->seconds = GetCounterSeconds(&simulation) - start;
+
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        result->wins += simulation.totals[i].wins;
+        result->moves += simulation.totals[i].moves;
+        result->guesses += simulation.totals[i].guesses;
+        result->generateSeconds += simulation.totals[i].generateSeconds;
+        result->solveSeconds += simulation.totals[i].solveSeconds;
+        result->moveSeconds += simulation.totals[i].moveSeconds;
+        MergeQuantileSketch(&result->gameSeconds, &simulation.totals[i].gameSeconds);
+    }
+
+    // Wilson score interval, which stays inside [0, 1] for win rates near either end.
+    double n = (double)options->games;
+    double p = (double)result->wins / n;
+    double z2 = CONFIDENCE_Z * CONFIDENCE_Z;
+    double center = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    double margin = CONFIDENCE_Z * sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+
+    result->games = options->games;
+    result->winRate = p;
+    result->confidenceLow = max(0.0, center - margin);
+    result->confidenceHigh = min(1.0, center + margin);
+    result->threads = threads;
+
+    if (simulation.cache != NULL)
+        DestroySolverCache(&cache);
+
+    HeapFree(hHeap, 0, simulation.totals);
+
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "quantilesketch.h"
+
+#define SIMULATOR_DEFAULT_GAMES 10000
+#define SIMULATOR_BATCH_GAMES 16
+
+typedef enum
+{
+    STRATEGY_RANDOM,
+    STRATEGY_SAFE,
+    STRATEGY_PROBABILITY,
+    STRATEGY_RULES
+} BotStrategy;
+
+typedef struct
+{
+    uint64_t seed;
+    uint64_t games;
+    uint32_t threads;
+    Difficulty difficulty;
+    BotStrategy strategy;
+} SimulationOptions;
+
+// Phase timings are summed over all workers, so they can exceed the wall-clock time of the run. gameSeconds holds
+// the time each game took, merged from the sketches of the workers.
+typedef struct
+{
+    uint64_t games;
+    uint64_t wins;
+    uint64_t moves;
+    uint64_t guesses;
+    double winRate;
+    double confidenceLow;
+    double confidenceHigh;
+    double seconds;
+    double generateSeconds;
+    double solveSeconds;
+    double moveSeconds;
+    QuantileSketch gameSeconds;
+    uint32_t threads;
+} SimulationResult;
+
+_Ret_maybenull_z_ const char* GetBotStrategyName(_In_ BotStrategy strategy);
+
+// The seed of a game depends only on the master seed, the difficulty and the game number.
+uint64_t GetSimulationGameSeed(_In_ const SimulationOptions* options, _In_ uint64_t game);
+
+bool RunSimulation(_In_ const SimulationOptions* options, _Out_ SimulationResult* result);
@@ -0,0 +1,1099 @@
+#include "pch.h"
+
+#include <intrin.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "sampler.h"
+#include "solver.h"
+#include "solvercache.h"
+
+#define VARIABLE_PENDING (UINT32_MAX - 1)
+#define VARIABLE_QUEUED (UINT32_MAX - 2)
+#define CONSTRAINT_VISITED (UINT32_MAX - 3)
+
+#define LANE_BITS 6
+
+static const uint64_t laneMasks[LANE_BITS] = {
+    0xAAAAAAAAAAAAAAAAull,
+    0xCCCCCCCCCCCCCCCCull,
+    0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull,
+    0xFFFF0000FFFF0000ull,
+    0xFFFFFFFF00000000ull,
+};
+
+typedef struct
+{
+    const FrontierConstraint* constraints;
+    double* solutions;
+    double* variableMines;
+    uint64_t solutionsEnumerated;
+    uint64_t candidatesTested;
+    uint32_t work;
+    uint32_t variableCount;
+    uint32_t constraintCount;
+    uint32_t prefixCount;
+    uint32_t laneCount;
+    uint32_t blockCount;
+    uint32_t prefixMineCount;
+    uint32_t suffixConstraintCount;
+    uint64_t validLanes;
+    uint64_t laneMinesMasks[LANE_BITS + 1];
+    uint16_t order[SOLVER_MAX_EXACT_VARIABLES];
+    uint16_t prefixMines[SOLVER_MAX_EXACT_VARIABLES];
+    uint8_t variableConstraintCount[SOLVER_MAX_EXACT_VARIABLES];
+    uint16_t variableConstraints[SOLVER_MAX_EXACT_VARIABLES][8];
+    int32_t assigned[SOLVER_MAX_EXACT_CONSTRAINTS];
+    int32_t unassigned[SOLVER_MAX_EXACT_CONSTRAINTS];
+    uint16_t suffixConstraints[SOLVER_MAX_EXACT_CONSTRAINTS];
+    uint8_t laneVariables[SOLVER_MAX_EXACT_CONSTRAINTS];
+    uint8_t laneVariableCount[SOLVER_MAX_EXACT_CONSTRAINTS];
+    uint32_t blockVariables[SOLVER_MAX_EXACT_CONSTRAINTS];
+} Enumerator;
+
+static uint32_t
+GetHiddenNeighbors(
+    _In_ const Minefield* field,
+    _In_ uint32_t x,
+    _In_ uint32_t y,
+    _Out_writes_(8) uint32_t* hidden,
+    _Out_ uint32_t* flagged)
+{
+    uint32_t count = 0;
+    *flagged = 0;
+
+    for (int32_t dy = -1; dy <= 1; dy++)
+    {
+        for (int32_t dx = -1; dx <= 1; dx++)
+        {
+            if (dx == 0 && dy == 0)
+                continue;
+
+            int32_t nx = (int32_t)x + dx;
+            int32_t ny = (int32_t)y + dy;
+            const Cell* neighbor = GetCell(field, (uint32_t)nx, (uint32_t)ny);
+
+            if (nx < 0 || ny < 0 || neighbor == NULL)
+                continue;
+
+            if (neighbor->state == CELL_HIDDEN)
+                hidden[count++] = (uint32_t)ny * field->width + (uint32_t)nx;
+            else if (neighbor->state == CELL_FLAGGED)
+                (*flagged)++;
+        }
+    }
+
+    return count;
+}
+
+static int
+CompareCellIndices(_In_ const void* a, _In_ const void* b)
+{
+    uint32_t lhs = *(const uint32_t*)a;
+    uint32_t rhs = *(const uint32_t*)b;
+
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+static bool
+CollectComponent(_In_ const Minefield* field, _Inout_ Frontier* frontier, _In_ uint32_t seed)
+{
+    FrontierComponent* component = &frontier->components[frontier->componentCount];
+    component->firstVariable = frontier->variableCount;
+    component->firstConstraint = frontier->constraintCount;
+
+    uint32_t* variables = &frontier->variables[component->firstVariable];
+    uint32_t variableCount = 0;
+    uint32_t constraintCount = 0;
+
+    variables[variableCount++] = seed;
+    frontier->cellVariable[seed] = VARIABLE_QUEUED;
+
+    for (uint32_t head = 0; head < variableCount; head++)
+    {
+        uint32_t cx = variables[head] % field->width;
+        uint32_t cy = variables[head] / field->width;
+
+        for (int32_t dy = -1; dy <= 1; dy++)
+        {
+            for (int32_t dx = -1; dx <= 1; dx++)
+            {
+                int32_t nx = (int32_t)cx + dx;
+                int32_t ny = (int32_t)cy + dy;
+                const Cell* neighbor = GetCell(field, (uint32_t)nx, (uint32_t)ny);
+
+                if (nx < 0 || ny < 0 || neighbor == NULL || neighbor->state != CELL_REVEALED)
+                    continue;
+
+                uint32_t index = (uint32_t)ny * field->width + (uint32_t)nx;
+
+                if (frontier->cellVariable[index] == CONSTRAINT_VISITED)
+                    continue;
+
+                frontier->cellVariable[index] = CONSTRAINT_VISITED;
+                frontier->constraints[component->firstConstraint + constraintCount++].cell = index;
+
+                uint32_t hidden[8];
+                uint32_t flagged;
+                uint32_t hiddenCount = GetHiddenNeighbors(field, (uint32_t)nx, (uint32_t)ny, hidden, &flagged);
+
+                for (uint32_t i = 0; i < hiddenCount; i++)
+                {
+                    if (frontier->cellVariable[hidden[i]] == VARIABLE_PENDING)
+                    {
+                        frontier->cellVariable[hidden[i]] = VARIABLE_QUEUED;
+                        variables[variableCount++] = hidden[i];
+                    }
+                }
+            }
+        }
+    }
+
+    qsort(variables, variableCount, sizeof(uint32_t), CompareCellIndices);
+
+    for (uint32_t i = 0; i < variableCount; i++)
+        frontier->cellVariable[variables[i]] = component->firstVariable + i;
+
+    for (uint32_t i = 0; i < constraintCount; i++)
+    {
+        FrontierConstraint* constraint = &frontier->constraints[component->firstConstraint + i];
+        uint32_t hidden[8];
+        uint32_t flagged;
+        uint32_t x = constraint->cell % field->width;
+        uint32_t y = constraint->cell / field->width;
+        uint32_t hiddenCount = GetHiddenNeighbors(field, x, y, hidden, &flagged);
+        const Cell* cell = GetCell(field, x, y);
+
+        if (flagged > cell->neighborMines || cell->neighborMines - flagged > hiddenCount)
+            return false;
+
+        constraint->mines = (uint8_t)(cell->neighborMines - flagged);
+        constraint->variableCount = (uint8_t)hiddenCount;
+
+        for (uint32_t j = 0; j < hiddenCount; j++)
+            constraint->variables[j] = (uint16_t)(frontier->cellVariable[hidden[j]] - component->firstVariable);
+    }
+
+    component->variableCount = variableCount;
+    component->constraintCount = constraintCount;
+
+    frontier->variableCount += variableCount;
+    frontier->constraintCount += constraintCount;
+    frontier->componentCount++;
+
+    return true;
+}
+
+bool
+BuildFrontier(_In_ const Minefield* field, _Out_ Frontier* frontier)
+{
+    uint32_t cellCount = field->width * field->height;
+
+    frontier->width = field->width;
+    frontier->height = field->height;
+    frontier->variableCount = 0;
+    frontier->constraintCount = 0;
+    frontier->componentCount = 0;
+    frontier->unconstrainedCount = 0;
+    frontier->remainingMines = 0;
+
+    if (field->state != GAME_PLAYING || field->flaggedCells > field->totalMines)
+        return false;
+
+    frontier->remainingMines = field->totalMines - field->flaggedCells;
+
+    for (uint32_t i = 0; i < cellCount; i++)
+        frontier->cellVariable[i] = SOLVER_NO_VARIABLE;
+
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+        {
+            const Cell* cell = GetCell(field, x, y);
+
+            if (cell->state != CELL_REVEALED)
+                continue;
+
+            uint32_t hidden[8];
+            uint32_t flagged;
+            uint32_t hiddenCount = GetHiddenNeighbors(field, x, y, hidden, &flagged);
+
+            for (uint32_t i = 0; i < hiddenCount; i++)
+                frontier->cellVariable[hidden[i]] = VARIABLE_PENDING;
+        }
+    }
+
+    for (uint32_t i = 0; i < cellCount; i++)
+    {
+        if (frontier->cellVariable[i] == VARIABLE_PENDING && !CollectComponent(field, frontier, i))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < frontier->constraintCount; i++)
+        frontier->cellVariable[frontier->constraints[i].cell] = SOLVER_NO_VARIABLE;
+
+    for (uint32_t y = 0; y < field->height; y++)
+    {
+        for (uint32_t x = 0; x < field->width; x++)
+        {
+            if (GetCell(field, x, y)->state == CELL_HIDDEN &&
+                frontier->cellVariable[y * field->width + x] == SOLVER_NO_VARIABLE)
+            {
+                frontier->unconstrainedCount++;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void
+OrderVariables(_Inout_ Enumerator* e)
+{
+    bool placed[SOLVER_MAX_EXACT_VARIABLES] = {0};
+    uint32_t count = 0;
+
+    for (uint32_t start = 0; start < e->variableCount; start++)
+    {
+        if (placed[start])
+            continue;
+
+        placed[start] = true;
+        e->order[count++] = (uint16_t)start;
+
+        for (uint32_t head = count - 1; head < count; head++)
+        {
+            uint32_t variable = e->order[head];
+
+            for (uint32_t i = 0; i < e->variableConstraintCount[variable]; i++)
+            {
+                const FrontierConstraint* constraint = &e->constraints[e->variableConstraints[variable][i]];
+
+                for (uint32_t j = 0; j < constraint->variableCount; j++)
+                {
+                    uint32_t next = constraint->variables[j];
+
+                    if (!placed[next])
+                    {
+                        placed[next] = true;
+                        e->order[count++] = (uint16_t)next;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void
+InitEnumerator(
+    _Out_ Enumerator* e,
+    _In_ const Frontier* frontier,
+    _In_ const FrontierComponent* component,
+    _Out_writes_(component->variableCount + 1) double* solutions,
+    _Out_writes_(component->variableCount*(component->variableCount + 1)) double* variableMines)
+{
+    e->constraints = &frontier->constraints[component->firstConstraint];
+    e->solutions = solutions;
+    e->variableMines = variableMines;
+    e->solutionsEnumerated = 0;
+    e->candidatesTested = 0;
+    e->work = 0;
+    e->variableCount = component->variableCount;
+    e->constraintCount = component->constraintCount;
+    e->prefixMineCount = 0;
+    e->suffixConstraintCount = 0;
+
+    ZeroMemory(solutions, sizeof(double) * (e->variableCount + 1));
+    ZeroMemory(variableMines, sizeof(double) * e->variableCount * (e->variableCount + 1));
+    ZeroMemory(e->variableConstraintCount, sizeof(e->variableConstraintCount));
+
+    for (uint32_t c = 0; c < e->constraintCount; c++)
+    {
+        const FrontierConstraint* constraint = &e->constraints[c];
+
+        e->assigned[c] = 0;
+        e->unassigned[c] = constraint->variableCount;
+
+        for (uint32_t j = 0; j < constraint->variableCount; j++)
+        {
+            uint32_t variable = constraint->variables[j];
+            e->variableConstraints[variable][e->variableConstraintCount[variable]++] = (uint16_t)c;
+        }
+    }
+
+    OrderVariables(e);
+
+    uint32_t suffixCount = min(e->variableCount, (uint32_t)SOLVER_BITPARALLEL_VARIABLES);
+    e->prefixCount = e->variableCount - suffixCount;
+    e->laneCount = min(suffixCount, (uint32_t)LANE_BITS);
+    e->blockCount = suffixCount - e->laneCount;
+
+    uint32_t laneTotal = 1u << e->laneCount;
+    e->validLanes = laneTotal == 64 ? UINT64_MAX : ((1ull << laneTotal) - 1);
+
+    ZeroMemory(e->laneMinesMasks, sizeof(e->laneMinesMasks));
+
+    for (uint32_t lane = 0; lane < laneTotal; lane++)
+        e->laneMinesMasks[__popcnt(lane)] |= 1ull << lane;
+
+    ZeroMemory(e->laneVariables, sizeof(uint8_t) * e->constraintCount);
+    ZeroMemory(e->laneVariableCount, sizeof(uint8_t) * e->constraintCount);
+    ZeroMemory(e->blockVariables, sizeof(uint32_t) * e->constraintCount);
+
+    for (uint32_t j = 0; j < suffixCount; j++)
+    {
+        uint32_t variable = e->order[e->prefixCount + j];
+
+        for (uint32_t i = 0; i < e->variableConstraintCount[variable]; i++)
+        {
+            uint32_t c = e->variableConstraints[variable][i];
+
+            if (j < e->laneCount)
+            {
+                e->laneVariables[c] |= (uint8_t)(1u << j);
+                e->laneVariableCount[c]++;
+            }
+            else
+            {
+                e->blockVariables[c] |= 1u << (j - e->laneCount);
+            }
+        }
+    }
+
+    for (uint32_t c = 0; c < e->constraintCount; c++)
+    {
+        if (e->laneVariables[c] != 0 || e->blockVariables[c] != 0)
+            e->suffixConstraints[e->suffixConstraintCount++] = (uint16_t)c;
+    }
+}
+
+static void
+AccumulateLanes(_Inout_ Enumerator* e, _In_ uint32_t block, _In_ uint64_t valid)
+{
+    uint32_t stride = e->variableCount + 1;
+    uint32_t blockMines = __popcnt(block);
+
+    for (uint32_t lanesMines = 0; lanesMines <= e->laneCount; lanesMines++)
+    {
+        uint64_t matching = valid & e->laneMinesMasks[lanesMines];
+
+        if (matching == 0)
+            continue;
+
+        double count = (double)__popcnt64(matching);
+        uint32_t mines = e->prefixMineCount + blockMines + lanesMines;
+
+        e->solutions[mines] += count;
+        e->solutionsEnumerated += __popcnt64(matching);
+
+        for (uint32_t j = 0; j < e->laneCount; j++)
+        {
+            uint32_t variable = e->order[e->prefixCount + j];
+            e->variableMines[variable * stride + mines] += (double)__popcnt64(matching & laneMasks[j]);
+        }
+
+        for (uint32_t bits = block; bits != 0; bits &= bits - 1)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, bits);
+
+            uint32_t variable = e->order[e->prefixCount + e->laneCount + bit];
+            e->variableMines[variable * stride + mines] += count;
+        }
+
+        for (uint32_t i = 0; i < e->prefixMineCount; i++)
+            e->variableMines[e->prefixMines[i] * stride + mines] += count;
+    }
+}
+
+static bool
+EnumerateSuffix(_Inout_ Enumerator* e)
+{
+    uint32_t blocks = 1u << e->blockCount;
+
+    if (e->work > SOLVER_WORK_BUDGET - blocks)
+        return false;
+
+    e->work += blocks;
+
+    for (uint32_t block = 0; block < blocks; block++)
+    {
+        uint64_t valid = e->validLanes;
+
+        for (uint32_t i = 0; i < e->suffixConstraintCount && valid != 0; i++)
+        {
+            uint32_t c = e->suffixConstraints[i];
+            int32_t target = (int32_t)e->constraints[c].mines - e->assigned[c] -
+                             (int32_t)__popcnt(block & e->blockVariables[c]);
+
+            if (target < 0 || target > e->laneVariableCount[c])
+            {
+                valid = 0;
+                break;
+            }
+
+            uint64_t sum0 = 0;
+            uint64_t sum1 = 0;
+            uint64_t sum2 = 0;
+
+            for (uint32_t bits = e->laneVariables[c]; bits != 0; bits &= bits - 1)
+            {
+                unsigned long j;
+                _BitScanForward(&j, bits);
+
+                uint64_t carry0 = sum0 & laneMasks[j];
+                sum0 ^= laneMasks[j];
+                uint64_t carry1 = sum1 & carry0;
+                sum1 ^= carry0;
+                sum2 ^= carry1;
+            }
+
+            uint64_t want0 = (target & 1) ? UINT64_MAX : 0;
+            uint64_t want1 = (target & 2) ? UINT64_MAX : 0;
+            uint64_t want2 = (target & 4) ? UINT64_MAX : 0;
+
+            valid &= ~(sum0 ^ want0) & ~(sum1 ^ want1) & ~(sum2 ^ want2);
+        }
+
+        e->candidatesTested += __popcnt64(e->validLanes);
+
+        if (valid != 0)
+            AccumulateLanes(e, block, valid);
+    }
+
+    return true;
+}
+
+static bool
+Backtrack(_Inout_ Enumerator* e, _In_ uint32_t depth)
+{
+    if (depth == e->prefixCount)
+        return EnumerateSuffix(e);
+
+    if (++e->work > SOLVER_WORK_BUDGET)
+        return false;
+
+    uint32_t variable = e->order[depth];
+    uint32_t constraintCount = e->variableConstraintCount[variable];
+    const uint16_t* constraints = e->variableConstraints[variable];
+
+    for (int32_t value = 0; value <= 1; value++)
+    {
+        bool feasible = true;
+
+        for (uint32_t i = 0; i < constraintCount; i++)
+        {
+            uint32_t c = constraints[i];
+            int32_t mines = e->constraints[c].mines;
+
+            e->assigned[c] += value;
+            e->unassigned[c]--;
+
+            if (e->assigned[c] > mines || e->assigned[c] + e->unassigned[c] < mines)
+                feasible = false;
+        }
+
+        bool completed = true;
+
+        if (feasible)
+        {
+            if (value)
+                e->prefixMines[e->prefixMineCount++] = (uint16_t)variable;
+
+            completed = Backtrack(e, depth + 1);
+
+            if (value)
+                e->prefixMineCount--;
+        }
+
+        for (uint32_t i = 0; i < constraintCount; i++)
+        {
+            e->assigned[constraints[i]] -= value;
+            e->unassigned[constraints[i]]++;
+        }
+
+        if (!completed)
+            return false;
+    }
+
+    return true;
+}
+
+static uint32_t
+ConvolveNormalized(
+    _In_reads_(aLength) const double* a,
+    _In_ uint32_t aLength,
+    _In_reads_(bLength) const double* b,
+    _In_ uint32_t bLength,
+    _In_ uint32_t maxLength,
+    _Out_writes_(maxLength) double* out)
+{
+    uint32_t length = min(aLength + bLength - 1, maxLength);
+    double largest = 0.0;
+
+    for (uint32_t i = 0; i < length; i++)
+        out[i] = 0.0;
+
+    for (uint32_t i = 0; i < aLength && i < length; i++)
+    {
+        if (a[i] == 0.0)
+            continue;
+
+        for (uint32_t j = 0; j < bLength && i + j < length; j++)
+            out[i + j] += a[i] * b[j];
+    }
+
+    for (uint32_t i = 0; i < length; i++)
+        largest = max(largest, out[i]);
+
+    if (largest > 0.0)
+    {
+        for (uint32_t i = 0; i < length; i++)
+            out[i] /= largest;
+    }
+
+    return length;
+}
+
+typedef struct
+{
+    const Frontier* frontier;
+    const bool* solved;
+    double* const* solutions;
+    double* const* variableMines;
+    const double* weights;
+    SolverResult* result;
+    uint32_t maxLength;
+    bool consistent;
+} Combiner;
+
+static uint32_t
+ConvolveRange(_In_ const Combiner* c, _In_ uint32_t first, _In_ uint32_t last, _Out_writes_(c->maxLength) double* out)
+{
+    double* scratch = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * c->maxLength);
+    uint32_t length = 1;
+
+    out[0] = 1.0;
+
+    if (scratch == NULL)
+        return 0;
+
+    for (uint32_t i = first; i < last; i++)
+    {
+        if (!c->solved[i])
+            continue;
+
+        CopyMemory(scratch, out, sizeof(double) * length);
+        length = ConvolveNormalized(
+            scratch,
+            length,
+            c->solutions[i],
+            c->frontier->components[i].variableCount + 1,
+            c->maxLength,
+            out);
+    }
+
+    HeapFree(GetProcessHeap(), 0, scratch);
+    return length;
+}
+
+static void
+ResolveComponent(
+    _Inout_ Combiner* c,
+    _In_ uint32_t index,
+    _In_reads_(outsideLength) const double* outside,
+    _In_ uint32_t outsideLength)
+{
+    const FrontierComponent* component = &c->frontier->components[index];
+    uint32_t stride = component->variableCount + 1;
+    double partition = 0.0;
+    double* weighted = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * stride);
+
+    if (weighted == NULL)
+    {
+        c->consistent = false;
+        return;
+    }
+
+    for (uint32_t m = 0; m < stride; m++)
+    {
+        double sum = 0.0;
+
+        for (uint32_t other = 0; other < outsideLength && m + other < c->maxLength; other++)
+            sum += outside[other] * c->weights[m + other];
+
+        weighted[m] = sum;
+        partition += c->solutions[index][m] * sum;
+    }
+
+    if (partition <= 0.0)
+    {
+        c->consistent = false;
+        HeapFree(GetProcessHeap(), 0, weighted);
+        return;
+    }
+
+    for (uint32_t i = 0; i < component->variableCount; i++)
+    {
+        double sum = 0.0;
+
+        for (uint32_t m = 0; m < stride; m++)
+            sum += c->variableMines[index][i * stride + m] * weighted[m];
+
+        c->result->probability[c->frontier->variables[component->firstVariable + i]] = sum / partition;
+    }
+
+    HeapFree(GetProcessHeap(), 0, weighted);
+}
+
+static void
+ResolveRange(
+    _Inout_ Combiner* c,
+    _In_ uint32_t first,
+    _In_ uint32_t last,
+    _In_reads_(outsideLength) const double* outside,
+    _In_ uint32_t outsideLength)
+{
+    while (first < last && !c->solved[first])
+        first++;
+
+    while (last > first && !c->solved[last - 1])
+        last--;
+
+    if (first >= last || !c->consistent)
+        return;
+
+    if (last - first == 1)
+    {
+        ResolveComponent(c, first, outside, outsideLength);
+        return;
+    }
+
+    uint32_t mid = first + (last - first) / 2;
+    double* range = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * c->maxLength);
+    double* inner = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * c->maxLength);
+
+    if (range != NULL && inner != NULL)
+    {
+        uint32_t rangeLength = ConvolveRange(c, mid, last, range);
+        uint32_t innerLength = ConvolveNormalized(outside, outsideLength, range, rangeLength, c->maxLength, inner);
+        ResolveRange(c, first, mid, inner, innerLength);
+
+        rangeLength = ConvolveRange(c, first, mid, range);
+        innerLength = ConvolveNormalized(outside, outsideLength, range, rangeLength, c->maxLength, inner);
+        ResolveRange(c, mid, last, inner, innerLength);
+    }
+    else
+    {
+        c->consistent = false;
+    }
+
+    HeapFree(GetProcessHeap(), 0, range);
+    HeapFree(GetProcessHeap(), 0, inner);
+}
+
+static double
+LogBinomial(_In_ uint32_t n, _In_ uint32_t k)
+{
+    return lgamma((double)n + 1.0) - lgamma((double)k + 1.0) - lgamma((double)(n - k) + 1.0);
+}
+
+static bool
+CombineComponents(_Inout_ Combiner* c, _In_ uint32_t unconstrained)
+{
+    uint32_t remaining = c->frontier->remainingMines;
+    double* weights = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * c->maxLength);
+    double* total = HeapAlloc(GetProcessHeap(), 0, sizeof(double) * c->maxLength);
+    double largest = -INFINITY;
+    bool success = false;
+
+    if (weights == NULL || total == NULL)
+        goto cleanup;
+
+    for (uint32_t t = 0; t < c->maxLength; t++)
+    {
+        uint32_t rest = remaining - t;
+        weights[t] = rest <= unconstrained ? LogBinomial(unconstrained, rest) : -INFINITY;
+        largest = max(largest, weights[t]);
+    }
+
+    if (largest == -INFINITY)
+        goto cleanup;
+
+    for (uint32_t t = 0; t < c->maxLength; t++)
+        weights[t] = weights[t] == -INFINITY ? 0.0 : exp(weights[t] - largest);
+
+    c->weights = weights;
+
+    uint32_t totalLength = ConvolveRange(c, 0, c->frontier->componentCount, total);
+    double partition = 0.0;
+    double expectedRest = 0.0;
+
+    for (uint32_t t = 0; t < totalLength; t++)
+    {
+        partition += total[t] * weights[t];
+        expectedRest += total[t] * weights[t] * (double)(remaining - t);
+    }
+
+    if (totalLength == 0 || partition <= 0.0)
+        goto cleanup;
+
+    c->result->unconstrainedProbability = unconstrained > 0 ? expectedRest / partition / unconstrained : 0.0;
+
+    double one = 1.0;
+    ResolveRange(c, 0, c->frontier->componentCount, &one, 1);
+    success = c->consistent;
+
+cleanup:
+    HeapFree(GetProcessHeap(), 0, weights);
+    HeapFree(GetProcessHeap(), 0, total);
+
+    return success;
+}
+
+static uint32_t
+GetUnknownVariables(_In_ const FrontierConstraint* constraint, _In_ const int8_t* known, _Out_ int32_t* mines)
+{
+    uint32_t mask = 0;
+
+    *mines = constraint->mines;
+
+    for (uint32_t j = 0; j < constraint->variableCount; j++)
+    {
+        int8_t value = known[constraint->variables[j]];
+
+        if (value < 0)
+            mask |= 1u << j;
+        else
+            *mines -= value;
+    }
+
+    return mask;
+}
+
+static bool
+AssignVariables(_In_ const FrontierConstraint* constraint, _Inout_ int8_t* known, _In_ uint32_t mask, _In_ int8_t value)
+{
+    bool changed = false;
+
+    for (uint32_t j = 0; j < constraint->variableCount; j++)
+    {
+        if ((mask & (1u << j)) != 0 && known[constraint->variables[j]] < 0)
+        {
+            known[constraint->variables[j]] = value;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+static bool
+DeduceFromPair(_In_ const FrontierConstraint* c, _In_ const FrontierConstraint* d, _Inout_ int8_t* known)
+{
+    int32_t minesC;
+    int32_t minesD;
+    uint32_t maskC = GetUnknownVariables(c, known, &minesC);
+    uint32_t maskD = GetUnknownVariables(d, known, &minesD);
+    uint32_t sharedC = 0;
+    uint32_t sharedD = 0;
+
+    for (uint32_t i = 0; i < c->variableCount; i++)
+    {
+        for (uint32_t j = 0; j < d->variableCount; j++)
+        {
+            if ((maskC & (1u << i)) != 0 && (maskD & (1u << j)) != 0 && c->variables[i] == d->variables[j])
+            {
+                sharedC |= 1u << i;
+                sharedD |= 1u << j;
+            }
+        }
+    }
+
+    int32_t shared = (int32_t)__popcnt(sharedC);
+    int32_t onlyC = (int32_t)__popcnt(maskC) - shared;
+    int32_t onlyD = (int32_t)__popcnt(maskD) - shared;
+
+    if (shared == 0)
+        return false;
+
+    int32_t fewest = max(max(0, minesC - onlyC), minesD - onlyD);
+    int32_t most = min(min(shared, minesC), minesD);
+    bool changed = false;
+
+    if (fewest > most)
+        return false;
+
+    if (minesC - fewest == 0)
+        changed |= AssignVariables(c, known, maskC & ~sharedC, 0);
+    else if (minesC - most == onlyC)
+        changed |= AssignVariables(c, known, maskC & ~sharedC, 1);
+
+    if (minesD - fewest == 0)
+        changed |= AssignVariables(d, known, maskD & ~sharedD, 0);
+    else if (minesD - most == onlyD)
+        changed |= AssignVariables(d, known, maskD & ~sharedD, 1);
+
+    if (most == 0)
+        changed |= AssignVariables(c, known, sharedC, 0);
+    else if (fewest == shared)
+        changed |= AssignVariables(c, known, sharedC, 1);
+
+    return changed;
+}
+
+// Components too large to enumerate still usually contain cells a player can settle from one number or from two
+// overlapping ones. Those get an exact 0 or 1; the rest stay unknown.
+static void
+DeduceSkippedComponent(
+    _In_ const Frontier* frontier,
+    _In_ const FrontierComponent* component,
+    _Inout_ SolverResult* result)
+{
+    HANDLE hHeap = GetProcessHeap();
+    const FrontierConstraint* constraints = &frontier->constraints[component->firstConstraint];
+    int8_t* known = HeapAlloc(hHeap, 0, sizeof(int8_t) * component->variableCount);
+    uint32_t* variableConstraints = HeapAlloc(hHeap, 0, sizeof(uint32_t) * 8 * component->variableCount);
+    uint8_t* variableConstraintCount = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, component->variableCount);
+    bool changed = true;
+
+    if (known == NULL || variableConstraints == NULL || variableConstraintCount == NULL)
+        goto cleanup;
+
+    FillMemory(known, component->variableCount, 0xFF);
+
+    for (uint32_t c = 0; c < component->constraintCount; c++)
+    {
+        for (uint32_t j = 0; j < constraints[c].variableCount; j++)
+        {
+            uint32_t v = constraints[c].variables[j];
+            variableConstraints[v * 8 + variableConstraintCount[v]++] = c;
+        }
+    }
+
+    while (changed)
+    {
+        changed = false;
+
+        for (uint32_t c = 0; c < component->constraintCount; c++)
+        {
+            int32_t mines;
+            uint32_t mask = GetUnknownVariables(&constraints[c], known, &mines);
+
+            if (mask == 0)
+                continue;
+
+            if (mines == 0)
+                changed |= AssignVariables(&constraints[c], known, mask, 0);
+            else if (mines == (int32_t)__popcnt(mask))
+                changed |= AssignVariables(&constraints[c], known, mask, 1);
+
+            for (uint32_t j = 0; j < constraints[c].variableCount; j++)
+            {
+                uint32_t v = constraints[c].variables[j];
+
+                for (uint32_t i = 0; i < variableConstraintCount[v]; i++)
+                {
+                    uint32_t d = variableConstraints[v * 8 + i];
+
+                    if (d > c)
+                        changed |= DeduceFromPair(&constraints[c], &constraints[d], known);
+                }
+            }
+        }
+    }
+
+    for (uint32_t v = 0; v < component->variableCount; v++)
+    {
+        if (known[v] >= 0)
+            result->probability[frontier->variables[component->firstVariable + v]] = known[v];
+    }
+
+cleanup:
+    HeapFree(hHeap, 0, known);
+    HeapFree(hHeap, 0, variableConstraints);
+    HeapFree(hHeap, 0, variableConstraintCount);
+}
+
+bool
+SolveFrontier(_In_ const Frontier* frontier, _Inout_opt_ SolverCache* cache, _Out_ SolverResult* result)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint32_t componentCount = frontier->componentCount;
+    size_t countStorage = 0;
+
+    result->unconstrainedProbability = 0.0;
+    result->solutionsEnumerated = 0;
+    result->candidatesTested = 0;
+    result->cacheHits = 0;
+    result->componentsSolved = 0;
+    result->componentsSkipped = 0;
+    result->complete = true;
+    result->sampled = false;
+
+    for (uint32_t i = 0; i < componentCount; i++)
+    {
+        uint32_t k = frontier->components[i].variableCount;
+
+        if (k <= SOLVER_MAX_EXACT_VARIABLES && frontier->components[i].constraintCount <= SOLVER_MAX_EXACT_CONSTRAINTS)
+            countStorage += (size_t)(k + 1) * (k + 1);
+    }
+
+    Enumerator* e = HeapAlloc(hHeap, 0, sizeof(Enumerator));
+    double* storage = HeapAlloc(hHeap, 0, sizeof(double) * max(countStorage, 1));
+    bool* solved = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(bool) * max(componentCount, 1u));
+    double** solutions = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(double*) * max(componentCount, 1u));
+    double** variableMines = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(double*) * max(componentCount, 1u));
+    bool success = false;
+
+    if (e == NULL || storage == NULL || solved == NULL || solutions == NULL || variableMines == NULL)
+        goto cleanup;
+
+    double* next = storage;
+    uint32_t unconstrained = frontier->unconstrainedCount;
+    uint32_t solvedVariables = 0;
+
+    for (uint32_t i = 0; i < componentCount; i++)
+    {
+        const FrontierComponent* component = &frontier->components[i];
+        uint32_t k = component->variableCount;
+
+        if (k <= SOLVER_MAX_EXACT_VARIABLES && component->constraintCount <= SOLVER_MAX_EXACT_CONSTRAINTS)
+        {
+            solutions[i] = next;
+            variableMines[i] = next + k + 1;
+            next += (size_t)(k + 1) * (k + 1);
+
+            uint64_t key = cache != NULL ? GetComponentHash(frontier, component) : 0;
+
+            if (cache != NULL && LookupSolverCache(cache, key, component, solutions[i]))
+            {
+                solved[i] = true;
+                result->cacheHits++;
+            }
+            else
+            {
+                InitEnumerator(e, frontier, component, solutions[i], variableMines[i]);
+                solved[i] = Backtrack(e, 0);
+
+                result->solutionsEnumerated += e->solutionsEnumerated;
+                result->candidatesTested += e->candidatesTested;
+
+                if (cache != NULL && solved[i])
+                    InsertSolverCache(cache, key, component, solutions[i], e->candidatesTested);
+            }
+        }
+
+        if (solved[i])
+        {
+            result->componentsSolved++;
+            solvedVariables += k;
+        }
+        else
+        {
+            result->componentsSkipped++;
+            result->complete = false;
+            unconstrained += k;
+
+            for (uint32_t j = 0; j < k; j++)
+                result->probability[frontier->variables[component->firstVariable + j]] = SOLVER_PROBABILITY_UNKNOWN;
+
+            DeduceSkippedComponent(frontier, component, result);
+        }
+    }
+
+    Combiner combiner = {
+        .frontier = frontier,
+        .solved = solved,
+        .solutions = solutions,
+        .variableMines = variableMines,
+        .weights = NULL,
+        .result = result,
+        .maxLength = min(solvedVariables, frontier->remainingMines) + 1,
+        .consistent = true,
+    };
+
+    success = CombineComponents(&combiner, unconstrained);
+
+cleanup:
+    HeapFree(hHeap, 0, e);
+    HeapFree(hHeap, 0, storage);
+    HeapFree(hHeap, 0, solved);
+    HeapFree(hHeap, 0, solutions);
+    HeapFree(hHeap, 0, variableMines);
+
+    return success;
+}
+
+static void
+EstimateSkippedComponents(_In_ const Frontier* frontier, _In_ uint32_t threads, _Inout_ SolverResult* result)
+{
+    HANDLE hHeap = GetProcessHeap();
+    double* estimate = HeapAlloc(hHeap, 0, sizeof(double) * frontier->width * frontier->height);
+    SamplerOptions options;
+    SamplerStats stats;
+
+    GetDefaultSamplerOptions(&options);
+    options.threads = threads;
+
+    if (estimate != NULL && SampleFrontier(frontier, &options, estimate, &stats))
+    {
+        // A cell no sample put a mine on, or every sample did, is still not certain, so sampled frequencies are kept
+        // strictly between 0 and 1 and only exact results can read as safe or as mines.
+        double margin = 1.0 / (double)(stats.samples + 2);
+
+        for (uint32_t v = 0; v < frontier->variableCount; v++)
+        {
+            uint32_t cell = frontier->variables[v];
+
+            if (result->probability[cell] == SOLVER_PROBABILITY_UNKNOWN)
+                result->probability[cell] = min(max(estimate[cell], margin), 1.0 - margin);
+        }
+
+        result->sampled = true;
+    }
+
+    HeapFree(hHeap, 0, estimate);
+}
+
+bool
+SolveMinefield(
+    _In_ const Minefield* field,
+    _Inout_opt_ SolverCache* cache,
+    _In_ uint32_t threads,
+    _Out_ SolverResult* result)
+{
+    HANDLE hHeap = GetProcessHeap();
+    Frontier* frontier = HeapAlloc(hHeap, 0, sizeof(Frontier));
+
+    if (frontier == NULL)
+        return false;
+
+    bool success = BuildFrontier(field, frontier) && SolveFrontier(frontier, cache, result);
+
+    if (success && !result->complete)
+        EstimateSkippedComponents(frontier, threads, result);
+
+    if (success)
+    {
+        for (uint32_t y = 0; y < field->height; y++)
+        {
+            for (uint32_t x = 0; x < field->width; x++)
+            {
+                uint32_t index = y * field->width + x;
+                const Cell* cell = GetCell(field, x, y);
+
+                if (cell->state == CELL_REVEALED)
+                    result->probability[index] = 0.0;
+                else if (cell->state == CELL_FLAGGED)
+                    result->probability[index] = 1.0;
+                else if (frontier->cellVariable[index] == SOLVER_NO_VARIABLE)
+                    result->probability[index] = result->unconstrainedProbability;
+            }
+        }
+    }
+
+    HeapFree(hHeap, 0, frontier);
+    return success;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+
+#define SOLVER_MAX_CELLS (MAX_CELLS_VERTICALLY * MAX_CELLS_HORIZONTALLY)
+
+// Components with more unknown cells than this are not enumerated exactly.
+#define SOLVER_MAX_EXACT_VARIABLES 128
+#define SOLVER_MAX_EXACT_CONSTRAINTS (SOLVER_MAX_EXACT_VARIABLES * 8)
+
+// Trailing variables of the enumeration order that are tested 64 assignments per word instead of by backtracking.
+#define SOLVER_BITPARALLEL_VARIABLES 16
+
+// Upper bound on backtracking nodes plus 64-lane blocks spent on a single component.
+#define SOLVER_WORK_BUDGET (1u << 22)
+
+#define SOLVER_NO_VARIABLE UINT32_MAX
+#define SOLVER_PROBABILITY_UNKNOWN (-1.0)
+
+typedef struct
+{
+    uint32_t cell;
+    uint8_t mines;
+    uint8_t variableCount;
+    uint16_t variables[8];
+} FrontierConstraint;
+
+typedef struct
+{
+    uint32_t firstVariable;
+    uint32_t variableCount;
+    uint32_t firstConstraint;
+    uint32_t constraintCount;
+} FrontierComponent;
+
+typedef struct
+{
+    uint32_t variables[SOLVER_MAX_CELLS];
+    uint32_t cellVariable[SOLVER_MAX_CELLS];
+    FrontierConstraint constraints[SOLVER_MAX_CELLS];
+    FrontierComponent components[SOLVER_MAX_CELLS];
+    uint32_t width;
+    uint32_t height;
+    uint32_t variableCount;
+    uint32_t constraintCount;
+    uint32_t componentCount;
+    uint32_t unconstrainedCount;
+    uint32_t remainingMines;
+} Frontier;
+
+// When sampled is set, the cells of components too large to enumerate hold sampled frequencies. These never reach
+// 0 or 1, so a certain cell is always an exact result.
+typedef struct
+{
+    double probability[SOLVER_MAX_CELLS];
+    double unconstrainedProbability;
+    uint64_t solutionsEnumerated;
+    uint64_t candidatesTested;
+    uint32_t cacheHits;
+    uint32_t componentsSolved;
+    uint32_t componentsSkipped;
+    bool complete;
+    bool sampled;
+} SolverResult;
+
+bool BuildFrontier(_In_ const Minefield* field, _Out_ Frontier* frontier);
+
+typedef struct SolverCache SolverCache;
+
+bool SolveFrontier(_In_ const Frontier* frontier, _Inout_opt_ SolverCache* cache, _Out_ SolverResult* result);
+
+// Solves the field and samples the components too large to enumerate on up to threads threads, or on every core
+// when threads is 0.
+bool SolveMinefield(
+    _In_ const Minefield* field,
+    _Inout_opt_ SolverCache* cache,
+    _In_ uint32_t threads,
+    _Out_ SolverResult* result);
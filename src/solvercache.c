@@ -0,0 +1,164 @@
+#include "pch.h"
+
+#include "random.h"
+#include "solvercache.h"
+
+bool
+CreateSolverCache(_Out_ SolverCache* cache, _In_ uint32_t entryCount)
+{
+    ZeroMemory(cache, sizeof(SolverCache));
+
+    if (entryCount == 0 || (entryCount & (entryCount - 1)) != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return false;
+    }
+
+    cache->entries = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(SolverCacheEntry) * entryCount);
+
+    if (cache->entries == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return false;
+    }
+
+    cache->entryCount = entryCount;
+
+    return true;
+}
+
+void
+DestroySolverCache(_Inout_ SolverCache* cache)
+{
+    HeapFree(GetProcessHeap(), 0, cache->entries);
+    ZeroMemory(cache, sizeof(SolverCache));
+}
+
+void
+ClearSolverCache(_Inout_ SolverCache* cache)
+{
+    for (uint32_t i = 0; i < cache->entryCount; i++)
+    {
+        SolverCacheEntry* entry = &cache->entries[i];
+        LONG64 sequence = entry->sequence;
+
+        if ((sequence & 1) == 0 && InterlockedCompareExchange64(&entry->sequence, sequence + 1, sequence) == sequence)
+        {
+            entry->variableCount = 0;
+            InterlockedExchange64(&entry->sequence, sequence + 2);
+        }
+    }
+
+    cache->lookups = 0;
+    cache->hits = 0;
+    cache->candidatesSaved = 0;
+}
+
+uint64_t
+GetComponentHash(_In_ const Frontier* frontier, _In_ const FrontierComponent* component)
+{
+    uint64_t sum = 0;
+
+    // Constraints are combined by addition so the key does not depend on the order they were discovered in.
+    for (uint32_t c = 0; c < component->constraintCount; c++)
+    {
+        const FrontierConstraint* constraint = &frontier->constraints[component->firstConstraint + c];
+        uint64_t hash = mix64(constraint->mines + 1);
+
+        for (uint32_t i = 0; i < constraint->variableCount; i++)
+            hash = mix64(hash ^ constraint->variables[i]);
+
+        sum += hash;
+    }
+
+    return mix64(sum ^ ((uint64_t)component->variableCount << 32 | component->constraintCount));
+}
+
+bool
+LookupSolverCache(
+    _Inout_ SolverCache* cache,
+    _In_ uint64_t key,
+    _In_ const FrontierComponent* component,
+    _Out_writes_((component->variableCount + 1) * (component->variableCount + 1)) double* counts)
+{
+    if (cache->entryCount == 0)
+        return false;
+
+    SolverCacheEntry* entry = &cache->entries[key & (cache->entryCount - 1)];
+    LONG64 sequence = entry->sequence;
+
+    InterlockedIncrement64(&cache->lookups);
+    MemoryBarrier();
+
+    if ((sequence & 1) != 0 || entry->key != key || entry->variableCount != component->variableCount ||
+        entry->constraintCount != component->constraintCount)
+    {
+        return false;
+    }
+
+    uint32_t stride = component->variableCount + 1;
+    uint32_t fewestMines = entry->fewestMines;
+    uint32_t mineRange = entry->mineRange;
+    uint64_t candidatesTested = entry->candidatesTested;
+
+    if (fewestMines + mineRange > stride || stride * mineRange > SOLVER_CACHE_ENTRY_COUNTS)
+        return false;
+
+    ZeroMemory(counts, sizeof(double) * stride * stride);
+
+    for (uint32_t row = 0; row < stride; row++)
+        CopyMemory(&counts[row * stride + fewestMines], &entry->counts[row * mineRange], sizeof(double) * mineRange);
+
+    MemoryBarrier();
+
+    if (entry->sequence != sequence)
+        return false;
+
+    InterlockedIncrement64(&cache->hits);
+    InterlockedExchangeAdd64(&cache->candidatesSaved, (LONG64)candidatesTested);
+
+    return true;
+}
+
+void
+InsertSolverCache(
+    _Inout_ SolverCache* cache,
+    _In_ uint64_t key,
+    _In_ const FrontierComponent* component,
+    _In_reads_((component->variableCount + 1) * (component->variableCount + 1)) const double* counts,
+    _In_ uint64_t candidatesTested)
+{
+    uint32_t stride = component->variableCount + 1;
+    uint32_t fewestMines = 0;
+    uint32_t mostMines = component->variableCount;
+
+    while (fewestMines < mostMines && counts[fewestMines] == 0.0)
+        fewestMines++;
+
+    while (mostMines > fewestMines && counts[mostMines] == 0.0)
+        mostMines--;
+
+    uint32_t mineRange = mostMines - fewestMines + 1;
+
+    if (cache->entryCount == 0 || stride * mineRange > SOLVER_CACHE_ENTRY_COUNTS)
+        return;
+
+    SolverCacheEntry* entry = &cache->entries[key & (cache->entryCount - 1)];
+    LONG64 sequence = entry->sequence;
+
+    // Another writer owns the slot; dropping this insert keeps writers from ever blocking each other.
+    if ((sequence & 1) != 0 || InterlockedCompareExchange64(&entry->sequence, sequence + 1, sequence) != sequence)
+        return;
+
+    entry->key = key;
+    entry->candidatesTested = candidatesTested;
+    entry->variableCount = component->variableCount;
+    entry->constraintCount = component->constraintCount;
+    entry->fewestMines = fewestMines;
+    entry->mineRange = mineRange;
+
+    for (uint32_t row = 0; row < stride; row++)
+        CopyMemory(&entry->counts[row * mineRange], &counts[row * stride + fewestMines], sizeof(double) * mineRange);
+
+    InterlockedExchange64(&entry->sequence, sequence + 2);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "solver.h"
+
+// Only the mine counts a component can actually take are stored; components whose counts do not fit are not cached.
+#define SOLVER_CACHE_ENTRY_COUNTS 2048
+#define SOLVER_CACHE_DEFAULT_ENTRIES 1024
+
+// Per-mine-count solution counts of one component, keyed by the shape of its constraints rather than its position,
+// so a component seen again elsewhere on the board or in another game reuses the enumeration. The sequence is odd
+// while a writer owns the entry; a reader that sees it change treats the lookup as a miss instead of waiting.
+typedef struct
+{
+    volatile LONG64 sequence;
+    uint64_t key;
+    uint64_t candidatesTested;
+    uint32_t variableCount;
+    uint32_t constraintCount;
+    uint32_t fewestMines;
+    uint32_t mineRange;
+    double counts[SOLVER_CACHE_ENTRY_COUNTS];
+} SolverCacheEntry;
+
+struct SolverCache
+{
+    SolverCacheEntry* entries;
+    uint32_t entryCount;
+    volatile LONG64 lookups;
+    volatile LONG64 hits;
+    volatile LONG64 candidatesSaved;
+};
+
+bool CreateSolverCache(_Out_ SolverCache* cache, _In_ uint32_t entryCount);
+
+void DestroySolverCache(_Inout_ SolverCache* cache);
+
+void ClearSolverCache(_Inout_ SolverCache* cache);
+
+uint64_t GetComponentHash(_In_ const Frontier* frontier, _In_ const FrontierComponent* component);
+
+bool LookupSolverCache(
+    _Inout_ SolverCache* cache,
+    _In_ uint64_t key,
+    _In_ const FrontierComponent* component,
+    _Out_writes_((component->variableCount + 1) * (component->variableCount + 1)) double* counts);
+
+void InsertSolverCache(
+    _Inout_ SolverCache* cache,
+    _In_ uint64_t key,
+    _In_ const FrontierComponent* component,
+    _In_reads_((component->variableCount + 1) * (component->variableCount + 1)) const double* counts,
+    _In_ uint64_t candidatesTested);
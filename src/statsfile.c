@@ -0,0 +1,126 @@
+#include "pch.h"
+
+#include "metrics.h"
+#include "statsfile.h"
+
+static bool
+ReadStatsFile(
+    _Inout_opt_ void* context,
+    _In_ uint64_t offset,
+    _Out_writes_bytes_(size) uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    LARGE_INTEGER position = {.QuadPart = (LONGLONG)offset};
+    DWORD read = 0;
+
+    return SetFilePointerEx((HANDLE)context, position, NULL, FILE_BEGIN) &&
+           ReadFile((HANDLE)context, bytes, size, &read, NULL) && read == size;
+}
+
+static bool
+WriteStatsFile(
+    _Inout_opt_ void* context,
+    _In_ uint64_t offset,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    LARGE_INTEGER position = {.QuadPart = (LONGLONG)offset};
+    DWORD written = 0;
+
+    return SetFilePointerEx((HANDLE)context, position, NULL, FILE_BEGIN) &&
+           WriteFile((HANDLE)context, bytes, size, &written, NULL) && written == size;
+}
+
+static bool
+FlushStatsFile(_Inout_opt_ void* context)
+{
+    return FlushFileBuffers((HANDLE)context);
+}
+
+static bool
+GetStatsFileSize(_Inout_opt_ void* context, _Out_ uint64_t* size)
+{
+    LARGE_INTEGER fileSize;
+
+    *size = 0;
+
+    if (!GetFileSizeEx((HANDLE)context, &fileSize))
+        return false;
+
+    *size = (uint64_t)fileSize.QuadPart;
+
+    return true;
+}
+
+static bool
+SetStatsFileSize(_Inout_opt_ void* context, _In_ uint64_t size)
+{
+    LARGE_INTEGER position = {.QuadPart = (LONGLONG)size};
+
+    return SetFilePointerEx((HANDLE)context, position, NULL, FILE_BEGIN) && SetEndOfFile((HANDLE)context);
+}
+
+static void
+CloseStatsFile(_Inout_opt_ void* context)
+{
+    CloseHandle((HANDLE)context);
+}
+
+bool
+OpenStatsStore(_Out_ StatsStore* store, _In_z_ const wchar_t* path)
+{
+    HANDLE hFile = CreateFileW(
+        path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    ZeroMemory(store, sizeof(StatsStore));
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    StatsStorage storage = {
+        .read = ReadStatsFile,
+        .write = WriteStatsFile,
+        .flush = FlushStatsFile,
+        .getSize = GetStatsFileSize,
+        .setSize = SetStatsFileSize,
+        .close = CloseStatsFile,
+        .context = hFile,
+    };
+
+    if (!OpenStatsStorage(store, &storage))
+    {
+        DWORD error = store->badFormat ? ERROR_BAD_FORMAT : GetLastError();
+
+        CloseHandle(hFile);
+        SetLastError(error);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+GetFinishedGameRecord(_In_ const Minefield* field, _Out_ GameRecord* record)
+{
+    BoardMetrics metrics;
+    FILETIME now;
+
+    ZeroMemory(record, sizeof(GameRecord));
+
+    if (field->state == GAME_PLAYING || !ComputeMinefieldMetrics(field, &metrics))
+        return false;
+
+    GetSystemTimeAsFileTime(&now);
+
+    record->difficulty = field->difficulty;
+    record->state = field->state;
+    record->width = field->width;
+    record->height = field->height;
+    record->totalMines = field->totalMines;
+    record->duration = (uint32_t)min(field->endTime - field->startTime, (uint64_t)UINT32_MAX);
+    record->bbbv = metrics.bbbv;
+    record->seed = field->seed;
+    record->finished = (uint64_t)now.dwHighDateTime << 32 | now.dwLowDateTime;
+
+    return true;
+}
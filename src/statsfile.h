@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Windows.h>
+#include <sal.h>
+
+#include <stdbool.h>
+
+#include "game.h"
+#include "statsstore.h"
+
+// Opens the store kept in a file, creating the file when it does not exist.
+bool OpenStatsStore(_Out_ StatsStore* store, _In_z_ const wchar_t* path);
+
+// Fills a record from a won or lost game, working out its 3BV from the mines.
+bool GetFinishedGameRecord(_In_ const Minefield* field, _Out_ GameRecord* record);
@@ -0,0 +1,501 @@
+// The store logic touches its bytes only through StatsStorage and needs nothing from Windows, so it builds without
+// the precompiled header.
+#include <string.h>
+
+#include "littleendian.h"
+#include "random.h"
+#include "statsstore.h"
+
+#define STATS_STORE_MAGIC 0x5453534Du
+#define STATS_STORE_VERSION 2
+#define STATS_SLOT_HEADER_SIZE 32
+#define STATS_SKETCH_SIZE (32 + QUANTILE_SKETCH_BUCKETS * 4)
+#define STATS_DIFFICULTY_SIZE (52 + STATS_BEST_TIMES * 24 + 2 * STATS_SKETCH_SIZE)
+#define STATS_SNAPSHOT_SIZE ((DIFFICULTY_CUSTOM + 1) * STATS_DIFFICULTY_SIZE)
+#define STATS_BLOCK_RECORDS (STATS_STORE_SLOT_SIZE / STATS_STORE_RECORD_SIZE)
+#define STATS_REBUILD_BLOCK_RECORDS 256
+
+static bool
+ReadStoreBytes(
+    _In_ const StatsStorage* storage,
+    _In_ uint64_t offset,
+    _Out_writes_bytes_(size) uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    return storage->read(storage->context, offset, bytes, size);
+}
+
+static bool
+WriteStoreBytes(
+    _In_ const StatsStorage* storage,
+    _In_ uint64_t offset,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    return storage->write(storage->context, offset, bytes, size);
+}
+
+static uint64_t
+ComputeSnapshotChecksum(_In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    uint64_t checksum = size;
+
+    for (uint32_t i = 0; i < size; i += 8)
+        checksum = mix64(checksum ^ GetLittleEndian(bytes + i, size - i < 8 ? size - i : 8));
+
+    return checksum;
+}
+
+static void
+EncodeGameRecord(_Out_writes_bytes_(STATS_STORE_RECORD_SIZE) uint8_t* bytes, _In_ const GameRecord* record)
+{
+    PutLittleEndian(bytes, record->difficulty, 1);
+    PutLittleEndian(bytes + 1, record->state, 1);
+    PutLittleEndian(bytes + 2, record->width, 2);
+    PutLittleEndian(bytes + 4, record->height, 2);
+    PutLittleEndian(bytes + 6, record->totalMines, 2);
+    PutLittleEndian(bytes + 8, record->duration, 4);
+    PutLittleEndian(bytes + 12, record->bbbv, 4);
+    PutLittleEndian(bytes + 16, record->seed, 8);
+    PutLittleEndian(bytes + 24, record->finished, 8);
+}
+
+// A record that was never written, or only in part, is caught by its board not making sense.
+static bool
+DecodeGameRecord(_In_reads_bytes_(STATS_STORE_RECORD_SIZE) const uint8_t* bytes, _Out_ GameRecord* record)
+{
+    record->difficulty = (Difficulty)GetLittleEndian(bytes, 1);
+    record->state = (GameState)GetLittleEndian(bytes + 1, 1);
+    record->width = (uint32_t)GetLittleEndian(bytes + 2, 2);
+    record->height = (uint32_t)GetLittleEndian(bytes + 4, 2);
+    record->totalMines = (uint32_t)GetLittleEndian(bytes + 6, 2);
+    record->duration = (uint32_t)GetLittleEndian(bytes + 8, 4);
+    record->bbbv = (uint32_t)GetLittleEndian(bytes + 12, 4);
+    record->seed = GetLittleEndian(bytes + 16, 8);
+    record->finished = GetLittleEndian(bytes + 24, 8);
+
+    return record->difficulty <= DIFFICULTY_CUSTOM && (record->state == GAME_WON || record->state == GAME_LOST) &&
+           record->width != 0 && record->width <= MAX_CELLS_HORIZONTALLY && record->height != 0 &&
+           record->height <= MAX_CELLS_VERTICALLY && record->totalMines < record->width * record->height &&
+           record->finished != 0;
+}
+
+static uint64_t
+GetDoubleBits(_In_ double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static double
+GetBitsDouble(_In_ uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static uint8_t*
+EncodeQuantileSketch(_Out_writes_bytes_(STATS_SKETCH_SIZE) uint8_t* bytes, _In_ const QuantileSketch* sketch)
+{
+    PutLittleEndian(bytes, sketch->count, 8);
+    PutLittleEndian(bytes + 8, GetDoubleBits(sketch->sum), 8);
+    PutLittleEndian(bytes + 16, GetDoubleBits(sketch->minimum), 8);
+    PutLittleEndian(bytes + 24, GetDoubleBits(sketch->maximum), 8);
+    bytes += 32;
+
+    for (uint32_t i = 0; i < QUANTILE_SKETCH_BUCKETS; i++, bytes += 4)
+        PutLittleEndian(bytes, sketch->buckets[i], 4);
+
+    return bytes;
+}
+
+static const uint8_t*
+DecodeQuantileSketch(_In_reads_bytes_(STATS_SKETCH_SIZE) const uint8_t* bytes, _Out_ QuantileSketch* sketch)
+{
+    sketch->count = GetLittleEndian(bytes, 8);
+    sketch->sum = GetBitsDouble(GetLittleEndian(bytes + 8, 8));
+    sketch->minimum = GetBitsDouble(GetLittleEndian(bytes + 16, 8));
+    sketch->maximum = GetBitsDouble(GetLittleEndian(bytes + 24, 8));
+    bytes += 32;
+
+    for (uint32_t i = 0; i < QUANTILE_SKETCH_BUCKETS; i++, bytes += 4)
+        sketch->buckets[i] = (uint32_t)GetLittleEndian(bytes, 4);
+
+    return bytes;
+}
+
+static uint8_t*
+EncodeDifficultyAggregate(
+    _Out_writes_bytes_(STATS_DIFFICULTY_SIZE) uint8_t* bytes,
+    _In_ const DifficultyAggregate* aggregate)
+{
+    PutLittleEndian(bytes, aggregate->games, 8);
+    PutLittleEndian(bytes + 8, aggregate->wins, 8);
+    PutLittleEndian(bytes + 16, aggregate->losses, 8);
+    PutLittleEndian(bytes + 24, aggregate->wonMilliseconds, 8);
+    PutLittleEndian(bytes + 32, aggregate->winStreak, 4);
+    PutLittleEndian(bytes + 36, aggregate->lossStreak, 4);
+    PutLittleEndian(bytes + 40, aggregate->longestWinStreak, 4);
+    PutLittleEndian(bytes + 44, aggregate->longestLossStreak, 4);
+    PutLittleEndian(bytes + 48, aggregate->bestCount, 4);
+    bytes += 52;
+
+    for (uint32_t i = 0; i < STATS_BEST_TIMES; i++, bytes += 24)
+    {
+        PutLittleEndian(bytes, aggregate->best[i].duration, 4);
+        PutLittleEndian(bytes + 4, aggregate->best[i].bbbv, 4);
+        PutLittleEndian(bytes + 8, aggregate->best[i].seed, 8);
+        PutLittleEndian(bytes + 16, aggregate->best[i].finished, 8);
+    }
+
+    bytes = EncodeQuantileSketch(bytes, &aggregate->times);
+
+    return EncodeQuantileSketch(bytes, &aggregate->bbbvRates);
+}
+
+static const uint8_t*
+DecodeDifficultyAggregate(
+    _In_reads_bytes_(STATS_DIFFICULTY_SIZE) const uint8_t* bytes,
+    _Out_ DifficultyAggregate* aggregate)
+{
+    aggregate->games = GetLittleEndian(bytes, 8);
+    aggregate->wins = GetLittleEndian(bytes + 8, 8);
+    aggregate->losses = GetLittleEndian(bytes + 16, 8);
+    aggregate->wonMilliseconds = GetLittleEndian(bytes + 24, 8);
+    aggregate->winStreak = (uint32_t)GetLittleEndian(bytes + 32, 4);
+    aggregate->lossStreak = (uint32_t)GetLittleEndian(bytes + 36, 4);
+    aggregate->longestWinStreak = (uint32_t)GetLittleEndian(bytes + 40, 4);
+    aggregate->longestLossStreak = (uint32_t)GetLittleEndian(bytes + 44, 4);
+    aggregate->bestCount = (uint32_t)GetLittleEndian(bytes + 48, 4);
+    aggregate->bestCount = aggregate->bestCount < STATS_BEST_TIMES ? aggregate->bestCount : STATS_BEST_TIMES;
+    bytes += 52;
+
+    for (uint32_t i = 0; i < STATS_BEST_TIMES; i++, bytes += 24)
+    {
+        aggregate->best[i].duration = (uint32_t)GetLittleEndian(bytes, 4);
+        aggregate->best[i].bbbv = (uint32_t)GetLittleEndian(bytes + 4, 4);
+        aggregate->best[i].seed = GetLittleEndian(bytes + 8, 8);
+        aggregate->best[i].finished = GetLittleEndian(bytes + 16, 8);
+    }
+
+    bytes = DecodeQuantileSketch(bytes, &aggregate->times);
+
+    return DecodeQuantileSketch(bytes, &aggregate->bbbvRates);
+}
+
+// Reads one slot and takes its aggregates if it is whole and covers no more records than the log holds.
+static bool
+LoadSnapshot(_Inout_ StatsStore* store, _In_ uint32_t slot, _In_ uint64_t fileRecords)
+{
+    uint8_t* buffer = store->buffer;
+    const uint8_t* payload = buffer + STATS_SLOT_HEADER_SIZE;
+
+    if (!ReadStoreBytes(&store->storage,
+                        STATS_STORE_HEADER_SIZE + (uint64_t)slot * STATS_STORE_SLOT_SIZE,
+                        buffer,
+                        STATS_SLOT_HEADER_SIZE + STATS_SNAPSHOT_SIZE))
+    {
+        return false;
+    }
+
+    uint64_t sequence = GetLittleEndian(buffer, 8);
+    uint64_t records = GetLittleEndian(buffer + 8, 8);
+
+    if (sequence == 0 || records > fileRecords || GetLittleEndian(buffer + 24, 4) != STATS_SNAPSHOT_SIZE ||
+        GetLittleEndian(buffer + 16, 8) != ComputeSnapshotChecksum(payload, STATS_SNAPSHOT_SIZE))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i <= DIFFICULTY_CUSTOM; i++)
+        payload = DecodeDifficultyAggregate(payload, &store->aggregates.difficulties[i]);
+
+    store->aggregates.records = records;
+    store->snapshotRecords = records;
+    store->slot = slot;
+
+    return true;
+}
+
+// Adds up the records from the aggregates' count onwards, stopping at the end of the log or the first bad record.
+static bool
+FoldGameRecords(
+    _In_ const StatsStorage* storage,
+    _Inout_updates_bytes_(blockRecords* STATS_STORE_RECORD_SIZE) uint8_t* buffer,
+    _In_ uint32_t blockRecords,
+    _In_ uint64_t fileRecords,
+    _Inout_ StatsAggregates* aggregates)
+{
+    while (aggregates->records < fileRecords)
+    {
+        uint64_t left = fileRecords - aggregates->records;
+        uint32_t count = left < blockRecords ? (uint32_t)left : blockRecords;
+        uint64_t offset = STATS_STORE_RECORDS_OFFSET + aggregates->records * STATS_STORE_RECORD_SIZE;
+
+        if (!ReadStoreBytes(storage, offset, buffer, count * STATS_STORE_RECORD_SIZE))
+            return false;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            GameRecord record;
+
+            if (!DecodeGameRecord(buffer + i * STATS_STORE_RECORD_SIZE, &record))
+                return true;
+
+            AddGameRecord(aggregates, &record);
+        }
+    }
+
+    return true;
+}
+
+static bool
+InitializeStatsFile(_Inout_ StatsStore* store)
+{
+    const StatsStorage* storage = &store->storage;
+    uint8_t* buffer = store->buffer;
+
+    memset(buffer, 0, STATS_STORE_SLOT_SIZE);
+
+    if (!WriteStoreBytes(storage, STATS_STORE_HEADER_SIZE, buffer, STATS_STORE_SLOT_SIZE) ||
+        !WriteStoreBytes(storage, STATS_STORE_HEADER_SIZE + STATS_STORE_SLOT_SIZE, buffer, STATS_STORE_SLOT_SIZE))
+    {
+        return false;
+    }
+
+    PutLittleEndian(buffer, STATS_STORE_MAGIC, 4);
+    PutLittleEndian(buffer + 4, STATS_STORE_VERSION, 2);
+    PutLittleEndian(buffer + 6, STATS_STORE_RECORD_SIZE, 2);
+    PutLittleEndian(buffer + 8, STATS_STORE_SLOT_SIZE, 4);
+
+    // The header goes last, so a file without one is simply set up again.
+    return WriteStoreBytes(storage, 0, buffer, STATS_STORE_HEADER_SIZE) && storage->flush(storage->context);
+}
+
+bool
+OpenStatsStorage(_Out_ StatsStore* store, _In_ const StatsStorage* storage)
+{
+    uint64_t size;
+    uint8_t header[STATS_STORE_HEADER_SIZE];
+
+    memset(store, 0, sizeof(StatsStore));
+    store->storage = *storage;
+    store->slot = 1;
+
+    if (!storage->getSize(storage->context, &size))
+        return false;
+
+    bool hasHeader = size >= STATS_STORE_HEADER_SIZE && ReadStoreBytes(storage, 0, header, sizeof(header));
+
+    // The header is written last when a store is set up, so one without it is set up again. Any other bytes are left
+    // alone.
+    if (!hasHeader || GetLittleEndian(header, 4) == 0)
+    {
+        store->open = InitializeStatsFile(store);
+        return store->open;
+    }
+
+    uint32_t version = (uint32_t)GetLittleEndian(header + 4, 2);
+
+    if (GetLittleEndian(header, 4) != STATS_STORE_MAGIC || version == 0 || version > STATS_STORE_VERSION ||
+        GetLittleEndian(header + 6, 2) != STATS_STORE_RECORD_SIZE ||
+        GetLittleEndian(header + 8, 4) != STATS_STORE_SLOT_SIZE || size < STATS_STORE_RECORDS_OFFSET)
+    {
+        store->badFormat = true;
+        return false;
+    }
+
+    uint64_t fileRecords = (size - STATS_STORE_RECORDS_OFFSET) / STATS_STORE_RECORD_SIZE;
+    uint8_t sequences[2][8];
+
+    if (!ReadStoreBytes(storage, STATS_STORE_HEADER_SIZE, sequences[0], 8) ||
+        !ReadStoreBytes(storage, STATS_STORE_HEADER_SIZE + STATS_STORE_SLOT_SIZE, sequences[1], 8))
+    {
+        return false;
+    }
+
+    // The newer slot is tried first; without a usable snapshot every record is read. Either way the next snapshot
+    // is numbered past both, so a stale slot never looks newer than it.
+    uint32_t newer = GetLittleEndian(sequences[1], 8) > GetLittleEndian(sequences[0], 8) ? 1 : 0;
+
+    store->sequence = GetLittleEndian(sequences[newer], 8);
+
+    if (!LoadSnapshot(store, newer, fileRecords) && !LoadSnapshot(store, newer ^ 1, fileRecords))
+        memset(&store->aggregates, 0, sizeof(StatsAggregates));
+
+    if (!FoldGameRecords(storage, store->buffer, STATS_BLOCK_RECORDS, fileRecords, &store->aggregates))
+        return false;
+
+    uint64_t end = STATS_STORE_RECORDS_OFFSET + store->aggregates.records * STATS_STORE_RECORD_SIZE;
+
+    if (end < size && !storage->setSize(storage->context, end))
+        return false;
+
+    // Snapshots from an older version have another size and are never loaded, so its records were all read above
+    // and the store moves to this version with a snapshot of its own.
+    if (version < STATS_STORE_VERSION)
+    {
+        PutLittleEndian(header + 4, STATS_STORE_VERSION, 2);
+
+        if (!CompactStatsStore(store) || !WriteStoreBytes(storage, 0, header, sizeof(header)))
+            return false;
+    }
+    else if (store->aggregates.records - store->snapshotRecords >= STATS_STORE_COMPACT_RECORDS)
+    {
+        CompactStatsStore(store);
+    }
+
+    store->open = true;
+
+    return true;
+}
+
+bool
+AppendGameRecord(_Inout_ StatsStore* store, _In_ const GameRecord* record)
+{
+    uint8_t bytes[STATS_STORE_RECORD_SIZE];
+    uint64_t offset = STATS_STORE_RECORDS_OFFSET + store->aggregates.records * STATS_STORE_RECORD_SIZE;
+
+    EncodeGameRecord(bytes, record);
+
+    // Opening cut the log after its last good record, so this lands at the end of the file.
+    if (!WriteStoreBytes(&store->storage, offset, bytes, sizeof(bytes)))
+        return false;
+
+    AddGameRecord(&store->aggregates, record);
+
+    if (store->aggregates.records - store->snapshotRecords >= STATS_STORE_COMPACT_RECORDS)
+        CompactStatsStore(store);
+
+    return true;
+}
+
+bool
+CompactStatsStore(_Inout_ StatsStore* store)
+{
+    const StatsStorage* storage = &store->storage;
+    uint8_t* buffer = store->buffer;
+    uint8_t* payload = buffer + STATS_SLOT_HEADER_SIZE;
+    uint32_t slot = store->slot ^ 1;
+
+    for (uint32_t i = 0; i <= DIFFICULTY_CUSTOM; i++)
+        payload = EncodeDifficultyAggregate(payload, &store->aggregates.difficulties[i]);
+
+    memset(buffer, 0, STATS_SLOT_HEADER_SIZE);
+    PutLittleEndian(buffer, store->sequence + 1, 8);
+    PutLittleEndian(buffer + 8, store->aggregates.records, 8);
+    PutLittleEndian(buffer + 16, ComputeSnapshotChecksum(buffer + STATS_SLOT_HEADER_SIZE, STATS_SNAPSHOT_SIZE), 8);
+    PutLittleEndian(buffer + 24, STATS_SNAPSHOT_SIZE, 4);
+
+    // The records are flushed before the snapshot that covers them, so a snapshot never gets ahead of the log.
+    if (!storage->flush(storage->context) ||
+        !WriteStoreBytes(storage,
+                         STATS_STORE_HEADER_SIZE + (uint64_t)slot * STATS_STORE_SLOT_SIZE,
+                         buffer,
+                         STATS_SLOT_HEADER_SIZE + STATS_SNAPSHOT_SIZE) ||
+        !storage->flush(storage->context))
+    {
+        return false;
+    }
+
+    store->sequence++;
+    store->snapshotRecords = store->aggregates.records;
+    store->slot = slot;
+
+    return true;
+}
+
+void
+CloseStatsStore(_Inout_ StatsStore* store)
+{
+    if (store->open)
+    {
+        if (store->aggregates.records != store->snapshotRecords)
+            CompactStatsStore(store);
+
+        if (store->storage.close != NULL)
+            store->storage.close(store->storage.context);
+    }
+
+    store->open = false;
+}
+
+bool
+RebuildStatsAggregates(_In_ const StatsStore* store, _Out_ StatsAggregates* aggregates)
+{
+    uint8_t buffer[STATS_REBUILD_BLOCK_RECORDS * STATS_STORE_RECORD_SIZE];
+    uint64_t size;
+
+    memset(aggregates, 0, sizeof(StatsAggregates));
+
+    return store->storage.getSize(store->storage.context, &size) &&
+           FoldGameRecords(&store->storage,
+                           buffer,
+                           STATS_REBUILD_BLOCK_RECORDS,
+                           (size - STATS_STORE_RECORDS_OFFSET) / STATS_STORE_RECORD_SIZE,
+                           aggregates);
+}
+
+static void
+InsertBestTime(_Inout_ DifficultyAggregate* aggregate, _In_ const GameRecord* record)
+{
+    uint32_t position = aggregate->bestCount;
+
+    // Ties keep the earlier game ahead.
+    while (position > 0 && aggregate->best[position - 1].duration > record->duration)
+        position--;
+
+    if (position == STATS_BEST_TIMES)
+        return;
+
+    uint32_t last = aggregate->bestCount < STATS_BEST_TIMES - 1 ? aggregate->bestCount : STATS_BEST_TIMES - 1;
+
+    memmove(&aggregate->best[position + 1], &aggregate->best[position], sizeof(BestTime) * (last - position));
+
+    aggregate->best[position] = (BestTime){
+        .duration = record->duration,
+        .bbbv = record->bbbv,
+        .seed = record->seed,
+        .finished = record->finished,
+    };
+    aggregate->bestCount = last + 1;
+}
+
+void
+AddGameRecord(_Inout_ StatsAggregates* aggregates, _In_ const GameRecord* record)
+{
+    DifficultyAggregate* aggregate = &aggregates->difficulties[record->difficulty];
+
+    aggregates->records++;
+    aggregate->games++;
+
+    if (record->state == GAME_WON)
+    {
+        aggregate->wins++;
+        aggregate->wonMilliseconds += record->duration;
+        aggregate->winStreak++;
+        aggregate->lossStreak = 0;
+        aggregate->longestWinStreak =
+            aggregate->winStreak > aggregate->longestWinStreak ? aggregate->winStreak : aggregate->longestWinStreak;
+        AddQuantileSketchValue(&aggregate->times, record->duration / 1000.0);
+
+        if (record->bbbv != 0 && record->duration != 0)
+            AddQuantileSketchValue(&aggregate->bbbvRates, record->bbbv * 1000.0 / record->duration);
+
+        InsertBestTime(aggregate, record);
+    }
+    else
+    {
+        aggregate->losses++;
+        aggregate->lossStreak++;
+        aggregate->winStreak = 0;
+        aggregate->longestLossStreak =
+            aggregate->lossStreak > aggregate->longestLossStreak ? aggregate->lossStreak : aggregate->longestLossStreak;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "quantilesketch.h"
+
+#define STATS_STORE_HEADER_SIZE 64
+#define STATS_STORE_SLOT_SIZE (64 * 1024)
+#define STATS_STORE_RECORD_SIZE 32
+#define STATS_STORE_RECORDS_OFFSET (STATS_STORE_HEADER_SIZE + 2 * STATS_STORE_SLOT_SIZE)
+
+// Records appended since the last snapshot before the store writes a new one, which bounds the records read at
+// startup.
+#define STATS_STORE_COMPACT_RECORDS 64
+
+#define STATS_BEST_TIMES 10
+
+// One finished game. duration is in milliseconds, bbbv is zero when it was not worked out, and finished is a
+// FILETIME.
+typedef struct
+{
+    Difficulty difficulty;
+    GameState state;
+    uint32_t width;
+    uint32_t height;
+    uint32_t totalMines;
+    uint32_t duration;
+    uint32_t bbbv;
+    uint64_t seed;
+    uint64_t finished;
+} GameRecord;
+
+typedef struct
+{
+    uint32_t duration;
+    uint32_t bbbv;
+    uint64_t seed;
+    uint64_t finished;
+} BestTime;
+
+// Totals for one difficulty. A streak runs until a game of the same difficulty ends the other way. Best times are
+// kept fastest first. The sketches hold won times in seconds and 3BV/s of the won games with a 3BV and a time.
+typedef struct
+{
+    uint64_t games;
+    uint64_t wins;
+    uint64_t losses;
+    uint64_t wonMilliseconds;
+    uint32_t winStreak;
+    uint32_t lossStreak;
+    uint32_t longestWinStreak;
+    uint32_t longestLossStreak;
+    uint32_t bestCount;
+    BestTime best[STATS_BEST_TIMES];
+    QuantileSketch times;
+    QuantileSketch bbbvRates;
+} DifficultyAggregate;
+
+typedef struct
+{
+    DifficultyAggregate difficulties[DIFFICULTY_CUSTOM + 1];
+    uint64_t records;
+} StatsAggregates;
+
+// The bytes a store lives in. Reads and writes name their offset, a read past the end fails and a write past it
+// extends the bytes; setSize cuts them short. This file uses nothing else, so a buffer in memory can stand in for the
+// file the game keeps; statsfile.h has that one. close may be NULL.
+typedef struct
+{
+    bool (*read)(
+        _Inout_opt_ void* context,
+        _In_ uint64_t offset,
+        _Out_writes_bytes_(size) uint8_t* bytes,
+        _In_ uint32_t size);
+    bool (*write)(
+        _Inout_opt_ void* context,
+        _In_ uint64_t offset,
+        _In_reads_bytes_(size) const uint8_t* bytes,
+        _In_ uint32_t size);
+    bool (*flush)(_Inout_opt_ void* context);
+    bool (*getSize)(_Inout_opt_ void* context, _Out_ uint64_t* size);
+    bool (*setSize)(_Inout_opt_ void* context, _In_ uint64_t size);
+    void (*close)(_Inout_opt_ void* context);
+    void* context;
+} StatsStorage;
+
+// The store is a 64-byte header, two snapshot slots and then one 32-byte record per finished game, in the order they
+// were played. A snapshot holds the aggregates over the first records of the log, with a sequence number and a
+// checksum; opening the store takes the newest whole snapshot and folds in only the records after it. Every
+// STATS_STORE_COMPACT_RECORDS games the aggregates are written over the older slot, so a torn write leaves the
+// other one to fall back on and startup never reads more than a snapshot and a short tail, however long the history.
+typedef struct
+{
+    StatsStorage storage;
+    uint64_t sequence;
+    uint64_t snapshotRecords;
+    uint32_t slot;
+    bool open;
+    bool badFormat;
+    StatsAggregates aggregates;
+    uint8_t buffer[STATS_STORE_SLOT_SIZE];
+} StatsStore;
+
+// Opens the store in the storage, setting it up when it is empty. The records after the snapshot are checked one by
+// one and the log is cut at the first that does not hold a finished game, so the records behind a damaged one never
+// come back once new games are appended over it. The store closes the storage once it is open; when opening fails the
+// storage is left to the caller, and badFormat tells bytes that are not a store from a failed read or write.
+bool OpenStatsStorage(_Out_ StatsStore* store, _In_ const StatsStorage* storage);
+
+// Appends the record and adds it to the aggregates, writing a snapshot once enough records have piled up after the
+// last one.
+bool AppendGameRecord(_Inout_ StatsStore* store, _In_ const GameRecord* record);
+
+bool CompactStatsStore(_Inout_ StatsStore* store);
+
+// Writes a snapshot if any records came after the last one.
+void CloseStatsStore(_Inout_ StatsStore* store);
+
+// Reads the whole log and adds up every record again, which is what opening the store would cost without snapshots.
+bool RebuildStatsAggregates(_In_ const StatsStore* store, _Out_ StatsAggregates* aggregates);
+
+void AddGameRecord(_Inout_ StatsAggregates* aggregates, _In_ const GameRecord* record);
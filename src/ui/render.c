@@ -118,6 +118,10 @@ GetFaceBitmap(_In_ const Application* app)
                 return app->faceResources.click;
             }
 
+            // A no-guess first click waiting for its board.
+            if (app->firstClickPending)
+                return app->faceResources.click;
+
             break;
         }
         case GAME_WON:
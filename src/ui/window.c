@@ -2,11 +2,18 @@
 
 #include "application.h"
 #include "game.h"
+#include "replay.h"
 #include "resource.h"
+#include "savegame.h"
+#include "statsfile.h"
 #include "ui/render.h"
 #include "ui/window.h"
 
 #define TICK_TIMER_ID 1
+#define AUTOSAVE_TIMER_ID 2
+#define AUTOSAVE_INTERVAL 5000
+#define FIRST_CLICK_TIMER_ID 3
+#define FIRST_CLICK_POLL_INTERVAL 50
 
 _Success_(return) static bool TryGetCellFromPoint(
     _In_ const Application* app,
@@ -315,9 +322,34 @@ ResizeWindowForMinefield(_Inout_ Application* app, _In_ HWND hWnd, _In_ bool for
     return true;
 }
 
+static BoardSettings
+GetBoardSettings(_In_ const Application* app)
+{
+    BoardSettings settings = {
+        .width = app->minefield.width,
+        .height = app->minefield.height,
+        .mines = app->minefield.totalMines,
+    };
+
+    return settings;
+}
+
+static void
+CancelPendingFirstClick(_Inout_ Application* app, _In_ HWND hWnd)
+{
+    if (!app->firstClickPending)
+        return;
+
+    KillTimer(hWnd, FIRST_CLICK_TIMER_ID);
+    app->firstClickPending = false;
+    SetCursor(LoadCursorW(NULL, IDC_ARROW));
+}
+
 static bool
 InitNewGame(_Inout_ Application* app, _In_ HWND hWnd, _In_ bool forceMinimum)
 {
+    CancelPendingFirstClick(app, hWnd);
+
     if (!ResizeWindowForMinefield(app, hWnd, forceMinimum))
     {
         MessageBoxW(hWnd, L"Minefield too large for display!", L"Error", MB_OK | MB_ICONWARNING);
@@ -328,10 +360,25 @@ InitNewGame(_Inout_ Application* app, _In_ HWND hWnd, _In_ bool forceMinimum)
     app->hoverCellX = (uint32_t)-1;
     app->hoverCellY = (uint32_t)-1;
 
+    BoardSettings settings = GetBoardSettings(app);
+
+    if (app->noGuess)
+        SetBoardPoolSettings(&app->boardPool, &settings);
+    else
+        StopBoardPool(&app->boardPool);
+
     InvalidateRect(hWnd, NULL, TRUE);
     return true;
 }
 
+// Creating a field detaches its opening index and replay log, so every new game takes the application's again.
+static void
+AttachGameRecords(_Inout_ Application* app)
+{
+    AttachOpeningIndex(&app->minefield, app->openings);
+    AttachReplayLog(&app->minefield, app->replay);
+}
+
 static void
 StartNewGame(_In_ Application* app, _In_ HWND hWnd, _In_ Difficulty difficulty)
 {
@@ -360,6 +407,8 @@ StartNewGame(_In_ Application* app, _In_ HWND hWnd, _In_ Difficulty difficulty)
         }
     }
 
+    AttachGameRecords(app);
+
     bool sizeChanged = (app->minefield.width != previousWidth) || (app->minefield.height != previousHeight);
     bool forceResize = false;
 
@@ -392,6 +441,8 @@ StartNewGameCustom(
         return;
     }
 
+    AttachGameRecords(app);
+
     bool sizeChanged = (app->minefield.width != previousWidth) || (app->minefield.height != previousHeight);
 
     InitNewGame(app, hWnd, sizeChanged);
@@ -523,6 +574,88 @@ HandleLeftMouseDown(_In_ Application* app, _In_ HWND hWnd, _In_ int32_t x, _In_
     InvalidateRect(hWnd, NULL, FALSE);
 }
 
+// Called after a click that ended the game, so each game is counted once. The autosave is brought up to date first: left
+// at the position before the finish, a crash would restore the game as still in play and count it again when it ends.
+static void
+RecordFinishedGame(_Inout_ Application* app)
+{
+    GameRecord record;
+
+    if (app->autosaveEnabled)
+        SaveGame(&app->autosave, &app->minefield);
+
+    if (app->statsEnabled && GetFinishedGameRecord(&app->minefield, &record))
+        AppendGameRecord(&app->stats, &record);
+}
+
+// No-guess boards only come from the pool, which generates them in the background. Generating one here could take
+// seconds on every core and would freeze the window, so on a miss the first click waits for the pool instead.
+static bool
+PlaceFirstClickMines(_Inout_ Application* app, _In_ uint32_t cellX, _In_ uint32_t cellY)
+{
+    Minefield* field = &app->minefield;
+    BoardSettings settings = GetBoardSettings(app);
+    HANDLE hHeap = GetProcessHeap();
+    bool* layout = HeapAlloc(hHeap, 0, sizeof(bool) * field->width * field->height);
+
+    if (layout == NULL)
+        return false;
+
+    bool placed = TakePooledBoard(&app->boardPool, &settings, cellX, cellY, layout) && SetMinefieldLayout(field, layout);
+
+    HeapFree(hHeap, 0, layout);
+
+    return placed;
+}
+
+static void
+RevealFirstClick(_Inout_ Application* app, _In_ uint32_t cellX, _In_ uint32_t cellY)
+{
+    if (RevealCell(&app->minefield, cellX, cellY) && app->minefield.state != GAME_PLAYING)
+        RecordFinishedGame(app);
+}
+
+// Polled while a no-guess first click waits for its board. The board is only abandoned when the pool has given up on
+// these settings, and then the player is told rather than dealt a board that may need guessing.
+static void
+ServePendingFirstClick(_Inout_ Application* app, _In_ HWND hWnd)
+{
+    BoardPoolStats stats;
+
+    if (PlaceFirstClickMines(app, app->pendingCellX, app->pendingCellY))
+    {
+        CancelPendingFirstClick(app, hWnd);
+        RevealFirstClick(app, app->pendingCellX, app->pendingCellY);
+        InvalidateRect(hWnd, NULL, FALSE);
+        return;
+    }
+
+    GetBoardPoolStats(&app->boardPool, &stats);
+
+    if (stats.exhausted)
+    {
+        CancelPendingFirstClick(app, hWnd);
+        InvalidateRect(hWnd, NULL, FALSE);
+        MessageBoxW(
+            hWnd,
+            L"No board that can be cleared without guessing could be made with this many mines. Choose fewer mines or "
+            L"turn off No Guessing.",
+            L"No Guessing",
+            MB_OK | MB_ICONWARNING);
+    }
+}
+
+static void
+WaitForFirstClickBoard(_Inout_ Application* app, _In_ HWND hWnd, _In_ uint32_t cellX, _In_ uint32_t cellY)
+{
+    app->pendingCellX = cellX;
+    app->pendingCellY = cellY;
+    app->firstClickPending = SetTimer(hWnd, FIRST_CLICK_TIMER_ID, FIRST_CLICK_POLL_INTERVAL, NULL) != 0;
+
+    if (app->firstClickPending)
+        SetCursor(LoadCursorW(NULL, IDC_APPSTARTING));
+}
+
 static void
 HandleLeftMouseUp(_In_ Application* app, _In_ HWND hWnd, _In_ int32_t x, _In_ int32_t y)
 {
@@ -538,9 +671,12 @@ HandleLeftMouseUp(_In_ Application* app, _In_ HWND hWnd, _In_ int32_t x, _In_ in
             app->isFaceHot = false;
             StartNewGame(app, hWnd, app->minefield.difficulty);
         }
-        else if (TryGetCellFromPoint(app, x, y, &cellX, &cellY))
+        else if (!app->firstClickPending && TryGetCellFromPoint(app, x, y, &cellX, &cellY))
         {
-            RevealCell(&app->minefield, cellX, cellY);
+            if (app->minefield.firstClick && app->noGuess && !PlaceFirstClickMines(app, cellX, cellY))
+                WaitForFirstClickBoard(app, hWnd, cellX, cellY);
+            else
+                RevealFirstClick(app, cellX, cellY);
         }
     }
 
@@ -562,6 +698,130 @@ HandleRightMouseClick(_In_ Application* app, _In_ HWND hWnd, _In_ int32_t x, _In
     }
 }
 
+static void
+HandleMiddleMouseClick(_In_ Application* app, _In_ HWND hWnd, _In_ int32_t x, _In_ int32_t y)
+{
+    uint32_t cellX, cellY;
+
+    if (TryGetCellFromPoint(app, x, y, &cellX, &cellY) && ChordCell(&app->minefield, cellX, cellY))
+    {
+        if (app->minefield.state != GAME_PLAYING)
+            RecordFinishedGame(app);
+
+        InvalidateRect(hWnd, NULL, FALSE);
+    }
+}
+
+// Only a game still being played is picked up again; a finished one gives way to a new Beginner game.
+static bool
+RestoreAutosavedGame(_Inout_ Application* app, _In_ HWND hWnd)
+{
+    if (!app->autosaveEnabled || !LoadSavedGame(&app->minefield, app->openings, app->replay, app->autosave.path) ||
+        app->minefield.state != GAME_PLAYING)
+    {
+        return false;
+    }
+
+    return InitNewGame(app, hWnd, true);
+}
+
+static bool
+WriteReplayFile(_In_z_ const wchar_t* path, _In_reads_bytes_(size) const uint8_t* bytes, _In_ uint32_t size)
+{
+    HANDLE hFile = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    DWORD written = 0;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool success = WriteFile(hFile, bytes, size, &written, NULL) && written == size;
+
+    CloseHandle(hFile);
+
+    return success;
+}
+
+static void
+SaveReplay(_In_ const Application* app, _In_ HWND hWnd)
+{
+    HANDLE hHeap = GetProcessHeap();
+    uint8_t* bytes = HeapAlloc(hHeap, 0, REPLAY_FILE_MAX_SIZE);
+
+    if (bytes == NULL)
+        return;
+
+    uint32_t size = EncodeReplayFile(&app->minefield, bytes);
+    wchar_t path[MAX_PATH] = L"replay.msr";
+
+    OPENFILENAMEW ofn = {
+        .lStructSize = sizeof(OPENFILENAMEW),
+        .hwndOwner = hWnd,
+        .lpstrFilter = L"Minesweeper replays (*.msr)\0*.msr\0All files (*.*)\0*.*\0",
+        .lpstrFile = path,
+        .nMaxFile = ARRAYSIZE(path),
+        .lpstrDefExt = L"msr",
+        .Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST,
+    };
+
+    if (size == 0)
+    {
+        MessageBoxW(hWnd, L"Nothing to save until the first cell is revealed.", L"Save Replay", MB_OK);
+    }
+    else if (app->minefield.replay->droppedEvents != 0)
+    {
+        MessageBoxW(hWnd, L"This game is too long to replay in full.", L"Save Replay", MB_OK | MB_ICONWARNING);
+    }
+    else if (GetSaveFileNameW(&ofn) && !WriteReplayFile(path, bytes, size))
+    {
+        MessageBoxW(hWnd, L"Failed to save the replay.", L"Error", MB_OK | MB_ICONERROR);
+    }
+
+    HeapFree(hHeap, 0, bytes);
+}
+
+static void
+ShowStatistics(_In_ const Application* app, _In_ HWND hWnd)
+{
+    static const wchar_t* const names[] = {L"Beginner", L"Intermediate", L"Expert", L"Custom"};
+
+    wchar_t text[2048];
+    int length = 0;
+
+    if (!app->statsEnabled)
+    {
+        MessageBoxW(hWnd, L"Statistics are not available.", L"Statistics", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    for (uint32_t i = 0; i < ARRAYSIZE(names) && length >= 0; i++)
+    {
+        const DifficultyAggregate* aggregate = &app->stats.aggregates.difficulties[i];
+        int written = swprintf(text + length,
+                               ARRAYSIZE(text) - length,
+                               L"%ls\n"
+                               L"  Played %llu, won %llu (%.0f%%)\n"
+                               L"  Best %.3f s, median %.1f s, 90%% under %.1f s, median %.2f 3BV/s\n"
+                               L"  Longest streak %u won, %u lost; current %u %ls\n\n",
+                               names[i],
+                               (unsigned long long)aggregate->games,
+                               (unsigned long long)aggregate->wins,
+                               aggregate->games == 0 ? 0.0 : 100.0 * aggregate->wins / aggregate->games,
+                               aggregate->bestCount == 0 ? 0.0 : aggregate->best[0].duration / 1000.0,
+                               GetQuantileSketchValue(&aggregate->times, 0.5),
+                               GetQuantileSketchValue(&aggregate->times, 0.9),
+                               GetQuantileSketchValue(&aggregate->bbbvRates, 0.5),
+                               aggregate->longestWinStreak,
+                               aggregate->longestLossStreak,
+                               max(aggregate->winStreak, aggregate->lossStreak),
+                               aggregate->lossStreak != 0 ? L"lost" : L"won");
+
+        length = written < 0 ? -1 : length + written;
+    }
+
+    if (length >= 0)
+        MessageBoxW(hWnd, text, L"Statistics", MB_OK | MB_ICONINFORMATION);
+}
+
 static LRESULT CALLBACK
 WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lParam)
 {
@@ -608,16 +868,26 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
             if (app != NULL)
             {
                 UpdateLayoutMetricsForWindow(app, hWnd);
-                StartNewGame(app, hWnd, DIFFICULTY_BEGINNER);
+
+                if (!RestoreAutosavedGame(app, hWnd))
+                    StartNewGame(app, hWnd, DIFFICULTY_BEGINNER);
             }
 
             SetTimer(hWnd, TICK_TIMER_ID, 1000, NULL);
+            SetTimer(hWnd, AUTOSAVE_TIMER_ID, AUTOSAVE_INTERVAL, NULL);
 
             return 0;
         }
         case WM_DESTROY:
         {
+            Application* app = (Application*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+
             KillTimer(hWnd, TICK_TIMER_ID);
+            KillTimer(hWnd, AUTOSAVE_TIMER_ID);
+
+            if (app != NULL && app->autosaveEnabled)
+                SaveGame(&app->autosave, &app->minefield);
+
             PostQuitMessage(0);
 
             return 0;
@@ -661,6 +931,24 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
                         }
                     }
 
+                    return 0;
+                }
+                case FIRST_CLICK_TIMER_ID:
+                {
+                    if (app != NULL && app->firstClickPending)
+                        ServePendingFirstClick(app, hWnd);
+
+                    return 0;
+                }
+                case AUTOSAVE_TIMER_ID:
+                {
+                    // A save writes only the chunks changed since the last one, so it can run while the game is played.
+                    if (app != NULL && app->autosaveEnabled && app->minefield.state == GAME_PLAYING &&
+                        !app->minefield.firstClick)
+                    {
+                        SaveGame(&app->autosave, &app->minefield);
+                    }
+
                     return 0;
                 }
             }
@@ -711,6 +999,17 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
                         (LPARAM)app);
                     break;
                 }
+                case IDM_GAME_NOGUESS:
+                    app->noGuess = !app->noGuess;
+                    CheckMenuItem(GetMenu(hWnd), IDM_GAME_NOGUESS, app->noGuess ? MF_CHECKED : MF_UNCHECKED);
+                    StartNewGame(app, hWnd, app->minefield.difficulty);
+                    break;
+                case IDM_GAME_SAVE_REPLAY:
+                    SaveReplay(app, hWnd);
+                    break;
+                case IDM_GAME_STATISTICS:
+                    ShowStatistics(app, hWnd);
+                    break;
                 case IDM_GAME_EXIT:
                     SendMessage(hWnd, WM_CLOSE, 0, 0);
                     break;
@@ -729,7 +1028,9 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
                         L"Controls:\n"
                         L"- Left-click: Reveal\n"
                         L"- Right-click: Flag/Unflag\n"
-                        L"- F2: New Game\n\n",
+                        L"- Middle-click: Chord\n"
+                        L"- F2: New Game\n"
+                        L"- Ctrl+S: Save Replay\n\n",
                         __DATE__,
                         __TIME__);
 
@@ -742,6 +1043,18 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
 
             return 0;
         }
+        case WM_SETCURSOR:
+        {
+            Application* app = (Application*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+
+            if (app != NULL && app->firstClickPending && LOWORD(lParam) == HTCLIENT)
+            {
+                SetCursor(LoadCursorW(NULL, IDC_APPSTARTING));
+                return TRUE;
+            }
+
+            break;
+        }
         case WM_MOUSEMOVE:
         {
             int32_t x = GET_X_LPARAM(lParam);
@@ -794,6 +1107,19 @@ WindowProc(_In_ HWND hWnd, _In_ UINT uMsg, _In_ WPARAM wParam, _In_ LPARAM lPara
 
             return 0;
         }
+        case WM_MBUTTONUP:
+        {
+            int32_t x = GET_X_LPARAM(lParam);
+            int32_t y = GET_Y_LPARAM(lParam);
+            Application* app = (Application*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+
+            if (app != NULL)
+            {
+                HandleMiddleMouseClick(app, hWnd, x, y);
+            }
+
+            return 0;
+        }
         case WM_DPICHANGED:
         {
             RECT* const prcNewWindow = (RECT*)lParam;
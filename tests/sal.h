@@ -0,0 +1,19 @@
+#pragma once
+
+// The annotations the portable sources use, expanded to nothing for compilers that ship without sal.h.
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_reads_(size)
+#define _In_reads_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Out_writes_bytes_(size)
+#define _Inout_
+#define _Inout_opt_
+#define _Inout_updates_(size)
+#define _Inout_updates_bytes_(size)
+#define _Ret_maybenull_
+#define _Ret_maybenull_z_
+#define _Success_(expression)
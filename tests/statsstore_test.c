@@ -0,0 +1,280 @@
+// Opens, appends to and damages a statistics store kept in memory, checking what each open recovers.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statsstore.h"
+
+#define TEST_GAMES 1000
+
+typedef struct
+{
+    uint8_t* bytes;
+    uint64_t size;
+    uint64_t capacity;
+    uint32_t failingWrite;
+} MemoryStorage;
+
+static StatsStore store;
+static StatsAggregates expected;
+static StatsAggregates rebuilt;
+static uint32_t failures;
+
+static bool
+ReadMemory(
+    _Inout_opt_ void* context,
+    _In_ uint64_t offset,
+    _Out_writes_bytes_(size) uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    MemoryStorage* memory = context;
+
+    if (offset + size > memory->size)
+        return false;
+
+    memcpy(bytes, memory->bytes + offset, size);
+
+    return true;
+}
+
+static bool
+SetMemorySize(_Inout_opt_ void* context, _In_ uint64_t size)
+{
+    MemoryStorage* memory = context;
+
+    if (size > memory->capacity)
+    {
+        uint8_t* bytes = realloc(memory->bytes, size * 2);
+
+        if (bytes == NULL)
+            return false;
+
+        memory->bytes = bytes;
+        memory->capacity = size * 2;
+    }
+
+    if (size > memory->size)
+        memset(memory->bytes + memory->size, 0, size - memory->size);
+
+    memory->size = size;
+
+    return true;
+}
+
+// failingWrite counts down the writes that succeed before one fails.
+static bool
+WriteMemory(
+    _Inout_opt_ void* context,
+    _In_ uint64_t offset,
+    _In_reads_bytes_(size) const uint8_t* bytes,
+    _In_ uint32_t size)
+{
+    MemoryStorage* memory = context;
+
+    if (memory->failingWrite != 0 && --memory->failingWrite == 0)
+        return false;
+
+    if (offset + size > memory->size && !SetMemorySize(context, offset + size))
+        return false;
+
+    memcpy(memory->bytes + offset, bytes, size);
+
+    return true;
+}
+
+static bool
+FlushMemory(_Inout_opt_ void* context)
+{
+    (void)context;
+
+    return true;
+}
+
+static bool
+GetMemorySize(_Inout_opt_ void* context, _Out_ uint64_t* size)
+{
+    *size = ((MemoryStorage*)context)->size;
+
+    return true;
+}
+
+static StatsStorage
+GetMemoryStorage(_In_ MemoryStorage* memory)
+{
+    StatsStorage storage = {
+        .read = ReadMemory,
+        .write = WriteMemory,
+        .flush = FlushMemory,
+        .getSize = GetMemorySize,
+        .setSize = SetMemorySize,
+        .close = NULL,
+        .context = memory,
+    };
+
+    return storage;
+}
+
+static void
+Check(_In_ bool condition, _In_z_ const char* name)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s\n", name);
+        failures++;
+    }
+}
+
+static void
+GetTestRecord(_In_ uint32_t index, _Out_ GameRecord* record)
+{
+    static const uint32_t sizes[][3] = {{9, 9, 10}, {16, 16, 40}, {30, 16, 99}, {50, 50, 500}};
+
+    uint32_t difficulty = index % 4;
+
+    memset(record, 0, sizeof(GameRecord));
+    record->difficulty = (Difficulty)difficulty;
+    record->state = (index * 7) % 3 != 0 ? GAME_WON : GAME_LOST;
+    record->width = sizes[difficulty][0];
+    record->height = sizes[difficulty][1];
+    record->totalMines = sizes[difficulty][2];
+    record->duration = 1000 + index * 37 % 5000;
+    record->bbbv = 10 + index % 30;
+    record->seed = index;
+    record->finished = 1 + (uint64_t)index;
+}
+
+static uint64_t
+GetRecordOffset(_In_ uint64_t index)
+{
+    return STATS_STORE_RECORDS_OFFSET + index * STATS_STORE_RECORD_SIZE;
+}
+
+// A slot numbered zero was never written, so clearing the numbers loses both snapshots however often it is done.
+static void
+TearSnapshots(_Inout_ MemoryStorage* memory)
+{
+    memset(memory->bytes + STATS_STORE_HEADER_SIZE, 0, 8);
+    memset(memory->bytes + STATS_STORE_HEADER_SIZE + STATS_STORE_SLOT_SIZE, 0, 8);
+}
+
+// Closes the store, reopens it and checks the aggregates it opens with, and a full rebuild, against the expected ones.
+static void
+CheckReopen(_In_ const StatsStorage* storage, _In_z_ const char* name)
+{
+    CloseStatsStore(&store);
+
+    bool opened = OpenStatsStorage(&store, storage);
+
+    Check(opened, name);
+
+    if (opened)
+    {
+        Check(memcmp(&store.aggregates, &expected, sizeof(StatsAggregates)) == 0, name);
+        Check(RebuildStatsAggregates(&store, &rebuilt) &&
+                  memcmp(&rebuilt, &expected, sizeof(StatsAggregates)) == 0,
+              name);
+    }
+}
+
+static void
+TestHistory(void)
+{
+    MemoryStorage memory = {0};
+    StatsStorage storage = GetMemoryStorage(&memory);
+    GameRecord record;
+
+    memset(&expected, 0, sizeof(StatsAggregates));
+    Check(OpenStatsStorage(&store, &storage), "open empty");
+
+    for (uint32_t i = 0; i < TEST_GAMES; i++)
+    {
+        GetTestRecord(i, &record);
+        AddGameRecord(&expected, &record);
+        Check(AppendGameRecord(&store, &record), "append");
+    }
+
+    Check(store.snapshotRecords > 0, "snapshot written");
+    CheckReopen(&storage, "reopen");
+
+    // A torn last record is dropped and the next game goes in its place.
+    memset(&expected, 0, sizeof(StatsAggregates));
+
+    for (uint32_t i = 0; i < TEST_GAMES - 1; i++)
+    {
+        GetTestRecord(i, &record);
+        AddGameRecord(&expected, &record);
+    }
+
+    CloseStatsStore(&store);
+    memory.size -= 5;
+    CheckReopen(&storage, "torn record");
+    Check(memory.size == GetRecordOffset(TEST_GAMES - 1), "torn record cut");
+
+    // With both snapshots torn every record is read again.
+    TearSnapshots(&memory);
+    CheckReopen(&storage, "torn snapshots");
+
+    // A bad record in the middle ends the log there, and the records after it stay gone once a game is appended over
+    // it and the store is opened from the snapshot that covers that game.
+    uint32_t damaged = TEST_GAMES / 2;
+
+    memset(&expected, 0, sizeof(StatsAggregates));
+
+    for (uint32_t i = 0; i < damaged; i++)
+    {
+        GetTestRecord(i, &record);
+        AddGameRecord(&expected, &record);
+    }
+
+    CloseStatsStore(&store);
+    TearSnapshots(&memory);
+    memset(memory.bytes + GetRecordOffset(damaged), 0, STATS_STORE_RECORD_SIZE);
+    CheckReopen(&storage, "damaged record");
+    Check(memory.size == GetRecordOffset(damaged), "damaged record cut");
+
+    GetTestRecord(TEST_GAMES, &record);
+    AddGameRecord(&expected, &record);
+    Check(AppendGameRecord(&store, &record), "append after damaged record");
+    CheckReopen(&storage, "reopen after damaged record");
+
+    CloseStatsStore(&store);
+    free(memory.bytes);
+}
+
+static void
+TestBadFormat(void)
+{
+    MemoryStorage memory = {0};
+    StatsStorage storage = GetMemoryStorage(&memory);
+    uint8_t junk[STATS_STORE_HEADER_SIZE];
+
+    memset(junk, 'A', sizeof(junk));
+    WriteMemory(&memory, 0, junk, sizeof(junk));
+
+    Check(!OpenStatsStorage(&store, &storage) && store.badFormat, "bad format");
+    free(memory.bytes);
+}
+
+static void
+TestFailedWrite(void)
+{
+    MemoryStorage memory = {
+        .failingWrite = 2,
+    };
+    StatsStorage storage = GetMemoryStorage(&memory);
+
+    Check(!OpenStatsStorage(&store, &storage) && !store.badFormat, "failed write");
+    free(memory.bytes);
+}
+
+int
+main(void)
+{
+    TestHistory();
+    TestBadFormat();
+    TestFailedWrite();
+
+    printf("%s\n", failures == 0 ? "ok" : "FAILED");
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
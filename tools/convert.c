@@ -0,0 +1,211 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "mbf.h"
+#include "rawvf.h"
+#include "replayer.h"
+#include "tools.h"
+
+#define CONVERT_CHUNK_SIZE 65536
+
+typedef enum
+{
+    FORMAT_UNKNOWN,
+    FORMAT_REPLAY,
+    FORMAT_MBF,
+    FORMAT_RAWVF
+} FileFormat;
+
+typedef struct
+{
+    Minefield field;
+    ReplayLog log;
+    RawvfParser parser;
+    bool hasLog;
+} ConvertState;
+
+static FileFormat
+GetFileFormat(_In_z_ const char* path)
+{
+    const char* extension = strrchr(path, '.');
+
+    if (extension == NULL)
+        return FORMAT_UNKNOWN;
+
+    if (_stricmp(extension, ".msr") == 0)
+        return FORMAT_REPLAY;
+
+    if (_stricmp(extension, ".mbf") == 0)
+        return FORMAT_MBF;
+
+    if (_stricmp(extension, ".rawvf") == 0 || _stricmp(extension, ".txt") == 0)
+        return FORMAT_RAWVF;
+
+    return FORMAT_UNKNOWN;
+}
+
+static bool
+LoadReplay(_Inout_ ConvertState* state, _In_z_ const char* path)
+{
+    uint8_t* bytes = HeapAlloc(GetProcessHeap(), 0, REPLAY_FILE_MAX_SIZE);
+    ReplayOutcome outcome;
+    ReplayCheck check;
+    uint32_t size;
+
+    if (bytes == NULL || !ReadReplayFileBytes(path, bytes, &size) ||
+        !DecodeReplayFile(bytes, size, &outcome, &state->log))
+    {
+        HeapFree(GetProcessHeap(), 0, bytes);
+        return false;
+    }
+
+    HeapFree(GetProcessHeap(), 0, bytes);
+    VerifyReplay(&state->field, &outcome, &state->log, &check);
+
+    if (check.verdict != REPLAY_VERIFIED)
+    {
+        fprintf(stderr, "%s does not replay: %s\n", path, GetReplayVerdictName(check.verdict));
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    state->hasLog = true;
+
+    return true;
+}
+
+static bool
+LoadMbf(_Inout_ ConvertState* state, _In_z_ const char* path)
+{
+    uint8_t* bytes = HeapAlloc(GetProcessHeap(), 0, MBF_MAX_SIZE + 1);
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    DWORD read = 0;
+    bool success = bytes != NULL && hFile != INVALID_HANDLE_VALUE &&
+                   ReadFile(hFile, bytes, MBF_MAX_SIZE + 1, &read, NULL) &&
+                   LoadMbfBoard(&state->field, bytes, read);
+
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+
+    HeapFree(GetProcessHeap(), 0, bytes);
+
+    return success;
+}
+
+// The video is fed to the parser a chunk at a time, so its size is not bounded by a buffer.
+static bool
+LoadRawvf(_Inout_ ConvertState* state, _In_z_ const char* path)
+{
+    char* chunk = HeapAlloc(GetProcessHeap(), 0, CONVERT_CHUNK_SIZE);
+    HANDLE hFile =
+        CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    bool success = chunk != NULL && hFile != INVALID_HANDLE_VALUE;
+    DWORD read = 0;
+
+    BeginRawvfParse(&state->parser, &state->field);
+
+    while (success && ReadFile(hFile, chunk, CONVERT_CHUNK_SIZE, &read, NULL) && read > 0)
+        success = ParseRawvfChunk(&state->parser, chunk, read);
+
+    success = success && EndRawvfParse(&state->parser);
+
+    if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+
+    HeapFree(GetProcessHeap(), 0, chunk);
+
+    if (!success && state->parser.failed)
+        fprintf(stderr, "%s: invalid RAWVF at line %u\n", path, state->parser.line);
+
+    return success;
+}
+
+static bool
+WriteOutputFile(_In_z_ const char* path, _In_reads_bytes_(size) const void* bytes, _In_ uint32_t size)
+{
+    HANDLE hFile = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    DWORD written = 0;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool success = WriteFile(hFile, bytes, size, &written, NULL) && written == size;
+
+    CloseHandle(hFile);
+
+    return success;
+}
+
+int
+RunConvertCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: mstool convert <input.msr|.mbf|.rawvf> <output.mbf|.rawvf>\n");
+        return 1;
+    }
+
+    FileFormat input = GetFileFormat(argv[0]);
+    FileFormat output = GetFileFormat(argv[1]);
+
+    if (input == FORMAT_UNKNOWN || (output != FORMAT_MBF && output != FORMAT_RAWVF))
+    {
+        fprintf(stderr, "Cannot convert %s to %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    ConvertState* state = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(ConvertState));
+    uint8_t* buffer = HeapAlloc(hHeap, 0, max(MBF_MAX_SIZE, RAWVF_MAX_SIZE));
+
+    if (state == NULL || buffer == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        HeapFree(hHeap, 0, buffer);
+        HeapFree(hHeap, 0, state);
+        return 1;
+    }
+
+    bool loaded = input == FORMAT_REPLAY ? LoadReplay(state, argv[0])
+                  : input == FORMAT_MBF  ? LoadMbf(state, argv[0])
+                                         : LoadRawvf(state, argv[0]);
+    uint32_t size = 0;
+
+    if (!loaded)
+    {
+        fprintf(stderr, "Cannot read %s (error %lu)\n", argv[0], GetLastError());
+    }
+    else
+    {
+        size = output == FORMAT_MBF ? SaveMbfBoard(&state->field, buffer)
+                                    : ExportRawvf(&state->field, state->hasLog ? &state->log : NULL, (char*)buffer);
+
+        if (size == 0 || !WriteOutputFile(argv[1], buffer, size))
+        {
+            fprintf(stderr, "Cannot write %s (error %lu)\n", argv[1], GetLastError());
+            size = 0;
+        }
+    }
+
+    if (size > 0)
+    {
+        printf("%s -> %s: %ux%u, %u mines, %u bytes",
+               argv[0],
+               argv[1],
+               state->field.width,
+               state->field.height,
+               state->field.totalMines,
+               size);
+
+        if (input == FORMAT_RAWVF)
+            printf(", %u events, %u applied", state->parser.events, state->parser.actions);
+
+        printf("\n");
+    }
+
+    HeapFree(hHeap, 0, buffer);
+    HeapFree(hHeap, 0, state);
+
+    return size > 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "corpus.h"
+#include "corpusstats.h"
+#include "tools.h"
+
+typedef struct
+{
+    CorpusWriter writer;
+    uint8_t* scratch;
+    uint64_t packed;
+    uint64_t skipped;
+} PackRun;
+
+static bool
+PackReplayFile(_Inout_opt_ void* context, _In_z_ const char* path)
+{
+    PackRun* run = (PackRun*)context;
+    ReplayOutcome outcome;
+    ReplayFileView view;
+    uint32_t size;
+
+    if (!ReadReplayFileBytes(path, run->scratch, &size) || !ViewReplayFile(run->scratch, size, &outcome, &view))
+    {
+        fprintf(stderr, "Skipping %s (error %lu)\n", path, GetLastError());
+        run->skipped++;
+        return true;
+    }
+
+    if (!AppendCorpusReplay(&run->writer, run->scratch, size))
+    {
+        fprintf(stderr, "Cannot write the corpus (error %lu)\n", GetLastError());
+        return false;
+    }
+
+    run->packed++;
+
+    return true;
+}
+
+int
+RunPackCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    PackRun run = {0};
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: mstool pack <corpus> <file|directory>...\n");
+        return 1;
+    }
+
+    run.scratch = HeapAlloc(GetProcessHeap(), 0, REPLAY_FILE_MAX_SIZE);
+
+    if (run.scratch == NULL || !CreateCorpusWriter(&run.writer, argv[0]))
+    {
+        fprintf(stderr, "Cannot create %s (error %lu)\n", argv[0], GetLastError());
+        HeapFree(GetProcessHeap(), 0, run.scratch);
+        return 1;
+    }
+
+    bool success = true;
+
+    for (int i = 1; i < argc && success; i++)
+        success = VisitReplayFiles(argv[i], PackReplayFile, &run);
+
+    uint64_t bytes = run.writer.offset;
+
+    success = CloseCorpusWriter(&run.writer) && success;
+    HeapFree(GetProcessHeap(), 0, run.scratch);
+
+    if (!success)
+    {
+        fprintf(stderr, "Packing %s failed\n", argv[0]);
+        return 1;
+    }
+
+    printf("Packed %llu replays into %s, %.1f MB, %llu skipped\n",
+           (unsigned long long)run.packed,
+           argv[0],
+           (double)bytes / (1024.0 * 1024.0),
+           (unsigned long long)run.skipped);
+
+    return 0;
+}
+
+static void
+PrintDifficultyStats(_In_ Difficulty difficulty, _In_ const DifficultyStats* stats)
+{
+    double wins = (double)max(stats->wins, 1);
+
+    printf("%-13s %10llu %10llu %7.2f%% %8.1f %7.3f %9.3f %9.3f %10.3f %7.1f %7.1f %7.1f %7.1f\n",
+           GetDifficultyName(difficulty),
+           (unsigned long long)stats->games,
+           (unsigned long long)stats->wins,
+           stats->wins * 100.0 / (double)stats->games,
+           (double)stats->bbbv / wins,
+           stats->bbbvPerSecond / (double)max(stats->timedWins, 1),
+           GetQuantileSketchValue(&stats->bbbvRates, 0.5),
+           GetQuantileSketchValue(&stats->bbbvRates, 0.9),
+           stats->efficiency / wins,
+           GetQuantileSketchValue(&stats->times, 0.1),
+           GetQuantileSketchValue(&stats->times, 0.5),
+           GetQuantileSketchValue(&stats->times, 0.9),
+           GetQuantileSketchValue(&stats->times, 0.99));
+}
+
+int
+RunAnalyzeCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    const char* path = NULL;
+    uint32_t threads = 0;
+
+    for (int i = 0; i < argc; i++)
+    {
+        uint64_t number = 0;
+
+        if (strcmp(argv[i], "--threads") == 0)
+        {
+            const char* value = i + 1 < argc ? argv[i + 1] : "";
+
+            if (!ParseUnsigned(value, &number) || number > UINT32_MAX)
+            {
+                fprintf(stderr, "Invalid value for %s: %s\n", argv[i], value);
+                return 1;
+            }
+
+            threads = (uint32_t)number;
+            i++;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0 || path != NULL)
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    if (path == NULL)
+    {
+        fprintf(stderr, "Usage: mstool analyze [--threads T] <corpus>\n");
+        return 1;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    CorpusStats* stats = HeapAlloc(hHeap, 0, sizeof(CorpusStats));
+    ReplayCorpus corpus;
+
+    if (stats == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    if (!OpenReplayCorpus(&corpus, path))
+    {
+        fprintf(stderr, "Cannot open %s (error %lu)\n", path, GetLastError());
+        HeapFree(hHeap, 0, stats);
+        return 1;
+    }
+
+    if (!AnalyzeReplayCorpus(&corpus, threads, stats))
+    {
+        fprintf(stderr, "Analysis failed (error %lu)\n", GetLastError());
+        CloseReplayCorpus(&corpus);
+        HeapFree(hHeap, 0, stats);
+        return 1;
+    }
+
+    printf("%-13s %10s %10s %8s %8s %7s %9s %9s %10s %7s %7s %7s %7s\n",
+           "difficulty",
+           "games",
+           "wins",
+           "win rate",
+           "3BV",
+           "3BV/s",
+           "p50 3BV/s",
+           "p90 3BV/s",
+           "efficiency",
+           "p10 s",
+           "p50 s",
+           "p90 s",
+           "p99 s");
+
+    for (Difficulty d = DIFFICULTY_BEGINNER; d <= DIFFICULTY_CUSTOM; d++)
+    {
+        if (stats->difficulties[d].games > 0)
+            PrintDifficultyStats(d, &stats->difficulties[d]);
+    }
+
+    printf("\n%llu replays, %llu invalid, %.1f MB mapped, %u threads: %.0f replays/s\n",
+           (unsigned long long)stats->replays,
+           (unsigned long long)stats->invalid,
+           (double)corpus.size / (1024.0 * 1024.0),
+           stats->threads,
+           (double)stats->replays / stats->seconds);
+    printf("3BV, efficiency (3BV per click) and times cover won games; times are in seconds.\n");
+    printf("Quantiles come from sketches merged across threads and are within 2%% of a recorded value.\n");
+
+    CloseReplayCorpus(&corpus);
+    HeapFree(hHeap, 0, stats);
+
+    return 0;
+}
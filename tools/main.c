@@ -0,0 +1,170 @@
+#include "pch.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools.h"
+
+static const Command commands[] = {
+    {"simulate",
+     "simulate [--games N] [--seed S] [--threads T] [--difficulty D|all] [--strategy S|all]",
+     "Play seeded games headlessly with bot strategies and report win rates",
+     RunSimulateCommand},
+    {"metrics",
+     "metrics [--boards N] [--seed S] [--threads T] [--difficulty D]",
+     "Score seeded boards by 3BV and ZiNi and report their distribution",
+     RunMetricsCommand},
+    {"replay",
+     "replay [--threads T] [--repeat N] <file|directory>...",
+     "Replay recorded games headlessly and report any that diverge",
+     RunReplayCommand},
+    {"pack",
+     "pack <corpus> <file|directory>...",
+     "Pack replay files into one indexed corpus file",
+     RunPackCommand},
+    {"analyze",
+     "analyze [--threads T] <corpus>",
+     "Map a replay corpus and report win rate, 3BV/s, efficiency and times by difficulty",
+     RunAnalyzeCommand},
+    {"convert",
+     "convert <input.msr|.mbf|.rawvf> <output.mbf|.rawvf>",
+     "Convert replays and boards to MBF boards and RAWVF videos, or load boards from them",
+     RunConvertCommand},
+    {"stats",
+     "stats [--import <corpus>] [--rebuild] <store>",
+     "Show the statistics in a store, adding the finished games of a replay corpus first",
+     RunStatsCommand},
+};
+
+static const char* const difficultyNames[] = {"beginner", "intermediate", "expert", "custom"};
+
+bool
+ParseUnsigned(_In_z_ const char* text, _Out_ uint64_t* value)
+{
+    char* end = NULL;
+
+    errno = 0;
+    *value = strtoull(text, &end, 0);
+
+    return text[0] != '\0' && text[0] != '-' && *end == '\0' && errno == 0;
+}
+
+bool
+ParseDifficulty(_In_z_ const char* text, _Out_ Difficulty* difficulty)
+{
+    for (size_t i = 0; i < ARRAYSIZE(difficultyNames); i++)
+    {
+        if (strcmp(text, difficultyNames[i]) == 0)
+        {
+            *difficulty = (Difficulty)i;
+            return true;
+        }
+    }
+
+    *difficulty = DIFFICULTY_BEGINNER;
+    return false;
+}
+
+_Ret_z_ const char*
+GetDifficultyName(_In_ Difficulty difficulty)
+{
+    return (size_t)difficulty < ARRAYSIZE(difficultyNames) ? difficultyNames[difficulty] : "unknown";
+}
+
+bool
+VisitReplayFiles(_In_z_ const char* path, _In_ ReplayFileVisitor visit, _Inout_opt_ void* context)
+{
+    DWORD attributes = GetFileAttributesA(path);
+
+    if (attributes == INVALID_FILE_ATTRIBUTES || (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+        return visit(context, path);
+
+    char pattern[MAX_PATH];
+    WIN32_FIND_DATAA data;
+
+    snprintf(pattern, sizeof(pattern), "%s\\%s", path, REPLAY_FILE_PATTERN);
+
+    HANDLE hFind = FindFirstFileA(pattern, &data);
+
+    if (hFind == INVALID_HANDLE_VALUE)
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+    bool success = true;
+
+    do
+    {
+        char file[MAX_PATH];
+
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+            continue;
+
+        snprintf(file, sizeof(file), "%s\\%s", path, data.cFileName);
+        success = visit(context, file);
+    } while (success && FindNextFileA(hFind, &data));
+
+    FindClose(hFind);
+
+    return success;
+}
+
+bool
+ReadReplayFileBytes(
+    _In_z_ const char* path,
+    _Out_writes_bytes_to_(REPLAY_FILE_MAX_SIZE, *size) uint8_t* bytes,
+    _Out_ uint32_t* size)
+{
+    HANDLE hFile =
+        CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER fileSize;
+    DWORD read = 0;
+
+    *size = 0;
+
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart > REPLAY_FILE_MAX_SIZE)
+    {
+        CloseHandle(hFile);
+        SetLastError(ERROR_BAD_FORMAT);
+        return false;
+    }
+
+    bool success = ReadFile(hFile, bytes, (DWORD)fileSize.QuadPart, &read, NULL) && read == fileSize.QuadPart;
+
+    CloseHandle(hFile);
+    *size = read;
+
+    return success;
+}
+
+static void
+PrintUsage(void)
+{
+    printf("Usage: mstool <command> [options]\n\nCommands:\n");
+
+    for (size_t i = 0; i < ARRAYSIZE(commands); i++)
+        printf("  %-12s %s\n  %-12s mstool %s\n", commands[i].name, commands[i].description, "", commands[i].usage);
+}
+
+int
+main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    for (size_t i = 0; i < ARRAYSIZE(commands); i++)
+    {
+        if (strcmp(argv[1], commands[i].name) == 0)
+            return commands[i].run(argc - 2, argv + 2);
+    }
+
+    fprintf(stderr, "Unknown command: %s\n\n", argv[1]);
+    PrintUsage();
+
+    return 1;
+}
@@ -0,0 +1,214 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "metrics.h"
+#include "parallel.h"
+#include "random.h"
+#include "tools.h"
+
+#define METRICS_BATCH_BOARDS 256
+#define METRICS_HISTOGRAM_SIZE (MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY + 1)
+
+typedef struct
+{
+    uint64_t seed;
+    uint64_t boards;
+    Difficulty difficulty;
+    volatile LONG64 nextBoard;
+    uint64_t* bbbvHistograms;
+    uint64_t* ziniHistograms;
+} MetricsRun;
+
+static void
+ScoreBoards(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    MetricsRun* run = (MetricsRun*)context;
+    HANDLE hHeap = GetProcessHeap();
+    uint64_t* bbbvHistogram = run->bbbvHistograms + (size_t)index * METRICS_HISTOGRAM_SIZE;
+    uint64_t* ziniHistogram = run->ziniHistograms + (size_t)index * METRICS_HISTOGRAM_SIZE;
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    bool* mines = HeapAlloc(hHeap, 0, sizeof(bool) * MAX_CELLS_HORIZONTALLY * MAX_CELLS_VERTICALLY);
+    MetricsWorkspace workspace;
+
+    if (field != NULL && mines != NULL &&
+        CreateMetricsWorkspace(&workspace, MAX_CELLS_HORIZONTALLY, MAX_CELLS_VERTICALLY))
+    {
+        for (;;)
+        {
+            uint64_t first = (uint64_t)InterlockedExchangeAdd64(&run->nextBoard, METRICS_BATCH_BOARDS);
+
+            if (first >= run->boards)
+                break;
+
+            uint64_t last = min(first + METRICS_BATCH_BOARDS, run->boards);
+
+            for (uint64_t board = first; board < last; board++)
+            {
+                BoardMetrics metrics;
+
+                // Seeded the same way as the simulator, so board n here is board n there.
+                CreateMinefield(field, run->difficulty);
+                field->seed = mix64(run->seed + mix64((uint64_t)run->difficulty << 56 | board));
+                RevealCell(field, field->width / 2, field->height / 2);
+
+                for (uint32_t i = 0; i < field->width * field->height; i++)
+                    mines[i] = field->cells[i].hasMine;
+
+                ComputeBoardMetrics(&workspace, field->width, field->height, mines, true, &metrics);
+                bbbvHistogram[metrics.bbbv]++;
+                ziniHistogram[metrics.zini]++;
+            }
+        }
+
+        DestroyMetricsWorkspace(&workspace);
+    }
+
+    HeapFree(hHeap, 0, field);
+    HeapFree(hHeap, 0, mines);
+}
+
+static void
+PrintDistribution(_In_z_ const char* name, _In_reads_(METRICS_HISTOGRAM_SIZE) const uint64_t* histogram)
+{
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint32_t minimum = UINT32_MAX;
+    uint32_t maximum = 0;
+
+    for (uint32_t value = 0; value < METRICS_HISTOGRAM_SIZE; value++)
+    {
+        if (histogram[value] == 0)
+            continue;
+
+        total += histogram[value];
+        sum += histogram[value] * value;
+        minimum = min(minimum, value);
+        maximum = max(maximum, value);
+    }
+
+    const double quantiles[] = {0.1, 0.5, 0.9, 0.99};
+    uint32_t values[ARRAYSIZE(quantiles)] = {0};
+    uint64_t seen = 0;
+    size_t next = 0;
+
+    for (uint32_t value = 0; value < METRICS_HISTOGRAM_SIZE && next < ARRAYSIZE(quantiles); value++)
+    {
+        seen += histogram[value];
+
+        while (next < ARRAYSIZE(quantiles) && (double)seen >= quantiles[next] * (double)total)
+            values[next++] = value;
+    }
+
+    printf("%-5s mean %8.2f  min %5u  p10 %5u  p50 %5u  p90 %5u  p99 %5u  max %5u\n",
+           name,
+           (double)sum / (double)total,
+           minimum,
+           values[0],
+           values[1],
+           values[2],
+           values[3],
+           maximum);
+}
+
+int
+RunMetricsCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    MetricsRun run = {
+        .seed = 1,
+        .boards = 100000,
+        .difficulty = DIFFICULTY_EXPERT,
+    };
+
+    uint32_t threads = 0;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        uint64_t number = 0;
+        bool valid = true;
+
+        if (strcmp(argv[i], "--boards") == 0)
+        {
+            valid = ParseUnsigned(value, &run.boards) && run.boards > 0;
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            valid = ParseUnsigned(value, &run.seed);
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            valid = ParseUnsigned(value, &number) && number <= UINT32_MAX;
+            threads = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--difficulty") == 0)
+        {
+            valid = ParseDifficulty(value, &run.difficulty) && run.difficulty != DIFFICULTY_CUSTOM;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid value for %s: %s\n", argv[i], value);
+            return 1;
+        }
+
+        i++;
+    }
+
+    if (threads == 0)
+        threads = GetParallelThreadCount();
+
+    threads = min(threads, (uint32_t)PARALLEL_MAX_THREADS);
+
+    HANDLE hHeap = GetProcessHeap();
+    SIZE_T histogramBytes = sizeof(uint64_t) * METRICS_HISTOGRAM_SIZE * threads;
+
+    run.bbbvHistograms = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, histogramBytes);
+    run.ziniHistograms = HeapAlloc(hHeap, HEAP_ZERO_MEMORY, histogramBytes);
+
+    if (run.bbbvHistograms == NULL || run.ziniHistograms == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        HeapFree(hHeap, 0, run.bbbvHistograms);
+        HeapFree(hHeap, 0, run.ziniHistograms);
+        return 1;
+    }
+
+    LARGE_INTEGER frequency, start, end;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    ParallelFor(threads, threads, ScoreBoards, &run);
+    QueryPerformanceCounter(&end);
+
+    double seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+
+    for (uint32_t t = 1; t < threads; t++)
+    {
+        for (uint32_t value = 0; value < METRICS_HISTOGRAM_SIZE; value++)
+        {
+            run.bbbvHistograms[value] += run.bbbvHistograms[(size_t)t * METRICS_HISTOGRAM_SIZE + value];
+            run.ziniHistograms[value] += run.ziniHistograms[(size_t)t * METRICS_HISTOGRAM_SIZE + value];
+        }
+    }
+
+    printf("%s, %llu boards, seed %llu, %u threads: %.0f boards/min including generation\n",
+           GetDifficultyName(run.difficulty),
+           (unsigned long long)run.boards,
+           (unsigned long long)run.seed,
+           threads,
+           (double)run.boards * 60.0 / seconds);
+
+    PrintDistribution("3BV", run.bbbvHistograms);
+    PrintDistribution("ZiNi", run.ziniHistograms);
+
+    HeapFree(hHeap, 0, run.bbbvHistograms);
+    HeapFree(hHeap, 0, run.ziniHistograms);
+
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "parallel.h"
+#include "replayer.h"
+#include "tools.h"
+
+#define REPLAY_INITIAL_ENTRIES 64
+
+typedef struct
+{
+    char path[MAX_PATH];
+    uint8_t* bytes;
+    uint32_t size;
+    bool decoded;
+    ReplayOutcome recorded;
+    ReplayCheck check;
+} ReplayEntry;
+
+typedef struct
+{
+    ReplayEntry* entries;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t repeat;
+    uint8_t* scratch;
+    volatile LONG64 nextReplay;
+    volatile LONG64 events;
+} ReplayRun;
+
+static bool
+AddReplayFile(_Inout_opt_ void* context, _In_z_ const char* path)
+{
+    ReplayRun* run = (ReplayRun*)context;
+    HANDLE hHeap = GetProcessHeap();
+
+    if (run->count == run->capacity)
+    {
+        uint32_t capacity = run->capacity == 0 ? REPLAY_INITIAL_ENTRIES : run->capacity * 2;
+        ReplayEntry* entries = run->entries == NULL
+                                   ? HeapAlloc(hHeap, 0, sizeof(ReplayEntry) * capacity)
+                                   : HeapReAlloc(hHeap, 0, run->entries, sizeof(ReplayEntry) * capacity);
+
+        if (entries == NULL)
+        {
+            fprintf(stderr, "Out of memory\n");
+            return false;
+        }
+
+        run->entries = entries;
+        run->capacity = capacity;
+    }
+
+    ReplayEntry* entry = &run->entries[run->count];
+
+    ZeroMemory(entry, sizeof(ReplayEntry));
+    snprintf(entry->path, sizeof(entry->path), "%s", path);
+
+    if (!ReadReplayFileBytes(path, run->scratch, &entry->size))
+    {
+        fprintf(stderr, "Cannot read %s (error %lu)\n", path, GetLastError());
+        return false;
+    }
+
+    entry->bytes = HeapAlloc(hHeap, 0, max(entry->size, 1));
+
+    if (entry->bytes == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    CopyMemory(entry->bytes, run->scratch, entry->size);
+    run->count++;
+
+    return true;
+}
+
+static void
+ReplayWorker(_Inout_opt_ void* context, _In_ uint32_t index)
+{
+    ReplayRun* run = (ReplayRun*)context;
+    HANDLE hHeap = GetProcessHeap();
+    Minefield* field = HeapAlloc(hHeap, 0, sizeof(Minefield));
+    ReplayLog* log = HeapAlloc(hHeap, 0, sizeof(ReplayLog));
+    uint64_t total = run->count * run->repeat;
+    LONG64 events = 0;
+
+    UNREFERENCED_PARAMETER(index);
+
+    if (field != NULL && log != NULL)
+    {
+        for (;;)
+        {
+            uint64_t replay = (uint64_t)InterlockedIncrement64(&run->nextReplay) - 1;
+
+            if (replay >= total)
+                break;
+
+            ReplayEntry* entry = &run->entries[replay % run->count];
+            ReplayOutcome recorded;
+            ReplayCheck check;
+
+            if (!DecodeReplayFile(entry->bytes, entry->size, &recorded, log))
+                continue;
+
+            VerifyReplay(field, &recorded, log, &check);
+            events += check.events;
+
+            // Repeated rounds give the same result, so only the first one stores it.
+            if (replay < run->count)
+            {
+                entry->decoded = true;
+                entry->recorded = recorded;
+                entry->check = check;
+            }
+        }
+    }
+
+    InterlockedExchangeAdd64(&run->events, events);
+
+    HeapFree(hHeap, 0, field);
+    HeapFree(hHeap, 0, log);
+}
+
+static void
+PrintDivergence(_In_ const ReplayEntry* entry)
+{
+    const ReplayOutcome* recorded = &entry->recorded;
+    const ReplayOutcome* replayed = &entry->check.outcome;
+
+    if (!entry->decoded)
+    {
+        printf("%s: not a replay file\n", entry->path);
+        return;
+    }
+
+    printf("%s: %s", entry->path, GetReplayVerdictName(entry->check.verdict));
+
+    if (entry->check.verdict == REPLAY_REJECTED)
+        printf(" at event %u", entry->check.rejectedEvent);
+
+    printf("\n  recorded state %d, %u revealed, %u flagged, %llu ms, hash %016llx\n",
+           (int)recorded->state,
+           recorded->revealedCells,
+           recorded->flaggedCells,
+           (unsigned long long)recorded->duration,
+           (unsigned long long)recorded->hash);
+    printf("  replayed state %d, %u revealed, %u flagged, %llu ms, hash %016llx, %u events\n",
+           (int)replayed->state,
+           replayed->revealedCells,
+           replayed->flaggedCells,
+           (unsigned long long)replayed->duration,
+           (unsigned long long)replayed->hash,
+           entry->check.events);
+}
+
+int
+RunReplayCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    ReplayRun run = {
+        .repeat = 1,
+    };
+
+    uint32_t threads = 1;
+    int status = 0;
+
+    run.scratch = HeapAlloc(GetProcessHeap(), 0, REPLAY_FILE_MAX_SIZE);
+
+    if (run.scratch == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 0; i < argc && status == 0; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        uint64_t number = 0;
+        bool valid = true;
+
+        if (strcmp(argv[i], "--threads") == 0)
+        {
+            valid = ParseUnsigned(value, &number) && number <= UINT32_MAX;
+            threads = (uint32_t)number;
+            i++;
+        }
+        else if (strcmp(argv[i], "--repeat") == 0)
+        {
+            valid = ParseUnsigned(value, &run.repeat) && run.repeat > 0 && run.repeat <= UINT32_MAX;
+            i++;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0)
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            status = 1;
+            continue;
+        }
+        else
+        {
+            status = VisitReplayFiles(argv[i], AddReplayFile, &run) ? 0 : 1;
+            continue;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid value for %s: %s\n", argv[i - 1], value);
+            status = 1;
+        }
+    }
+
+    if (status == 0 && run.count == 0)
+    {
+        fprintf(stderr, "No replay files given\n");
+        status = 1;
+    }
+
+    if (status == 0)
+    {
+        if (threads == 0)
+            threads = GetParallelThreadCount();
+
+        threads = min(threads, (uint32_t)PARALLEL_MAX_THREADS);
+
+        LARGE_INTEGER frequency, start, end;
+
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&start);
+        ParallelFor(threads, threads, ReplayWorker, &run);
+        QueryPerformanceCounter(&end);
+
+        double seconds = (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+        uint32_t verified = 0;
+
+        for (uint32_t i = 0; i < run.count; i++)
+        {
+            if (run.entries[i].decoded && run.entries[i].check.verdict == REPLAY_VERIFIED)
+                verified++;
+            else
+                PrintDivergence(&run.entries[i]);
+        }
+
+        printf("%u of %u replays verified, %llu rounds, %u threads: %.0f replays/s, %.2f M events/s\n",
+               verified,
+               run.count,
+               (unsigned long long)run.repeat,
+               threads,
+               (double)run.count * (double)run.repeat / seconds,
+               (double)run.events / seconds / 1e6);
+
+        status = verified == run.count ? 0 : 1;
+    }
+
+    for (uint32_t i = 0; i < run.count; i++)
+        HeapFree(GetProcessHeap(), 0, run.entries[i].bytes);
+
+    HeapFree(GetProcessHeap(), 0, run.entries);
+    HeapFree(GetProcessHeap(), 0, run.scratch);
+
+    return status;
+}
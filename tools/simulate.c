@@ -0,0 +1,147 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "simulator.h"
+#include "tools.h"
+
+static bool
+ParseStrategy(_In_z_ const char* text, _Out_ BotStrategy* strategy)
+{
+    for (BotStrategy s = STRATEGY_RANDOM; s <= STRATEGY_RULES; s++)
+    {
+        if (strcmp(text, GetBotStrategyName(s)) == 0)
+        {
+            *strategy = s;
+            return true;
+        }
+    }
+
+    *strategy = STRATEGY_RANDOM;
+    return false;
+}
+
+static void
+PrintSimulation(_In_ const SimulationOptions* options, _In_ const SimulationResult* result)
+{
+    double games = (double)result->games;
+
+    printf("%-13s %-12s %9llu %7.3f%% [%7.3f%%, %7.3f%%] %10.0f %9.3f %9.3f %9.3f %9.3f %9.3f %7.2f\n",
+           GetDifficultyName(options->difficulty),
+           GetBotStrategyName(options->strategy),
+           (unsigned long long)result->games,
+           result->winRate * 100.0,
+           result->confidenceLow * 100.0,
+           result->confidenceHigh * 100.0,
+           games / result->seconds,
+           result->generateSeconds * 1e3 / games,
+           result->solveSeconds * 1e3 / games,
+           result->moveSeconds * 1e3 / games,
+           GetQuantileSketchValue(&result->gameSeconds, 0.5) * 1e3,
+           GetQuantileSketchValue(&result->gameSeconds, 0.99) * 1e3,
+           (double)result->guesses / games);
+}
+
+int
+RunSimulateCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    SimulationOptions options = {
+        .seed = 1,
+        .games = SIMULATOR_DEFAULT_GAMES,
+        .threads = 0,
+    };
+
+    Difficulty firstDifficulty = DIFFICULTY_BEGINNER;
+    Difficulty lastDifficulty = DIFFICULTY_EXPERT;
+    BotStrategy firstStrategy = STRATEGY_RANDOM;
+    BotStrategy lastStrategy = STRATEGY_RULES;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : "";
+        uint64_t number = 0;
+        bool valid = true;
+
+        if (strcmp(argv[i], "--games") == 0)
+        {
+            valid = ParseUnsigned(value, &options.games) && options.games > 0;
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            valid = ParseUnsigned(value, &options.seed);
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            valid = ParseUnsigned(value, &number) && number <= UINT32_MAX;
+            options.threads = (uint32_t)number;
+        }
+        else if (strcmp(argv[i], "--difficulty") == 0)
+        {
+            if (strcmp(value, "all") != 0)
+            {
+                valid = ParseDifficulty(value, &firstDifficulty) && firstDifficulty != DIFFICULTY_CUSTOM;
+                lastDifficulty = firstDifficulty;
+            }
+        }
+        else if (strcmp(argv[i], "--strategy") == 0)
+        {
+            if (strcmp(value, "all") != 0)
+            {
+                valid = ParseStrategy(value, &firstStrategy);
+                lastStrategy = firstStrategy;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Invalid value for %s: %s\n", argv[i], value);
+            return 1;
+        }
+
+        i++;
+    }
+
+    printf("%-13s %-12s %9s %8s %20s %10s %9s %9s %9s %9s %9s %7s\n",
+           "difficulty",
+           "strategy",
+           "games",
+           "wins",
+           "95% interval",
+           "games/s",
+           "gen ms",
+           "solve ms",
+           "move ms",
+           "p50 ms",
+           "p99 ms",
+           "guesses");
+
+    for (Difficulty d = firstDifficulty; d <= lastDifficulty; d++)
+    {
+        for (BotStrategy s = firstStrategy; s <= lastStrategy; s++)
+        {
+            SimulationResult result;
+
+            options.difficulty = d;
+            options.strategy = s;
+
+            if (!RunSimulation(&options, &result))
+            {
+                fprintf(stderr, "Simulation failed (error %lu)\n", GetLastError());
+                return 1;
+            }
+
+            PrintSimulation(&options, &result);
+        }
+    }
+
+    printf("\nPhase timings are per game, summed across worker threads; p50 and p99 are the times of whole games.\n");
+    printf("Seed %llu.\n",
+           (unsigned long long)options.seed);
+
+    return 0;
+}
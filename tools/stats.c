@@ -0,0 +1,212 @@
+#include "pch.h"
+
+#include <string.h>
+
+#include "corpus.h"
+#include "replayer.h"
+#include "statsfile.h"
+#include "tools.h"
+
+typedef struct
+{
+    StatsStore store;
+    StatsAggregates rebuilt;
+    Minefield field;
+    ReplayLog log;
+} StatsRun;
+
+static double
+GetElapsedSeconds(_In_ LARGE_INTEGER start)
+{
+    LARGE_INTEGER frequency, end;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&end);
+
+    return (double)(end.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+}
+
+// Appends a record for every finished game in the corpus that replays to its recorded outcome, with the recorded
+// time rather than the replayed one.
+static bool
+ImportReplayCorpus(_Inout_ StatsRun* run, _In_z_ const char* path, _Out_ uint64_t* imported)
+{
+    ReplayCorpus corpus;
+
+    *imported = 0;
+
+    if (!OpenReplayCorpus(&corpus, path))
+    {
+        fprintf(stderr, "Cannot open %s (error %lu)\n", path, GetLastError());
+        return false;
+    }
+
+    bool success = true;
+
+    for (uint64_t i = 0; i < corpus.count && success; i++)
+    {
+        const uint8_t* bytes;
+        uint32_t size;
+        ReplayOutcome outcome;
+        ReplayCheck check;
+        GameRecord record;
+
+        if (!GetCorpusReplay(&corpus, i, &bytes, &size) || !DecodeReplayFile(bytes, size, &outcome, &run->log) ||
+            outcome.state == GAME_PLAYING)
+        {
+            continue;
+        }
+
+        VerifyReplay(&run->field, &outcome, &run->log, &check);
+
+        if (check.verdict != REPLAY_VERIFIED || !GetFinishedGameRecord(&run->field, &record))
+            continue;
+
+        record.duration = (uint32_t)min(outcome.duration, (uint64_t)UINT32_MAX);
+        success = AppendGameRecord(&run->store, &record);
+        *imported += success ? 1 : 0;
+    }
+
+    if (!success)
+        fprintf(stderr, "Cannot write the store (error %lu)\n", GetLastError());
+
+    CloseReplayCorpus(&corpus);
+
+    return success;
+}
+
+static void
+PrintDifficultyAggregate(_In_ Difficulty difficulty, _In_ const DifficultyAggregate* aggregate)
+{
+    printf("%-13s %10llu %10llu %7.2f%% %8.3f %7.1f %7.1f %7.1f %9.2f %7u %7u %7u\n",
+           GetDifficultyName(difficulty),
+           (unsigned long long)aggregate->games,
+           (unsigned long long)aggregate->wins,
+           aggregate->wins * 100.0 / (double)aggregate->games,
+           aggregate->bestCount == 0 ? 0.0 : aggregate->best[0].duration / 1000.0,
+           GetQuantileSketchValue(&aggregate->times, 0.1),
+           GetQuantileSketchValue(&aggregate->times, 0.5),
+           GetQuantileSketchValue(&aggregate->times, 0.9),
+           GetQuantileSketchValue(&aggregate->bbbvRates, 0.5),
+           aggregate->winStreak,
+           aggregate->longestWinStreak,
+           aggregate->longestLossStreak);
+}
+
+int
+RunStatsCommand(_In_ int argc, _In_reads_(argc) char** argv)
+{
+    const char* importPath = NULL;
+    const char* path = NULL;
+    bool rebuild = false;
+
+    for (int i = 0; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--import") == 0 && i + 1 < argc)
+        {
+            importPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rebuild") == 0)
+        {
+            rebuild = true;
+        }
+        else if (strncmp(argv[i], "--", 2) == 0 || path != NULL)
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+
+    wchar_t widePath[MAX_PATH];
+
+    if (path == NULL || MultiByteToWideChar(CP_ACP, 0, path, -1, widePath, ARRAYSIZE(widePath)) == 0)
+    {
+        fprintf(stderr, "Usage: mstool stats [--import <corpus>] [--rebuild] <store>\n");
+        return 1;
+    }
+
+    HANDLE hHeap = GetProcessHeap();
+    StatsRun* run = HeapAlloc(hHeap, 0, sizeof(StatsRun));
+    LARGE_INTEGER start;
+
+    if (run == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    QueryPerformanceCounter(&start);
+
+    if (!OpenStatsStore(&run->store, widePath))
+    {
+        fprintf(stderr, "Cannot open %s (error %lu)\n", path, GetLastError());
+        HeapFree(hHeap, 0, run);
+        return 1;
+    }
+
+    double openSeconds = GetElapsedSeconds(start);
+    uint64_t tail = run->store.aggregates.records - run->store.snapshotRecords;
+    uint64_t imported = 0;
+    int status = 0;
+
+    if (importPath != NULL)
+    {
+        status = ImportReplayCorpus(run, importPath, &imported) ? 0 : 1;
+        printf("Imported %llu finished games from %s\n", (unsigned long long)imported, importPath);
+    }
+
+    printf("%-13s %10s %10s %8s %8s %7s %7s %7s %9s %7s %7s %7s\n",
+           "difficulty",
+           "games",
+           "wins",
+           "win rate",
+           "best s",
+           "p10 s",
+           "p50 s",
+           "p90 s",
+           "p50 3BV/s",
+           "streak",
+           "longest",
+           "losing");
+
+    for (Difficulty d = DIFFICULTY_BEGINNER; d <= DIFFICULTY_CUSTOM; d++)
+    {
+        if (run->store.aggregates.difficulties[d].games > 0)
+            PrintDifficultyAggregate(d, &run->store.aggregates.difficulties[d]);
+    }
+
+    printf("\n%llu games recorded, opened in %.3f ms from a snapshot and %llu later records\n",
+           (unsigned long long)run->store.aggregates.records,
+           openSeconds * 1e3,
+           (unsigned long long)tail);
+
+    if (rebuild)
+    {
+        QueryPerformanceCounter(&start);
+
+        if (!RebuildStatsAggregates(&run->store, &run->rebuilt))
+        {
+            fprintf(stderr, "Cannot read %s (error %lu)\n", path, GetLastError());
+            status = 1;
+        }
+        else
+        {
+            // Both sides are zeroed before they are filled, so their padding compares equal too.
+            bool same = memcmp(&run->rebuilt, &run->store.aggregates, sizeof(StatsAggregates)) == 0;
+
+            printf("Rebuilt from every record in %.3f ms: %s\n",
+                   GetElapsedSeconds(start) * 1e3,
+                   same ? "matches the snapshot" : "DIFFERS from the snapshot");
+            status = same ? status : 1;
+        }
+    }
+
+    CloseStatsStore(&run->store);
+    HeapFree(hHeap, 0, run);
+
+    return status;
+}
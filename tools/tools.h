@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "game.h"
+#include "replay.h"
+
+#define REPLAY_FILE_PATTERN "*.msr"
+
+typedef struct
+{
+    const char* name;
+    const char* usage;
+    const char* description;
+    int (*run)(_In_ int argc, _In_reads_(argc) char** argv);
+} Command;
+
+typedef bool (*ReplayFileVisitor)(_Inout_opt_ void* context, _In_z_ const char* path);
+
+bool ParseUnsigned(_In_z_ const char* text, _Out_ uint64_t* value);
+
+bool ParseDifficulty(_In_z_ const char* text, _Out_ Difficulty* difficulty);
+
+_Ret_z_ const char* GetDifficultyName(_In_ Difficulty difficulty);
+
+// Visits a file, or every replay file in a directory, until the visitor returns false.
+bool VisitReplayFiles(_In_z_ const char* path, _In_ ReplayFileVisitor visit, _Inout_opt_ void* context);
+
+bool ReadReplayFileBytes(
+    _In_z_ const char* path,
+    _Out_writes_bytes_to_(REPLAY_FILE_MAX_SIZE, *size) uint8_t* bytes,
+    _Out_ uint32_t* size);
+
+int RunSimulateCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunMetricsCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunReplayCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunPackCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunAnalyzeCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunConvertCommand(_In_ int argc, _In_reads_(argc) char** argv);
+
+int RunStatsCommand(_In_ int argc, _In_reads_(argc) char** argv);